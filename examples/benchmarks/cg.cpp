@@ -72,6 +72,28 @@ void sparseConjugateGradient(void)
     }
 }
 
+void operatorConjugateGradient(void)
+{
+    // The analysis of spA is done once and reused by every product
+    sparseOperator opA(spA);
+
+    array x = constant(0, b.dims(), f32);
+    array r = b - matmul(opA, x);
+    array p = r;
+
+    for (int i = 0; i < maxIter; ++i) {
+        array Ap = matmul(opA, p);
+        array alpha_num = dot(r, r);
+        array alpha_den = dot(p, Ap);
+        array alpha = alpha_num/alpha_den;
+        r -= tile(alpha, Ap.dims())*Ap;
+        x += tile(alpha, Ap.dims())*p;
+        array beta_num = dot(r, r);
+        array beta = beta_num/alpha_num;
+        p = r + tile(beta, p.dims()) * p;
+    }
+}
+
 void denseConjugateGradient(void)
 {
     array x = constant(0, b.dims(), f32);
@@ -91,6 +113,12 @@ void denseConjugateGradient(void)
     }
 }
 
+void nativeConjugateGradient(void)
+{
+    // The whole solve runs in the library, without a call per vector operation
+    array x = solveIterative(spA, b, AF_ITERATIVE_CG, AF_PRECOND_NONE, 0, maxIter);
+}
+
 void checkConjugateGradient(const af::array in)
 {
     array x = constant(0, b.dims(), f32);
@@ -135,5 +163,13 @@ int main(int argc, char *argv[])
               << timeit(sparseConjugateGradient) * 1000
               << "ms" << std::endl;
 
+    std::cout << "Sparse Operator Conjugate Gradient Time: "
+              << timeit(operatorConjugateGradient) * 1000
+              << "ms" << std::endl;
+
+    std::cout << "Native Sparse Conjugate Gradient Time: "
+              << timeit(nativeConjugateGradient) * 1000
+              << "ms" << std::endl;
+
     return 0;
 }
@@ -345,6 +345,49 @@ namespace af
     AFAPI array scanByKey(const array &key, const array& in, const int dim = 0, binaryOp op = AF_BINARY_ADD, bool inclusive_scan = true);
 #endif
 
+#if AF_API_VERSION >= 35
+    /**
+       C++ Interface for reducing an array by key
+
+       \param[out] keys_out will contain one key per group of \p keys
+       \param[out] vals_out will contain the reduction of \p vals for each
+                   group along \p dim
+       \param[in] keys is the key vector. It must have as many elements as
+                  \p vals has along \p dim
+       \param[in] vals is the input array
+       \param[in] dim The dimension along which the reduction is performed
+       \param[in] op is the type of binary operation used
+       \param[in] is_sorted if true, every run of equal consecutive keys forms
+                  a group. Otherwise equal keys are grouped wherever they occur
+                  and the groups are returned in the order of first occurrence
+
+       \ingroup reduce_func_by_key
+    */
+    AFAPI void reduceByKey(array &keys_out, array &vals_out,
+                           const array &keys, const array &vals,
+                           const int dim = 0, const binaryOp op = AF_BINARY_ADD,
+                           const bool is_sorted = false);
+
+    /**
+       C++ Interface for counting non-zero values of an array by key
+
+       \param[out] keys_out will contain one key per group of \p keys
+       \param[out] vals_out will contain the number of non-zero values of
+                   \p vals for each group along \p dim
+       \param[in] keys is the key vector. It must have as many elements as
+                  \p vals has along \p dim
+       \param[in] vals is the input array
+       \param[in] dim The dimension along which the count is performed
+       \param[in] is_sorted if true, every run of equal consecutive keys forms
+                  a group. Otherwise equal keys are grouped wherever they occur
+
+       \ingroup reduce_func_by_key
+    */
+    AFAPI void countByKey(array &keys_out, array &vals_out,
+                          const array &keys, const array &vals,
+                          const int dim = 0, const bool is_sorted = false);
+#endif
+
     /**
        C++ Interface for finding the locations of non-zero values in an array
 
@@ -355,6 +398,21 @@ namespace af
     */
     AFAPI array where(const array &in);
 
+#if AF_API_VERSION >= 35
+    /**
+       C++ Interface for selecting the values of an array where a mask is true
+
+       \param[in] in is the input array
+       \param[in] mask is a \ref b8 array. It either has the same dimensions as
+                  \p in or is a vector with one entry per row of \p in
+       \return the selected elements of \p in as a vector, or the selected
+               rows of \p in when \p mask has one entry per row
+
+       \ingroup scan_func_compact
+    */
+    AFAPI array compact(const array &in, const array &mask);
+#endif
+
     /**
        C++ Interface for calculating first order differences in an array
 
@@ -451,6 +509,62 @@ namespace af
        \ingroup set_func_intersect
     */
     AFAPI array setIntersect(const array &first, const array &second, const bool is_unique=false);
+
+#if AF_API_VERSION >= 35
+    /**
+       C++ Interface for getting unique values in the order of their first
+       occurrence
+
+       \param[in] in is the input array
+       \return the unique values from \p in, in the order in which they first
+               appear in \p in
+
+       \note The input does not need to be sorted
+
+       \ingroup set_func_unique
+    */
+    AFAPI array setUniqueStable(const array &in);
+
+    /**
+       C++ Interface for performing union of two arrays while preserving the
+       order of first occurrence
+
+       \param[in] first is the first array
+       \param[in] second is the second array
+       \return the union of \p first and \p second. Values appear in the order
+               in which they first occur in \p first followed by \p second
+
+       \ingroup set_func_union
+    */
+    AFAPI array setUnionStable(const array &first, const array &second);
+
+    /**
+       C++ Interface for performing intersect of two arrays while preserving
+       the order of first occurrence
+
+       \param[in] first is the first array
+       \param[in] second is the second array
+       \return the intersection of \p first and \p second. Values appear in
+               the order in which they first occur in \p first
+
+       \ingroup set_func_intersect
+    */
+    AFAPI array setIntersectStable(const array &first, const array &second);
+
+    /**
+       C++ Interface for testing membership of values in a set
+
+       \param[in] elements is the array of values to look up
+       \param[in] set is the array of values to look up in
+       \return a \ref b8 array of the same shape as \p elements. An element is
+               true if the corresponding value in \p elements is in \p set
+
+       \note Neither input needs to be sorted or unique
+
+       \ingroup set_func_contains
+    */
+    AFAPI array setContains(const array &elements, const array &set);
+#endif
 }
 #endif
 
@@ -803,6 +917,50 @@ extern "C" {
     AFAPI af_err af_scan_by_key(af_array *out, const af_array key, const af_array in, const int dim, af_binary_op op, bool inclusive_scan);
 #endif
 
+#if AF_API_VERSION >= 35
+    /**
+       C Interface for reducing an array by key
+
+       \param[out] keys_out will contain one key per group of \p keys
+       \param[out] vals_out will contain the reduction of \p vals for each
+                   group along \p dim
+       \param[in] keys is the key vector (\ref s32, \ref u32, \ref s64 or
+                  \ref u64)
+       \param[in] vals is the input array
+       \param[in] dim The dimension along which the reduction is performed
+       \param[in] op is the type of binary operation used
+       \param[in] is_sorted if true, every run of equal consecutive keys forms
+                  a group. Otherwise equal keys are grouped wherever they occur
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup reduce_func_by_key
+    */
+    AFAPI af_err af_reduce_by_key(af_array *keys_out, af_array *vals_out,
+                                  const af_array keys, const af_array vals,
+                                  const int dim, const af_binary_op op,
+                                  const bool is_sorted);
+
+    /**
+       C Interface for counting non-zero values of an array by key
+
+       \param[out] keys_out will contain one key per group of \p keys
+       \param[out] vals_out will contain the number of non-zero values of
+                   \p vals for each group along \p dim
+       \param[in] keys is the key vector (\ref s32, \ref u32, \ref s64 or
+                  \ref u64)
+       \param[in] vals is the input array
+       \param[in] dim The dimension along which the count is performed
+       \param[in] is_sorted if true, every run of equal consecutive keys forms
+                  a group. Otherwise equal keys are grouped wherever they occur
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup reduce_func_by_key
+    */
+    AFAPI af_err af_count_by_key(af_array *keys_out, af_array *vals_out,
+                                 const af_array keys, const af_array vals,
+                                 const int dim, const bool is_sorted);
+#endif
+
     /**
        C Interface for finding the locations of non-zero values in an array
 
@@ -814,6 +972,23 @@ extern "C" {
     */
     AFAPI af_err af_where(af_array *idx, const af_array in);
 
+#if AF_API_VERSION >= 35
+    /**
+       C Interface for selecting the values of an array where a mask is true
+
+       \param[out] out will contain the selected elements of \p in as a
+                   vector, or the selected rows of \p in when \p mask has
+                   one entry per row
+       \param[in] in is the input array
+       \param[in] mask is a \ref b8 array. It either has the same dimensions
+                  as \p in or is a vector with one entry per row of \p in
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup scan_func_compact
+    */
+    AFAPI af_err af_compact(af_array *out, const af_array in, const af_array mask);
+#endif
+
     /**
        C Interface for calculating first order differences in an array
 
@@ -920,6 +1095,60 @@ extern "C" {
     */
     AFAPI af_err af_set_intersect(af_array *out, const af_array first, const af_array second, const bool is_unique);
 
+#if AF_API_VERSION >= 35
+    /**
+       C Interface for getting unique values in the order of their first
+       occurrence
+
+       \param[out] out will contain the unique values from \p in, in the order
+                   in which they first appear in \p in
+       \param[in] in is the input array
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup set_func_unique
+    */
+    AFAPI af_err af_set_unique_stable(af_array *out, const af_array in);
+
+    /**
+       C Interface for performing union of two arrays while preserving the
+       order of first occurrence
+
+       \param[out] out will contain the union of \p first and \p second
+       \param[in] first is the first array
+       \param[in] second is the second array
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup set_func_union
+    */
+    AFAPI af_err af_set_union_stable(af_array *out, const af_array first, const af_array second);
+
+    /**
+       C Interface for performing intersect of two arrays while preserving
+       the order of first occurrence
+
+       \param[out] out will contain the intersection of \p first and \p second
+       \param[in] first is the first array
+       \param[in] second is the second array
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup set_func_intersect
+    */
+    AFAPI af_err af_set_intersect_stable(af_array *out, const af_array first, const af_array second);
+
+    /**
+       C Interface for testing membership of values in a set
+
+       \param[out] out will be a \ref b8 array of the same shape as \p elements
+                   that is true where the value of \p elements is in \p set
+       \param[in] elements is the array of values to look up
+       \param[in] set is the array of values to look up in
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup set_func_contains
+    */
+    AFAPI af_err af_set_contains(af_array *out, const af_array elements, const af_array set);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -134,6 +134,62 @@ namespace af
     */
     AFAPI array matmul(const array &a, const array &b, const array &c, const array &d);
 
+#if AF_API_VERSION >= 35
+    /**
+        \brief General matrix multiply with accumulation
+
+        \copydetails blas_func_gemm
+
+        \param[in,out] C The output. If \p C is empty, a new array is created
+                   and \p beta is ignored. Otherwise \p C must have the
+                   dimensions of the product and is updated in place.
+        \param[in] lhs The array object on the left hand side
+        \param[in] rhs The array object on the right hand side
+        \param[in] alpha The scale of the product
+        \param[in] beta The scale of the existing \p C
+        \param[in] optLhs Transpose left hand side before the function is performed
+        \param[in] optRhs Transpose right hand side before the function is performed
+
+        \note This function is not supported in GFOR
+
+        \ingroup blas_func_gemm
+    */
+    AFAPI void gemm(array &C, const array &lhs, const array &rhs,
+                    const double alpha = 1.0, const double beta = 0.0,
+                    const matProp optLhs = AF_MAT_NONE,
+                    const matProp optRhs = AF_MAT_NONE);
+
+    /**
+        \brief General matrix multiply with a bias and an activation
+
+        \copydetails blas_func_gemm
+
+        \param[in,out] C The output. If \p C is empty, a new array is created
+                   and \p beta is ignored. Otherwise \p C must have the
+                   dimensions of the product and is updated in place.
+        \param[in] lhs The array object on the left hand side
+        \param[in] rhs The array object on the right hand side
+        \param[in] bias An M x 1 vector added to every column or a 1 x N
+                   vector added to every row of the result. Can be empty.
+        \param[in] act The activation applied to every element of the result
+        \param[in] alpha The scale of the product
+        \param[in] beta The scale of the existing \p C
+        \param[in] optLhs Transpose left hand side before the function is performed
+        \param[in] optRhs Transpose right hand side before the function is performed
+
+        \note Activations other than \ref AF_ACTIVATION_NONE are only
+              supported for real types.
+        \note This function is not supported in GFOR
+
+        \ingroup blas_func_gemm
+    */
+    AFAPI void gemm(array &C, const array &lhs, const array &rhs,
+                    const array &bias, const activation act,
+                    const double alpha = 1.0, const double beta = 0.0,
+                    const matProp optLhs = AF_MAT_NONE,
+                    const matProp optRhs = AF_MAT_NONE);
+#endif
+
 
     /**
         \brief Dot Product
@@ -258,6 +314,62 @@ extern "C" {
                             const af_mat_prop optLhs, const af_mat_prop optRhs);
 
 
+#if AF_API_VERSION >= 35
+    /**
+        \brief General matrix multiply with accumulation
+
+        \copydetails blas_func_gemm
+
+        \param[in,out] C Pointer to the output \ref af_array. If \p *C is
+                   0, a new array is created and \p beta is ignored.
+                   Otherwise \p *C must have the dimensions of the product
+                   and is updated in place.
+        \param[in] optLhs Transpose left hand side before the function is performed
+        \param[in] optRhs Transpose right hand side before the function is performed
+        \param[in] alpha Pointer to the scale of the product, of the type of \p lhs
+        \param[in] lhs The array object on the left hand side
+        \param[in] rhs The array object on the right hand side
+        \param[in] beta Pointer to the scale of the existing \p *C, of the type of \p lhs
+
+        \return AF_SUCCESS if the process is successful.
+
+        \ingroup blas_func_gemm
+    */
+    AFAPI af_err af_gemm(af_array *C, const af_mat_prop optLhs, const af_mat_prop optRhs,
+                         const void *alpha, const af_array lhs, const af_array rhs,
+                         const void *beta);
+
+    /**
+        \brief General matrix multiply with a bias and an activation
+
+        \copydetails blas_func_gemm
+
+        \param[in,out] C Pointer to the output \ref af_array. If \p *C is
+                   0, a new array is created and \p beta is ignored.
+                   Otherwise \p *C must have the dimensions of the product
+                   and is updated in place.
+        \param[in] optLhs Transpose left hand side before the function is performed
+        \param[in] optRhs Transpose right hand side before the function is performed
+        \param[in] alpha Pointer to the scale of the product, of the type of \p lhs
+        \param[in] lhs The array object on the left hand side
+        \param[in] rhs The array object on the right hand side
+        \param[in] beta Pointer to the scale of the existing \p *C, of the type of \p lhs
+        \param[in] bias An M x 1 vector added to every column or a 1 x N
+                   vector added to every row of the result. Can be 0.
+        \param[in] act The activation applied to every element of the result
+
+        \return AF_SUCCESS if the process is successful.
+
+        \note Activations other than \ref AF_ACTIVATION_NONE are only
+              supported for real types.
+
+        \ingroup blas_func_gemm
+    */
+    AFAPI af_err af_gemm_fused(af_array *C, const af_mat_prop optLhs, const af_mat_prop optRhs,
+                               const void *alpha, const af_array lhs, const af_array rhs,
+                               const void *beta, const af_array bias, const af_activation act);
+#endif
+
     /**
         Scalar dot product between two vectors.  Also referred to as the inner
         product.
@@ -452,9 +452,45 @@ typedef enum {
     AF_STORAGE_CSR       = 1,   ///< Storage type is CSR
     AF_STORAGE_CSC       = 2,   ///< Storage type is CSC
     AF_STORAGE_COO       = 3,   ///< Storage type is COO
+#if AF_API_VERSION >= 35
+    AF_STORAGE_BSR       = 4,   ///< Storage type is BSR, a CSR of dense square blocks
+    AF_STORAGE_SELL      = 5,   ///< Storage type is SELL-C-sigma, sliced ELLPACK
+#endif
 } af_storage;
 #endif
 
+#if AF_API_VERSION >= 35
+typedef enum {
+    AF_ACTIVATION_NONE      = 0,   ///< No activation
+    AF_ACTIVATION_RELU      = 1,   ///< max(x, 0)
+    AF_ACTIVATION_SIGMOID   = 2,   ///< 1 / (1 + exp(-x))
+    AF_ACTIVATION_TANH      = 3    ///< tanh(x)
+} af_activation;
+#endif
+
+#if AF_API_VERSION >= 35
+typedef enum {
+    AF_SPARSE_DUPLICATES_SUM  = 0,  ///< Values at the same position are added
+    AF_SPARSE_DUPLICATES_LAST = 1   ///< The last value given for a position is kept
+} af_sparse_duplicates;
+#endif
+
+#if AF_API_VERSION >= 35
+typedef enum {
+    AF_ITERATIVE_CG       = 0,  ///< Conjugate gradient, for Hermitian positive definite matrices
+    AF_ITERATIVE_BICGSTAB = 1,  ///< Stabilized biconjugate gradient
+    AF_ITERATIVE_GMRES    = 2   ///< Restarted generalized minimal residual
+} af_iterative_method;
+#endif
+
+#if AF_API_VERSION >= 35
+typedef enum {
+    AF_PRECOND_NONE   = 0,  ///< No preconditioner
+    AF_PRECOND_JACOBI = 1,  ///< Inverse of the diagonal
+    AF_PRECOND_ILU0   = 2   ///< Incomplete LU factorization without fill in
+} af_preconditioner;
+#endif
+
 #ifdef __cplusplus
 namespace af
 {
@@ -496,6 +532,18 @@ namespace af
 #if AF_API_VERSION >= 34
     typedef af_random_engine_type randomEngineType;
 #endif
+#if AF_API_VERSION >= 35
+    typedef af_activation activation;
+#endif
+#if AF_API_VERSION >= 35
+    typedef af_sparse_duplicates sparseDuplicates;
+#endif
+#if AF_API_VERSION >= 35
+    typedef af_iterative_method iterativeMethod;
+#endif
+#if AF_API_VERSION >= 35
+    typedef af_preconditioner preconditioner;
+#endif
 }
 
 #endif
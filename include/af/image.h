@@ -297,6 +297,57 @@ AFAPI array skew(const array& in, const float skew0, const float skew1, const di
 */
 AFAPI array bilateral(const array &in, const float spatial_sigma, const float chromatic_sigma, const bool is_color=false);
 
+#if AF_API_VERSION >= 35
+/**
+    C++ Interface for approximate bilateral filter
+
+    The filter is computed on a bilateral grid, in time that does not grow
+    with \p spatial_sigma. Unlike \ref bilateral, \p spatial_sigma is not
+    limited.
+
+    \param[in]  in array is the input image
+    \param[in]  spatial_sigma is the spatial variance parameter, greater than zero
+    \param[in]  chromatic_sigma is the chromatic variance parameter, greater than zero
+    \param[in]  is_color indicates if the input \p in is color image or grayscale
+    \return     the processed image
+
+    \ingroup image_func_bilateral
+*/
+AFAPI array bilateralGrid(const array &in, const float spatial_sigma, const float chromatic_sigma, const bool is_color=false);
+#endif
+
+#if AF_API_VERSION >= 35
+/**
+    C++ Interface for Gaussian pyramid
+
+    Level 0 is a copy of \p in. Every other level is the one before it
+    blurred with the 5-tap binomial filter and decimated by two, which halves
+    its first two dimensions, rounding up.
+
+    \param[out] out is an array of \p levels arrays, set to the levels of the pyramid
+    \param[in]  in is the input image, of type f32 or f64
+    \param[in]  levels is the number of levels, greater than zero
+
+    \ingroup image_func_pyramid
+*/
+AFAPI void pyramidGaussian(array *out, const array &in, const unsigned levels);
+
+/**
+    C++ Interface for Laplacian pyramid
+
+    Every level but the last is the matching level of the Gaussian pyramid
+    of \p in minus the next Gaussian level brought back to its size. The
+    last level is the last Gaussian level.
+
+    \param[out] out is an array of \p levels arrays, set to the levels of the pyramid
+    \param[in]  in is the input image, of type f32 or f64
+    \param[in]  levels is the number of levels, greater than zero
+
+    \ingroup image_func_pyramid
+*/
+AFAPI void pyramidLaplacian(array *out, const array &in, const unsigned levels);
+#endif
+
 /**
    C++ Interface for histogram
 
@@ -325,6 +376,24 @@ AFAPI array histogram(const array &in, const unsigned nbins, const double minval
  */
 AFAPI array histogram(const array &in, const unsigned nbins);
 
+#if AF_API_VERSION >= 35
+/**
+   C++ Interface for weighted histogram
+
+   \param[in]  in is the input array
+   \param[in]  weights has the dimensions of \p in. Every element adds its
+               weight to its bin
+   \param[in]  nbins  Number of bins to populate between min and max
+   \param[in]  minval minimum bin value (accumulates -inf to min)
+   \param[in]  maxval minimum bin value (accumulates max to +inf)
+   \return     histogram array of the type of \p weights (f32 or f64)
+
+   \ingroup image_func_histogram
+ */
+AFAPI array histogram(const array &in, const array &weights, const unsigned nbins,
+                      const double minval, const double maxval);
+#endif
+
 /**
     C++ Interface for mean shift
 
@@ -978,6 +1047,27 @@ extern "C" {
      */
     AFAPI af_err af_histogram(af_array *out, const af_array in, const unsigned nbins, const double minval, const double maxval);
 
+#if AF_API_VERSION >= 35
+    /**
+       C Interface for weighted histogram
+
+       \param[out] out is the histogram for input array in. It has the type
+                   of \p weights
+       \param[in]  in is the input array
+       \param[in]  weights (type f32 or f64) has the dimensions of \p in.
+                   Every element adds its weight to its bin
+       \param[in]  nbins  Number of bins to populate between min and max
+       \param[in]  minval minimum bin value (accumulates -inf to min)
+       \param[in]  maxval minimum bin value (accumulates max to +inf)
+       \return     \ref AF_SUCCESS if the histogram is successfully created,
+       otherwise an appropriate error code is returned.
+
+       \ingroup image_func_histogram
+     */
+    AFAPI af_err af_weighted_histogram(af_array *out, const af_array in, const af_array weights,
+                                       const unsigned nbins, const double minval, const double maxval);
+#endif
+
     /**
         C Interface for image dilation (max filter)
 
@@ -1049,6 +1139,51 @@ extern "C" {
     */
     AFAPI af_err af_bilateral(af_array *out, const af_array in, const float spatial_sigma, const float chromatic_sigma, const bool isColor);
 
+#if AF_API_VERSION >= 35
+    /**
+        C Interface for approximate bilateral filter
+
+        \param[out] out array is the processed image
+        \param[in]  in array is the input image
+        \param[in]  spatial_sigma is the spatial variance parameter, greater than zero
+        \param[in]  chromatic_sigma is the chromatic variance parameter, greater than zero
+        \param[in]  isColor indicates if the input \p in is color image or grayscale
+        \return     \ref AF_SUCCESS if the filter is applied successfully,
+        otherwise an appropriate error code is returned.
+
+        \ingroup image_func_bilateral
+    */
+    AFAPI af_err af_bilateral_grid(af_array *out, const af_array in, const float spatial_sigma, const float chromatic_sigma, const bool isColor);
+#endif
+
+#if AF_API_VERSION >= 35
+    /**
+        C Interface for Gaussian pyramid
+
+        \param[out] out points to \p levels handles, set to the levels of the pyramid
+        \param[in]  in is the input image, of type f32 or f64
+        \param[in]  levels is the number of levels, greater than zero
+        \return     \ref AF_SUCCESS if the pyramid is built successfully,
+        otherwise an appropriate error code is returned.
+
+        \ingroup image_func_pyramid
+    */
+    AFAPI af_err af_pyramid_gaussian(af_array *out, const af_array in, const unsigned levels);
+
+    /**
+        C Interface for Laplacian pyramid
+
+        \param[out] out points to \p levels handles, set to the levels of the pyramid
+        \param[in]  in is the input image, of type f32 or f64
+        \param[in]  levels is the number of levels, greater than zero
+        \return     \ref AF_SUCCESS if the pyramid is built successfully,
+        otherwise an appropriate error code is returned.
+
+        \ingroup image_func_pyramid
+    */
+    AFAPI af_err af_pyramid_laplacian(af_array *out, const af_array in, const unsigned levels);
+#endif
+
     /**
         C Interface for mean shift
 
@@ -186,6 +186,42 @@ namespace af
     AFAPI array solveLU(const array &a, const array &piv,
                         const array &b, const matProp options = AF_MAT_NONE);
 
+#if AF_API_VERSION >= 35
+    /**
+       C++ Interface for solving a system of equations with a Krylov method
+
+       \param[in] a is the square coefficient matrix, dense or sparse in CSR
+                  format
+       \param[in] b is the matrix of measured values. Every column is solved
+                  on its own.
+       \param[in] method is the \ref af::iterativeMethod
+       \param[in] precond is the \ref af::preconditioner
+       \param[in] tol is the relative residual ||b - a x|| / ||b|| to reach
+       \param[in] maxIter is the largest number of iterations
+       \param[in] restart is the number of iterations between restarts of
+                  \ref AF_ITERATIVE_GMRES
+       \param[out] iterations is set to the number of iterations when not
+                   NULL. With several columns in \p b, this is the largest
+                   number of iterations taken by any of them.
+       \param[out] residual is set to the relative residual reached when not
+                   NULL. With several columns in \p b, this is the largest
+                   relative residual of any of them.
+       \returns \p x, the matrix of unknown variables
+
+       \note Not reaching \p tol within \p maxIter iterations is not an
+             error. Check \p residual to know whether the solve converged.
+       \note This function is not supported in GFOR
+
+       \ingroup lapack_solve_iterative_func_gen
+    */
+    AFAPI array solveIterative(const array &a, const array &b,
+                               const iterativeMethod method = AF_ITERATIVE_CG,
+                               const preconditioner precond = AF_PRECOND_NONE,
+                               const double tol = 1E-6, const unsigned maxIter = 1000,
+                               const unsigned restart = 30,
+                               unsigned *iterations = NULL, double *residual = NULL);
+#endif
+
     /**
        C++ Interface for inverting a matrix
 
@@ -388,6 +424,39 @@ extern "C" {
     AFAPI af_err af_solve_lu(af_array *x, const af_array a, const af_array piv,
                              const af_array b, const af_mat_prop options);
 
+#if AF_API_VERSION >= 35
+    /**
+       C Interface for solving a system of equations with a Krylov method
+
+       \param[out] x will contain the matrix of unknown variables
+       \param[out] iterations is set to the number of iterations when not
+                   NULL. With several columns in \p b, this is the largest
+                   number of iterations taken by any of them.
+       \param[out] residual is set to the relative residual reached when not
+                   NULL. With several columns in \p b, this is the largest
+                   relative residual of any of them.
+       \param[in] a is the square coefficient matrix, dense or sparse in CSR
+                  format
+       \param[in] b is the matrix of measured values
+       \param[in] method is the \ref af_iterative_method
+       \param[in] precond is the \ref af_preconditioner
+       \param[in] tol is the relative residual ||b - a x|| / ||b|| to reach
+       \param[in] maxIter is the largest number of iterations
+       \param[in] restart is the number of iterations between restarts of
+                  \ref AF_ITERATIVE_GMRES
+
+       \ingroup lapack_solve_iterative_func_gen
+
+       \note This function is not supported in GFOR
+    */
+    AFAPI af_err af_solve_iterative(af_array *x, unsigned *iterations, double *residual,
+                                    const af_array a, const af_array b,
+                                    const af_iterative_method method,
+                                    const af_preconditioner precond,
+                                    const double tol, const unsigned maxIter,
+                                    const unsigned restart);
+#endif
+
     /**
        C Interface for inverting a matrix
 
@@ -10,6 +10,11 @@
 #pragma once
 #include <af/defines.h>
 
+///
+/// This handle is used to reference the internal streaming filter object.
+///
+typedef void * af_stream_filter;
+
 #ifdef __cplusplus
 
 namespace af
@@ -578,6 +583,23 @@ AFAPI array fftConvolve2(const array& signal, const array& filter, const convMod
  */
 AFAPI array fftConvolve3(const array& signal, const array& filter, const convMode mode=AF_CONV_DEFAULT);
 
+#if AF_API_VERSION >= 35
+/**
+   C++ Interface for calibrating the choice of convolution domain
+
+   Times the spatial and the frequency domain convolutions on the active
+   backend. The resulting model is used by every later convolution with
+   \ref AF_CONV_AUTO.
+
+   \param[in] path is the file the model is stored in. When it is NULL, the
+              file named by the AF_CONV_CALIBRATION_FILE environment variable
+              is used, if any.
+
+   \ingroup signal_func_calibrate_convolve
+ */
+AFAPI void calibrateConvolve(const char *path = NULL);
+#endif
+
 /**
    C++ Interface for finite impulse response  filter
 
@@ -603,6 +625,96 @@ AFAPI array fir(const array &b, const array &x);
 */
 AFAPI array iir(const array &b, const array &a, const array &x);
 
+#if AF_API_VERSION >= 35
+/**
+   C++ Interface for infinite impulse response filter made of second order sections
+
+   \param[in] sos is a 6 x N array with one section per column, holding
+              b0, b1, b2, a0, a1 and a2 in that order
+   \param[in] x is the input signal to the filter
+   \returns the output signal from the filter, the input filtered by each
+            section in turn
+
+   \ingroup signal_func_iir
+*/
+AFAPI array iirSos(const array &sos, const array &x);
+#endif
+
+#if AF_API_VERSION >= 35
+///
+/// \brief A filter that keeps its state between the chunks of a signal
+///
+/// Chunks of a stream are pushed one after another and each push returns the
+/// filtered samples of its chunk, exactly as if the whole stream had been
+/// filtered at once. Copies of a streamFilter share its state.
+///
+/// \ingroup signal_func_stream_filter
+///
+class AFAPI streamFilter
+{
+    private:
+        af_stream_filter filter;
+    public:
+        /**
+            Creates a finite impulse response filter
+
+            \param[in] b is the vector of filter coefficients
+            \param[in] domain is the domain the chunks are filtered in.
+                       \ref AF_CONV_FREQ uses overlap-save with the spectrum
+                       of \p b kept between chunks.
+
+            \ingroup signal_func_stream_filter
+        */
+        explicit
+        streamFilter(const array &b, const convDomain domain = AF_CONV_AUTO);
+
+        /**
+            Creates an infinite impulse response filter
+
+            \param[in] b is the vector of feedforward coefficients
+            \param[in] a is the vector of feedback coefficients
+
+            \ingroup signal_func_stream_filter
+        */
+        streamFilter(const array &b, const array &a);
+
+        /**
+            Copy constructor. The copy shares the state of \p in.
+
+            \ingroup signal_func_stream_filter
+        */
+        streamFilter(const streamFilter &in);
+
+        ~streamFilter();
+
+        streamFilter& operator= (const streamFilter &in);
+
+        /**
+            \param[in] x is the next chunk of the stream, one channel per
+                       column. Every chunk must have as many channels as
+                       the first one pushed after creation or reset.
+            \returns the filtered samples of \p x
+
+            \ingroup signal_func_stream_filter
+        */
+        array push(const array &x);
+
+        /**
+            Clears the state, so that the next chunk starts a new stream
+
+            \ingroup signal_func_stream_filter
+        */
+        void reset();
+
+        /**
+            \returns the \ref af_stream_filter handle of the object
+
+            \ingroup signal_func_stream_filter
+        */
+        af_stream_filter get() const;
+};
+#endif
+
 /**
     C++ Interface for median filter
 
@@ -1105,6 +1217,21 @@ AFAPI af_err af_fft_convolve2(af_array *out, const af_array signal, const af_arr
  */
 AFAPI af_err af_fft_convolve3(af_array *out, const af_array signal, const af_array filter, const af_conv_mode mode);
 
+#if AF_API_VERSION >= 35
+/**
+   C Interface for calibrating the choice of convolution domain
+
+   \param[in] path is the file the model is stored in. When it is NULL, the
+              file named by the AF_CONV_CALIBRATION_FILE environment variable
+              is used, if any.
+   \return    \ref AF_SUCCESS if the calibration is successful,
+              otherwise an appropriate error code is returned.
+
+   \ingroup signal_func_calibrate_convolve
+ */
+AFAPI af_err af_calibrate_convolve(const char *path);
+#endif
+
 /**
    C Interface for finite impulse response  filter
 
@@ -1130,6 +1257,82 @@ AFAPI af_err af_fir(af_array *y, const af_array b, const af_array x);
 */
 AFAPI af_err af_iir(af_array *y, const af_array b, const af_array a, const af_array x);
 
+#if AF_API_VERSION >= 35
+/**
+   C Interface for infinite impulse response filter made of second order sections
+
+   \param[out] y is the output signal from the filter
+   \param[in] sos is a 6 x N array with one section per column, holding
+              b0, b1, b2, a0, a1 and a2 in that order
+   \param[in] x is the input signal to the filter
+   \return    \ref AF_SUCCESS if the filtering is successful,
+              otherwise an appropriate error code is returned.
+
+   \ingroup signal_func_iir
+*/
+AFAPI af_err af_iir_sos(af_array *y, const af_array sos, const af_array x);
+#endif
+
+#if AF_API_VERSION >= 35
+/**
+   C Interface for creating a streaming finite impulse response filter
+
+   \param[out] out is the handle of the new filter
+   \param[in] b is the vector of filter coefficients
+   \param[in] domain is the domain the chunks are filtered in
+
+   \ingroup signal_func_stream_filter
+*/
+AFAPI af_err af_create_fir_stream(af_stream_filter *out, const af_array b,
+                                  const af_conv_domain domain);
+
+/**
+   C Interface for creating a streaming infinite impulse response filter
+
+   \param[out] out is the handle of the new filter
+   \param[in] b is the vector of feedforward coefficients
+   \param[in] a is the vector of feedback coefficients
+
+   \ingroup signal_func_stream_filter
+*/
+AFAPI af_err af_create_iir_stream(af_stream_filter *out, const af_array b, const af_array a);
+
+/**
+   \param[out] out is a new handle sharing the state of \p in
+   \param[in] in is the input streaming filter
+
+   \ingroup signal_func_stream_filter
+*/
+AFAPI af_err af_retain_stream_filter(af_stream_filter *out, const af_stream_filter in);
+
+/**
+   \param[in] filter is the streaming filter to be released
+
+   \ingroup signal_func_stream_filter
+*/
+AFAPI af_err af_release_stream_filter(af_stream_filter filter);
+
+/**
+   C Interface for filtering the next chunk of a stream
+
+   \param[out] y is the filtered samples of \p x
+   \param[in] filter is the streaming filter
+   \param[in] x is the next chunk of the stream, one channel per column
+
+   \ingroup signal_func_stream_filter
+*/
+AFAPI af_err af_stream_filter_push(af_array *y, af_stream_filter filter, const af_array x);
+
+/**
+   C Interface for clearing the state of a streaming filter
+
+   \param[in] filter is the streaming filter
+
+   \ingroup signal_func_stream_filter
+*/
+AFAPI af_err af_stream_filter_reset(af_stream_filter filter);
+#endif
+
     /**
         C Interface for median filter
 
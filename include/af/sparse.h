@@ -10,6 +10,11 @@
 #pragma once
 #include <af/defines.h>
 
+///
+/// This handle is used to reference the internal sparse operator object.
+///
+typedef void * af_sparse_operator;
+
 #ifdef __cplusplus
 namespace af
 {
@@ -166,6 +171,107 @@ namespace af
      */
     AFAPI af::storage sparseGetStorage(const array in);
 #endif
+#if AF_API_VERSION >= 35
+    ///
+    /// \brief A sparse matrix prepared for repeated products with dense matrices
+    /// \ingroup sparse_func_operator
+    ///
+    class AFAPI sparseOperator
+    {
+        private:
+            af_sparse_operator op;
+        public:
+            /**
+                Analyses a CSR array for products of the form
+                matmul(sparse, rhs, optLhs).
+
+                \param[in] sparse is the input sparse matrix in CSR format
+                \param[in] optLhs is the transpose option applied to \p sparse
+                \param[in] ncols is the expected number of columns of the dense
+                           matrices it is multiplied with
+
+                \ingroup sparse_func_operator
+            */
+            explicit
+            sparseOperator(const array &sparse, const matProp optLhs = AF_MAT_NONE,
+                           const dim_t ncols = 1);
+
+            /**
+                Copy constructor. The copy shares the analysis of \p in.
+
+                \ingroup sparse_func_operator
+            */
+            sparseOperator(const sparseOperator &in);
+
+            ~sparseOperator();
+
+            sparseOperator& operator= (const sparseOperator &in);
+
+            /**
+                \returns the \ref af_sparse_operator handle of the object
+
+                \ingroup sparse_func_operator
+            */
+            af_sparse_operator get() const;
+    };
+
+    /**
+       \param[in] lhs is the sparse operator
+       \param[in] rhs is the dense matrix
+       \return op(sparse) * \p rhs where op is the transpose option \p lhs
+               was created with
+
+       \ingroup sparse_func_operator
+     */
+    AFAPI array matmul(const sparseOperator &lhs, const array &rhs);
+
+    /**
+       \param[in] lhs is a sparse matrix in CSR format
+       \param[in] rhs is a sparse matrix in CSR format of the same size
+       \return \p lhs + \p rhs in CSR format. The result stores every
+               position stored by either input.
+
+       \ingroup sparse_func_arith
+     */
+    AFAPI array sparseAdd(const array &lhs, const array &rhs);
+
+    /**
+       \param[in] lhs is a sparse matrix in CSR format
+       \param[in] rhs is a sparse matrix in CSR format of the same size
+       \return the element wise product of \p lhs and \p rhs in CSR
+               format. The result stores the positions stored by both inputs.
+
+       \ingroup sparse_func_arith
+     */
+    AFAPI array sparseMul(const array &lhs, const array &rhs);
+
+    /**
+       \param[in] lhs is a sparse matrix in CSR format
+       \param[in] rhs is a sparse matrix in CSR format
+       \return the matrix product \p lhs * \p rhs in CSR format
+
+       \ingroup sparse_func_arith
+     */
+    AFAPI array sparseMatmul(const array &lhs, const array &rhs);
+
+    /**
+       Builds a sparse matrix in CSR format from (row, column, value)
+       triplets given in any order.
+
+       \param[in] nRows is the number of rows of the matrix
+       \param[in] nCols is the number of columns of the matrix
+       \param[in] values holds the value of every triplet
+       \param[in] rowIdx holds the row of every triplet
+       \param[in] colIdx holds the column of every triplet
+       \param[in] dups tells how triplets sharing a position are combined
+       \return \ref af::array for the sparse array in CSR format
+
+       \ingroup sparse_func_assemble
+     */
+    AFAPI array sparseAssemble(const dim_t nRows, const dim_t nCols,
+                               const array &values, const array &rowIdx, const array &colIdx,
+                               const sparseDuplicates dups = AF_SPARSE_DUPLICATES_SUM);
+#endif
 }
 #endif
 
@@ -354,6 +460,107 @@ extern "C" {
     AFAPI af_err af_sparse_get_storage(af_storage *out, const af_array in);
 #endif
 
+#if AF_API_VERSION >= 35
+    /**
+       \param[out] out is the handle of the new sparse operator
+       \param[in] sparse is the input sparse matrix in CSR format
+       \param[in] optLhs is the transpose option applied to \p sparse
+       \param[in] ncols is the expected number of columns of the dense
+                  matrices it is multiplied with
+
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup sparse_func_operator
+     */
+    AFAPI af_err af_create_sparse_operator(af_sparse_operator *out, const af_array sparse,
+                                           const af_mat_prop optLhs, const dim_t ncols);
+
+    /**
+       \param[out] out is a new handle sharing the analysis of \p in
+       \param[in] in is the input sparse operator
+
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup sparse_func_operator
+     */
+    AFAPI af_err af_retain_sparse_operator(af_sparse_operator *out, const af_sparse_operator in);
+
+    /**
+       \param[in] op is the sparse operator to be released
+
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup sparse_func_operator
+     */
+    AFAPI af_err af_release_sparse_operator(af_sparse_operator op);
+
+    /**
+       \param[out] out is op(sparse) * \p rhs
+       \param[in] op is the sparse operator
+       \param[in] rhs is the dense matrix
+
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup sparse_func_operator
+     */
+    AFAPI af_err af_sparse_operator_matmul(af_array *out, const af_sparse_operator op,
+                                           const af_array rhs);
+    /**
+       \param[out] out is \p lhs + \p rhs in CSR format
+       \param[in] lhs is a sparse matrix in CSR format
+       \param[in] rhs is a sparse matrix in CSR format of the same size
+
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup sparse_func_arith
+     */
+    AFAPI af_err af_sparse_add(af_array *out, const af_array lhs, const af_array rhs);
+
+    /**
+       \param[out] out is the element wise product of \p lhs and \p rhs in
+                   CSR format
+       \param[in] lhs is a sparse matrix in CSR format
+       \param[in] rhs is a sparse matrix in CSR format of the same size
+
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup sparse_func_arith
+     */
+    AFAPI af_err af_sparse_mul(af_array *out, const af_array lhs, const af_array rhs);
+
+    /**
+       \param[out] out is the matrix product \p lhs * \p rhs in CSR format
+       \param[in] lhs is a sparse matrix in CSR format
+       \param[in] rhs is a sparse matrix in CSR format
+
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup sparse_func_arith
+     */
+    AFAPI af_err af_sparse_sparse_matmul(af_array *out, const af_array lhs, const af_array rhs);
+
+    /**
+       Builds a sparse matrix in CSR format from (row, column, value)
+       triplets given in any order.
+
+       \param[out] out \ref af_array for the sparse array in CSR format
+       \param[in] nRows is the number of rows of the matrix
+       \param[in] nCols is the number of columns of the matrix
+       \param[in] values holds the value of every triplet
+       \param[in] rowIdx holds the row of every triplet as s32
+       \param[in] colIdx holds the column of every triplet as s32
+       \param[in] dups tells how triplets sharing a position are combined
+
+       \return \ref AF_SUCCESS if the execution completes properly
+
+       \ingroup sparse_func_assemble
+     */
+    AFAPI af_err af_sparse_assemble(af_array *out,
+                                    const dim_t nRows, const dim_t nCols,
+                                    const af_array values, const af_array rowIdx, const af_array colIdx,
+                                    const af_sparse_duplicates dups);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -192,6 +192,116 @@ AFAPI T median(const array& in);
 template<typename T>
 AFAPI T corrcoef(const array& X, const array& Y);
 
+#if AF_API_VERSION >= 35
+/**
+   C++ Interface for building a quantile sketch
+
+   \param[in] in is the input array. All of its elements are added to the
+              sketch. NaN values are ignored
+   \param[in] compression controls the size and the accuracy of the sketch.
+              The sketch holds in the order of \p compression centroids
+   \return    the sketch, an f64 array of k x 2. The first column holds the
+              centroid means in ascending order and the second their weights
+
+   \ingroup stat_func_quantile_sketch
+*/
+AFAPI array quantileSketch(const array& in, const double compression=100);
+
+/**
+   C++ Interface for merging two quantile sketches
+
+   \param[in] lhs is the first sketch
+   \param[in] rhs is the second sketch
+   \param[in] compression controls the size and the accuracy of the result
+   \return    a sketch of the union of the data summarized by \p lhs and \p rhs
+
+   \ingroup stat_func_quantile_sketch
+*/
+AFAPI array quantileSketchMerge(const array& lhs, const array& rhs, const double compression=100);
+
+/**
+   C++ Interface for estimating quantiles from a quantile sketch
+
+   \param[in] sketch is the quantile sketch
+   \param[in] probs (type f32 or f64) are the quantiles to estimate, in [0, 1]
+   \return    an f64 array of the dimensions of \p probs with the estimated
+              values
+
+   \ingroup stat_func_quantile_sketch
+*/
+AFAPI array quantileSketchQuery(const array& sketch, const array& probs);
+
+/**
+   C++ Interface for building a distinct count sketch
+
+   \param[in] in is the input array
+   \param[in] precision is the base 2 logarithm of the number of registers,
+              between 4 and 18. The relative error is about 1.04 / sqrt(2^precision)
+   \return    the sketch, a u8 vector of 2^precision registers
+
+   \ingroup stat_func_distinct_sketch
+*/
+AFAPI array distinctSketch(const array& in, const unsigned precision=14);
+
+/**
+   C++ Interface for merging two distinct count sketches
+
+   \param[in] lhs is the first sketch
+   \param[in] rhs is the second sketch. It must have the precision of \p lhs
+   \return    a sketch of the union of the data summarized by \p lhs and \p rhs
+
+   \ingroup stat_func_distinct_sketch
+*/
+AFAPI array distinctSketchMerge(const array& lhs, const array& rhs);
+
+/**
+   C++ Interface for estimating the number of distinct values
+
+   \param[in] sketch is the distinct count sketch
+   \return    the estimated number of distinct values
+
+   \ingroup stat_func_distinct_sketch
+*/
+AFAPI double distinctSketchCount(const array& sketch);
+
+/**
+   C++ Interface for building a frequency sketch
+
+   \param[in] in is the input array
+   \param[in] width is the number of counters per row. The overestimate of a
+              count is at most about e / \p width times the number of elements
+   \param[in] depth is the number of rows. The error bound holds with
+              probability 1 - exp(-\p depth)
+   \return    the sketch, a u64 array of \p width x \p depth
+
+   \ingroup stat_func_frequency_sketch
+*/
+AFAPI array frequencySketch(const array& in, const unsigned width=2048, const unsigned depth=4);
+
+/**
+   C++ Interface for merging two frequency sketches
+
+   \param[in] lhs is the first sketch
+   \param[in] rhs is the second sketch. It must have the dimensions of \p lhs
+   \return    a sketch of the union of the data summarized by \p lhs and \p rhs
+
+   \ingroup stat_func_frequency_sketch
+*/
+AFAPI array frequencySketchMerge(const array& lhs, const array& rhs);
+
+/**
+   C++ Interface for estimating the number of occurrences of values
+
+   \param[in] sketch is the frequency sketch
+   \param[in] values are the values to look up
+   \return    a u64 array of the dimensions of \p values with the estimated
+              counts. The estimates are never smaller than the true counts
+
+   \ingroup stat_func_frequency_sketch
+*/
+AFAPI array frequencySketchQuery(const array& sketch, const array& values);
+#endif
+
 }
 #endif
 
@@ -396,6 +506,132 @@ AFAPI af_err af_median_all(double *realVal, double *imagVal, const af_array in);
 
 AFAPI af_err af_corrcoef(double *realVal, double *imagVal, const af_array X, const af_array Y);
 
+#if AF_API_VERSION >= 35
+/**
+   C Interface for building a quantile sketch
+
+   \param[out] out will contain the sketch, an f64 array of k x 2. The first
+               column holds the centroid means in ascending order and the
+               second their weights
+   \param[in] in is the input array. NaN values are ignored
+   \param[in] compression controls the size and the accuracy of the sketch
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_quantile_sketch
+*/
+AFAPI af_err af_quantile_sketch(af_array *out, const af_array in, const double compression);
+
+/**
+   C Interface for merging two quantile sketches
+
+   \param[out] out will contain a sketch of the union of the data summarized
+               by \p lhs and \p rhs
+   \param[in] lhs is the first sketch
+   \param[in] rhs is the second sketch
+   \param[in] compression controls the size and the accuracy of the result
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_quantile_sketch
+*/
+AFAPI af_err af_quantile_sketch_merge(af_array *out, const af_array lhs, const af_array rhs, const double compression);
+
+/**
+   C Interface for estimating quantiles from a quantile sketch
+
+   \param[out] out will contain the estimated values (type f64)
+   \param[in] sketch is the quantile sketch
+   \param[in] probs (type f32 or f64) are the quantiles to estimate, in [0, 1]
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_quantile_sketch
+*/
+AFAPI af_err af_quantile_sketch_query(af_array *out, const af_array sketch, const af_array probs);
+
+/**
+   C Interface for building a distinct count sketch
+
+   \param[out] out will contain the sketch, a u8 vector of 2^precision registers
+   \param[in] in is the input array
+   \param[in] precision is the base 2 logarithm of the number of registers,
+              between 4 and 18
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_distinct_sketch
+*/
+AFAPI af_err af_distinct_sketch(af_array *out, const af_array in, const unsigned precision);
+
+/**
+   C Interface for merging two distinct count sketches
+
+   \param[out] out will contain a sketch of the union of the data summarized
+               by \p lhs and \p rhs
+   \param[in] lhs is the first sketch
+   \param[in] rhs is the second sketch. It must have the precision of \p lhs
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_distinct_sketch
+*/
+AFAPI af_err af_distinct_sketch_merge(af_array *out, const af_array lhs, const af_array rhs);
+
+/**
+   C Interface for estimating the number of distinct values
+
+   \param[out] count will contain the estimated number of distinct values
+   \param[in] sketch is the distinct count sketch
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_distinct_sketch
+*/
+AFAPI af_err af_distinct_sketch_count(double *count, const af_array sketch);
+
+/**
+   C Interface for building a frequency sketch
+
+   \param[out] out will contain the sketch, a u64 array of \p width x \p depth
+   \param[in] in is the input array
+   \param[in] width is the number of counters per row
+   \param[in] depth is the number of rows
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_frequency_sketch
+*/
+AFAPI af_err af_frequency_sketch(af_array *out, const af_array in, const unsigned width, const unsigned depth);
+
+/**
+   C Interface for merging two frequency sketches
+
+   \param[out] out will contain a sketch of the union of the data summarized
+               by \p lhs and \p rhs
+   \param[in] lhs is the first sketch
+   \param[in] rhs is the second sketch. It must have the dimensions of \p lhs
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_frequency_sketch
+*/
+AFAPI af_err af_frequency_sketch_merge(af_array *out, const af_array lhs, const af_array rhs);
+
+/**
+   C Interface for estimating the number of occurrences of values
+
+   \param[out] out will contain the estimated counts (type u64)
+   \param[in] sketch is the frequency sketch
+   \param[in] values are the values to look up
+   \return     \ref AF_SUCCESS if the operation is successful,
+   otherwise an appropriate error code is returned.
+
+   \ingroup stat_func_frequency_sketch
+*/
+AFAPI af_err af_frequency_sketch_query(af_array *out, const af_array sketch, const af_array values);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -140,6 +140,8 @@
 
         The \ref af::storage is used to determin the type of storage to use.
         Currently \ref AF_STORAGE_CSR and \ref AF_STORAGE_COO are available.
+        CSR arrays can be converted to the blocked \ref AF_STORAGE_BSR and
+        \ref AF_STORAGE_SELL storages using \ref af::sparseConvertTo.
 
         A sparse array can be identied using the \ref af::array::issparse()
         function.  This function will return true for a sparse array and false
@@ -8,6 +8,7 @@
  ********************************************************/
 
 #include <af/blas.h>
+#include <af/sparse.h>
 #include <blas.hpp>
 #include <handle.hpp>
 #include <Array.hpp>
@@ -18,6 +19,9 @@
 #include <sparse_blas.hpp>
 #include <err_common.hpp>
 #include <backend.hpp>
+#include <copy.hpp>
+#include <math.hpp>
+#include <algorithm>
 
 template<typename T>
 static inline af_array sparseMatmul(const af_array lhs, const af_array rhs,
@@ -34,6 +38,48 @@ static inline af_array matmul(const af_array lhs, const af_array rhs,
     return getHandle(detail::matmul<T>(getArray<T>(lhs), getArray<T>(rhs), optLhs, optRhs));
 }
 
+template<typename T>
+static inline void gemm(af_array *C, af_mat_prop optLhs, af_mat_prop optRhs,
+                        const void *alpha, const af_array lhs, const af_array rhs,
+                        const void *beta, const af_array bias, const af_activation act,
+                        const af::dim4 &odims)
+{
+    const T *a = static_cast<const T *>(alpha);
+
+    // The operands are held here, so that C shares their data, and is copied
+    // below, when it is passed as one of them
+    const detail::Array<T> l = getArray<T>(lhs);
+    const detail::Array<T> r = getArray<T>(rhs);
+    const detail::Array<T> b = bias ? getArray<T>(bias) : l;
+    const detail::Array<T> *biasArray = bias ? &b : nullptr;
+
+    if (*C == 0) {
+        // There is nothing to accumulate into
+        const T zero = detail::scalar<T>(0);
+        detail::Array<T> out = detail::createEmptyArray<T>(odims);
+        detail::gemm<T>(out, optLhs, optRhs, a, l, r, &zero, biasArray, act);
+        *C = getHandle(out);
+    } else {
+        detail::Array<T> &out = getWritableArray<T>(*C);
+        // Arrays sharing the data with C, including the operands, must not
+        // see the update
+        if (out.useCount() > 1 || !out.isLinear()) out = detail::copyArray<T>(out);
+        detail::gemm<T>(out, optLhs, optRhs, a, l, r,
+                        static_cast<const T *>(beta), biasArray, act);
+    }
+}
+
+// Matrices are batched along dimensions 2 and 3. A single matrix along a
+// dimension is multiplied with every matrix of the other side.
+static void checkBatchDims(const af::dim4 &lDims, const af::dim4 &rDims)
+{
+    for (int d = 2; d < 4; d++) {
+        if (lDims[d] != rDims[d] && lDims[d] != 1 && rDims[d] != 1) {
+            AF_ERROR("matmul batch dimensions must match or be 1", AF_ERR_BATCH);
+        }
+    }
+}
+
 template<typename T>
 static inline af_array dot(const af_array lhs, const af_array rhs,
                     af_mat_prop optLhs, af_mat_prop optRhs)
@@ -56,7 +102,15 @@ af_err af_sparse_matmul(af_array *out,
         af_dtype lhs_type = lhsBase.getType();
         af_dtype rhs_type = rhsInfo.getType();
 
-        ARG_ASSERT(1, lhsBase.getStorage() == AF_STORAGE_CSR);
+        const af_storage lhsStorage = lhsBase.getStorage();
+        ARG_ASSERT(1, lhsStorage == AF_STORAGE_CSR ||
+                      lhsStorage == AF_STORAGE_BSR ||
+                      lhsStorage == AF_STORAGE_SELL);
+
+        // The blocked storages are only multiplied as they are
+        if (lhsStorage != AF_STORAGE_CSR && optLhs != AF_MAT_NONE) {
+            AF_ERROR("Transposed products are only supported for CSR", AF_ERR_NOT_SUPPORTED);
+        }
 
         if (!(optLhs == AF_MAT_NONE ||
               optLhs == AF_MAT_TRANS ||
@@ -104,10 +158,15 @@ af_err af_matmul(af_array *out,
 
     try {
         ArrayInfo lhsInfo = getInfo(lhs, false, true);
-        ArrayInfo rhsInfo = getInfo(rhs, true, true);
 
-        if(lhsInfo.isSparse())
+        if(lhsInfo.isSparse()) {
+            if (getInfo(rhs, false, true).isSparse() &&
+                optLhs == AF_MAT_NONE && optRhs == AF_MAT_NONE)
+                return af_sparse_sparse_matmul(out, lhs, rhs);
             return af_sparse_matmul(out, lhs, rhs, optLhs, optRhs);
+        }
+
+        ArrayInfo rhsInfo = getInfo(rhs, true, true);
 
         af_dtype lhs_type = lhsInfo.getType();
         af_dtype rhs_type = rhsInfo.getType();
@@ -125,18 +184,17 @@ af_err af_matmul(af_array *out,
         }
 
 
-        if (lhsInfo.ndims() > 2 ||
-            rhsInfo.ndims() > 2) {
-            AF_ERROR("matmul can not be used in batch mode", AF_ERR_BATCH);
-        }
-
         TYPE_ASSERT(lhs_type == rhs_type);
         af_array output = 0;
 
         int aColDim = (optLhs == AF_MAT_NONE) ? 1 : 0;
         int bRowDim = (optRhs == AF_MAT_NONE) ? 0 : 1;
 
-        DIM_ASSERT(1, lhsInfo.dims()[aColDim] == rhsInfo.dims()[bRowDim]);
+        af::dim4 lDims = lhsInfo.dims();
+        af::dim4 rDims = rhsInfo.dims();
+
+        DIM_ASSERT(1, lDims[aColDim] == rDims[bRowDim]);
+        checkBatchDims(lDims, rDims);
 
         switch(lhs_type) {
             case f32: output = matmul<float  >(lhs, rhs, optLhs, optRhs);   break;
@@ -151,6 +209,76 @@ af_err af_matmul(af_array *out,
     return AF_SUCCESS;
 }
 
+af_err af_gemm_fused(af_array *C, const af_mat_prop optLhs, const af_mat_prop optRhs,
+                     const void *alpha, const af_array lhs, const af_array rhs,
+                     const void *beta, const af_array bias, const af_activation act)
+{
+    using namespace detail;
+
+    try {
+        ArrayInfo lhsInfo = getInfo(lhs);
+        ArrayInfo rhsInfo = getInfo(rhs);
+
+        ARG_ASSERT(1, optLhs == AF_MAT_NONE || optLhs == AF_MAT_TRANS || optLhs == AF_MAT_CTRANS);
+        ARG_ASSERT(2, optRhs == AF_MAT_NONE || optRhs == AF_MAT_TRANS || optRhs == AF_MAT_CTRANS);
+        ARG_ASSERT(3, alpha != 0);
+        ARG_ASSERT(6, beta != 0);
+        ARG_ASSERT(8, act >= AF_ACTIVATION_NONE && act <= AF_ACTIVATION_TANH);
+
+        af_dtype type = lhsInfo.getType();
+        TYPE_ASSERT(type == rhsInfo.getType());
+
+        af::dim4 lDims = lhsInfo.dims();
+        af::dim4 rDims = rhsInfo.dims();
+
+        int aRowDim = (optLhs == AF_MAT_NONE) ? 0 : 1;
+        int aColDim = (optLhs == AF_MAT_NONE) ? 1 : 0;
+        int bRowDim = (optRhs == AF_MAT_NONE) ? 0 : 1;
+        int bColDim = (optRhs == AF_MAT_NONE) ? 1 : 0;
+
+        DIM_ASSERT(4, lDims[aColDim] == rDims[bRowDim]);
+        checkBatchDims(lDims, rDims);
+
+        const dim_t M = lDims[aRowDim];
+        const dim_t N = rDims[bColDim];
+        af::dim4 odims(M, N, std::max(lDims[2], rDims[2]), std::max(lDims[3], rDims[3]));
+
+        if (*C != 0) {
+            ArrayInfo cInfo = getInfo(*C);
+            TYPE_ASSERT(cInfo.getType() == type);
+            DIM_ASSERT(0, cInfo.dims() == odims);
+        }
+
+        if (bias != 0) {
+            ArrayInfo bInfo = getInfo(bias);
+            TYPE_ASSERT(bInfo.getType() == type);
+            DIM_ASSERT(7, bInfo.dims() == af::dim4(M, 1, 1, 1) ||
+                          bInfo.dims() == af::dim4(1, N, 1, 1));
+        }
+
+        if (type == c32 || type == c64) {
+            ARG_ASSERT(8, act == AF_ACTIVATION_NONE);
+        }
+
+        switch(type) {
+            case f32: gemm<float  >(C, optLhs, optRhs, alpha, lhs, rhs, beta, bias, act, odims); break;
+            case c32: gemm<cfloat >(C, optLhs, optRhs, alpha, lhs, rhs, beta, bias, act, odims); break;
+            case f64: gemm<double >(C, optLhs, optRhs, alpha, lhs, rhs, beta, bias, act, odims); break;
+            case c64: gemm<cdouble>(C, optLhs, optRhs, alpha, lhs, rhs, beta, bias, act, odims); break;
+            default:  TYPE_ERROR(4, type);
+        }
+    }
+    CATCHALL
+    return AF_SUCCESS;
+}
+
+af_err af_gemm(af_array *C, const af_mat_prop optLhs, const af_mat_prop optRhs,
+               const void *alpha, const af_array lhs, const af_array rhs,
+               const void *beta)
+{
+    return af_gemm_fused(C, optLhs, optRhs, alpha, lhs, rhs, beta, 0, AF_ACTIVATION_NONE);
+}
+
 af_err af_dot(af_array *out,
               const af_array lhs, const af_array rhs,
               const af_mat_prop optLhs, const af_mat_prop optRhs)
@@ -15,6 +15,7 @@
 #include <backend.hpp>
 #include <ArrayInfo.hpp>
 #include <cholesky.hpp>
+#include <lu.hpp>
 
 using af::dim4;
 using namespace detail;
@@ -36,7 +37,7 @@ af_err af_cholesky(af_array *out, int *info, const af_array in, const bool is_up
     try {
         ArrayInfo i_info = getInfo(in);
 
-        if (i_info.ndims() > 2) {
+        if (i_info.ndims() > 2 && !isLAPACKBatchAvailable()) {
             AF_ERROR("cholesky can not be used in batch mode", AF_ERR_BATCH);
         }
 
@@ -70,7 +71,7 @@ af_err af_cholesky_inplace(int *info, af_array in, const bool is_upper)
     try {
         ArrayInfo i_info = getInfo(in);
 
-        if (i_info.ndims() > 2) {
+        if (i_info.ndims() > 2 && !isLAPACKBatchAvailable()) {
             AF_ERROR("cholesky can not be used in batch mode", AF_ERR_BATCH);
         }
 
@@ -14,6 +14,8 @@
 #include <backend.hpp>
 #include <convolve.hpp>
 #include <fftconvolve.hpp>
+#include <convolve_cost.hpp>
+#include <util.hpp>
 
 #include <cstdio>
 
@@ -143,8 +145,34 @@ af_err convolve2_sep(af_array *out, af_array col_filter, af_array row_filter, co
 }
 
 
+// Sizes of filters the spatial convolution of the GPU backends supports
 template<int baseDim>
-bool isFreqDomain(const af_array &signal, const af_array filter, af_conv_domain domain)
+bool isSpatialSupported(const dim4 &fdims)
+{
+    if (getBackend() == AF_BACKEND_CPU) return true;
+
+    if (baseDim == 1) {
+        if (fdims[0] > 128) return false;
+    }
+
+    if (baseDim == 2) {
+        // maximum supported size in 2D domain
+        if (fdims[0] > 17 || fdims[1] > 17) return false;
+
+        // Maximum supported non square size
+        if (fdims[0] != fdims[1] && fdims[0] > 5) return false;
+    }
+
+    if (baseDim == 3) {
+        if (fdims[0] > 5 || fdims[1] > 5 || fdims[2] > 5) return false;
+    }
+
+    return true;
+}
+
+template<int baseDim>
+bool isFreqDomain(const af_array &signal, const af_array filter,
+                  const af_conv_mode mode, af_conv_domain domain)
 {
     if (domain == AF_CONV_FREQ) return true;
     if (domain != AF_CONV_AUTO) return false;
@@ -157,36 +185,26 @@ bool isFreqDomain(const af_array &signal, const af_array filter, af_conv_domain
 
     if (identifyBatchKind<baseDim>(sdims, fdims) == AF_BATCH_DIFF) return true;
 
-    int kbatch = 1;
-    for(int i = 3; i >= baseDim; i--) {
-        kbatch *= fdims[i];
-    }
-
-    if (kbatch >= 10) return true;
-
-    if (baseDim == 1) {
-        if (fdims[0] > 128) return true;
-    }
-
-    if (baseDim == 2) {
-        // maximum supported size in 2D domain
-        if (fdims[0] > 17 || fdims[1] > 17) return true;
+    if (!isSpatialSupported<baseDim>(fdims)) return true;
 
-        // Maximum supported non square size
-        if (fdims[0] != fdims[1] && fdims[0] > 5) return true;
+    double spatial, freq;
+    if (estimateConvolveCost(spatial, freq, baseDim, sdims, fdims,
+                             mode == AF_CONV_EXPAND, sInfo.getType())) {
+        return freq < spatial;
     }
 
-    if (baseDim == 3) {
-        if (fdims[0] > 5 || fdims[1] > 5 || fdims[2] > 5) return true;
+    int kbatch = 1;
+    for(int i = 3; i >= baseDim; i--) {
+        kbatch *= fdims[i];
     }
 
-    return false;
+    return kbatch >= 10;
 }
 
 af_err af_convolve1(af_array *out, const af_array signal, const af_array filter, const af_conv_mode mode, af_conv_domain domain)
 {
     try {
-        if (isFreqDomain<1>(signal, filter, domain))
+        if (isFreqDomain<1>(signal, filter, mode, domain))
             return af_fft_convolve1(out, signal, filter, mode);
 
         if (mode == AF_CONV_EXPAND)
@@ -203,7 +221,7 @@ af_err af_convolve2(af_array *out, const af_array signal, const af_array filter,
             return af_convolve1(out, signal, filter, mode, domain);
         }
 
-        if (isFreqDomain<2>(signal, filter, domain))
+        if (isFreqDomain<2>(signal, filter, mode, domain))
             return af_fft_convolve2(out, signal, filter, mode);
 
         if (mode == AF_CONV_EXPAND)
@@ -220,7 +238,7 @@ af_err af_convolve3(af_array *out, const af_array signal, const af_array filter,
             return af_convolve2(out, signal, filter, mode, domain);
         }
 
-        if (isFreqDomain<3>(signal, filter, domain))
+        if (isFreqDomain<3>(signal, filter, mode, domain))
             return af_fft_convolve3(out, signal, filter, mode);
 
         if (mode == AF_CONV_EXPAND)
@@ -239,3 +257,12 @@ af_err af_convolve2_sep(af_array *out, const af_array signal, const af_array col
             return convolve2_sep<false>(out, signal, col_filter, row_filter);
     } CATCHALL;
 }
+
+af_err af_calibrate_convolve(const char *path)
+{
+    try {
+        calibrateConvolveCost(path ? std::string(path) : getEnvVar("AF_CONV_CALIBRATION_FILE"));
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
@@ -0,0 +1,303 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/array.h>
+#include <af/random.h>
+#include <af/device.h>
+#include <af/signal.h>
+#include <err_common.hpp>
+#include <backend.hpp>
+#include <platform.hpp>
+#include <dispatch.hpp>
+#include <util.hpp>
+#include <convolve_cost.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+using af::dim4;
+using std::string;
+using std::vector;
+using namespace detail;
+
+namespace
+{
+
+// f32 and the integer types, which are all convolved in single precision,
+// f64, c32 and c64
+static const int CONV_COST_TYPES = 4;
+
+// Seconds per multiply add of the spatial convolution and per n log2 n of a
+// transform of the frequency domain convolution, by dimension and type
+struct ConvCostModel
+{
+    double spatial[3][CONV_COST_TYPES];
+    double freq[3][CONV_COST_TYPES];
+};
+
+// Single threaded costs on an x86-64 with AVX-512, with FFTW as the FFT
+// library. Used by the CPU backend until it is calibrated.
+static const ConvCostModel cpuDefaultModel = {
+    {{4.4e-11, 7.8e-11, 1.0e-09, 1.5e-09},
+     {4.8e-11, 7.3e-11, 9.7e-10, 1.1e-09},
+     {1.7e-10, 1.7e-10, 1.2e-09, 1.1e-09}},
+    {{5.0e-10, 9.0e-10, 8.0e-10, 1.4e-09},
+     {6.0e-10, 1.1e-09, 1.0e-09, 1.7e-09},
+     {7.5e-10, 1.3e-09, 1.2e-09, 2.1e-09}}
+};
+
+struct ConvCostState
+{
+    std::mutex lock;
+    bool loaded;
+    bool valid;
+    ConvCostModel model;
+
+    ConvCostState() : loaded(false), valid(false), model(cpuDefaultModel) {}
+};
+
+ConvCostState& getConvCostState()
+{
+    static ConvCostState state;
+    return state;
+}
+
+int typeIndex(const af_dtype type)
+{
+    switch (type) {
+        case f64: return 1;
+        case c32: return 2;
+        case c64: return 3;
+        default:  return 0;
+    }
+}
+
+// Multiply adds of the spatial convolution
+double spatialWork(const int baseDim, const dim4 &sdims, const dim4 &fdims, const bool expand)
+{
+    double work = 1;
+    for (int i = 0; i < baseDim; ++i) {
+        work *= (double)fdims[i] * (expand ? sdims[i] + fdims[i] - 1 : sdims[i]);
+    }
+    for (int i = baseDim; i < 4; ++i) work *= std::max(sdims[i], fdims[i]);
+    return work;
+}
+
+// Sum of n log2 n over the forward transforms of the signal and the filter
+// and the inverse transforms of the product
+double freqWork(const int baseDim, const dim4 &sdims, const dim4 &fdims)
+{
+    double n = 1;
+    for (int i = 0; i < baseDim; ++i) n *= nextpow2(sdims[i] + fdims[i] - 1);
+
+    double sbatch = 1, fbatch = 1, obatch = 1;
+    for (int i = baseDim; i < 4; ++i) {
+        sbatch *= sdims[i];
+        fbatch *= fdims[i];
+        obatch *= std::max(sdims[i], fdims[i]);
+    }
+    return n * (std::log2(n) + 1) * (sbatch + fbatch + obatch);
+}
+
+// Best time out of a few runs of a convolution, after one warm up run
+double timeConvolve(const bool freq, const int baseDim, const af_array signal, const af_array filter)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < 4; ++run) {
+        AF_CHECK(af_sync(-1));
+        auto start = std::chrono::steady_clock::now();
+
+        af_array out = 0;
+        switch (baseDim + (freq ? 3 : 0)) {
+            case 1: AF_CHECK(af_convolve1(&out, signal, filter, AF_CONV_DEFAULT, AF_CONV_SPATIAL)); break;
+            case 2: AF_CHECK(af_convolve2(&out, signal, filter, AF_CONV_DEFAULT, AF_CONV_SPATIAL)); break;
+            case 3: AF_CHECK(af_convolve3(&out, signal, filter, AF_CONV_DEFAULT, AF_CONV_SPATIAL)); break;
+            case 4: AF_CHECK(af_fft_convolve1(&out, signal, filter, AF_CONV_DEFAULT));              break;
+            case 5: AF_CHECK(af_fft_convolve2(&out, signal, filter, AF_CONV_DEFAULT));              break;
+            case 6: AF_CHECK(af_fft_convolve3(&out, signal, filter, AF_CONV_DEFAULT));              break;
+        }
+        try {
+            AF_CHECK(af_eval(out));
+            AF_CHECK(af_sync(-1));
+        } catch (...) {
+            af_release_array(out);
+            throw;
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        AF_CHECK(af_release_array(out));
+        if (run > 0) best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+ConvCostModel calibrate()
+{
+    // Problems close to where the two methods break even
+    static const dim_t signals[3][4] = {{1 << 16, 1, 1, 1}, {512, 512, 1, 1}, {48, 48, 48, 1}};
+    static const dim_t filters[3][4] = {{33, 1, 1, 1}, {9, 9, 1, 1}, {5, 5, 5, 1}};
+    static const af_dtype types[CONV_COST_TYPES] = {f32, f64, c32, c64};
+
+    // Types the device can not convolve keep the built in costs
+    const bool doubles = isDoubleSupported(getActiveDeviceId());
+
+    // The problems come from an engine of their own, so that calibrating
+    // does not move the sequence of the default random engine
+    af_random_engine engine = 0;
+    AF_CHECK(af_create_random_engine(&engine, AF_RANDOM_ENGINE_DEFAULT, 0));
+
+    ConvCostModel model = cpuDefaultModel;
+    try {
+        for (int d = 0; d < 3; ++d) {
+            const dim4 sdims(4, signals[d]);
+            const dim4 fdims(4, filters[d]);
+            for (int t = 0; t < CONV_COST_TYPES; ++t) {
+                if (!doubles && (types[t] == f64 || types[t] == c64)) continue;
+
+                af_array signal = 0, filter = 0;
+                try {
+                    AF_CHECK(af_random_uniform(&signal, d + 1, signals[d], types[t], engine));
+                    AF_CHECK(af_random_uniform(&filter, d + 1, filters[d], types[t], engine));
+
+                    const double spatial = timeConvolve(false, d + 1, signal, filter);
+                    const double freq    = timeConvolve(true , d + 1, signal, filter);
+                    model.spatial[d][t] = spatial / spatialWork(d + 1, sdims, fdims, false);
+                    model.freq[d][t]    = freq / freqWork(d + 1, sdims, fdims);
+                } catch (...) {
+                    if (signal) af_release_array(signal);
+                    if (filter) af_release_array(filter);
+                    throw;
+                }
+
+                AF_CHECK(af_release_array(signal));
+                AF_CHECK(af_release_array(filter));
+            }
+        }
+    } catch (...) {
+        af_release_random_engine(engine);
+        throw;
+    }
+
+    AF_CHECK(af_release_random_engine(engine));
+    return model;
+}
+
+// Lines of the file are "backend dims type spatial freq". Entries of other
+// backends are left untouched.
+bool readModel(ConvCostModel &model, const string &path)
+{
+    std::ifstream file(path.c_str());
+    if (!file) return false;
+
+    int found = 0;
+    string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream entry(line);
+        int backend, dims, type;
+        double spatial, freq;
+        if (!(entry >> backend >> dims >> type >> spatial >> freq)) continue;
+        if (backend != getBackend()) continue;
+        if (dims < 1 || dims > 3 || type < 0 || type >= CONV_COST_TYPES) continue;
+        model.spatial[dims - 1][type] = spatial;
+        model.freq[dims - 1][type]    = freq;
+        ++found;
+    }
+    return found == 3 * CONV_COST_TYPES;
+}
+
+void writeModel(const ConvCostModel &model, const string &path)
+{
+    vector<string> others;
+    {
+        std::ifstream file(path.c_str());
+        string line;
+        while (file && std::getline(file, line)) {
+            int backend;
+            std::istringstream entry(line);
+            if (line.empty() || line[0] == '#') continue;
+            if ((entry >> backend) && backend == getBackend()) continue;
+            others.push_back(line);
+        }
+    }
+
+    std::ofstream file(path.c_str(), std::ios::trunc);
+    if (!file) {
+        AF_ERROR("Unable to write the convolution calibration file", AF_ERR_ARG);
+    }
+    file << "# ArrayFire convolution cost model: backend dims type spatial freq\n";
+    for (size_t i = 0; i < others.size(); ++i) file << others[i] << "\n";
+    file.precision(6);
+    for (int d = 0; d < 3; ++d) {
+        for (int t = 0; t < CONV_COST_TYPES; ++t) {
+            file << getBackend() << " " << d + 1 << " " << t << " "
+                 << model.spatial[d][t] << " " << model.freq[d][t] << "\n";
+        }
+    }
+}
+
+}
+
+bool estimateConvolveCost(double &spatial, double &freq,
+                          const int baseDim, const dim4 &sdims, const dim4 &fdims,
+                          const bool expand, const af_dtype type)
+{
+    ConvCostState &state = getConvCostState();
+    std::lock_guard<std::mutex> guard(state.lock);
+
+    if (!state.loaded) {
+        state.loaded = true;
+        state.valid  = (getBackend() == AF_BACKEND_CPU);
+
+        const string path = getEnvVar("AF_CONV_CALIBRATION_FILE");
+        if (!path.empty()) {
+            ConvCostModel model = state.model;
+            if (readModel(model, path)) {
+                state.model = model;
+                state.valid = true;
+            } else {
+                // A calibration that fails, or a file that can not be
+                // written, does not fail the convolution. Without a model,
+                // the caller falls back to its own heuristic.
+                try {
+                    model = calibrate();
+                    state.model = model;
+                    state.valid = true;
+                    writeModel(state.model, path);
+                } catch (...) {
+                }
+            }
+        }
+    }
+
+    if (!state.valid) return false;
+
+    const int t = typeIndex(type);
+    spatial = state.model.spatial[baseDim - 1][t] * spatialWork(baseDim, sdims, fdims, expand);
+    freq    = state.model.freq[baseDim - 1][t] * freqWork(baseDim, sdims, fdims);
+    return true;
+}
+
+void calibrateConvolveCost(const string &path)
+{
+    ConvCostModel model = calibrate();
+    if (!path.empty()) writeModel(model, path);
+
+    ConvCostState &state = getConvCostState();
+    std::lock_guard<std::mutex> guard(state.lock);
+    state.model  = model;
+    state.loaded = true;
+    state.valid  = true;
+}
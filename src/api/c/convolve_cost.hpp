@@ -0,0 +1,29 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <af/dim4.hpp>
+#include <string>
+
+// Estimated run times, in seconds, of the spatial and the frequency domain
+// convolution of a baseDim dimensional signal with a filter on the active
+// backend. Returns false when the backend has neither been calibrated nor
+// has a built in model.
+//
+// The model is loaded once from the file named by AF_CONV_CALIBRATION_FILE.
+// When that file holds no entry for the active backend, the backend is
+// calibrated and the file is written back.
+bool estimateConvolveCost(double &spatial, double &freq,
+                          const int baseDim, const af::dim4 &sdims, const af::dim4 &fdims,
+                          const bool expand, const af_dtype type);
+
+// Times both convolutions on the active backend, replaces the model with the
+// results and stores them in path when it is not empty
+void calibrateConvolveCost(const std::string &path);
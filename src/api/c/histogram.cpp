@@ -59,3 +59,64 @@ af_err af_histogram(af_array *out, const af_array in,
 
     return AF_SUCCESS;
 }
+
+template<typename inType, typename outType>
+static inline af_array weightedHistogram(const af_array in, const af_array weights,
+                                         const unsigned &nbins,
+                                         const double &minval, const double &maxval)
+{
+    return getHandle(weightedHistogram<inType, outType>(getArray<inType>(in),
+                                                        getArray<outType>(weights),
+                                                        nbins, minval, maxval));
+}
+
+template<typename outType>
+static af_array weightedHistogram(const af_array in, const af_array weights,
+                                  const unsigned nbins, const double minval, const double maxval)
+{
+    af_dtype type = getInfo(in).getType();
+
+    af_array output = 0;
+    switch(type) {
+        case f32: output = weightedHistogram<float , outType>(in, weights, nbins, minval, maxval); break;
+        case f64: output = weightedHistogram<double, outType>(in, weights, nbins, minval, maxval); break;
+        case b8 : output = weightedHistogram<char  , outType>(in, weights, nbins, minval, maxval); break;
+        case s32: output = weightedHistogram<int   , outType>(in, weights, nbins, minval, maxval); break;
+        case u32: output = weightedHistogram<uint  , outType>(in, weights, nbins, minval, maxval); break;
+        case s16: output = weightedHistogram<short , outType>(in, weights, nbins, minval, maxval); break;
+        case u16: output = weightedHistogram<ushort, outType>(in, weights, nbins, minval, maxval); break;
+        case s64: output = weightedHistogram<intl  , outType>(in, weights, nbins, minval, maxval); break;
+        case u64: output = weightedHistogram<uintl , outType>(in, weights, nbins, minval, maxval); break;
+        case u8 : output = weightedHistogram<uchar , outType>(in, weights, nbins, minval, maxval); break;
+        default : TYPE_ERROR(1, type);
+    }
+    return output;
+}
+
+af_err af_weighted_histogram(af_array *out, const af_array in, const af_array weights,
+                             const unsigned nbins, const double minval, const double maxval)
+{
+    try {
+        ArrayInfo info   = getInfo(in);
+        ArrayInfo w_info = getInfo(weights);
+        af_dtype w_type  = w_info.getType();
+
+        if(info.ndims() == 0) {
+            return af_retain_array(out, in);
+        }
+
+        ARG_ASSERT(3, nbins > 0);
+        DIM_ASSERT(2, info.dims() == w_info.dims());
+
+        af_array output;
+        switch(w_type) {
+            case f32: output = weightedHistogram<float >(in, weights, nbins, minval, maxval); break;
+            case f64: output = weightedHistogram<double>(in, weights, nbins, minval, maxval); break;
+            default : TYPE_ERROR(2, w_type);
+        }
+        std::swap(*out,output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
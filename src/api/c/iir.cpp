@@ -99,3 +99,39 @@ af_err af_iir(af_array *y, const af_array b, const af_array a, const af_array x)
     } CATCHALL;
     return AF_SUCCESS;
 }
+
+template<typename T>
+inline static af_array iirSos(const af_array sos, const af_array x)
+{
+    return getHandle(iirSos<T>(getArray<T>(sos),
+                               getArray<T>(x)));
+}
+
+af_err af_iir_sos(af_array *y, const af_array sos, const af_array x)
+{
+    try {
+        ArrayInfo sinfo = getInfo(sos);
+        ArrayInfo xinfo = getInfo(x);
+
+        af_dtype xtype = xinfo.getType();
+
+        ARG_ASSERT(1, sinfo.getType() == xtype);
+        ARG_ASSERT(1, sinfo.dims()[0] == 6 && sinfo.ndims() <= 2);
+
+        if(xinfo.ndims() == 0) {
+            return af_retain_array(y, x);
+        }
+
+        af_array res;
+        switch (xtype) {
+        case f32: res = iirSos<float  >(sos, x); break;
+        case f64: res = iirSos<double >(sos, x); break;
+        case c32: res = iirSos<cfloat >(sos, x); break;
+        case c64: res = iirSos<cdouble>(sos, x); break;
+        default: TYPE_ERROR(2, xtype);
+        }
+
+        std::swap(*y, res);
+    } CATCHALL;
+    return AF_SUCCESS;
+}
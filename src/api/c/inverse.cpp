@@ -15,6 +15,7 @@
 #include <backend.hpp>
 #include <ArrayInfo.hpp>
 #include <inverse.hpp>
+#include <lu.hpp>
 
 using af::dim4;
 using namespace detail;
@@ -30,7 +31,7 @@ af_err af_inverse(af_array *out, const af_array in, const af_mat_prop options)
     try {
         ArrayInfo i_info = getInfo(in);
 
-        if (i_info.ndims() > 2) {
+        if (i_info.ndims() > 2 && !isLAPACKBatchAvailable()) {
             AF_ERROR("solve can not be used in batch mode", AF_ERR_BATCH);
         }
 
@@ -122,6 +122,8 @@ static void printSparse(const char *exp, af_array arr, const int precision,
         case AF_STORAGE_CSR  : os << "AF_STORAGE_CSR\n";      break;
         case AF_STORAGE_CSC  : os << "AF_STORAGE_CSC\n";      break;
         case AF_STORAGE_COO  : os << "AF_STORAGE_COO\n";      break;
+        case AF_STORAGE_BSR  : os << "AF_STORAGE_BSR\n";      break;
+        case AF_STORAGE_SELL : os << "AF_STORAGE_SELL\n";     break;
     }
     os << "[" << sparse.dims() << "]\n";
 
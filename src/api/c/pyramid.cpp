@@ -0,0 +1,66 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/dim4.hpp>
+#include <af/defines.h>
+#include <af/image.h>
+#include <handle.hpp>
+#include <backend.hpp>
+#include <pyramid.hpp>
+#include <err_common.hpp>
+#include <algorithm>
+#include <vector>
+
+using af::dim4;
+using namespace detail;
+
+template<typename T>
+static inline void pyramid(af_array *out, const af_array in, const unsigned levels,
+                           const bool laplacian)
+{
+    std::vector<Array<T> > res = pyramid<T>(getArray<T>(in), levels, laplacian);
+    for (unsigned l = 0; l < levels; l++) {
+        out[l] = getHandle(res[l]);
+    }
+}
+
+static af_err pyramid(af_array *out, const af_array in, const unsigned levels, const bool laplacian)
+{
+    try {
+        ARG_ASSERT(2, levels > 0);
+        ARG_ASSERT(0, out != NULL);
+
+        ArrayInfo info = getInfo(in);
+        af_dtype type  = info.getType();
+        af::dim4 dims  = info.dims();
+
+        DIM_ASSERT(1, (dims.ndims()>=2));
+
+        std::vector<af_array> output(levels);
+        switch(type) {
+            case f32: pyramid<float >(&output.front(), in, levels, laplacian); break;
+            case f64: pyramid<double>(&output.front(), in, levels, laplacian); break;
+            default : TYPE_ERROR(1, type);
+        }
+        std::copy(output.begin(), output.end(), out);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_pyramid_gaussian(af_array *out, const af_array in, const unsigned levels)
+{
+    return pyramid(out, in, levels, false);
+}
+
+af_err af_pyramid_laplacian(af_array *out, const af_array in, const unsigned levels)
+{
+    return pyramid(out, in, levels, true);
+}
@@ -15,6 +15,7 @@
 #include <backend.hpp>
 #include <ArrayInfo.hpp>
 #include <qr.hpp>
+#include <lu.hpp>
 
 using af::dim4;
 using namespace detail;
@@ -44,7 +45,7 @@ af_err af_qr(af_array *q, af_array *r, af_array *tau, const af_array in)
     try {
         ArrayInfo i_info = getInfo(in);
 
-        if (i_info.ndims() > 2) {
+        if (i_info.ndims() > 2 && !isLAPACKBatchAvailable()) {
             AF_ERROR("qr can not be used in batch mode", AF_ERR_BATCH);
         }
 
@@ -78,7 +79,7 @@ af_err af_qr_inplace(af_array *tau, af_array in)
     try {
         ArrayInfo i_info = getInfo(in);
 
-        if (i_info.ndims() > 2) {
+        if (i_info.ndims() > 2 && !isLAPACKBatchAvailable()) {
             AF_ERROR("qr can not be used in batch mode", AF_ERR_BATCH);
         }
 
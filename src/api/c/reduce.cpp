@@ -17,6 +17,7 @@
 #include <backend.hpp>
 #include <reduce.hpp>
 #include <ireduce.hpp>
+#include <reduce_by_key.hpp>
 #include <math.hpp>
 
 using af::dim4;
@@ -520,3 +521,151 @@ af_err af_product_nan_all(double *real, double *imag, const af_array in, const d
 {
     return reduce_all_promote<af_mul_t>(real, imag, in, true, nanval);
 }
+
+template<af_op_t op, typename Ti, typename Tk, typename To>
+static inline void reduce_key(af_array *keys_out, af_array *vals_out,
+                              const af_array keys, const af_array vals,
+                              const int dim, const bool is_sorted)
+{
+    Array<Tk> okeys = createEmptyArray<Tk>(dim4());
+    Array<To> ovals = createEmptyArray<To>(dim4());
+
+    reduce_by_key<op, Ti, Tk, To>(okeys, ovals,
+                                  getArray<Tk>(keys), castArray<Ti>(vals),
+                                  dim, is_sorted);
+
+    *keys_out = getHandle(okeys);
+    *vals_out = getHandle(ovals);
+}
+
+template<af_op_t op, typename Ti, typename To>
+static inline void reduce_key(af_array *keys_out, af_array *vals_out,
+                              const af_array keys, const af_array vals,
+                              const int dim, const bool is_sorted)
+{
+    af_dtype type = getInfo(keys).getType();
+
+    switch(type) {
+    case s32: reduce_key<op, Ti, int  , To>(keys_out, vals_out, keys, vals, dim, is_sorted); break;
+    case u32: reduce_key<op, Ti, uint , To>(keys_out, vals_out, keys, vals, dim, is_sorted); break;
+    case s64: reduce_key<op, Ti, intl , To>(keys_out, vals_out, keys, vals, dim, is_sorted); break;
+    case u64: reduce_key<op, Ti, uintl, To>(keys_out, vals_out, keys, vals, dim, is_sorted); break;
+    default:  TYPE_ERROR(2, type);
+    }
+}
+
+template<af_op_t op>
+static af_err reduce_by_key_common(af_array *keys_out, af_array *vals_out,
+                                   const af_array keys, const af_array vals,
+                                   const int dim, const bool is_sorted)
+{
+    try {
+
+        ARG_ASSERT(4, dim >= 0);
+        ARG_ASSERT(4, dim <  4);
+
+        const ArrayInfo keys_info = getInfo(keys);
+        const ArrayInfo vals_info = getInfo(vals);
+
+        if (vals_info.isEmpty()) {
+            *keys_out = retain(keys);
+            *vals_out = retain(vals);
+            return AF_SUCCESS;
+        }
+
+        ARG_ASSERT(2, keys_info.isVector());
+        ARG_ASSERT(2, (dim_t)keys_info.elements() == vals_info.dims()[dim]);
+
+        af_dtype type = vals_info.getType();
+        af_array okeys, ovals;
+
+        switch(type) {
+        case f32: reduce_key<op, float  , float  >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case f64: reduce_key<op, double , double >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case c32: reduce_key<op, cfloat , cfloat >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case c64: reduce_key<op, cdouble, cdouble>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case u32: reduce_key<op, uint   , uint   >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case s32: reduce_key<op, int    , int    >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case u64: reduce_key<op, uintl  , uintl  >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case s64: reduce_key<op, intl   , intl   >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case u16: reduce_key<op, uint   , uint   >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case s16: reduce_key<op, int    , int    >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case u8:  reduce_key<op, uint   , uint   >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case b8:  reduce_key<op, uint   , uint   >(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        default:  TYPE_ERROR(3, type);
+        }
+
+        std::swap(*keys_out, okeys);
+        std::swap(*vals_out, ovals);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_reduce_by_key(af_array *keys_out, af_array *vals_out,
+                        const af_array keys, const af_array vals,
+                        const int dim, const af_binary_op op, const bool is_sorted)
+{
+    try {
+        switch(op) {
+        case AF_BINARY_ADD: return reduce_by_key_common<af_add_t>(keys_out, vals_out, keys, vals, dim, is_sorted);
+        case AF_BINARY_MUL: return reduce_by_key_common<af_mul_t>(keys_out, vals_out, keys, vals, dim, is_sorted);
+        case AF_BINARY_MIN: return reduce_by_key_common<af_min_t>(keys_out, vals_out, keys, vals, dim, is_sorted);
+        case AF_BINARY_MAX: return reduce_by_key_common<af_max_t>(keys_out, vals_out, keys, vals, dim, is_sorted);
+        default:
+            AF_ERROR("Incorrect binary operation enum for argument number 5", AF_ERR_ARG); break;
+        }
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_count_by_key(af_array *keys_out, af_array *vals_out,
+                       const af_array keys, const af_array vals,
+                       const int dim, const bool is_sorted)
+{
+    try {
+
+        ARG_ASSERT(4, dim >= 0);
+        ARG_ASSERT(4, dim <  4);
+
+        const ArrayInfo keys_info = getInfo(keys);
+        const ArrayInfo vals_info = getInfo(vals);
+
+        if (vals_info.isEmpty()) {
+            *keys_out = retain(keys);
+            *vals_out = retain(vals);
+            return AF_SUCCESS;
+        }
+
+        ARG_ASSERT(2, keys_info.isVector());
+        ARG_ASSERT(2, (dim_t)keys_info.elements() == vals_info.dims()[dim]);
+
+        af_dtype type = vals_info.getType();
+        af_array okeys, ovals;
+
+        switch(type) {
+        case f32: reduce_key<af_notzero_t, float  , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case f64: reduce_key<af_notzero_t, double , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case c32: reduce_key<af_notzero_t, cfloat , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case c64: reduce_key<af_notzero_t, cdouble, uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case u32: reduce_key<af_notzero_t, uint   , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case s32: reduce_key<af_notzero_t, int    , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case u64: reduce_key<af_notzero_t, uintl  , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case s64: reduce_key<af_notzero_t, intl   , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case u16: reduce_key<af_notzero_t, uint   , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case s16: reduce_key<af_notzero_t, int    , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case u8:  reduce_key<af_notzero_t, uint   , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        case b8:  reduce_key<af_notzero_t, uint   , uint>(&okeys, &ovals, keys, vals, dim, is_sorted); break;
+        default:  TYPE_ERROR(3, type);
+        }
+
+        std::swap(*keys_out, okeys);
+        std::swap(*vals_out, ovals);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
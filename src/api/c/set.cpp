@@ -157,3 +157,192 @@ af_err af_set_intersect(af_array *out, const af_array first, const af_array seco
 
     return AF_SUCCESS;
 }
+
+template<typename T>
+static inline af_array setUniqueStable(const af_array in)
+{
+    return getHandle(setUniqueStable(getArray<T>(in)));
+}
+
+af_err af_set_unique_stable(af_array *out, const af_array in)
+{
+    try {
+
+        ArrayInfo in_info = getInfo(in);
+        if(in_info.isEmpty()) {
+            return af_retain_array(out, in);
+        }
+        ARG_ASSERT(1, in_info.isVector());
+        af_dtype type = in_info.getType();
+
+        af_array res;
+        switch(type) {
+        case f32: res = setUniqueStable<float  >(in); break;
+        case f64: res = setUniqueStable<double >(in); break;
+        case s32: res = setUniqueStable<int    >(in); break;
+        case u32: res = setUniqueStable<uint   >(in); break;
+        case s16: res = setUniqueStable<short  >(in); break;
+        case u16: res = setUniqueStable<ushort >(in); break;
+        case s64: res = setUniqueStable<intl   >(in); break;
+        case u64: res = setUniqueStable<uintl  >(in); break;
+        case b8:  res = setUniqueStable<char   >(in); break;
+        case u8:  res = setUniqueStable<uchar  >(in); break;
+        default: TYPE_ERROR(1, type);
+        }
+
+        std::swap(*out, res);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+template<typename T>
+static inline af_array setUnionStable(const af_array first, const af_array second)
+{
+    return getHandle(setUnionStable(getArray<T>(first), getArray<T>(second)));
+}
+
+af_err af_set_union_stable(af_array *out, const af_array first, const af_array second)
+{
+    try {
+
+        ArrayInfo first_info = getInfo(first);
+        ArrayInfo second_info = getInfo(second);
+
+        if(first_info.isEmpty()) {
+            return af_set_unique_stable(out, second);
+        }
+
+        if(second_info.isEmpty()) {
+            return af_set_unique_stable(out, first);
+        }
+
+        ARG_ASSERT(1, first_info.isVector());
+        ARG_ASSERT(2, second_info.isVector());
+
+        af_dtype first_type = first_info.getType();
+        af_dtype second_type = second_info.getType();
+
+        ARG_ASSERT(2, first_type == second_type);
+
+        af_array res;
+        switch(first_type) {
+        case f32: res = setUnionStable<float  >(first, second); break;
+        case f64: res = setUnionStable<double >(first, second); break;
+        case s32: res = setUnionStable<int    >(first, second); break;
+        case u32: res = setUnionStable<uint   >(first, second); break;
+        case s16: res = setUnionStable<short  >(first, second); break;
+        case u16: res = setUnionStable<ushort >(first, second); break;
+        case s64: res = setUnionStable<intl   >(first, second); break;
+        case u64: res = setUnionStable<uintl  >(first, second); break;
+        case b8:  res = setUnionStable<char   >(first, second); break;
+        case u8:  res = setUnionStable<uchar  >(first, second); break;
+        default: TYPE_ERROR(1, first_type);
+        }
+
+        std::swap(*out, res);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+template<typename T>
+static inline af_array setIntersectStable(const af_array first, const af_array second)
+{
+    return getHandle(setIntersectStable(getArray<T>(first), getArray<T>(second)));
+}
+
+af_err af_set_intersect_stable(af_array *out, const af_array first, const af_array second)
+{
+    try {
+
+        ArrayInfo first_info = getInfo(first);
+        ArrayInfo second_info = getInfo(second);
+
+        if(first_info.isEmpty()) {
+            return af_retain_array(out, first);
+        }
+
+        if(second_info.isEmpty()) {
+            return af_retain_array(out, second);
+        }
+
+        ARG_ASSERT(1, first_info.isVector());
+        ARG_ASSERT(2, second_info.isVector());
+
+        af_dtype first_type = first_info.getType();
+        af_dtype second_type = second_info.getType();
+
+        ARG_ASSERT(2, first_type == second_type);
+
+        af_array res;
+        switch(first_type) {
+        case f32: res = setIntersectStable<float  >(first, second); break;
+        case f64: res = setIntersectStable<double >(first, second); break;
+        case s32: res = setIntersectStable<int    >(first, second); break;
+        case u32: res = setIntersectStable<uint   >(first, second); break;
+        case s16: res = setIntersectStable<short  >(first, second); break;
+        case u16: res = setIntersectStable<ushort >(first, second); break;
+        case s64: res = setIntersectStable<intl   >(first, second); break;
+        case u64: res = setIntersectStable<uintl  >(first, second); break;
+        case b8:  res = setIntersectStable<char   >(first, second); break;
+        case u8:  res = setIntersectStable<uchar  >(first, second); break;
+        default: TYPE_ERROR(1, first_type);
+        }
+
+        std::swap(*out, res);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+template<typename T>
+static inline af_array setContains(const af_array elements, const af_array set)
+{
+    return getHandle(setContains(getArray<T>(elements), getArray<T>(set)));
+}
+
+af_err af_set_contains(af_array *out, const af_array elements, const af_array set)
+{
+    try {
+
+        ArrayInfo elements_info = getInfo(elements);
+        ArrayInfo set_info = getInfo(set);
+
+        af_dtype elements_type = elements_info.getType();
+        af_dtype set_type = set_info.getType();
+
+        ARG_ASSERT(2, elements_type == set_type);
+
+        af_array res;
+        if(elements_info.isEmpty()) {
+            res = getHandle(createEmptyArray<char>(dim4(0)));
+            std::swap(*out, res);
+            return AF_SUCCESS;
+        }
+
+        if(set_info.isEmpty()) {
+            res = getHandle(createValueArray<char>(elements_info.dims(), 0));
+            std::swap(*out, res);
+            return AF_SUCCESS;
+        }
+
+        switch(elements_type) {
+        case f32: res = setContains<float  >(elements, set); break;
+        case f64: res = setContains<double >(elements, set); break;
+        case s32: res = setContains<int    >(elements, set); break;
+        case u32: res = setContains<uint   >(elements, set); break;
+        case s16: res = setContains<short  >(elements, set); break;
+        case u16: res = setContains<ushort >(elements, set); break;
+        case s64: res = setContains<intl   >(elements, set); break;
+        case u64: res = setContains<uintl  >(elements, set); break;
+        case b8:  res = setContains<char   >(elements, set); break;
+        case u8:  res = setContains<uchar  >(elements, set); break;
+        default: TYPE_ERROR(1, elements_type);
+        }
+
+        std::swap(*out, res);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
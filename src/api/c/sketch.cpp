@@ -0,0 +1,423 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/dim4.hpp>
+#include <af/defines.h>
+#include <af/statistics.h>
+#include <af/index.h>
+#include <af/data.h>
+#include <af/arith.h>
+#include <handle.hpp>
+#include <err_common.hpp>
+#include <backend.hpp>
+#include <sketch.hpp>
+#include <vector>
+
+using namespace detail;
+using af::dim4;
+
+// The sketches are built on the host. Inputs are copied over in chunks of
+// this many elements so that huge arrays do not need a full host copy.
+static const dim_t SKETCH_CHUNK = 1 << 22;
+
+// Calls fn(ptr, count) for consecutive chunks of the elements of in
+template<typename T, typename Func>
+static void forEachChunk(const af_array in, Func fn)
+{
+    const dim_t nElems = getInfo(in).elements();
+    if (nElems == 0) return;
+
+    std::vector<T> buffer(std::min(nElems, SKETCH_CHUNK));
+
+    if (nElems <= SKETCH_CHUNK) {
+        copyData(&buffer.front(), in);
+        fn(&buffer.front(), nElems);
+        return;
+    }
+
+    af_array flat = 0;
+    dim_t fdims[] = {nElems};
+    AF_CHECK(af_moddims(&flat, in, 1, fdims));
+
+    af_array part = 0;
+    try {
+        for (dim_t off = 0; off < nElems; off += SKETCH_CHUNK) {
+            const dim_t len = std::min(SKETCH_CHUNK, nElems - off);
+            af_seq s = af_make_seq(off, off + len - 1, 1);
+
+            AF_CHECK(af_index(&part, flat, 1, &s));
+            copyData(&buffer.front(), part);
+            AF_CHECK(af_release_array(part));
+            part = 0;
+
+            fn(&buffer.front(), len);
+        }
+    } catch (...) {
+        if (part) af_release_array(part);
+        af_release_array(flat);
+        throw;
+    }
+
+    AF_CHECK(af_release_array(flat));
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Quantile sketch
+///////////////////////////////////////////////////////////////////////////
+
+// Adds the centroids of a quantile sketch to digest
+static void addSketch(sketch::TDigest &digest, const af_array in)
+{
+    const ArrayInfo info = getInfo(in);
+    const dim_t count = info.dims()[0];
+    if (info.elements() == 0) return;
+
+    std::vector<double> data(info.elements());
+    copyData(&data.front(), in);
+    for (dim_t i = 0; i < count; ++i) {
+        digest.add(data[i], data[count + i]);
+    }
+}
+
+static af_array getSketch(sketch::TDigest &digest)
+{
+    const std::vector<sketch::Centroid> &centroids = digest.get();
+    const dim_t count = centroids.size();
+
+    if (count == 0) return createHandle<double>(dim4(0, 2));
+
+    std::vector<double> data(2 * count);
+    for (dim_t i = 0; i < count; ++i) {
+        data[i]         = centroids[i].mean;
+        data[count + i] = centroids[i].weight;
+    }
+    return createHandleFromData<double>(dim4(count, 2), &data.front());
+}
+
+template<typename T>
+static af_array quantileSketch(const af_array in, const double compression)
+{
+    sketch::TDigest digest(compression);
+    forEachChunk<T>(in, [&](const T *ptr, dim_t len) {
+        for (dim_t i = 0; i < len; ++i) digest.add((double)ptr[i], 1.0);
+    });
+    return getSketch(digest);
+}
+
+static void checkQuantileSketch(const int argId, const af_array sketch)
+{
+    const ArrayInfo info = getInfo(sketch);
+    ARG_ASSERT(argId, info.getType() == f64);
+    ARG_ASSERT(argId, info.dims()[1] == 2 && info.dims()[2] == 1 && info.dims()[3] == 1);
+}
+
+af_err af_quantile_sketch(af_array *out, const af_array in, const double compression)
+{
+    try {
+        ArrayInfo info = getInfo(in);
+        af_dtype type = info.getType();
+
+        ARG_ASSERT(2, compression >= 10);
+
+        af_array output = 0;
+        switch(type) {
+            case f32: output = quantileSketch<float >(in, compression); break;
+            case f64: output = quantileSketch<double>(in, compression); break;
+            case s32: output = quantileSketch<int   >(in, compression); break;
+            case u32: output = quantileSketch<uint  >(in, compression); break;
+            case s64: output = quantileSketch<intl  >(in, compression); break;
+            case u64: output = quantileSketch<uintl >(in, compression); break;
+            case s16: output = quantileSketch<short >(in, compression); break;
+            case u16: output = quantileSketch<ushort>(in, compression); break;
+            case u8:  output = quantileSketch<uchar >(in, compression); break;
+            case b8:  output = quantileSketch<char  >(in, compression); break;
+            default:  TYPE_ERROR(1, type);
+        }
+        std::swap(*out, output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_quantile_sketch_merge(af_array *out, const af_array lhs, const af_array rhs,
+                                const double compression)
+{
+    try {
+        checkQuantileSketch(1, lhs);
+        checkQuantileSketch(2, rhs);
+        ARG_ASSERT(3, compression >= 10);
+
+        sketch::TDigest digest(compression);
+        addSketch(digest, lhs);
+        addSketch(digest, rhs);
+
+        af_array output = getSketch(digest);
+        std::swap(*out, output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+template<typename T>
+static af_array quantileQuery(const af_array sketch, const af_array probs)
+{
+    const ArrayInfo s_info = getInfo(sketch);
+    const ArrayInfo p_info = getInfo(probs);
+    const dim_t count = s_info.dims()[0];
+
+    std::vector<double> data(s_info.elements());
+    if (count > 0) copyData(&data.front(), sketch);
+
+    std::vector<T> h_probs(p_info.elements());
+    std::vector<double> result(p_info.elements());
+    if (h_probs.empty()) return createHandle<double>(p_info.dims());
+
+    copyData(&h_probs.front(), probs);
+    for (size_t i = 0; i < h_probs.size(); ++i) {
+        const double q = h_probs[i];
+        ARG_ASSERT(2, q >= 0 && q <= 1);
+        result[i] = sketch::quantile(count ? &data.front()         : NULL,
+                                     count ? &data.front() + count : NULL,
+                                     count, q);
+    }
+
+    return createHandleFromData<double>(p_info.dims(), &result.front());
+}
+
+af_err af_quantile_sketch_query(af_array *out, const af_array sketch, const af_array probs)
+{
+    try {
+        checkQuantileSketch(1, sketch);
+
+        af_dtype type = getInfo(probs).getType();
+
+        af_array output = 0;
+        switch(type) {
+            case f32: output = quantileQuery<float >(sketch, probs); break;
+            case f64: output = quantileQuery<double>(sketch, probs); break;
+            default:  TYPE_ERROR(2, type);
+        }
+        std::swap(*out, output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Distinct count sketch
+///////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+static af_array distinctSketch(const af_array in, const unsigned precision)
+{
+    std::vector<uchar> registers(1 << precision, 0);
+    forEachChunk<T>(in, [&](const T *ptr, dim_t len) {
+        for (dim_t i = 0; i < len; ++i) {
+            sketch::hllAdd(&registers.front(), precision, sketch::hashValue(ptr[i]));
+        }
+    });
+    return createHandleFromData<uchar>(dim4(registers.size()), &registers.front());
+}
+
+static void checkDistinctSketch(const int argId, const af_array sketch)
+{
+    const ArrayInfo info = getInfo(sketch);
+    const dim_t m = info.elements();
+    ARG_ASSERT(argId, info.getType() == u8);
+    ARG_ASSERT(argId, info.isVector());
+    ARG_ASSERT(argId, m >= 16 && m <= (1 << 18) && (m & (m - 1)) == 0);
+}
+
+af_err af_distinct_sketch(af_array *out, const af_array in, const unsigned precision)
+{
+    try {
+        ArrayInfo info = getInfo(in);
+        af_dtype type = info.getType();
+
+        ARG_ASSERT(2, precision >= 4 && precision <= 18);
+
+        af_array output = 0;
+        switch(type) {
+            case f32: output = distinctSketch<float >(in, precision); break;
+            case f64: output = distinctSketch<double>(in, precision); break;
+            case s32: output = distinctSketch<int   >(in, precision); break;
+            case u32: output = distinctSketch<uint  >(in, precision); break;
+            case s64: output = distinctSketch<intl  >(in, precision); break;
+            case u64: output = distinctSketch<uintl >(in, precision); break;
+            case s16: output = distinctSketch<short >(in, precision); break;
+            case u16: output = distinctSketch<ushort>(in, precision); break;
+            case u8:  output = distinctSketch<uchar >(in, precision); break;
+            case b8:  output = distinctSketch<char  >(in, precision); break;
+            default:  TYPE_ERROR(1, type);
+        }
+        std::swap(*out, output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_distinct_sketch_merge(af_array *out, const af_array lhs, const af_array rhs)
+{
+    try {
+        checkDistinctSketch(1, lhs);
+        checkDistinctSketch(2, rhs);
+        DIM_ASSERT(2, getInfo(lhs).elements() == getInfo(rhs).elements());
+
+        // Registers keep the largest rank seen
+        af_array output = 0;
+        AF_CHECK(af_maxof(&output, lhs, rhs, false));
+        std::swap(*out, output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_distinct_sketch_count(double *count, const af_array sketch)
+{
+    try {
+        checkDistinctSketch(1, sketch);
+
+        const dim_t m = getInfo(sketch).elements();
+        std::vector<uchar> registers(m);
+        copyData(&registers.front(), sketch);
+
+        *count = sketch::hllCount(&registers.front(), m);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Frequency sketch
+///////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+static af_array frequencySketch(const af_array in, const unsigned width, const unsigned depth)
+{
+    std::vector<uintl> table((size_t)width * depth, 0);
+    forEachChunk<T>(in, [&](const T *ptr, dim_t len) {
+        for (dim_t i = 0; i < len; ++i) {
+            sketch::cmsAdd(&table.front(), width, depth, sketch::hashValue(ptr[i]));
+        }
+    });
+    return createHandleFromData<uintl>(dim4(width, depth), &table.front());
+}
+
+static void checkFrequencySketch(const int argId, const af_array sketch)
+{
+    const ArrayInfo info = getInfo(sketch);
+    ARG_ASSERT(argId, info.getType() == u64);
+    ARG_ASSERT(argId, info.elements() > 0 && info.dims()[2] == 1 && info.dims()[3] == 1);
+}
+
+af_err af_frequency_sketch(af_array *out, const af_array in,
+                           const unsigned width, const unsigned depth)
+{
+    try {
+        ArrayInfo info = getInfo(in);
+        af_dtype type = info.getType();
+
+        ARG_ASSERT(2, width > 0);
+        ARG_ASSERT(3, depth > 0);
+
+        af_array output = 0;
+        switch(type) {
+            case f32: output = frequencySketch<float >(in, width, depth); break;
+            case f64: output = frequencySketch<double>(in, width, depth); break;
+            case s32: output = frequencySketch<int   >(in, width, depth); break;
+            case u32: output = frequencySketch<uint  >(in, width, depth); break;
+            case s64: output = frequencySketch<intl  >(in, width, depth); break;
+            case u64: output = frequencySketch<uintl >(in, width, depth); break;
+            case s16: output = frequencySketch<short >(in, width, depth); break;
+            case u16: output = frequencySketch<ushort>(in, width, depth); break;
+            case u8:  output = frequencySketch<uchar >(in, width, depth); break;
+            case b8:  output = frequencySketch<char  >(in, width, depth); break;
+            default:  TYPE_ERROR(1, type);
+        }
+        std::swap(*out, output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_frequency_sketch_merge(af_array *out, const af_array lhs, const af_array rhs)
+{
+    try {
+        checkFrequencySketch(1, lhs);
+        checkFrequencySketch(2, rhs);
+        DIM_ASSERT(2, getInfo(lhs).dims() == getInfo(rhs).dims());
+
+        af_array output = 0;
+        AF_CHECK(af_add(&output, lhs, rhs, false));
+        std::swap(*out, output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+template<typename T>
+static af_array frequencyQuery(const af_array sketch, const af_array values)
+{
+    const ArrayInfo s_info = getInfo(sketch);
+    const ArrayInfo v_info = getInfo(values);
+    const dim_t width = s_info.dims()[0];
+    const dim_t depth = s_info.dims()[1];
+
+    if (v_info.elements() == 0) return createHandle<uintl>(v_info.dims());
+
+    std::vector<uintl> table(s_info.elements());
+    copyData(&table.front(), sketch);
+
+    std::vector<T> h_values(v_info.elements());
+    copyData(&h_values.front(), values);
+
+    std::vector<uintl> result(h_values.size());
+    for (size_t i = 0; i < h_values.size(); ++i) {
+        result[i] = sketch::cmsQuery(&table.front(), width, depth,
+                                     sketch::hashValue(h_values[i]));
+    }
+
+    return createHandleFromData<uintl>(v_info.dims(), &result.front());
+}
+
+af_err af_frequency_sketch_query(af_array *out, const af_array sketch, const af_array values)
+{
+    try {
+        checkFrequencySketch(1, sketch);
+
+        af_dtype type = getInfo(values).getType();
+
+        af_array output = 0;
+        switch(type) {
+            case f32: output = frequencyQuery<float >(sketch, values); break;
+            case f64: output = frequencyQuery<double>(sketch, values); break;
+            case s32: output = frequencyQuery<int   >(sketch, values); break;
+            case u32: output = frequencyQuery<uint  >(sketch, values); break;
+            case s64: output = frequencyQuery<intl  >(sketch, values); break;
+            case u64: output = frequencyQuery<uintl >(sketch, values); break;
+            case s16: output = frequencyQuery<short >(sketch, values); break;
+            case u16: output = frequencyQuery<ushort>(sketch, values); break;
+            case u8:  output = frequencyQuery<uchar >(sketch, values); break;
+            case b8:  output = frequencyQuery<char  >(sketch, values); break;
+            default:  TYPE_ERROR(2, type);
+        }
+        std::swap(*out, output);
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
@@ -0,0 +1,285 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace sketch
+{
+
+static const double PI = 3.14159265358979323846;
+
+///////////////////////////////////////////////////////////////////////////
+// Hashing
+///////////////////////////////////////////////////////////////////////////
+
+static inline uint64_t mix64(uint64_t h)
+{
+    // MurmurHash3 64-bit finalizer
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Integers are hashed by their value and floating point numbers by the bit
+// pattern of their double representation, so sketches built from arrays of
+// the same type (or of types with the same set of values) agree.
+template<typename T>
+static inline uint64_t hashValue(T val)
+{
+    return mix64((uint64_t)(intl)val);
+}
+
+static inline uint64_t hashValue(double val)
+{
+    if (val == 0) val = 0; // -0.0 and 0.0 are the same value
+    uint64_t bits = 0;
+    std::memcpy(&bits, &val, sizeof(double));
+    return mix64(bits);
+}
+
+static inline uint64_t hashValue(float val)
+{
+    return hashValue((double)val);
+}
+
+static inline uint64_t hashValue(uintl val)
+{
+    return mix64((uint64_t)val);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// t-digest
+//
+// Merging t-digest of Dunning & Ertl with the k1 (arcsine) scale function.
+// The centroids are kept sorted by their mean. The smallest and the largest
+// value are always kept as centroids of their own so that the extreme
+// quantiles are exact.
+///////////////////////////////////////////////////////////////////////////
+
+struct Centroid
+{
+    double mean;
+    double weight;
+
+    bool operator<(const Centroid &other) const { return mean < other.mean; }
+};
+
+class TDigest
+{
+    double compression;
+    std::vector<Centroid> centroids;
+    std::vector<Centroid> buffer;
+    size_t bufferLimit;
+
+    double scale(double q) const
+    {
+        return compression / (2 * PI) * std::asin(2 * q - 1);
+    }
+
+    double scaleInverse(double k) const
+    {
+        double x = k * 2 * PI / compression;
+        if (x >= PI / 2) return 1;
+        return (std::sin(x) + 1) / 2;
+    }
+
+    void compress(std::vector<Centroid> &sorted)
+    {
+        centroids.clear();
+        if (sorted.size() <= 3) {
+            centroids.swap(sorted);
+            return;
+        }
+
+        double total = 0;
+        for (size_t i = 0; i < sorted.size(); ++i) total += sorted[i].weight;
+
+        centroids.push_back(sorted.front());
+
+        double weightSoFar = sorted.front().weight;
+        double qLimit = scaleInverse(scale(weightSoFar / total) + 1);
+        Centroid cur = sorted[1];
+
+        for (size_t i = 2; i + 1 < sorted.size(); ++i) {
+            const Centroid &x = sorted[i];
+            double q = (weightSoFar + cur.weight + x.weight) / total;
+            if (q <= qLimit) {
+                cur.weight += x.weight;
+                cur.mean   += (x.mean - cur.mean) * x.weight / cur.weight;
+            } else {
+                centroids.push_back(cur);
+                weightSoFar += cur.weight;
+                qLimit = scaleInverse(scale(weightSoFar / total) + 1);
+                cur = x;
+            }
+        }
+
+        centroids.push_back(cur);
+        centroids.push_back(sorted.back());
+    }
+
+public:
+    explicit TDigest(double compression)
+        : compression(compression),
+          bufferLimit(std::max<size_t>(4096, (size_t)(10 * compression)))
+    {
+        buffer.reserve(bufferLimit);
+    }
+
+    void add(double mean, double weight)
+    {
+        if (std::isnan(mean) || !(weight > 0)) return;
+
+        Centroid c = {mean, weight};
+        buffer.push_back(c);
+        if (buffer.size() >= bufferLimit) flush();
+    }
+
+    void flush()
+    {
+        if (buffer.empty()) return;
+
+        std::sort(buffer.begin(), buffer.end());
+
+        std::vector<Centroid> merged(centroids.size() + buffer.size());
+        std::merge(centroids.begin(), centroids.end(),
+                   buffer.begin(), buffer.end(), merged.begin());
+        buffer.clear();
+
+        compress(merged);
+    }
+
+    const std::vector<Centroid> &get()
+    {
+        flush();
+        return centroids;
+    }
+};
+
+// Interpolates the value at quantile q from centroids sorted by their mean
+static inline double quantile(const double *means, const double *weights,
+                              const dim_t count, double q)
+{
+    if (count == 0) return std::numeric_limits<double>::quiet_NaN();
+    if (count == 1) return means[0];
+
+    double total = 0;
+    for (dim_t i = 0; i < count; ++i) total += weights[i];
+
+    const double index = q * total;
+
+    // Every centroid is centered on its cumulative weight
+    double weightSoFar = weights[0] / 2;
+    if (index <= weightSoFar) return means[0];
+
+    for (dim_t i = 0; i + 1 < count; ++i) {
+        double step = (weights[i] + weights[i + 1]) / 2;
+        if (weightSoFar + step > index) {
+            double t = (index - weightSoFar) / step;
+            return means[i] + (means[i + 1] - means[i]) * t;
+        }
+        weightSoFar += step;
+    }
+    return means[count - 1];
+}
+
+///////////////////////////////////////////////////////////////////////////
+// HyperLogLog
+///////////////////////////////////////////////////////////////////////////
+
+static inline int leadingZeros(uint64_t x)
+{
+    if (x == 0) return 64;
+    int n = 0;
+    while (!(x & (1ULL << 63))) {
+        x <<= 1;
+        ++n;
+    }
+    return n;
+}
+
+static inline void hllAdd(unsigned char *registers, const int precision, const uint64_t hash)
+{
+    const uint64_t idx = hash >> (64 - precision);
+    const uint64_t rest = hash << precision;
+    const unsigned char rank = (unsigned char)std::min(leadingZeros(rest) + 1, 64 - precision + 1);
+    registers[idx] = std::max(registers[idx], rank);
+}
+
+static inline double hllCount(const unsigned char *registers, const dim_t m)
+{
+    double alpha;
+    switch (m) {
+    case 16: alpha = 0.673; break;
+    case 32: alpha = 0.697; break;
+    case 64: alpha = 0.709; break;
+    default: alpha = 0.7213 / (1 + 1.079 / m); break;
+    }
+
+    double sum = 0;
+    dim_t zeros = 0;
+    for (dim_t i = 0; i < m; ++i) {
+        sum += std::ldexp(1.0, -registers[i]);
+        zeros += registers[i] == 0;
+    }
+
+    double estimate = alpha * m * m / sum;
+
+    // Linear counting is more accurate for small cardinalities. The hashes
+    // are 64 bits wide, so no large range correction is needed.
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * std::log((double)m / zeros);
+    }
+    return estimate;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Count-min
+//
+// The table is width x depth in column major order. Row i of the sketch is
+// column i of the table. The columns of a value are derived from a single
+// 64 bit hash with double hashing.
+///////////////////////////////////////////////////////////////////////////
+
+static inline dim_t cmsColumn(const uint64_t hash, const dim_t row, const dim_t width)
+{
+    const uint64_t h1 = hash & 0xffffffffULL;
+    const uint64_t h2 = (hash >> 32) | 1;
+    return (dim_t)((h1 + row * h2) % (uint64_t)width);
+}
+
+static inline void cmsAdd(uintl *table, const dim_t width, const dim_t depth,
+                          const uint64_t hash)
+{
+    for (dim_t r = 0; r < depth; ++r) {
+        table[r * width + cmsColumn(hash, r, width)]++;
+    }
+}
+
+static inline uintl cmsQuery(const uintl *table, const dim_t width, const dim_t depth,
+                             const uint64_t hash)
+{
+    uintl res = table[cmsColumn(hash, 0, width)];
+    for (dim_t r = 1; r < depth; ++r) {
+        res = std::min(res, table[r * width + cmsColumn(hash, r, width)]);
+    }
+    return res;
+}
+
+}
@@ -15,6 +15,9 @@
 #include <backend.hpp>
 #include <ArrayInfo.hpp>
 #include <solve.hpp>
+#include <lu.hpp>
+
+#include <algorithm>
 
 using af::dim4;
 using namespace detail;
@@ -31,8 +34,7 @@ af_err af_solve(af_array *out, const af_array a, const af_array b, const af_mat_
         ArrayInfo a_info = getInfo(a);
         ArrayInfo b_info = getInfo(b);
 
-        if (a_info.ndims() > 2 ||
-            b_info.ndims() > 2) {
+        if ((a_info.ndims() > 2 || b_info.ndims() > 2) && !isLAPACKBatchAvailable()) {
             AF_ERROR("solve can not be used in batch mode", AF_ERR_BATCH);
         }
 
@@ -40,7 +42,7 @@ af_err af_solve(af_array *out, const af_array a, const af_array b, const af_mat_
         af_dtype b_type = b_info.getType();
 
         dim4 adims = a_info.dims();
-        dim4 bdims = a_info.dims();
+        dim4 bdims = b_info.dims();
 
         ARG_ASSERT(1, a_info.isFloating());                       // Only floating and complex types
         ARG_ASSERT(2, b_info.isFloating());                       // Only floating and complex types
@@ -99,10 +101,10 @@ af_err af_solve_lu(af_array *out, const af_array a,
 {
     try {
         ArrayInfo a_info = getInfo(a);
+        ArrayInfo p_info = getInfo(piv);
         ArrayInfo b_info = getInfo(b);
 
-        if (a_info.ndims() > 2 ||
-            b_info.ndims() > 2) {
+        if ((a_info.ndims() > 2 || b_info.ndims() > 2) && !isLAPACKBatchAvailable()) {
             AF_ERROR("solveLU can not be used in batch mode", AF_ERR_BATCH);
         }
 
@@ -110,7 +112,7 @@ af_err af_solve_lu(af_array *out, const af_array a,
         af_dtype b_type = b_info.getType();
 
         dim4 adims = a_info.dims();
-        dim4 bdims = a_info.dims();
+        dim4 bdims = b_info.dims();
 
         ARG_ASSERT(1, a_info.isFloating());                       // Only floating and complex types
         ARG_ASSERT(2, b_info.isFloating());                       // Only floating and complex types
@@ -127,6 +129,13 @@ af_err af_solve_lu(af_array *out, const af_array a,
             return af_create_handle(out, AF_MAX_DIMS, my_dims, a_type);
         }
 
+        // One pivot per row of each matrix of a, as returned by af_lu_inplace
+        dim4 pdims = p_info.dims();
+        TYPE_ASSERT(p_info.getType() == s32);
+        DIM_ASSERT(2, pdims[0] >= std::min(adims[0], adims[1]));
+        DIM_ASSERT(2, pdims[2] == adims[2]);
+        DIM_ASSERT(2, pdims[3] == adims[3]);
+
         if (options != AF_MAT_NONE) {
             AF_ERROR("Using this property is not yet supported in solveLU", AF_ERR_NOT_SUPPORTED);
         }
@@ -0,0 +1,101 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/array.h>
+#include <af/lapack.h>
+#include <af/defines.h>
+#include <err_common.hpp>
+#include <handle.hpp>
+#include <sparse_handle.hpp>
+#include <backend.hpp>
+#include <ArrayInfo.hpp>
+#include <solve_iterative.hpp>
+
+using af::dim4;
+using namespace detail;
+
+template<typename T>
+static inline af_array solveIterative(const af_array a, const bool isSparse, const af_array b,
+                                      const af_iterative_method method,
+                                      const af_preconditioner precond,
+                                      const double tol, const unsigned maxIter,
+                                      const unsigned restart,
+                                      unsigned &iterations, double &residual)
+{
+    if (isSparse) {
+        return getHandle(solveIterative<T>(getSparseArray<T>(a), getArray<T>(b),
+                                           method, precond, tol, maxIter, restart,
+                                           iterations, residual));
+    }
+    return getHandle(solveIterative<T>(getArray<T>(a), getArray<T>(b),
+                                       method, precond, tol, maxIter, restart,
+                                       iterations, residual));
+}
+
+af_err af_solve_iterative(af_array *x, unsigned *iterations, double *residual,
+                          const af_array a, const af_array b,
+                          const af_iterative_method method, const af_preconditioner precond,
+                          const double tol, const unsigned maxIter, const unsigned restart)
+{
+    try {
+        ArrayInfo a_info = getInfo(a, false, true);
+        ArrayInfo b_info = getInfo(b);
+
+        const bool isSparse = a_info.isSparse();
+        if (isSparse) {
+            ARG_ASSERT(3, getSparseArrayBase(a).getStorage() == AF_STORAGE_CSR);
+        }
+
+        if (a_info.ndims() > 2 || b_info.ndims() > 2) {
+            AF_ERROR("solveIterative can not be used in batch mode", AF_ERR_BATCH);
+        }
+
+        af_dtype a_type = a_info.getType();
+        af_dtype b_type = b_info.getType();
+
+        dim4 adims = a_info.dims();
+        dim4 bdims = b_info.dims();
+
+        ARG_ASSERT(3, a_info.isFloating());                       // Only floating and complex types
+        ARG_ASSERT(4, b_info.isFloating());                       // Only floating and complex types
+
+        TYPE_ASSERT(a_type == b_type);
+
+        DIM_ASSERT(3, adims[0] == adims[1]);
+        DIM_ASSERT(4, bdims[0] == adims[0]);
+
+        ARG_ASSERT(5, method == AF_ITERATIVE_CG ||
+                      method == AF_ITERATIVE_BICGSTAB ||
+                      method == AF_ITERATIVE_GMRES);
+        ARG_ASSERT(6, precond == AF_PRECOND_NONE ||
+                      precond == AF_PRECOND_JACOBI ||
+                      precond == AF_PRECOND_ILU0);
+        ARG_ASSERT(7, tol >= 0);
+        ARG_ASSERT(8, maxIter > 0);
+        ARG_ASSERT(9, restart > 0 || method != AF_ITERATIVE_GMRES);
+
+        unsigned its = 0;
+        double res = 0;
+        af_array output;
+
+        switch(a_type) {
+            case f32: output = solveIterative<float  >(a, isSparse, b, method, precond, tol, maxIter, restart, its, res);  break;
+            case f64: output = solveIterative<double >(a, isSparse, b, method, precond, tol, maxIter, restart, its, res);  break;
+            case c32: output = solveIterative<cfloat >(a, isSparse, b, method, precond, tol, maxIter, restart, its, res);  break;
+            case c64: output = solveIterative<cdouble>(a, isSparse, b, method, precond, tol, maxIter, restart, its, res);  break;
+            default:  TYPE_ERROR(3, a_type);
+        }
+        std::swap(*x, output);
+        if (iterations) *iterations = its;
+        if (residual)   *residual   = res;
+    }
+    CATCHALL;
+
+    return AF_SUCCESS;
+}
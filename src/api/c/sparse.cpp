@@ -103,6 +103,59 @@ af_err af_create_sparse_array(
     return AF_SUCCESS;
 }
 
+template<typename T>
+af_array sparseAssemble(const af::dim4 &dims, const af_array values,
+                        const af_array rowIdx, const af_array colIdx,
+                        const af_sparse_duplicates dups)
+{
+    return getHandle(detail::sparseAssemble<T>(dims, getArray<T>(values),
+                                               getArray<int>(rowIdx), getArray<int>(colIdx),
+                                               dups));
+}
+
+af_err af_sparse_assemble(af_array *out,
+                          const dim_t nRows, const dim_t nCols,
+                          const af_array values, const af_array rowIdx, const af_array colIdx,
+                          const af_sparse_duplicates dups)
+{
+    try {
+        // Checks:
+        // rowIdx and colIdx arrays are of s32 type
+        // rowIdx, colIdx and values have the same number of elements
+        // values is of floating point type
+        // dups is within acceptable range
+
+        ArrayInfo vInfo = getInfo(values);
+        ArrayInfo rInfo = getInfo(rowIdx);
+        ArrayInfo cInfo = getInfo(colIdx);
+
+        TYPE_ASSERT(vInfo.isFloating());
+        TYPE_ASSERT(rInfo.getType() == s32);
+        TYPE_ASSERT(cInfo.getType() == s32);
+        DIM_ASSERT(4, rInfo.elements() == vInfo.elements());
+        DIM_ASSERT(5, cInfo.elements() == vInfo.elements());
+        ARG_ASSERT(1, nRows > 0);
+        ARG_ASSERT(2, nCols > 0);
+        ARG_ASSERT(6, dups == AF_SPARSE_DUPLICATES_SUM || dups == AF_SPARSE_DUPLICATES_LAST);
+
+        af_array output = 0;
+
+        af::dim4 dims(nRows, nCols);
+
+        switch(vInfo.getType()) {
+            case f32: output = sparseAssemble<float  >(dims, values, rowIdx, colIdx, dups); break;
+            case f64: output = sparseAssemble<double >(dims, values, rowIdx, colIdx, dups); break;
+            case c32: output = sparseAssemble<cfloat >(dims, values, rowIdx, colIdx, dups); break;
+            case c64: output = sparseAssemble<cdouble>(dims, values, rowIdx, colIdx, dups); break;
+            default : TYPE_ERROR(3, vInfo.getType());
+        }
+        std::swap(*out, output);
+
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
 template<typename T>
 af_array createSparseArrayFromPtr(
         const af::dim4 &dims, const dim_t nNZ,
@@ -235,9 +288,10 @@ af_array sparseConvertStorage(const af_array in_, const af_storage destStorage)
 {
     const SparseArray<T> in = getSparseArray<T>(in_);
 
-    // Only destStorage == AF_STORAGE_DENSE is supported
-    // All the other calls are for future when conversions are supported in
-    // the backend
+    // Every storage converts to dense, going through CSR for the blocked
+    // storages. Between sparse storages, af_sparse_convert_to only lets COO
+    // to CSR and CSR to and from BSR and SELL through, and the backends that
+    // do not implement one of them report it as not supported.
     if(destStorage == AF_STORAGE_DENSE) {
         // Returns a regular af_array, not sparse
         switch(in.getStorage()) {
@@ -247,6 +301,12 @@ af_array sparseConvertStorage(const af_array in_, const af_storage destStorage)
                 return getHandle(detail::sparseConvertStorageToDense<T, AF_STORAGE_CSC>(in));
             case AF_STORAGE_COO:
                 return getHandle(detail::sparseConvertStorageToDense<T, AF_STORAGE_COO>(in));
+            case AF_STORAGE_BSR:
+                return getHandle(detail::sparseConvertStorageToDense<T, AF_STORAGE_CSR>(
+                            detail::sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_BSR>(in)));
+            case AF_STORAGE_SELL:
+                return getHandle(detail::sparseConvertStorageToDense<T, AF_STORAGE_CSR>(
+                            detail::sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_SELL>(in)));
             default:
                 AF_ERROR("Invalid storage type of input array", AF_ERR_ARG);
         }
@@ -259,6 +319,10 @@ af_array sparseConvertStorage(const af_array in_, const af_storage destStorage)
                 return getHandle(detail::sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_CSC>(in));
             case AF_STORAGE_COO:
                 return getHandle(detail::sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_COO>(in));
+            case AF_STORAGE_BSR:
+                return getHandle(detail::sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_BSR>(in));
+            case AF_STORAGE_SELL:
+                return getHandle(detail::sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_SELL>(in));
             default:
                 AF_ERROR("Invalid storage type of input array", AF_ERR_ARG);
         }
@@ -286,6 +350,25 @@ af_array sparseConvertStorage(const af_array in_, const af_storage destStorage)
             default:
                 AF_ERROR("Invalid storage type of input array", AF_ERR_ARG);
         }
+    } else if(destStorage == AF_STORAGE_BSR) {
+        // Blocked storages are built from CSR only
+        switch(in.getStorage()) {
+            case AF_STORAGE_CSR:
+                return getHandle(detail::sparseConvertStorageToStorage<T, AF_STORAGE_BSR, AF_STORAGE_CSR>(in));
+            case AF_STORAGE_BSR:
+                return retainSparseHandle<T>(in_);
+            default:
+                AF_ERROR("Invalid storage type of input array", AF_ERR_ARG);
+        }
+    } else if(destStorage == AF_STORAGE_SELL) {
+        switch(in.getStorage()) {
+            case AF_STORAGE_CSR:
+                return getHandle(detail::sparseConvertStorageToStorage<T, AF_STORAGE_SELL, AF_STORAGE_CSR>(in));
+            case AF_STORAGE_SELL:
+                return retainSparseHandle<T>(in_);
+            default:
+                AF_ERROR("Invalid storage type of input array", AF_ERR_ARG);
+        }
     }
 
     // Shoud never come here
@@ -295,7 +378,6 @@ af_array sparseConvertStorage(const af_array in_, const af_storage destStorage)
 af_err af_sparse_convert_to(af_array *out, const af_array in,
                             const af_storage destStorage)
 {
-    // Right now dest_storage can only be AF_STORAGE_DENSE
     try {
         af_array output = 0;
 
@@ -305,9 +387,19 @@ af_err af_sparse_convert_to(af_array *out, const af_array in,
         // To convert from dense to type, use the create* functions
         ARG_ASSERT(1, base.getStorage() != AF_STORAGE_DENSE);
 
-        // Right now dest_storage can only be AF_STORAGE_DENSE
+        // Besides AF_STORAGE_DENSE, only COO to CSR and the conversions
+        // between CSR and the blocked storages are supported
         // TODO: Add support for [CSR, CSC, COO] <-> [CSR, CSC, COO] in backends
-        ARG_ASSERT(1, destStorage == AF_STORAGE_DENSE);
+        const af_storage srcStorage = base.getStorage();
+        const bool blockedDest = (destStorage == AF_STORAGE_BSR ||
+                                  destStorage == AF_STORAGE_SELL);
+        const bool blockedSrc  = (srcStorage == AF_STORAGE_BSR ||
+                                  srcStorage == AF_STORAGE_SELL);
+        ARG_ASSERT(2, destStorage == AF_STORAGE_DENSE ||
+                      destStorage == srcStorage ||
+                      (srcStorage == AF_STORAGE_COO && destStorage == AF_STORAGE_CSR) ||
+                      (blockedDest && srcStorage == AF_STORAGE_CSR) ||
+                      (blockedSrc && destStorage == AF_STORAGE_CSR));
 
         if(base.getStorage() == destStorage) {
             // Return a reference
@@ -0,0 +1,90 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/sparse.h>
+#include <af/array.h>
+#include <af/defines.h>
+#include <backend.hpp>
+#include <err_common.hpp>
+#include <handle.hpp>
+#include <sparse_handle.hpp>
+#include <sparse_arith.hpp>
+
+using namespace detail;
+using common::SparseArray;
+using common::SparseArrayBase;
+
+typedef enum {
+    SPARSE_ADD,
+    SPARSE_MUL,
+    SPARSE_MATMUL
+} sparse_arith_op;
+
+template<typename T>
+static inline af_array sparseArith(const af_array lhs, const af_array rhs,
+                                   const sparse_arith_op op)
+{
+    const SparseArray<T> &l = getSparseArray<T>(lhs);
+    const SparseArray<T> &r = getSparseArray<T>(rhs);
+    switch (op) {
+        case SPARSE_ADD: return getHandle(sparseAdd<T>(l, r));
+        case SPARSE_MUL: return getHandle(sparseMul<T>(l, r));
+        default:         return getHandle(sparseMatmul<T>(l, r));
+    }
+}
+
+static af_err sparseArith(af_array *out, const af_array lhs, const af_array rhs,
+                          const sparse_arith_op op)
+{
+    try {
+        SparseArrayBase lBase = getSparseArrayBase(lhs);
+        SparseArrayBase rBase = getSparseArrayBase(rhs);
+
+        ARG_ASSERT(1, lBase.getStorage() == AF_STORAGE_CSR);
+        ARG_ASSERT(2, rBase.getStorage() == AF_STORAGE_CSR);
+
+        const af_dtype type = lBase.getType();
+        TYPE_ASSERT(type == rBase.getType());
+
+        const af::dim4 lDims = lBase.dims();
+        const af::dim4 rDims = rBase.dims();
+        if (op == SPARSE_MATMUL) {
+            DIM_ASSERT(1, lDims[1] == rDims[0]);
+        } else {
+            DIM_ASSERT(1, lDims[0] == rDims[0] && lDims[1] == rDims[1]);
+        }
+
+        af_array output = 0;
+        switch (type) {
+            case f32: output = sparseArith<float  >(lhs, rhs, op); break;
+            case f64: output = sparseArith<double >(lhs, rhs, op); break;
+            case c32: output = sparseArith<cfloat >(lhs, rhs, op); break;
+            case c64: output = sparseArith<cdouble>(lhs, rhs, op); break;
+            default:  TYPE_ERROR(1, type);
+        }
+        std::swap(*out, output);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_sparse_add(af_array *out, const af_array lhs, const af_array rhs)
+{
+    return sparseArith(out, lhs, rhs, SPARSE_ADD);
+}
+
+af_err af_sparse_mul(af_array *out, const af_array lhs, const af_array rhs)
+{
+    return sparseArith(out, lhs, rhs, SPARSE_MUL);
+}
+
+af_err af_sparse_sparse_matmul(af_array *out, const af_array lhs, const af_array rhs)
+{
+    return sparseArith(out, lhs, rhs, SPARSE_MATMUL);
+}
@@ -0,0 +1,137 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/sparse.h>
+#include <af/array.h>
+#include <af/defines.h>
+#include <af/dim4.hpp>
+#include <backend.hpp>
+#include <err_common.hpp>
+#include <handle.hpp>
+#include <sparse_handle.hpp>
+#include <sparse_blas.hpp>
+#include <memory>
+
+using namespace detail;
+
+// The object behind an af_sparse_operator. Handles created by
+// af_retain_sparse_operator share the backend operator.
+class SparseOperatorHandle
+{
+    public:
+    af_dtype type;
+    af_mat_prop optLhs;
+    af::dim4 dims;
+    std::shared_ptr<void> op;
+};
+
+static SparseOperatorHandle *getSparseOperator(const af_sparse_operator handle)
+{
+    if (handle == 0) {
+        AF_ERROR("Uninitialized sparse operator", AF_ERR_ARG);
+    }
+    return static_cast<SparseOperatorHandle *>(handle);
+}
+
+template<typename T>
+static inline std::shared_ptr<void> createOperator(const af_array sparse,
+                                                   const af_mat_prop optLhs,
+                                                   const dim_t ncols)
+{
+    return std::make_shared<SparseOperator<T>>(getSparseArray<T>(sparse), optLhs, ncols);
+}
+
+template<typename T>
+static inline af_array operatorMatmul(const SparseOperatorHandle *h, const af_array rhs)
+{
+    const SparseOperator<T> *op = static_cast<const SparseOperator<T> *>(h->op.get());
+    return getHandle(op->matmul(getArray<T>(rhs)));
+}
+
+af_err af_create_sparse_operator(af_sparse_operator *out, const af_array sparse,
+                                 const af_mat_prop optLhs, const dim_t ncols)
+{
+    try {
+        common::SparseArrayBase base = getSparseArrayBase(sparse);
+
+        ARG_ASSERT(1, base.getStorage() == AF_STORAGE_CSR);
+        if (!(optLhs == AF_MAT_NONE ||
+              optLhs == AF_MAT_TRANS ||
+              optLhs == AF_MAT_CTRANS)) {
+            AF_ERROR("Using this property is not yet supported in sparse matmul", AF_ERR_NOT_SUPPORTED);
+        }
+        ARG_ASSERT(3, ncols > 0);
+
+        std::unique_ptr<SparseOperatorHandle> h(new SparseOperatorHandle);
+        h->type   = base.getType();
+        h->optLhs = optLhs;
+        h->dims   = base.dims();
+
+        switch (h->type) {
+            case f32: h->op = createOperator<float  >(sparse, optLhs, ncols); break;
+            case f64: h->op = createOperator<double >(sparse, optLhs, ncols); break;
+            case c32: h->op = createOperator<cfloat >(sparse, optLhs, ncols); break;
+            case c64: h->op = createOperator<cdouble>(sparse, optLhs, ncols); break;
+            default:  TYPE_ERROR(1, h->type);
+        }
+
+        *out = static_cast<af_sparse_operator>(h.release());
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_retain_sparse_operator(af_sparse_operator *out, const af_sparse_operator in)
+{
+    try {
+        const SparseOperatorHandle *h = getSparseOperator(in);
+        *out = static_cast<af_sparse_operator>(new SparseOperatorHandle(*h));
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_release_sparse_operator(af_sparse_operator op)
+{
+    try {
+        delete getSparseOperator(op);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_sparse_operator_matmul(af_array *out, const af_sparse_operator op,
+                                 const af_array rhs)
+{
+    try {
+        const SparseOperatorHandle *h = getSparseOperator(op);
+        ArrayInfo rhsInfo = getInfo(rhs);
+
+        if (rhsInfo.ndims() > 2) {
+            AF_ERROR("Sparse matmul can not be used in batch mode", AF_ERR_BATCH);
+        }
+
+        TYPE_ASSERT(h->type == rhsInfo.getType());
+
+        const int lColDim = (h->optLhs == AF_MAT_NONE) ? 1 : 0;
+        DIM_ASSERT(2, h->dims[lColDim] == rhsInfo.dims()[0]);
+
+        af_array output = 0;
+        switch (h->type) {
+            case f32: output = operatorMatmul<float  >(h, rhs); break;
+            case f64: output = operatorMatmul<double >(h, rhs); break;
+            case c32: output = operatorMatmul<cfloat >(h, rhs); break;
+            case c64: output = operatorMatmul<cdouble>(h, rhs); break;
+            default:  TYPE_ERROR(1, h->type);
+        }
+        std::swap(*out, output);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
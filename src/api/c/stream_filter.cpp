@@ -0,0 +1,385 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/dim4.hpp>
+#include <af/defines.h>
+#include <af/signal.h>
+#include <af/arith.h>
+#include <handle.hpp>
+#include <err_common.hpp>
+#include <backend.hpp>
+#include <platform.hpp>
+#include <arith.hpp>
+#include <convolve.hpp>
+#include <convolve_cost.hpp>
+#include <dispatch.hpp>
+#include <iir.hpp>
+#include <join.hpp>
+#include <tile.hpp>
+#include <copy.hpp>
+#include <fft_common.hpp>
+#include <memory>
+#include <vector>
+
+using af::dim4;
+using namespace detail;
+
+// Filters longer than this are convolved in the frequency domain by
+// AF_CONV_AUTO when there is no convolution cost model, and always on the
+// GPU backends, which cannot convolve them in the spatial domain.
+static const dim_t STREAM_FREQ_TAPS = 128;
+
+// Transforms of the overlap-save convolution, real to complex for real
+// types. n is the length of the transform.
+template<typename T> struct StreamSpectrum;
+
+#define STREAM_SPECTRUM_REAL(T, CT)                                     \
+    template<> struct StreamSpectrum<T>                                 \
+    {                                                                   \
+        typedef CT type;                                                \
+        static Array<CT> forward(const Array<T> &in, dim_t n)           \
+        {                                                               \
+            return fft_r2c<T, CT, 1>(in, 1.0, 1, &n);                   \
+        }                                                               \
+        static Array<T> inverse(const Array<CT> &in, dim_t n)           \
+        {                                                               \
+            dim4 odims = in.dims();                                     \
+            odims[0] = n;                                               \
+            return fft_c2r<CT, T, 1>(in, 1.0 / n, odims);               \
+        }                                                               \
+    };
+
+#define STREAM_SPECTRUM_COMPLEX(T)                                      \
+    template<> struct StreamSpectrum<T>                                 \
+    {                                                                   \
+        typedef T type;                                                 \
+        static Array<T> forward(const Array<T> &in, dim_t n)            \
+        {                                                               \
+            return fft<T, T, 1, true>(in, 1.0, 1, &n);                  \
+        }                                                               \
+        static Array<T> inverse(const Array<T> &in, dim_t n)            \
+        {                                                               \
+            return fft<T, T, 1, false>(in, 1.0 / n, 1, &n);             \
+        }                                                               \
+    };
+
+STREAM_SPECTRUM_REAL(float , cfloat )
+STREAM_SPECTRUM_REAL(double, cdouble)
+STREAM_SPECTRUM_COMPLEX(cfloat )
+STREAM_SPECTRUM_COMPLEX(cdouble)
+
+// Rows [begin, begin + len) of every column of in
+template<typename T>
+static Array<T> streamRows(const Array<T> &in, const dim_t begin, const dim_t len)
+{
+    std::vector<af_seq> index(4, af_span);
+    index[0].begin = begin;
+    index[0].end   = begin + len - 1;
+    index[0].step  = 1;
+    return createSubArray<T>(in, index);
+}
+
+// Filter of a stream of type T. The last P = nb - 1 inputs of every channel
+// are kept, so that each chunk is convolved with b as the tail of the
+// inputs before it. IIR filters also keep the last Q = na - 1 outputs, whose
+// part of the feedback on the first Q samples of a chunk is subtracted
+// before the chunk goes through the recursion.
+template<typename T>
+class StreamFilter
+{
+    typedef typename StreamSpectrum<T>::type CT;
+
+    const Array<T> b;
+    const std::vector<Array<T> > a;
+    const af_conv_domain domain;
+    const dim_t P;
+    const dim_t Q;
+
+    bool started;
+    dim4 channels;
+    std::vector<Array<T> > xhist;
+    std::vector<Array<T> > yhist;
+    std::vector<Array<CT> > spectrum;
+    std::vector<Array<CT> > aspectrum;
+
+    bool useFreq(const dim4 &sdims, const dim4 &fdims, const bool expand) const
+    {
+        if (domain != AF_CONV_AUTO) return domain == AF_CONV_FREQ;
+        if (getBackend() != AF_BACKEND_CPU && fdims[0] > STREAM_FREQ_TAPS) return true;
+
+        double spatial, freq;
+        if (estimateConvolveCost(spatial, freq, 1, sdims, fdims, expand,
+                                 (af_dtype)af::dtype_traits<T>::af_type)) {
+            return freq < spatial;
+        }
+        return fdims[0] > STREAM_FREQ_TAPS;
+    }
+
+    // Spectrum of filter for transforms shaped like X, kept in cache
+    static const Array<CT> &filterSpectrum(std::vector<Array<CT> > &cache, const Array<T> &filter,
+                                           const Array<CT> &X, const dim_t n)
+    {
+        if (cache.empty() || cache[0].dims() != X.dims()) {
+            dim4 tdims = X.dims();
+            tdims[0] = 1;
+            cache.assign(1, tile<CT>(StreamSpectrum<T>::forward(filter, n), tdims));
+        }
+        return cache[0];
+    }
+
+    // Rows [P, P + L) of the convolution of in, which holds P samples of
+    // history followed by L new ones, with b. Overlap-save only needs a
+    // transform as long as in, as the samples that wrap around land in the
+    // first P rows.
+    Array<T> convolve(const Array<T> &in, const dim_t L)
+    {
+        if (!useFreq(in.dims(), b.dims(), false)) {
+            AF_BATCH_KIND kind = in.ndims() > 1 ? AF_BATCH_LHS : AF_BATCH_NONE;
+            Array<T> out = detail::convolve<T, T, 1, true>(in, b, kind);
+            return streamRows(out, P, L);
+        }
+
+        const dim_t n = nextpow2((unsigned)(P + L));
+        Array<CT> X = StreamSpectrum<T>::forward(in, n);
+        X = arithOp<CT, af_mul_t>(X, filterSpectrum(spectrum, b, X, n), X.dims());
+        return streamRows(StreamSpectrum<T>::inverse(X, n), P, L);
+    }
+
+    // Rows [Q, Q + len) of the convolution of the last Q outputs with a,
+    // which are their feedback on the first len samples of a chunk. The
+    // whole convolution is 2Q rows long, so a transform of that length
+    // does not wrap around.
+    Array<T> feedback(const Array<T> &hist, const dim_t len)
+    {
+        if (!useFreq(hist.dims(), a[0].dims(), true)) {
+            AF_BATCH_KIND kind = hist.ndims() > 1 ? AF_BATCH_LHS : AF_BATCH_NONE;
+            Array<T> out = detail::convolve<T, T, 1, true>(hist, a[0], kind);
+            return streamRows(out, Q, len);
+        }
+
+        const dim_t n = nextpow2((unsigned)(2 * Q));
+        Array<CT> H = StreamSpectrum<T>::forward(hist, n);
+        H = arithOp<CT, af_mul_t>(H, filterSpectrum(aspectrum, a[0], H, n), H.dims());
+        return streamRows(StreamSpectrum<T>::inverse(H, n), Q, len);
+    }
+
+    // Keeps the last len rows of in, which are preceded by hist
+    static Array<T> history(const std::vector<Array<T> > &hist, const Array<T> &in, const dim_t len)
+    {
+        const dim_t L = in.dims()[0];
+        if (L >= len) return streamRows(in, L - len, len);
+        return streamRows(join<T, T>(0, hist[0], in), L, len);
+    }
+
+    public:
+
+    StreamFilter(const Array<T> &b, const std::vector<Array<T> > &a, const af_conv_domain domain) :
+        b(b), a(a), domain(domain),
+        P(b.dims()[0] - 1), Q(a.empty() ? 0 : a[0].dims()[0] - 1),
+        started(false)
+    {
+    }
+
+    Array<T> push(const Array<T> &x)
+    {
+        dim4 cdims = x.dims();
+        cdims[0] = 1;
+        if (started) DIM_ASSERT(2, cdims == channels);
+
+        // The state is only updated once the whole chunk is filtered
+        std::vector<Array<T> > xh = xhist, yh = yhist;
+        if (!started) {
+            dim4 hdims = cdims;
+            hdims[0] = P;
+            if (P > 0) xh.assign(1, createValueArray<T>(hdims, scalar<T>(0)));
+            hdims[0] = Q;
+            if (Q > 0) yh.assign(1, createValueArray<T>(hdims, scalar<T>(0)));
+        }
+
+        const dim_t L = x.dims()[0];
+        Array<T> in = (P > 0 ? join<T, T>(0, xh[0], x) : x);
+        Array<T> y = convolve(in, L);
+        if (P > 0) xh.assign(1, streamRows(in, L, P));
+
+        if (!a.empty()) {
+            if (Q > 0) {
+                Array<T> fb = feedback(yh[0], std::min(Q, L));
+                y = arithOp<T, af_sub_t>(y, padArray<T, T>(fb, y.dims(), scalar<T>(0)),
+                                         y.dims());
+            }
+            y = iir<T>(createValueArray<T>(dim4(1), scalar<T>(1)), a[0], y);
+            if (Q > 0) yh.assign(1, history(yh, y, Q));
+        }
+
+        started  = true;
+        channels = cdims;
+        xhist.swap(xh);
+        yhist.swap(yh);
+        return y;
+    }
+
+    void reset()
+    {
+        started = false;
+        xhist.clear();
+        yhist.clear();
+    }
+};
+
+// The object behind an af_stream_filter. Handles created by
+// af_retain_stream_filter share the filter and its state.
+class StreamFilterHandle
+{
+    public:
+    af_dtype type;
+    std::shared_ptr<void> filter;
+};
+
+static StreamFilterHandle *getStreamFilter(const af_stream_filter handle)
+{
+    if (handle == 0) {
+        AF_ERROR("Uninitialized stream filter", AF_ERR_ARG);
+    }
+    return static_cast<StreamFilterHandle *>(handle);
+}
+
+template<typename T>
+static inline std::shared_ptr<void> createFilter(const af_array b, const af_array a,
+                                                 const af_conv_domain domain)
+{
+    std::vector<Array<T> > feedback;
+    if (a != 0) feedback.push_back(getArray<T>(a));
+    return std::make_shared<StreamFilter<T> >(getArray<T>(b), feedback, domain);
+}
+
+static af_err createStreamFilter(af_stream_filter *out, const af_array b, const af_array a,
+                                 const af_conv_domain domain)
+{
+    try {
+        ArrayInfo binfo = getInfo(b);
+        ARG_ASSERT(1, binfo.ndims() == 1);
+        if (a != 0) {
+            ArrayInfo ainfo = getInfo(a);
+            ARG_ASSERT(2, ainfo.getType() == binfo.getType());
+            ARG_ASSERT(2, ainfo.ndims() == 1);
+        }
+
+        std::unique_ptr<StreamFilterHandle> h(new StreamFilterHandle);
+        h->type = binfo.getType();
+
+        switch (h->type) {
+            case f32: h->filter = createFilter<float  >(b, a, domain); break;
+            case f64: h->filter = createFilter<double >(b, a, domain); break;
+            case c32: h->filter = createFilter<cfloat >(b, a, domain); break;
+            case c64: h->filter = createFilter<cdouble>(b, a, domain); break;
+            default:  TYPE_ERROR(1, h->type);
+        }
+
+        *out = static_cast<af_stream_filter>(h.release());
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_create_fir_stream(af_stream_filter *out, const af_array b, const af_conv_domain domain)
+{
+    return createStreamFilter(out, b, 0, domain);
+}
+
+af_err af_create_iir_stream(af_stream_filter *out, const af_array b, const af_array a)
+{
+    try {
+        ARG_ASSERT(2, getInfo(a).getType() == getInfo(b).getType());
+
+        // With only a0, the filter is b / a0
+        if (getInfo(a).elements() == 1) {
+            af_array bnorm = 0;
+            AF_CHECK(af_div(&bnorm, b, a, true));
+            af_err err = createStreamFilter(out, bnorm, 0, AF_CONV_AUTO);
+            AF_CHECK(af_release_array(bnorm));
+            return err;
+        }
+    } CATCHALL;
+
+    return createStreamFilter(out, b, a, AF_CONV_AUTO);
+}
+
+af_err af_retain_stream_filter(af_stream_filter *out, const af_stream_filter in)
+{
+    try {
+        const StreamFilterHandle *h = getStreamFilter(in);
+        *out = static_cast<af_stream_filter>(new StreamFilterHandle(*h));
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_release_stream_filter(af_stream_filter filter)
+{
+    try {
+        delete getStreamFilter(filter);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+template<typename T>
+static inline af_array streamPush(const StreamFilterHandle *h, const af_array x)
+{
+    StreamFilter<T> *f = static_cast<StreamFilter<T> *>(h->filter.get());
+    return getHandle(f->push(getArray<T>(x)));
+}
+
+template<typename T>
+static inline void streamReset(const StreamFilterHandle *h)
+{
+    static_cast<StreamFilter<T> *>(h->filter.get())->reset();
+}
+
+af_err af_stream_filter_push(af_array *y, af_stream_filter filter, const af_array x)
+{
+    try {
+        const StreamFilterHandle *h = getStreamFilter(filter);
+        ArrayInfo xinfo = getInfo(x);
+
+        TYPE_ASSERT(h->type == xinfo.getType());
+
+        if (xinfo.ndims() == 0) {
+            return af_retain_array(y, x);
+        }
+
+        af_array output = 0;
+        switch (h->type) {
+            case f32: output = streamPush<float  >(h, x); break;
+            case f64: output = streamPush<double >(h, x); break;
+            case c32: output = streamPush<cfloat >(h, x); break;
+            case c64: output = streamPush<cdouble>(h, x); break;
+            default:  TYPE_ERROR(1, h->type);
+        }
+        std::swap(*y, output);
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
+
+af_err af_stream_filter_reset(af_stream_filter filter)
+{
+    try {
+        const StreamFilterHandle *h = getStreamFilter(filter);
+        switch (h->type) {
+            case f32: streamReset<float  >(h); break;
+            case f64: streamReset<double >(h); break;
+            case c32: streamReset<cfloat >(h); break;
+            case c64: streamReset<cdouble>(h); break;
+            default:  TYPE_ERROR(1, h->type);
+        }
+    } CATCHALL;
+
+    return AF_SUCCESS;
+}
@@ -60,3 +60,52 @@ af_err af_where(af_array *idx, const af_array in)
 
     return AF_SUCCESS;
 }
+
+template<typename T>
+static inline af_array compact(const af_array in, const af_array mask)
+{
+    return getHandle(compact<T>(getArray<T>(in), getArray<char>(mask)));
+}
+
+af_err af_compact(af_array *out, const af_array in, const af_array mask)
+{
+    try {
+        ArrayInfo i_info = getInfo(in);
+        ArrayInfo m_info = getInfo(mask);
+        af_dtype type = i_info.getType();
+
+        ARG_ASSERT(2, m_info.getType() == b8);
+
+        if (i_info.ndims() == 0 || m_info.ndims() == 0) {
+            dim_t my_dims[] = {0, 0, 0, 0};
+            return af_create_handle(out, AF_MAX_DIMS, my_dims, type);
+        }
+
+        // Either one mask value per element or one per row
+        const bool byElement = m_info.dims() == i_info.dims();
+        const bool byRow = m_info.isVector() && (dim_t)m_info.elements() == i_info.dims()[0];
+        ARG_ASSERT(2, byElement || byRow);
+
+        af_array res;
+        switch(type) {
+        case f32: res = compact<float  >(in, mask); break;
+        case f64: res = compact<double >(in, mask); break;
+        case c32: res = compact<cfloat >(in, mask); break;
+        case c64: res = compact<cdouble>(in, mask); break;
+        case s32: res = compact<int    >(in, mask); break;
+        case u32: res = compact<uint   >(in, mask); break;
+        case s64: res = compact<intl   >(in, mask); break;
+        case u64: res = compact<uintl  >(in, mask); break;
+        case s16: res = compact<short  >(in, mask); break;
+        case u16: res = compact<ushort >(in, mask); break;
+        case u8 : res = compact<uchar  >(in, mask); break;
+        case b8 : res = compact<char   >(in, mask); break;
+        default:
+            TYPE_ERROR(1, type);
+        }
+        std::swap(*out, res);
+    }
+    CATCHALL
+
+    return AF_SUCCESS;
+}
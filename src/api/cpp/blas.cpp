@@ -69,6 +69,40 @@ namespace af
         }
     }
 
+    // Stores val as a scalar of type ty. The storage is large enough for c64.
+    static void setScalar(double *storage, const dtype ty, const double val)
+    {
+        float *fstorage = reinterpret_cast<float *>(storage);
+        switch (ty) {
+        case f32: fstorage[0] = val;                 break;
+        case c32: fstorage[0] = val; fstorage[1] = 0; break;
+        case c64: storage[0]  = val; storage[1]  = 0; break;
+        default:  storage[0]  = val;                 break;
+        }
+    }
+
+    void gemm(array &C, const array &lhs, const array &rhs,
+              const array &bias, const activation act,
+              const double alpha, const double beta,
+              const matProp optLhs, const matProp optRhs)
+    {
+        double a[2], b[2];
+        setScalar(a, lhs.type(), alpha);
+        setScalar(b, lhs.type(), beta);
+
+        af_array out = C.isempty() ? 0 : C.get();
+        AF_THROW(af_gemm_fused(&out, optLhs, optRhs, a, lhs.get(), rhs.get(), b,
+                               bias.isempty() ? 0 : bias.get(), act));
+        if (C.isempty()) C = array(out);
+    }
+
+    void gemm(array &C, const array &lhs, const array &rhs,
+              const double alpha, const double beta,
+              const matProp optLhs, const matProp optRhs)
+    {
+        gemm(C, lhs, rhs, array(), AF_ACTIVATION_NONE, alpha, beta, optLhs, optRhs);
+    }
+
     array dot(const array &lhs, const array &rhs,
               const matProp optLhs, const matProp optRhs)
     {
@@ -57,6 +57,11 @@ array convolve3(const array& signal, const array& filter, const convMode mode, c
     return array(out);
 }
 
+void calibrateConvolve(const char *path)
+{
+    AF_THROW(af_calibrate_convolve(path));
+}
+
 array filter(const array& image, const array& kernel)
 {
     return convolve(image, kernel, AF_CONV_DEFAULT, AF_CONV_AUTO);
@@ -29,4 +29,11 @@ array iir(const array &b, const array& a, const array& x)
     return array(out);
 }
 
+array iirSos(const array &sos, const array& x)
+{
+    af_array out = 0;
+    AF_THROW(af_iir_sos(&out, sos.get(), x.get()));
+    return array(out);
+}
+
 }
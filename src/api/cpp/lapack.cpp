@@ -110,6 +110,17 @@ namespace af
         return array(out);
     }
 
+    array solveIterative(const array &a, const array &b,
+                         const iterativeMethod method, const preconditioner precond,
+                         const double tol, const unsigned maxIter, const unsigned restart,
+                         unsigned *iterations, double *residual)
+    {
+        af_array out;
+        AF_THROW(af_solve_iterative(&out, iterations, residual, a.get(), b.get(),
+                                    method, precond, tol, maxIter, restart));
+        return array(out);
+    }
+
     array inverse(const array &in, const matProp options)
     {
         af_array out;
@@ -0,0 +1,32 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/image.h>
+#include <af/array.h>
+#include <vector>
+#include "error.hpp"
+
+namespace af
+{
+
+void pyramidGaussian(array *out, const array &in, const unsigned levels)
+{
+    std::vector<af_array> res(levels);
+    AF_THROW(af_pyramid_gaussian(res.data(), in.get(), levels));
+    for (unsigned l = 0; l < levels; l++) out[l] = array(res[l]);
+}
+
+void pyramidLaplacian(array *out, const array &in, const unsigned levels)
+{
+    std::vector<af_array> res(levels);
+    AF_THROW(af_pyramid_laplacian(res.data(), in.get(), levels));
+    for (unsigned l = 0; l < levels; l++) out[l] = array(res[l]);
+}
+
+}
@@ -249,4 +249,24 @@ INSTANTIATE(product_nan, product)
 
     INSTANTIATE(min)
     INSTANTIATE(max)
+
+    void reduceByKey(array &keys_out, array &vals_out,
+                     const array &keys, const array &vals,
+                     const int dim, const binaryOp op, const bool is_sorted)
+    {
+        af_array okeys = 0, ovals = 0;
+        AF_THROW(af_reduce_by_key(&okeys, &ovals, keys.get(), vals.get(), dim, op, is_sorted));
+        keys_out = array(okeys);
+        vals_out = array(ovals);
+    }
+
+    void countByKey(array &keys_out, array &vals_out,
+                    const array &keys, const array &vals,
+                    const int dim, const bool is_sorted)
+    {
+        af_array okeys = 0, ovals = 0;
+        AF_THROW(af_count_by_key(&okeys, &ovals, keys.get(), vals.get(), dim, is_sorted));
+        keys_out = array(okeys);
+        vals_out = array(ovals);
+    }
 }
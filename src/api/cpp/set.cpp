@@ -51,4 +51,32 @@ array setIntersect(const array &first, const array &second, const bool is_unique
     return array(out);
 }
 
+array setUniqueStable(const array &in)
+{
+    af_array out = 0;
+    AF_THROW(af_set_unique_stable(&out, in.get()));
+    return array(out);
+}
+
+array setUnionStable(const array &first, const array &second)
+{
+    af_array out = 0;
+    AF_THROW(af_set_union_stable(&out, first.get(), second.get()));
+    return array(out);
+}
+
+array setIntersectStable(const array &first, const array &second)
+{
+    af_array out = 0;
+    AF_THROW(af_set_intersect_stable(&out, first.get(), second.get()));
+    return array(out);
+}
+
+array setContains(const array &elements, const array &set)
+{
+    af_array out = 0;
+    AF_THROW(af_set_contains(&out, elements.get(), set.get()));
+    return array(out);
+}
+
 }
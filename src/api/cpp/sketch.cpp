@@ -0,0 +1,80 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/statistics.h>
+#include <af/array.h>
+#include "error.hpp"
+
+namespace af
+{
+
+array quantileSketch(const array& in, const double compression)
+{
+    af_array out = 0;
+    AF_THROW(af_quantile_sketch(&out, in.get(), compression));
+    return array(out);
+}
+
+array quantileSketchMerge(const array& lhs, const array& rhs, const double compression)
+{
+    af_array out = 0;
+    AF_THROW(af_quantile_sketch_merge(&out, lhs.get(), rhs.get(), compression));
+    return array(out);
+}
+
+array quantileSketchQuery(const array& sketch, const array& probs)
+{
+    af_array out = 0;
+    AF_THROW(af_quantile_sketch_query(&out, sketch.get(), probs.get()));
+    return array(out);
+}
+
+array distinctSketch(const array& in, const unsigned precision)
+{
+    af_array out = 0;
+    AF_THROW(af_distinct_sketch(&out, in.get(), precision));
+    return array(out);
+}
+
+array distinctSketchMerge(const array& lhs, const array& rhs)
+{
+    af_array out = 0;
+    AF_THROW(af_distinct_sketch_merge(&out, lhs.get(), rhs.get()));
+    return array(out);
+}
+
+double distinctSketchCount(const array& sketch)
+{
+    double count = 0;
+    AF_THROW(af_distinct_sketch_count(&count, sketch.get()));
+    return count;
+}
+
+array frequencySketch(const array& in, const unsigned width, const unsigned depth)
+{
+    af_array out = 0;
+    AF_THROW(af_frequency_sketch(&out, in.get(), width, depth));
+    return array(out);
+}
+
+array frequencySketchMerge(const array& lhs, const array& rhs)
+{
+    af_array out = 0;
+    AF_THROW(af_frequency_sketch_merge(&out, lhs.get(), rhs.get()));
+    return array(out);
+}
+
+array frequencySketchQuery(const array& sketch, const array& values)
+{
+    af_array out = 0;
+    AF_THROW(af_frequency_sketch_query(&out, sketch.get(), values.get()));
+    return array(out);
+}
+
+}
@@ -104,4 +104,74 @@ namespace af
         AF_THROW(af_sparse_get_storage(&out, in.get()));
         return out;
     }
+
+    sparseOperator::sparseOperator(const array &sparse, const matProp optLhs,
+                                   const dim_t ncols) : op(0)
+    {
+        AF_THROW(af_create_sparse_operator(&op, sparse.get(), optLhs, ncols));
+    }
+
+    sparseOperator::sparseOperator(const sparseOperator &other) : op(0)
+    {
+        AF_THROW(af_retain_sparse_operator(&op, other.get()));
+    }
+
+    sparseOperator::~sparseOperator()
+    {
+        if (op) {
+            af_release_sparse_operator(op);
+        }
+    }
+
+    sparseOperator& sparseOperator::operator= (const sparseOperator &other)
+    {
+        if (this != &other) {
+            AF_THROW(af_release_sparse_operator(op));
+            AF_THROW(af_retain_sparse_operator(&op, other.get()));
+        }
+        return *this;
+    }
+
+    af_sparse_operator sparseOperator::get() const
+    {
+        return op;
+    }
+
+    array matmul(const sparseOperator &lhs, const array &rhs)
+    {
+        af_array out = 0;
+        AF_THROW(af_sparse_operator_matmul(&out, lhs.get(), rhs.get()));
+        return array(out);
+    }
+
+    array sparseAdd(const array &lhs, const array &rhs)
+    {
+        af_array out = 0;
+        AF_THROW(af_sparse_add(&out, lhs.get(), rhs.get()));
+        return array(out);
+    }
+
+    array sparseMul(const array &lhs, const array &rhs)
+    {
+        af_array out = 0;
+        AF_THROW(af_sparse_mul(&out, lhs.get(), rhs.get()));
+        return array(out);
+    }
+
+    array sparseMatmul(const array &lhs, const array &rhs)
+    {
+        af_array out = 0;
+        AF_THROW(af_sparse_sparse_matmul(&out, lhs.get(), rhs.get()));
+        return array(out);
+    }
+
+    array sparseAssemble(const dim_t nRows, const dim_t nCols,
+                         const array &values, const array &rowIdx, const array &colIdx,
+                         const sparseDuplicates dups)
+    {
+        af_array out = 0;
+        AF_THROW(af_sparse_assemble(&out, nRows, nCols,
+                                    values.get(), rowIdx.get(), colIdx.get(), dups));
+        return array(out);
+    }
 }
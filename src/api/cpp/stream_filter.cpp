@@ -0,0 +1,65 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/signal.h>
+#include <af/array.h>
+#include "error.hpp"
+
+namespace af
+{
+
+streamFilter::streamFilter(const array &b, const convDomain domain) : filter(0)
+{
+    AF_THROW(af_create_fir_stream(&filter, b.get(), domain));
+}
+
+streamFilter::streamFilter(const array &b, const array &a) : filter(0)
+{
+    AF_THROW(af_create_iir_stream(&filter, b.get(), a.get()));
+}
+
+streamFilter::streamFilter(const streamFilter &other) : filter(0)
+{
+    AF_THROW(af_retain_stream_filter(&filter, other.get()));
+}
+
+streamFilter::~streamFilter()
+{
+    if (filter) {
+        af_release_stream_filter(filter);
+    }
+}
+
+streamFilter& streamFilter::operator= (const streamFilter &other)
+{
+    if (this != &other) {
+        AF_THROW(af_release_stream_filter(filter));
+        AF_THROW(af_retain_stream_filter(&filter, other.get()));
+    }
+    return *this;
+}
+
+array streamFilter::push(const array &x)
+{
+    af_array out = 0;
+    AF_THROW(af_stream_filter_push(&out, filter, x.get()));
+    return array(out);
+}
+
+void streamFilter::reset()
+{
+    AF_THROW(af_stream_filter_reset(filter));
+}
+
+af_stream_filter streamFilter::get() const
+{
+    return filter;
+}
+
+}
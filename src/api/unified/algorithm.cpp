@@ -104,6 +104,12 @@ af_err af_where(af_array *idx, const af_array in)
     return CALL(idx, in);
 }
 
+af_err af_compact(af_array *out, const af_array in, const af_array mask)
+{
+    CHECK_ARRAYS(in, mask);
+    return CALL(out, in, mask);
+}
+
 af_err af_scan(af_array* out, const af_array in, const int dim, af_binary_op op, bool inclusive_scan)
 {
     CHECK_ARRAYS(in);
@@ -116,6 +122,22 @@ af_err af_scan_by_key(af_array* out, const af_array key, const af_array in, cons
     return CALL(out, key, in, dim, op, inclusive_scan);
 }
 
+af_err af_reduce_by_key(af_array *keys_out, af_array *vals_out,
+                        const af_array keys, const af_array vals,
+                        const int dim, const af_binary_op op, const bool is_sorted)
+{
+    CHECK_ARRAYS(keys, vals);
+    return CALL(keys_out, vals_out, keys, vals, dim, op, is_sorted);
+}
+
+af_err af_count_by_key(af_array *keys_out, af_array *vals_out,
+                       const af_array keys, const af_array vals,
+                       const int dim, const bool is_sorted)
+{
+    CHECK_ARRAYS(keys, vals);
+    return CALL(keys_out, vals_out, keys, vals, dim, is_sorted);
+}
+
 af_err af_sort(af_array *out, const af_array in, const unsigned dim, const bool isAscending)
 {
     CHECK_ARRAYS(in);
@@ -158,3 +180,30 @@ af_err af_set_intersect(af_array *out,
     CHECK_ARRAYS(first, second);
     return CALL(out, first, second, is_unique);
 }
+
+af_err af_set_unique_stable(af_array *out, const af_array in)
+{
+    CHECK_ARRAYS(in);
+    return CALL(out, in);
+}
+
+af_err af_set_union_stable(af_array *out,
+                           const af_array first, const af_array second)
+{
+    CHECK_ARRAYS(first, second);
+    return CALL(out, first, second);
+}
+
+af_err af_set_intersect_stable(af_array *out,
+                               const af_array first, const af_array second)
+{
+    CHECK_ARRAYS(first, second);
+    return CALL(out, first, second);
+}
+
+af_err af_set_contains(af_array *out,
+                       const af_array elements, const af_array set)
+{
+    CHECK_ARRAYS(elements, set);
+    return CALL(out, elements, set);
+}
@@ -18,6 +18,21 @@ af_err af_matmul( af_array *out ,
     return CALL(out, lhs, rhs, optLhs, optRhs);
 }
 
+af_err af_gemm(af_array *C, const af_mat_prop optLhs, const af_mat_prop optRhs,
+               const void *alpha, const af_array lhs, const af_array rhs,
+               const void *beta)
+{
+    CHECK_ARRAYS(lhs, rhs, *C);
+    return CALL(C, optLhs, optRhs, alpha, lhs, rhs, beta);
+}
+
+af_err af_gemm_fused(af_array *C, const af_mat_prop optLhs, const af_mat_prop optRhs,
+                     const void *alpha, const af_array lhs, const af_array rhs,
+                     const void *beta, const af_array bias, const af_activation act)
+{
+    CHECK_ARRAYS(lhs, rhs, *C, bias);
+    return CALL(C, optLhs, optRhs, alpha, lhs, rhs, beta, bias, act);
+}
 
 af_err af_dot(af_array *out,
         const af_array lhs, const af_array rhs,
@@ -116,6 +116,13 @@ af_err af_histogram(af_array *out, const af_array in, const unsigned nbins, cons
     return CALL(out, in, nbins, minval, maxval);
 }
 
+af_err af_weighted_histogram(af_array *out, const af_array in, const af_array weights,
+                             const unsigned nbins, const double minval, const double maxval)
+{
+    CHECK_ARRAYS(in, weights);
+    return CALL(out, in, weights, nbins, minval, maxval);
+}
+
 af_err af_dilate(af_array *out, const af_array in, const af_array mask)
 {
     CHECK_ARRAYS(in, mask);
@@ -146,6 +153,24 @@ af_err af_bilateral(af_array *out, const af_array in, const float spatial_sigma,
     return CALL(out, in, spatial_sigma, chromatic_sigma, isColor);
 }
 
+af_err af_bilateral_grid(af_array *out, const af_array in, const float spatial_sigma, const float chromatic_sigma, const bool isColor)
+{
+    CHECK_ARRAYS(in);
+    return CALL(out, in, spatial_sigma, chromatic_sigma, isColor);
+}
+
+af_err af_pyramid_gaussian(af_array *out, const af_array in, const unsigned levels)
+{
+    CHECK_ARRAYS(in);
+    return CALL(out, in, levels);
+}
+
+af_err af_pyramid_laplacian(af_array *out, const af_array in, const unsigned levels)
+{
+    CHECK_ARRAYS(in);
+    return CALL(out, in, levels);
+}
+
 af_err af_mean_shift(af_array *out, const af_array in, const float spatial_sigma, const float chromatic_sigma, const unsigned iter, const bool is_color)
 {
     CHECK_ARRAYS(in);
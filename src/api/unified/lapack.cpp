@@ -73,6 +73,15 @@ af_err af_solve_lu(af_array *x, const af_array a, const af_array piv,
     return CALL(x, a, piv, b, options);
 }
 
+af_err af_solve_iterative(af_array *x, unsigned *iterations, double *residual,
+                          const af_array a, const af_array b,
+                          const af_iterative_method method, const af_preconditioner precond,
+                          const double tol, const unsigned maxIter, const unsigned restart)
+{
+    CHECK_ARRAYS(a, b);
+    return CALL(x, iterations, residual, a, b, method, precond, tol, maxIter, restart);
+}
+
 af_err af_inverse(af_array *out, const af_array in, const af_mat_prop options)
 {
     CHECK_ARRAYS(in);
@@ -135,6 +135,11 @@ af_err af_convolve2_sep(af_array *out, const af_array col_filter, const af_array
     return CALL(out, col_filter, row_filter, signal, mode);
 }
 
+af_err af_calibrate_convolve(const char *path)
+{
+    return CALL(path);
+}
+
 af_err af_fir(af_array *y, const af_array b, const af_array x)
 {
     CHECK_ARRAYS(b, x);
@@ -147,6 +152,45 @@ af_err af_iir(af_array *y, const af_array b, const af_array a, const af_array x)
     return CALL(y, b, a, x);
 }
 
+af_err af_iir_sos(af_array *y, const af_array sos, const af_array x)
+{
+    CHECK_ARRAYS(sos, x);
+    return CALL(y, sos, x);
+}
+
+af_err af_create_fir_stream(af_stream_filter *out, const af_array b, const af_conv_domain domain)
+{
+    CHECK_ARRAYS(b);
+    return CALL(out, b, domain);
+}
+
+af_err af_create_iir_stream(af_stream_filter *out, const af_array b, const af_array a)
+{
+    CHECK_ARRAYS(b, a);
+    return CALL(out, b, a);
+}
+
+af_err af_retain_stream_filter(af_stream_filter *out, const af_stream_filter in)
+{
+    return CALL(out, in);
+}
+
+af_err af_release_stream_filter(af_stream_filter filter)
+{
+    return CALL(filter);
+}
+
+af_err af_stream_filter_push(af_array *y, af_stream_filter filter, const af_array x)
+{
+    CHECK_ARRAYS(x);
+    return CALL(y, filter, x);
+}
+
+af_err af_stream_filter_reset(af_stream_filter filter)
+{
+    return CALL(filter);
+}
+
 
 af_err af_medfilt(af_array *out, const af_array in, const dim_t wind_length, const dim_t wind_width, const af_border_type edge_pad)
 {
@@ -88,3 +88,54 @@ af_err af_sparse_get_storage(af_storage *out, const af_array in)
     CHECK_ARRAYS(in);
     return CALL(out, in);
 }
+
+af_err af_create_sparse_operator(af_sparse_operator *out, const af_array sparse,
+                                 const af_mat_prop optLhs, const dim_t ncols)
+{
+    CHECK_ARRAYS(sparse);
+    return CALL(out, sparse, optLhs, ncols);
+}
+
+af_err af_retain_sparse_operator(af_sparse_operator *out, const af_sparse_operator in)
+{
+    return CALL(out, in);
+}
+
+af_err af_release_sparse_operator(af_sparse_operator op)
+{
+    return CALL(op);
+}
+
+af_err af_sparse_operator_matmul(af_array *out, const af_sparse_operator op,
+                                 const af_array rhs)
+{
+    CHECK_ARRAYS(rhs);
+    return CALL(out, op, rhs);
+}
+
+af_err af_sparse_add(af_array *out, const af_array lhs, const af_array rhs)
+{
+    CHECK_ARRAYS(lhs, rhs);
+    return CALL(out, lhs, rhs);
+}
+
+af_err af_sparse_mul(af_array *out, const af_array lhs, const af_array rhs)
+{
+    CHECK_ARRAYS(lhs, rhs);
+    return CALL(out, lhs, rhs);
+}
+
+af_err af_sparse_sparse_matmul(af_array *out, const af_array lhs, const af_array rhs)
+{
+    CHECK_ARRAYS(lhs, rhs);
+    return CALL(out, lhs, rhs);
+}
+
+af_err af_sparse_assemble(af_array *out,
+                          const dim_t nRows, const dim_t nCols,
+                          const af_array values, const af_array rowIdx, const af_array colIdx,
+                          const af_sparse_duplicates dups)
+{
+    CHECK_ARRAYS(values, rowIdx, colIdx);
+    return CALL(out, nRows, nCols, values, rowIdx, colIdx, dups);
+}
@@ -94,3 +94,57 @@ af_err af_corrcoef(double *realVal, double *imagVal, const af_array X, const af_
     CHECK_ARRAYS(X, Y);
     return CALL(realVal, imagVal, X, Y);
 }
+
+af_err af_quantile_sketch(af_array *out, const af_array in, const double compression)
+{
+    CHECK_ARRAYS(in);
+    return CALL(out, in, compression);
+}
+
+af_err af_quantile_sketch_merge(af_array *out, const af_array lhs, const af_array rhs, const double compression)
+{
+    CHECK_ARRAYS(lhs, rhs);
+    return CALL(out, lhs, rhs, compression);
+}
+
+af_err af_quantile_sketch_query(af_array *out, const af_array sketch, const af_array probs)
+{
+    CHECK_ARRAYS(sketch, probs);
+    return CALL(out, sketch, probs);
+}
+
+af_err af_distinct_sketch(af_array *out, const af_array in, const unsigned precision)
+{
+    CHECK_ARRAYS(in);
+    return CALL(out, in, precision);
+}
+
+af_err af_distinct_sketch_merge(af_array *out, const af_array lhs, const af_array rhs)
+{
+    CHECK_ARRAYS(lhs, rhs);
+    return CALL(out, lhs, rhs);
+}
+
+af_err af_distinct_sketch_count(double *count, const af_array sketch)
+{
+    CHECK_ARRAYS(sketch);
+    return CALL(count, sketch);
+}
+
+af_err af_frequency_sketch(af_array *out, const af_array in, const unsigned width, const unsigned depth)
+{
+    CHECK_ARRAYS(in);
+    return CALL(out, in, width, depth);
+}
+
+af_err af_frequency_sketch_merge(af_array *out, const af_array lhs, const af_array rhs)
+{
+    CHECK_ARRAYS(lhs, rhs);
+    return CALL(out, lhs, rhs);
+}
+
+af_err af_frequency_sketch_query(af_array *out, const af_array sketch, const af_array values)
+{
+    CHECK_ARRAYS(sketch, values);
+    return CALL(out, sketch, values);
+}
@@ -91,6 +91,13 @@ dim_t SparseArrayBase::getNNZ() const
         return rowIdx.elements();
     else if(stype == AF_STORAGE_CSR)
         return colIdx.elements();
+    else if(stype == AF_STORAGE_SELL)   // Includes the padding of the slices
+        return colIdx.elements();
+    else if(stype == AF_STORAGE_BSR && rowIdx.elements() > 1) {
+        // One bs x bs block per column index
+        const dim_t bs = info.dims()[0] / (rowIdx.elements() - 1);
+        return colIdx.elements() * bs * bs;
+    }
 
     // This is to ensure future storages are properly configured
     return 0;
@@ -12,8 +12,11 @@
 #include <cassert>
 #include <err_common.hpp>
 #include <kernel/dot.hpp>
+#include <kernel/gemm.hpp>
+#include <parallel.hpp>
 #include <platform.hpp>
 #include <queue.hpp>
+#include <vector>
 
 namespace cpu
 {
@@ -117,6 +120,22 @@ BLAS_FUNC(gemv , double  , d)
 BLAS_FUNC(gemv , cfloat  , c)
 BLAS_FUNC(gemv , cdouble , z)
 
+#ifdef USE_MKL
+template<typename T>
+using gemm_batch_func_def = void (*)( const CBLAS_ORDER, const CBLAS_TRANSPOSE *, const CBLAS_TRANSPOSE *,
+                                      const MKL_INT *, const MKL_INT *, const MKL_INT *,
+                                      cptr_type<T>, cptr_type<T> *, const MKL_INT *,
+                                      cptr_type<T> *, const MKL_INT *,
+                                      cptr_type<T>, ptr_type<T> *, const MKL_INT *,
+                                      const MKL_INT, const MKL_INT *);
+
+BLAS_FUNC_DEF(gemm_batch)
+BLAS_FUNC(gemm_batch , float   , s)
+BLAS_FUNC(gemm_batch , double  , d)
+BLAS_FUNC(gemm_batch , cfloat  , c)
+BLAS_FUNC(gemm_batch , cdouble , z)
+#endif
+
 template<typename T, int value>
 typename enable_if<is_floating_point<T>::value, scale_type<T>>::type
 getScale() { return T(value); }
@@ -129,6 +148,14 @@ getScale()
     return (const typename blas_base<T>::type *)&val;
 }
 
+template<typename T>
+typename enable_if<is_floating_point<T>::value, scale_type<T>>::type
+toScale(const T &val) { return val; }
+
+template<typename T>
+typename enable_if<is_complex<T>::value, scale_type<T>>::type
+toScale(const T &val) { return (const typename blas_base<T>::type *)&val; }
+
 CBLAS_TRANSPOSE
 toCblasTranspose(af_mat_prop opt)
 {
@@ -142,6 +169,116 @@ toCblasTranspose(af_mat_prop opt)
     return out;
 }
 
+// output = act(alpha * op(left) * op(right) + beta * output + bias) for every
+// matrix along dimensions 2 and 3 of output. A dimension of size 1 on one
+// side is broadcast against the other side. output is linear. bias is null or
+// a vector that gemmEpilogue adds to every matrix.
+template<typename T>
+void gemmBatched(Array<T> output, const Array<T> left, const Array<T> right,
+                 af_mat_prop optLhs, af_mat_prop optRhs,
+                 const int M, const int N, const int K,
+                 const T alpha, const T beta,
+                 const T *bias, const bool biasPerRow, const af_activation act)
+{
+    const dim4 lDims    = left.dims();
+    const dim4 rDims    = right.dims();
+    const dim4 oDims    = output.dims();
+    const dim4 lStrides = left.strides();
+    const dim4 rStrides = right.strides();
+
+    const dim_t nbatch  = oDims[2] * oDims[3];
+    const dim_t oStride = oDims[0] * oDims[1];
+    const dim_t work    = (dim_t)M * N * K;
+    if (nbatch == 0) return;
+
+    const T *lptr = left.get();
+    const T *rptr = right.get();
+    T       *optr = output.get();
+
+    auto lOffset = [&](dim_t b) {
+        return (lDims[2] == 1 ? 0 : (b % oDims[2]) * lStrides[2]) +
+               (lDims[3] == 1 ? 0 : (b / oDims[2]) * lStrides[3]);
+    };
+    auto rOffset = [&](dim_t b) {
+        return (rDims[2] == 1 ? 0 : (b % oDims[2]) * rStrides[2]) +
+               (rDims[3] == 1 ? 0 : (b / oDims[2]) * rStrides[3]);
+    };
+
+    const bool epilogue = bias || act != AF_ACTIVATION_NONE;
+    auto finish = [&](dim_t b) {
+        if (epilogue) kernel::gemmEpilogue(optr + b * oStride, M, N, bias, biasPerRow, act);
+    };
+
+    if (M <= kernel::GEMM_SMALL_DIM &&
+        N <= kernel::GEMM_SMALL_DIM &&
+        K <= kernel::GEMM_SMALL_DIM) {
+        kernel::gemm_fixed_func<T> fixed = kernel::getGemmFixed<T>(M, N, K);
+        if (fixed) {
+            forEachMatrix(nbatch, work, [&](dim_t b) {
+                fixed(optr + b * oStride, M,
+                      lptr + lOffset(b), lStrides[1], optLhs,
+                      rptr + rOffset(b), rStrides[1], optRhs,
+                      alpha, beta);
+                finish(b);
+            });
+        } else {
+            forEachMatrix(nbatch, work, [&](dim_t b) {
+                kernel::gemmSmall(optr + b * oStride, M,
+                                  lptr + lOffset(b), lStrides[1], optLhs,
+                                  rptr + rOffset(b), rStrides[1], optRhs,
+                                  M, N, K, alpha, beta);
+                finish(b);
+            });
+        }
+        return;
+    }
+
+    using BT  =       typename blas_base<T>::type;
+    using CBT = const typename blas_base<T>::type;
+
+    CBLAS_TRANSPOSE lOpts = toCblasTranspose(optLhs);
+    CBLAS_TRANSPOSE rOpts = toCblasTranspose(optRhs);
+
+#ifdef USE_MKL
+    if (nbatch > 1) {
+        std::vector<cptr_type<T>> lPtrs(nbatch);
+        std::vector<cptr_type<T>> rPtrs(nbatch);
+        std::vector<ptr_type<T>>  oPtrs(nbatch);
+        for (dim_t b = 0; b < nbatch; ++b) {
+            lPtrs[b] = reinterpret_cast<CBT*>(lptr + lOffset(b));
+            rPtrs[b] = reinterpret_cast<CBT*>(rptr + rOffset(b));
+            oPtrs[b] = reinterpret_cast<BT*>(optr + b * oStride);
+        }
+
+        const MKL_INT m = M, n = N, k = K;
+        const MKL_INT lda = lStrides[1], ldb = rStrides[1], ldc = M;
+        const MKL_INT groupSize = nbatch;
+        gemm_batch_func<T>()(
+            CblasColMajor, &lOpts, &rOpts,
+            &m, &n, &k,
+            reinterpret_cast<CBT*>(&alpha), &lPtrs.front(), &lda,
+            &rPtrs.front(), &ldb,
+            reinterpret_cast<CBT*>(&beta), &oPtrs.front(), &ldc,
+            1, &groupSize);
+
+        if (epilogue) forEachMatrix(nbatch, (dim_t)M * N, finish);
+        return;
+    }
+#endif
+
+    forEachMatrix(nbatch, work, [&](dim_t b) {
+        gemm_func<T>()(
+            CblasColMajor, lOpts, rOpts,
+            M, N, K,
+            toScale(alpha),
+            reinterpret_cast<CBT*>(lptr + lOffset(b)), lStrides[1],
+            reinterpret_cast<CBT*>(rptr + rOffset(b)), rStrides[1],
+            toScale(beta),
+            reinterpret_cast<BT*>(optr + b * oStride), M);
+        finish(b);
+    });
+}
+
 template<typename T>
 Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
                 af_mat_prop optLhs, af_mat_prop optRhs)
@@ -162,6 +299,19 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
     int N = rDims[bColDim];
     int K = lDims[aColDim];
 
+    // Batches and small matrices skip the generic BLAS call below
+    dim_t batch2 = std::max(lDims[2], rDims[2]);
+    dim_t batch3 = std::max(lDims[3], rDims[3]);
+    bool small   = (M <= kernel::GEMM_SMALL_DIM &&
+                    N <= kernel::GEMM_SMALL_DIM &&
+                    K <= kernel::GEMM_SMALL_DIM);
+    if (batch2 != 1 || batch3 != 1 || small) {
+        Array<T> out = createEmptyArray<T>(af::dim4(M, N, batch2, batch3));
+        getQueue().enqueue(gemmBatched<T>, out, lhs, rhs, optLhs, optRhs, M, N, K,
+                           T(1), T(0), nullptr, false, AF_ACTIVATION_NONE);
+        return out;
+    }
+
     using BT  =       typename blas_base<T>::type;
     using CBT = const typename blas_base<T>::type;
 
@@ -198,6 +348,38 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
     return out;
 }
 
+template<typename T>
+void gemm(Array<T> &out, af_mat_prop optLhs, af_mat_prop optRhs,
+          const T *alpha, const Array<T> &lhs, const Array<T> &rhs, const T *beta,
+          const Array<T> *bias, af_activation act)
+{
+    lhs.eval();
+    rhs.eval();
+    out.eval();
+
+    int M = lhs.dims()[optLhs == AF_MAT_NONE ? 0 : 1];
+    int K = lhs.dims()[optLhs == AF_MAT_NONE ? 1 : 0];
+    int N = rhs.dims()[optRhs == AF_MAT_NONE ? 1 : 0];
+
+    // The scalars are copied since the work runs after this returns
+    const T a = *alpha;
+    const T c = *beta;
+
+    if (bias) {
+        bias->eval();
+        const bool perRow = bias->dims()[0] == M && (dim_t)bias->elements() == M;
+        auto func = [=] (Array<T> output, const Array<T> left, const Array<T> right,
+                         const Array<T> b) {
+            gemmBatched<T>(output, left, right, optLhs, optRhs, M, N, K,
+                           a, c, b.get(), perRow, act);
+        };
+        getQueue().enqueue(func, out, lhs, rhs, *bias);
+    } else {
+        getQueue().enqueue(gemmBatched<T>, out, lhs, rhs, optLhs, optRhs, M, N, K,
+                           a, c, nullptr, false, act);
+    }
+}
+
 template<typename T>
 Array<T> dot(const Array<T> &lhs, const Array<T> &rhs,
              af_mat_prop optLhs, af_mat_prop optRhs)
@@ -223,7 +405,12 @@ Array<T> dot(const Array<T> &lhs, const Array<T> &rhs,
 
 #define INSTANTIATE_BLAS(TYPE)                                                          \
     template Array<TYPE> matmul<TYPE>(const Array<TYPE> &lhs, const Array<TYPE> &rhs,   \
-                                      af_mat_prop optLhs, af_mat_prop optRhs);
+                                      af_mat_prop optLhs, af_mat_prop optRhs);          \
+    template void gemm<TYPE>(Array<TYPE> &out, af_mat_prop optLhs, af_mat_prop optRhs,  \
+                             const TYPE *alpha,                                         \
+                             const Array<TYPE> &lhs, const Array<TYPE> &rhs,            \
+                             const TYPE *beta,                                          \
+                             const Array<TYPE> *bias, af_activation act);
 
 INSTANTIATE_BLAS(float)
 INSTANTIATE_BLAS(cfloat)
@@ -40,6 +40,14 @@ namespace cpu
 template<typename T>
 Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
                 af_mat_prop optLhs, af_mat_prop optRhs);
+// out = act(alpha * op(lhs) * op(rhs) + beta * out + bias) in place. out is
+// linear and has the dims of the product. bias is null, an M x 1 vector added
+// to every column or a 1 x N vector added to every row of every matrix.
+template<typename T>
+void gemm(Array<T> &out, af_mat_prop optLhs, af_mat_prop optRhs,
+          const T *alpha, const Array<T> &lhs, const Array<T> &rhs, const T *beta,
+          const Array<T> *bias, af_activation act);
+
 template<typename T>
 Array<T> dot(const Array<T> &lhs, const Array<T> &rhs,
              af_mat_prop optLhs, af_mat_prop optRhs);
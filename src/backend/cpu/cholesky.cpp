@@ -19,8 +19,11 @@
 #include <err_cpu.hpp>
 #include <triangle.hpp>
 #include <lapack_helper.hpp>
+#include <parallel.hpp>
 #include <platform.hpp>
 #include <queue.hpp>
+#include <kernel/lapack.hpp>
+#include <vector>
 
 namespace cpu
 {
@@ -58,6 +61,8 @@ Array<T> cholesky(int *info, const Array<T> &in, const bool is_upper)
     return out;
 }
 
+// Factorizes every matrix along dimensions 2 and 3 of in. The result is 0
+// when all of them succeed and the info of the first failure otherwise.
 template<typename T>
 int cholesky_inplace(Array<T> &in, const bool is_upper)
 {
@@ -65,20 +70,35 @@ int cholesky_inplace(Array<T> &in, const bool is_upper)
 
     dim4 iDims = in.dims();
     int N = iDims[0];
+    const dim_t nbatch = iDims[2] * iDims[3];
 
     char uplo = 'L';
     if(is_upper)
         uplo = 'U';
 
-    int info = 0;
-    auto func = [&] (int& info, Array<T>& in) {
-        info = potrf_func<T>()(AF_LAPACK_COL_MAJOR, uplo, N, in.get(), in.strides()[1]);
+    std::vector<int> info(nbatch, 0);
+    // info is written through the reference captured here since the queue
+    // passes its arguments by value
+    auto func = [&] (Array<T> in) {
+        T *ptr = in.get();
+        const dim4 strides = in.strides();
+        forEachMatrix(nbatch, (dim_t)N * N * N / 3, [&](dim_t b) {
+            T *A = ptr + kernel::matrixOffset(iDims, strides, b);
+            if (N <= kernel::LAPACK_SMALL_DIM) {
+                info[b] = kernel::potrfSmall(A, N, strides[1], is_upper);
+            } else {
+                info[b] = potrf_func<T>()(AF_LAPACK_COL_MAJOR, uplo, N, A, strides[1]);
+            }
+        });
     };
 
-    getQueue().enqueue(func, info, in);
+    getQueue().enqueue(func, in);
     getQueue().sync();
 
-    return info;
+    for (dim_t b = 0; b < nbatch; ++b) {
+        if (info[b] != 0) return info[b];
+    }
+    return 0;
 }
 
 #define INSTANTIATE_CH(T)                                                                   \
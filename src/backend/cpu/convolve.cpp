@@ -21,6 +21,27 @@ using af::dim4;
 namespace cpu
 {
 
+// Filters that are a sum of a few outer products, like the Gaussian and box
+// filters, are run as that many separable convolutions. The two passes of a
+// separable convolution go through memory, so it is only used when it takes
+// less than a third of the multiply adds of the direct one.
+template<typename T, typename accT, bool expand>
+void convolve2_dense(Array<T> out, Array<T> const signal, Array<accT> const filter,
+                     AF_BATCH_KIND kind)
+{
+    if (kind == AF_BATCH_NONE || kind == AF_BATCH_LHS) {
+        dim4 const fDims = filter.dims();
+        kernel::FilterRank<accT> rank;
+        if (fDims[0] > 1 && fDims[1] > 1 &&
+            kernel::filterRank(rank, filter.get(), fDims[0], fDims[1], filter.strides()[1]) &&
+            3 * rank.rank * (fDims[0] + fDims[1]) < fDims[0] * fDims[1]) {
+            kernel::convolve2_lowrank<T, accT, expand>(out, signal, rank);
+            return;
+        }
+    }
+    kernel::convolve_nd<T, accT, 2, expand>(out, signal, filter, kind);
+}
+
 template<typename T, typename accT, dim_t baseDim, bool expand>
 Array<T> convolve(Array<T> const& signal, Array<accT> const& filter, AF_BATCH_KIND kind)
 {
@@ -49,7 +70,11 @@ Array<T> convolve(Array<T> const& signal, Array<accT> const& filter, AF_BATCH_KI
 
     Array<T> out = createEmptyArray<T>(oDims);
 
-    getQueue().enqueue(kernel::convolve_nd<T, accT, baseDim, expand>,out, signal, filter, kind);
+    if (baseDim == 2) {
+        getQueue().enqueue(convolve2_dense<T, accT, expand>, out, signal, filter, kind);
+    } else {
+        getQueue().enqueue(kernel::convolve_nd<T, accT, baseDim, expand>,out, signal, filter, kind);
+    }
 
     return out;
 }
@@ -10,6 +10,7 @@
 #include <af/dim4.hpp>
 #include <Array.hpp>
 #include <histogram.hpp>
+#include <copy.hpp>
 #include <platform.hpp>
 #include <queue.hpp>
 #include <kernel/histogram.hpp>
@@ -37,6 +38,28 @@ Array<outType> histogram(const Array<inType> &in,
     return out;
 }
 
+template<typename inType, typename outType>
+Array<outType> weightedHistogram(const Array<inType> &in, const Array<outType> &weights,
+                                 const unsigned &nbins, const double &minval, const double &maxval)
+{
+    in.eval();
+    weights.eval();
+
+    // The kernel walks both arrays with the same linear index
+    Array<inType>  lin_in = in.isLinear()      ? in      : copyArray<inType>(in);
+    Array<outType> lin_wt = weights.isLinear() ? weights : copyArray<outType>(weights);
+
+    const dim4 inDims  = in.dims();
+    dim4 outDims       = dim4(nbins,1,inDims[2],inDims[3]);
+    Array<outType> out = createValueArray<outType>(outDims, outType(0));
+    out.eval();
+
+    getQueue().enqueue(kernel::weightedHistogram<outType, inType>,
+            out, lin_in, lin_wt, nbins, minval, maxval);
+
+    return out;
+}
+
 #define INSTANTIATE(in_t,out_t)\
 template Array<out_t> histogram<in_t, out_t, true>(const Array<in_t> &in, const unsigned &nbins, const double &minval, const double &maxval); \
 template Array<out_t> histogram<in_t, out_t, false>(const Array<in_t> &in, const unsigned &nbins, const double &minval, const double &maxval);
@@ -52,4 +75,19 @@ INSTANTIATE(ushort, uint)
 INSTANTIATE(intl  , uint)
 INSTANTIATE(uintl , uint)
 
+#define INSTANTIATE_WEIGHTED(in_t)\
+template Array<float > weightedHistogram<in_t, float >(const Array<in_t> &in, const Array<float > &weights, const unsigned &nbins, const double &minval, const double &maxval); \
+template Array<double> weightedHistogram<in_t, double>(const Array<in_t> &in, const Array<double> &weights, const unsigned &nbins, const double &minval, const double &maxval);
+
+INSTANTIATE_WEIGHTED(float )
+INSTANTIATE_WEIGHTED(double)
+INSTANTIATE_WEIGHTED(char  )
+INSTANTIATE_WEIGHTED(int   )
+INSTANTIATE_WEIGHTED(uint  )
+INSTANTIATE_WEIGHTED(uchar )
+INSTANTIATE_WEIGHTED(short )
+INSTANTIATE_WEIGHTED(ushort)
+INSTANTIATE_WEIGHTED(intl  )
+INSTANTIATE_WEIGHTED(uintl )
+
 }
@@ -45,10 +45,25 @@ Array<T> iir(const Array<T> &b, const Array<T> &a, const Array<T> &x)
     return y;
 }
 
-#define INSTANTIATE(T)                          \
-    template Array<T> iir(const Array<T> &b,    \
-                          const Array<T> &a,    \
-                          const Array<T> &x);   \
+template<typename T>
+Array<T> iirSos(const Array<T> &sos, const Array<T> &x)
+{
+    sos.eval();
+    x.eval();
+
+    Array<T> y = createEmptyArray<T>(x.dims());
+
+    getQueue().enqueue(kernel::iirSos<T>, y, x, sos);
+
+    return y;
+}
+
+#define INSTANTIATE(T)                              \
+    template Array<T> iir(const Array<T> &b,        \
+                          const Array<T> &a,        \
+                          const Array<T> &x);       \
+    template Array<T> iirSos(const Array<T> &sos,   \
+                             const Array<T> &x);    \
 
 INSTANTIATE(float)
 INSTANTIATE(double)
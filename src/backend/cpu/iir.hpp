@@ -14,4 +14,8 @@ namespace cpu
 
 template<typename T>
 Array<T> iir(const Array<T> &b, const Array<T> &a, const Array<T> &x);
+
+// Cascade of the second order sections in the columns of sos
+template<typename T>
+Array<T> iirSos(const Array<T> &sos, const Array<T> &x);
 }
@@ -23,8 +23,10 @@
 #include <lu.hpp>
 #include <identity.hpp>
 #include <solve.hpp>
+#include <parallel.hpp>
 #include <platform.hpp>
 #include <queue.hpp>
+#include <kernel/lapack.hpp>
 
 namespace cpu
 {
@@ -64,9 +66,17 @@ Array<T> inverse(const Array<T> &in)
     Array<int> pivot = lu_inplace<T>(A, false);
 
     auto func = [=] (Array<T> A, Array<int> pivot, int M) {
-        getri_func<T>()(AF_LAPACK_COL_MAJOR, M,
-                A.get(), A.strides()[1],
-                pivot.get());
+        const dim4 aDims    = A.dims();
+        const dim4 aStrides = A.strides();
+        forEachMatrix(aDims[2] * aDims[3], (dim_t)M * M * M, [&](dim_t b) {
+            T *a = A.get() + kernel::matrixOffset(aDims, aStrides, b);
+            const int *ipiv = pivot.get() + b * M;
+            if (M <= kernel::LAPACK_SMALL_DIM) {
+                kernel::getriSmall(a, M, aStrides[1], ipiv);
+            } else {
+                getri_func<T>()(AF_LAPACK_COL_MAJOR, M, a, aStrides[1], ipiv);
+            }
+        });
     };
     getQueue().enqueue(func, A, pivot, M);
 
@@ -10,23 +10,66 @@
 #pragma once
 #include <Array.hpp>
 #include <utility.hpp>
+#include <parallel.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
 
 namespace cpu
 {
 namespace kernel
 {
 
-template<typename OutT, typename InT, bool IsColor>
-void bilateral(Array<OutT> out, Array<InT> const in, float const s_sigma, float const c_sigma)
+// Output columns handled by one task of the exact filter
+static const dim_t BILATERAL_COLS = 8;
+
+// Largest bilateral grid, in cells, built for one image. Finer grids fall
+// back to the exact filter.
+static const double BILATERAL_GRID_MAX_CELLS = double(1 << 23);
+
+// e^x for the weights of the exact filter. The single precision version is
+// the Cephes expf written without calls or conversions, so that the loops
+// using it are vectorised. It is within 1 ulp down to x = -87 and returns
+// about 1e-38 below that.
+static inline double bilateralExp(double const x)
 {
-    af::dim4 const dims     = in.dims();
-    af::dim4 const istrides = in.strides();
-    af::dim4 const ostrides = out.strides();
+    return std::exp(x);
+}
 
-          OutT *outData = out.get();
-    InT const * inData  = in.get();
+static inline float bilateralExp(float const x)
+{
+    // Adding 1.5 * 2^23 rounds to an integer held in the low mantissa bits
+    float const xs = (x > -87.f ? x : -87.f);
+    float const t  = xs * 1.44269504088896341f + 12582912.f;
+    float const n  = t - 12582912.f;
+    float const r  = xs - n * 0.693359375f + n * 2.12194440e-4f;
 
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    p = p * r * r + r + 1.f;
+
+    int bits;
+    std::memcpy(&bits, &t, sizeof(float));
+    bits = (bits - 0x4B400000 + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(float));
+    return (x == x ? p * scale : x);
+}
+
+// Exact bilateral filter of one channel. The window columns are copied into
+// buffers padded by replicating the edges, so that every tap of the window is
+// a bounds free loop over consecutive outputs of a column.
+template<typename OutT, typename InT>
+void bilateralExact(OutT *out, af::dim4 const &ostrides, InT const *in, af::dim4 const &istrides,
+                    af::dim4 const &dims, float const s_sigma, float const c_sigma,
+                    dim_t const j0, dim_t const j1)
+{
     // clamp spatical and chromatic sigma's
     float space_       = std::min(11.5f, std::max(s_sigma, 0.f));
     float color_       = std::max(c_sigma, 0.f);
@@ -34,44 +77,267 @@ void bilateral(Array<OutT> out, Array<InT> const in, float const s_sigma, float
     float const svar   = space_*space_;
     float const cvar   = color_*color_;
 
-    for(dim_t b3=0; b3<dims[3]; ++b3) {
-        // b3 for loop handles following batch configurations
-        //  - gfor
-        //  - input based batch
-        //      - when input is 4d array for color images
-        for(dim_t b2=0; b2<dims[2]; ++b2) {
-            // b2 for loop handles following batch configurations
-            //  - channels
-            //  - input based batch
-            //      - when input is 3d array for grayscale images
-            for(dim_t j=0; j<dims[1]; ++j) {
-                // j steps along 2nd dimension
-                for(dim_t i=0; i<dims[0]; ++i) {
-                    // i steps along 1st dimension
-                    OutT norm = 0.0;
-                    OutT res  = 0.0;
-                    OutT const center = (OutT)inData[getIdx(istrides, i, j)];
-                    for(dim_t wj=-radius; wj<=radius; ++wj) {
-                        // clamps offsets
-                        dim_t tj = clamp(j+wj, 0, dims[1]-1);
-                        for(dim_t wi=-radius; wi<=radius; ++wi) {
-                            // clamps offsets
-                            dim_t ti = clamp(i+wi, 0, dims[0]-1);
-                            // proceed
-                            OutT const val= (OutT)inData[getIdx(istrides, ti, tj)];
-                            OutT const gauss_space = (wi*wi+wj*wj)/(-2.0*svar);
-                            OutT const gauss_range = ((center-val)*(center-val))/(-2.0*cvar);
-                            OutT const weight = std::exp(gauss_space+gauss_range);
-                            norm += weight;
-                            res += val*weight;
-                        }
-                    } // filter loop ends here
-
-                    outData[getIdx(ostrides, i, j)] = res/norm;
-                } //1st dimension loop ends here
-            } //2nd dimension loop ends here
-            outData += ostrides[2];
-            inData  += istrides[2];
+    dim_t const n    = dims[0];
+    dim_t const nPad = n + 2 * radius;
+    dim_t const side = 2 * radius + 1;
+
+    // Spatial part of the exponent of every tap
+    std::vector<OutT> gspace(side * side);
+    for (dim_t wj = -radius; wj <= radius; ++wj) {
+        for (dim_t wi = -radius; wi <= radius; ++wi) {
+            gspace[(wj + radius) * side + wi + radius] = (wi*wi+wj*wj)/(-2.0*svar);
+        }
+    }
+    OutT const rscale = OutT(1) / OutT(-2.0*cvar);
+
+    std::vector<OutT> cols(side * nPad), center(n), norm(n), res(n);
+    for (dim_t j = j0; j < j1; ++j) {
+        for (dim_t wj = -radius; wj <= radius; ++wj) {
+            // clamps offsets
+            dim_t const tj = clamp(j+wj, 0, dims[1]-1);
+            OutT *col = &cols[(wj + radius) * nPad];
+            InT const *src = in + tj * istrides[1];
+            for (dim_t k = 0; k < nPad; ++k) {
+                col[k] = (OutT)src[clamp(k - radius, 0, n - 1) * istrides[0]];
+            }
+        }
+        std::copy(&cols[radius * nPad + radius], &cols[radius * nPad + radius] + n, center.begin());
+        std::fill(norm.begin(), norm.end(), OutT(0));
+        std::fill(res.begin(), res.end(), OutT(0));
+
+        OutT const *c = &center.front();
+        OutT *nrm = &norm.front();
+        OutT *acc = &res.front();
+        for (dim_t wj = 0; wj < side; ++wj) {
+            for (dim_t wi = 0; wi < side; ++wi) {
+                OutT const *val = &cols[wj * nPad + wi];
+                OutT const gs = gspace[wj * side + wi];
+                for (dim_t i = 0; i < n; ++i) {
+                    OutT const d = c[i] - val[i];
+                    OutT const weight = bilateralExp(gs + d * d * rscale);
+                    nrm[i] += weight;
+                    acc[i] += val[i] * weight;
+                }
+            }
+        }
+
+        OutT *dst = out + j * ostrides[1];
+        for (dim_t i = 0; i < n; ++i) dst[i * ostrides[0]] = acc[i] / nrm[i];
+    }
+}
+
+template<typename OutT, typename InT, bool IsColor>
+void bilateral(Array<OutT> out, Array<InT> const in, float const s_sigma, float const c_sigma)
+{
+    af::dim4 const dims     = in.dims();
+    af::dim4 const istrides = in.strides();
+    af::dim4 const ostrides = out.strides();
+
+    // Every channel and batch is filtered on its own
+    dim_t const nBlocks = (dims[1] + BILATERAL_COLS - 1) / BILATERAL_COLS;
+    parallelFor(nBlocks * dims[2] * dims[3], [&](dim_t task) {
+        dim_t const blk = task % nBlocks;
+        dim_t const b2  = (task / nBlocks) % dims[2];
+        dim_t const b3  = (task / nBlocks) / dims[2];
+
+        bilateralExact(out.get() + b2 * ostrides[2] + b3 * ostrides[3], ostrides,
+                       in.get() + b2 * istrides[2] + b3 * istrides[3], istrides,
+                       dims, s_sigma, c_sigma,
+                       blk * BILATERAL_COLS, std::min(dims[1], (blk + 1) * BILATERAL_COLS));
+    });
+}
+
+// Blurs n groups of lanes values by [1 4 6 4 1] / 16, a Gaussian of one
+// cell. Group k starts at data[k * stride] and the grid is zero outside.
+template<typename T>
+void bilateralGridBlur(T *data, dim_t const n, dim_t const stride, dim_t const lanes,
+                       std::vector<T> &buf)
+{
+    buf.assign((n + 4) * lanes, T(0));
+    for (dim_t k = 0; k < n; ++k) {
+        std::copy(data + k * stride, data + k * stride + lanes, buf.begin() + (k + 2) * lanes);
+    }
+    for (dim_t k = 0; k < n; ++k) {
+        T const *b = &buf[k * lanes];
+        T *dst = data + k * stride;
+        for (dim_t l = 0; l < lanes; ++l) {
+            dst[l] = (b[l] + b[4 * lanes + l] + T(4) * (b[lanes + l] + b[3 * lanes + l]) +
+                      T(6) * b[2 * lanes + l]) * T(0.0625);
+        }
+    }
+}
+
+// Approximate bilateral filter of one channel on a bilateral grid (Chen,
+// Paris and Durand). The image is splatted into a coarse grid over both
+// image dimensions and intensity, holding the sum of the values and of the
+// weights of every cell. The grid is blurred by a Gaussian of one cell along
+// its three dimensions and the output is interpolated back from it. Returns
+// false when the grid would be too fine, leaving out untouched.
+template<typename OutT, typename InT>
+bool bilateralGrid(OutT *out, af::dim4 const &ostrides, InT const *in, af::dim4 const &istrides,
+                   af::dim4 const &dims, float const s_sigma, float const c_sigma,
+                   std::vector<OutT> &grid)
+{
+    // The trilinear splat and slice each add a tent of one cell, a variance
+    // of 1/6 cell^2, to the blur. The cells are made smaller to make up for it.
+    double const cs = s_sigma * std::sqrt(0.75);
+    double const cr = c_sigma * std::sqrt(0.75);
+    if (!(cs >= 1) || !(cr > 0)) return false;
+
+    dim_t const d0 = dims[0], d1 = dims[1];
+    dim_t const is0 = istrides[0], is1 = istrides[1];
+    dim_t const os0 = ostrides[0], os1 = ostrides[1];
+
+    // NaN fails both comparisons and is left out of the range
+    OutT vmin = std::numeric_limits<OutT>::max();
+    OutT vmax = std::numeric_limits<OutT>::lowest();
+    for (dim_t j = 0; j < d1; ++j) {
+        InT const *src = in + j * is1;
+        for (dim_t i = 0; i < d0; ++i) {
+            OutT const v = (OutT)src[i * is0];
+            vmin = (v < vmin ? v : vmin);
+            vmax = (v > vmax ? v : vmax);
+        }
+    }
+    if (vmin > vmax) vmin = vmax = 0;
+    double const zr = (double(vmax) - double(vmin)) / cr;
+
+    // One more cell than the last coordinate, for the interpolation
+    double const ni_ = std::floor((d0 - 1) / cs) + 2;
+    double const nj_ = std::floor((d1 - 1) / cs) + 2;
+    double const nz_ = std::floor(zr) + 2;
+    if (!(ni_ * nj_ * nz_ <= BILATERAL_GRID_MAX_CELLS)) return false;
+
+    dim_t const ni = (dim_t)ni_, nj = (dim_t)nj_, nz = (dim_t)nz_;
+    dim_t const rowSize = ni * nz * 2;
+    OutT const zscale = OutT(1 / cr);
+    grid.assign(nj * rowSize, OutT(0));
+
+    // Grid coordinates of the pixels along the two image dimensions, and the
+    // first image column of every row of cells
+    std::vector<dim_t> li(d0), lj(d1), jBeg(nj, d1);
+    std::vector<OutT>  wi(d0), wj(d1);
+    for (dim_t i = 0; i < d0; ++i) {
+        double const f = i / cs;
+        li[i] = std::min((dim_t)f, ni - 2);
+        wi[i] = OutT(f - li[i]);
+    }
+    for (dim_t j = d1 - 1; j >= 0; --j) {
+        double const f = j / cs;
+        lj[j] = std::min((dim_t)f, nj - 2);
+        wj[j] = OutT(f - lj[j]);
+        jBeg[lj[j]] = j;
+    }
+    for (dim_t g = nj - 2; g >= 0; --g) jBeg[g] = std::min(jBeg[g], jBeg[g + 1]);
+
+    // The image columns of row of cells g are splatted into rows g and g + 1,
+    // so the even rows are done first and the odd ones after them
+    for (dim_t parity = 0; parity < 2; ++parity) {
+        parallelFor((nj - parity) / 2, [&](dim_t task) {
+            dim_t const g = 2 * task + parity;
+            OutT *row0 = &grid[g * rowSize];
+            OutT *row1 = row0 + rowSize;
+            for (dim_t j = jBeg[g]; j < jBeg[g + 1]; ++j) {
+                InT const *src = in + j * is1;
+                OutT const wcol = wj[j];
+                for (dim_t i = 0; i < d0; ++i) {
+                    OutT const v = (OutT)src[i * is0];
+                    if (v != v) continue;
+                    OutT const fz = (v - vmin) * zscale;
+                    dim_t const lz = std::min((dim_t)fz, nz - 2);
+                    OutT const wz = fz - lz;
+
+                    dim_t const c = (li[i] * nz + lz) * 2;
+                    OutT const w[4] = {(1 - wcol) * (1 - wi[i]), (1 - wcol) * wi[i],
+                                       wcol * (1 - wi[i]), wcol * wi[i]};
+                    OutT *cells[4] = {row0 + c, row0 + c + nz * 2, row1 + c, row1 + c + nz * 2};
+                    for (int k = 0; k < 4; ++k) {
+                        OutT const w0 = w[k] * (1 - wz), w1 = w[k] * wz;
+                        cells[k][0] += w0 * v;
+                        cells[k][1] += w0;
+                        cells[k][2] += w1 * v;
+                        cells[k][3] += w1;
+                    }
+                }
+            }
+        });
+    }
+
+    // Blur along intensity and the first image dimension one row at a time,
+    // then along the second image dimension
+    parallelFor(nj, [&](dim_t gj) {
+        std::vector<OutT> buf;
+        OutT *row = &grid[gj * rowSize];
+        for (dim_t gi = 0; gi < ni; ++gi) {
+            bilateralGridBlur(row + gi * nz * 2, nz, 2, 2, buf);
+        }
+        bilateralGridBlur(row, ni, nz * 2, nz * 2, buf);
+    });
+    parallelFor(ni, [&](dim_t gi) {
+        std::vector<OutT> buf;
+        bilateralGridBlur(&grid[gi * nz * 2], nj, rowSize, nz * 2, buf);
+    });
+
+    // Every image column reads from the two rows of cells around it, which
+    // are interpolated to the column first
+    dim_t blockSize = 0;
+    dim_t const nBlocks = splitRange(blockSize, d1, BILATERAL_COLS);
+    parallelFor(nBlocks, [&](dim_t blk) {
+        std::vector<OutT> plane(rowSize);
+        dim_t const jEnd = std::min(d1, (blk + 1) * blockSize);
+        for (dim_t j = blk * blockSize; j < jEnd; ++j) {
+            OutT const *row0 = &grid[lj[j] * rowSize];
+            OutT const *row1 = row0 + rowSize;
+            OutT const wcol = wj[j];
+            for (dim_t k = 0; k < rowSize; ++k) {
+                plane[k] = row0[k] + wcol * (row1[k] - row0[k]);
+            }
+
+            InT const *src = in + j * is1;
+            OutT *dst = out + j * os1;
+            for (dim_t i = 0; i < d0; ++i) {
+                OutT const v = (OutT)src[i * is0];
+                if (v != v) {
+                    dst[i * os0] = v;
+                    continue;
+                }
+                OutT const fz = (v - vmin) * zscale;
+                dim_t const lz = std::min((dim_t)fz, nz - 2);
+                OutT const wz = fz - lz;
+
+                OutT const *c0 = &plane[(li[i] * nz + lz) * 2];
+                OutT const *c1 = c0 + nz * 2;
+                OutT const s0 = c0[0] + wz * (c0[2] - c0[0]), n0 = c0[1] + wz * (c0[3] - c0[1]);
+                OutT const s1 = c1[0] + wz * (c1[2] - c1[0]), n1 = c1[1] + wz * (c1[3] - c1[1]);
+                dst[i * os0] = (s0 + wi[i] * (s1 - s0)) / (n0 + wi[i] * (n1 - n0));
+            }
+        }
+    });
+    return true;
+}
+
+template<typename OutT, typename InT, bool IsColor>
+void bilateralGrid(Array<OutT> out, Array<InT> const in, float const s_sigma, float const c_sigma)
+{
+    af::dim4 const dims     = in.dims();
+    af::dim4 const istrides = in.strides();
+    af::dim4 const ostrides = out.strides();
+
+    // Every channel and batch is filtered on its own, with the threads
+    // working within each one
+    std::vector<OutT> grid;
+    for (dim_t b3 = 0; b3 < dims[3]; ++b3) {
+        for (dim_t b2 = 0; b2 < dims[2]; ++b2) {
+            OutT *dst = out.get() + b2 * ostrides[2] + b3 * ostrides[3];
+            InT const *src = in.get() + b2 * istrides[2] + b3 * istrides[3];
+            if (bilateralGrid(dst, ostrides, src, istrides, dims, s_sigma, c_sigma, grid)) continue;
+
+            dim_t const nBlocks = (dims[1] + BILATERAL_COLS - 1) / BILATERAL_COLS;
+            parallelFor(nBlocks, [&](dim_t blk) {
+                bilateralExact(dst, ostrides, src, istrides, dims, s_sigma, c_sigma,
+                               blk * BILATERAL_COLS,
+                               std::min(dims[1], (blk + 1) * BILATERAL_COLS));
+            });
         }
     }
 }
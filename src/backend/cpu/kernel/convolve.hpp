@@ -9,116 +9,112 @@
 
 #pragma once
 #include <Array.hpp>
+#include <math.hpp>
+#include <parallel.hpp>
+#include <kernel/filter_rank.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace cpu
 {
 namespace kernel
 {
 
-template<typename InT, typename AccT, bool Expand>
-void one2one_1d(InT *optr, InT const * const iptr, AccT const * const fptr, af::dim4 const & oDims,
-                af::dim4 const & sDims, af::dim4 const & fDims, af::dim4 const & sStrides)
+// Outputs accumulated together by the interior loop of convolveColumn. The
+// accumulators stay in the L1 cache while every term is added to them.
+static const int CONV_TILE = 256;
+
+// Smallest number of multiply adds handled by one block of output columns
+static const dim_t CONV_MIN_WORK = 1 << 15;
+
+// A column of the input along dimension 0 and the column of the filter it
+// is multiplied with
+template<typename InT, typename AccT>
+struct ConvTerm
 {
-    dim_t start = (Expand ? 0 : fDims[0]/2);
-    dim_t end   = (Expand ? oDims[0] : start + sDims[0]);
-    for(dim_t i=start; i<end; ++i) {
-        AccT accum = 0.0;
-        for(dim_t f=0; f<fDims[0]; ++f) {
-            dim_t iIdx = i-f;
-            InT s_val = ((iIdx>=0 &&iIdx<sDims[0])? iptr[iIdx*sStrides[0]] : InT(0));
-            accum += AccT(s_val * fptr[f]);
+    InT  const *in;
+    AccT const *filt;
+};
+
+// out[i - iStart] = sum_t sum_w terms[t].in[i - w] * terms[t].filt[w] for i
+// in [iStart, iEnd), where the input columns hold sLen values and the filter
+// columns fLen taps. Outputs whose taps all fall inside the input are
+// computed CONV_TILE at a time without any bounds check, so that the loop
+// over the outputs is vectorised with every tap of a term held in a
+// register. FW is fLen when it is known at compile time and 0 otherwise.
+template<typename OutT, typename InT, typename AccT, int FW>
+void convolveColumn(OutT *out, ConvTerm<InT, AccT> const * const terms, int const nTerms,
+                    dim_t const fLen_, dim_t const sLen, dim_t const iStart, dim_t const iEnd)
+{
+    dim_t const fLen = FW ? FW : fLen_;
+    dim_t const lo   = std::min(iEnd, std::max(iStart, fLen - 1));
+    dim_t const hi   = std::max(lo, std::min(iEnd, sLen));
+
+    // Only the taps that fall inside the input are visited
+    auto border = [&](dim_t i) {
+        dim_t const wBegin = std::max<dim_t>(0, i - sLen + 1);
+        dim_t const wEnd   = std::min(fLen, i + 1);
+        AccT accum = scalar<AccT>(0);
+        for (int t = 0; t < nTerms; ++t) {
+            for (dim_t w = wBegin; w < wEnd; ++w) {
+                accum += AccT(terms[t].in[i - w] * terms[t].filt[w]);
+            }
+        }
+        out[i - iStart] = OutT(accum);
+    };
+
+    for (dim_t i = iStart; i < lo; ++i) border(i);
+
+    AccT accum[CONV_TILE];
+    for (dim_t i0 = lo; i0 < hi; i0 += CONV_TILE) {
+        int const len = (int)std::min<dim_t>(CONV_TILE, hi - i0);
+        for (int b = 0; b < len; ++b) accum[b] = scalar<AccT>(0);
+
+        for (int t = 0; t < nTerms; ++t) {
+            InT  const *x = terms[t].in + i0;
+            AccT const *f = terms[t].filt;
+            if (FW) {
+                for (int b = 0; b < len; ++b) {
+                    AccT sum = accum[b];
+                    for (dim_t w = 0; w < fLen; ++w) sum += AccT(x[b - w] * f[w]);
+                    accum[b] = sum;
+                }
+            } else {
+                // Long filters go through the tile once per tap
+                for (dim_t w = 0; w < fLen; ++w) {
+                    AccT const fw = f[w];
+                    InT  const *xw = x - w;
+                    for (int b = 0; b < len; ++b) accum[b] += AccT(xw[b] * fw);
+                }
+            }
         }
-        optr[i-start] = InT(accum);
+
+        for (int b = 0; b < len; ++b) out[i0 - iStart + b] = OutT(accum[b]);
     }
+
+    for (dim_t i = hi; i < iEnd; ++i) border(i);
 }
 
-template<typename InT, typename AccT, bool Expand>
-void one2one_2d(InT *optr, InT const * const iptr, AccT const * const fptr, af::dim4 const & oDims,
-                af::dim4 const & sDims, af::dim4 const & fDims, af::dim4 const & oStrides,
-                af::dim4 const & sStrides, af::dim4 const & fStrides)
+template<typename OutT, typename InT, typename AccT>
+void convolveColumn(OutT *out, ConvTerm<InT, AccT> const * const terms, int const nTerms,
+                    dim_t const fLen, dim_t const sLen, dim_t const iStart, dim_t const iEnd)
 {
-    dim_t jStart = (Expand ? 0 : fDims[1]/2);
-    dim_t jEnd   = (Expand ? oDims[1] : jStart + sDims[1]);
-    dim_t iStart = (Expand ? 0 : fDims[0]/2);
-    dim_t iEnd   = (Expand ? oDims[0] : iStart + sDims[0]);
-
-    for(dim_t j=jStart; j<jEnd; ++j) {
-        dim_t joff = (j-jStart)*oStrides[1];
-
-        for(dim_t i=iStart; i<iEnd; ++i) {
-
-            AccT accum = AccT(0);
-            for(dim_t wj=0; wj<fDims[1]; ++wj) {
-                dim_t jIdx  = j-wj;
-                dim_t w_joff = wj*fStrides[1];
-                dim_t s_joff = jIdx * sStrides[1];
-                bool isJValid = (jIdx>=0 && jIdx<sDims[1]);
-
-                for(dim_t wi=0; wi<fDims[0]; ++wi) {
-                    dim_t iIdx = i-wi;
-
-                    InT s_val = InT(0);
-                    if ( isJValid && (iIdx>=0 && iIdx<sDims[0])) {
-                        s_val = iptr[s_joff+iIdx*sStrides[0]];
-                    }
-
-                    accum += AccT(s_val * fptr[w_joff+wi*fStrides[0]]);
-                }
-            }
-            optr[joff+i-iStart] = InT(accum);
-        }
+    switch (fLen) {
+        case  1: convolveColumn<OutT, InT, AccT,  1>(out, terms, nTerms, fLen, sLen, iStart, iEnd); break;
+        case  3: convolveColumn<OutT, InT, AccT,  3>(out, terms, nTerms, fLen, sLen, iStart, iEnd); break;
+        case  5: convolveColumn<OutT, InT, AccT,  5>(out, terms, nTerms, fLen, sLen, iStart, iEnd); break;
+        case  7: convolveColumn<OutT, InT, AccT,  7>(out, terms, nTerms, fLen, sLen, iStart, iEnd); break;
+        case  9: convolveColumn<OutT, InT, AccT,  9>(out, terms, nTerms, fLen, sLen, iStart, iEnd); break;
+        case 11: convolveColumn<OutT, InT, AccT, 11>(out, terms, nTerms, fLen, sLen, iStart, iEnd); break;
+        default: convolveColumn<OutT, InT, AccT,  0>(out, terms, nTerms, fLen, sLen, iStart, iEnd); break;
     }
 }
 
-template<typename InT, typename AccT, bool Expand>
-void one2one_3d(InT *optr, InT const * const iptr, AccT const * const fptr, af::dim4 const & oDims,
-                af::dim4 const & sDims, af::dim4 const & fDims, af::dim4 const & oStrides,
-                af::dim4 const & sStrides, af::dim4 const & fStrides)
+// Number of blocks count columns of an output are split into when every
+// column costs work multiply adds
+static inline dim_t convolveBlocks(dim_t &blockSize, dim_t const count, dim_t const work)
 {
-    dim_t kStart = (Expand ? 0 : fDims[2]/2);
-    dim_t kEnd   = (Expand ? oDims[2] : kStart + sDims[2]);
-    dim_t jStart = (Expand ? 0 : fDims[1]/2);
-    dim_t jEnd   = (Expand ? oDims[1] : jStart + sDims[1]);
-    dim_t iStart = (Expand ? 0 : fDims[0]/2);
-    dim_t iEnd   = (Expand ? oDims[0] : iStart + sDims[0]);
-
-    for(dim_t k=kStart; k<kEnd; ++k) {
-        dim_t koff = (k-kStart)*oStrides[2];
-
-        for(dim_t j=jStart; j<jEnd; ++j) {
-            dim_t joff = (j-jStart)*oStrides[1];
-
-            for(dim_t i=iStart; i<iEnd; ++i) {
-
-                AccT accum = AccT(0);
-                for(dim_t wk=0; wk<fDims[2]; ++wk) {
-                    dim_t kIdx  = k-wk;
-                    dim_t w_koff = wk*fStrides[2];
-                    dim_t s_koff = kIdx * sStrides[2];
-                    bool isKValid = (kIdx>=0 && kIdx<sDims[2]);
-
-                    for(dim_t wj=0; wj<fDims[1]; ++wj) {
-                        dim_t jIdx  = j-wj;
-                        dim_t w_joff = wj*fStrides[1];
-                        dim_t s_joff = jIdx * sStrides[1];
-                        bool isJValid = (jIdx>=0 && jIdx<sDims[1]);
-
-                        for(dim_t wi=0; wi<fDims[0]; ++wi) {
-                            dim_t iIdx = i-wi;
-
-                            InT s_val = InT(0);
-                            if ( isKValid && isJValid && (iIdx>=0 && iIdx<sDims[0])) {
-                                s_val = iptr[s_koff+s_joff+iIdx*sStrides[0]];
-                            }
-
-                            accum += AccT(s_val * fptr[w_koff+w_joff+wi*fStrides[0]]);
-                        }
-                    }
-                }
-                optr[koff+joff+i-iStart] = InT(accum);
-            } //i loop ends here
-        } // j loop ends here
-    } // k loop ends here
+    return splitRange(blockSize, count, std::max<dim_t>(1, CONV_MIN_WORK / std::max<dim_t>(1, work)));
 }
 
 template<typename InT, typename AccT, dim_t baseDim, bool Expand>
@@ -164,62 +160,99 @@ void convolve_nd(Array<InT> out, Array<InT> const signal, Array<AccT> const filt
         }
     }
 
-    for (dim_t b3=0; b3<batch[3]; ++b3) {
-        for (dim_t b2=0; b2<batch[2]; ++b2) {
-            for (dim_t b1=0; b1<batch[1]; ++b1) {
-
-                InT * out          = optr + b1 * out_step[1] + b2 * out_step[2] + b3 * out_step[3];
-                InT const *in      = iptr + b1 *  in_step[1] + b2 *  in_step[2] + b3 *  in_step[3];
-                AccT const *filt = fptr + b1 *filt_step[1] + b2 *filt_step[2] + b3 *filt_step[3];
-
-                switch(baseDim) {
-                    case 1: one2one_1d<InT, AccT, Expand>(out, in, filt, oDims, sDims, fDims, sStrides);                     break;
-                    case 2: one2one_2d<InT, AccT, Expand>(out, in, filt, oDims, sDims, fDims, oStrides, sStrides, fStrides); break;
-                    case 3: one2one_3d<InT, AccT, Expand>(out, in, filt, oDims, sDims, fDims, oStrides, sStrides, fStrides); break;
+    // Every column of the output along dimension 0 is the sum of the
+    // columns of the input that overlap the filter, so the columns of all
+    // batches are computed independently of each other
+    dim_t const nj = (baseDim > 1 ? oDims[1] : 1);
+    dim_t const nk = (baseDim > 2 ? oDims[2] : 1);
+    dim_t const fj = (baseDim > 1 ? fDims[1] : 1);
+    dim_t const fk = (baseDim > 2 ? fDims[2] : 1);
+    dim_t const sj = (baseDim > 1 ? sDims[1] : 1);
+    dim_t const sk = (baseDim > 2 ? sDims[2] : 1);
+
+    dim_t const iStart = (Expand ? 0 : fDims[0]/2);
+    dim_t const iEnd   = (Expand ? oDims[0] : iStart + sDims[0]);
+    dim_t const jStart = (Expand ? 0 : fj/2);
+    dim_t const kStart = (Expand ? 0 : fk/2);
+
+    dim_t const nCols = nj * nk * batch[1] * batch[2] * batch[3];
+    dim_t blockSize = 0;
+    dim_t const nblocks = convolveBlocks(blockSize, nCols, oDims[0] * fDims[0] * fj * fk);
+
+    parallelFor(nblocks, [&](dim_t blk) {
+        std::vector<ConvTerm<InT, AccT>> terms(fj * fk);
+        dim_t const colEnd = std::min(nCols, (blk + 1) * blockSize);
+        for (dim_t c = blk * blockSize; c < colEnd; ++c) {
+            dim_t const j  = c % nj;
+            dim_t const k  = (c / nj) % nk;
+            dim_t const b  = c / (nj * nk);
+            dim_t const b1 = b % batch[1];
+            dim_t const b2 = (b / batch[1]) % batch[2];
+            dim_t const b3 = b / (batch[1] * batch[2]);
+
+            InT * out        = optr + b1 * out_step[1] + b2 * out_step[2] + b3 * out_step[3];
+            InT const *in    = iptr + b1 *  in_step[1] + b2 *  in_step[2] + b3 *  in_step[3];
+            AccT const *filt = fptr + b1 *filt_step[1] + b2 *filt_step[2] + b3 *filt_step[3];
+
+            // Position of the output column in the full convolution
+            dim_t const jf = j + jStart;
+            dim_t const kf = k + kStart;
+
+            int nTerms = 0;
+            for (dim_t wk = std::max<dim_t>(0, kf - sk + 1); wk < std::min(fk, kf + 1); ++wk) {
+                for (dim_t wj = std::max<dim_t>(0, jf - sj + 1); wj < std::min(fj, jf + 1); ++wj) {
+                    terms[nTerms].in   = in + (jf - wj) * sStrides[1] + (kf - wk) * sStrides[2];
+                    terms[nTerms].filt = filt + wj * fStrides[1] + wk * fStrides[2];
+                    ++nTerms;
                 }
             }
+
+            convolveColumn(out + j * oStrides[1] + k * oStrides[2], terms.data(), nTerms,
+                           fDims[0], sDims[0], iStart, iEnd);
         }
-    }
+    });
 }
 
+// One pass of a separable convolution along conv_dim of the columns of the
+// 2D matrices in, for nbatch matrices strided by inBatch and outBatch
 template<typename InT, typename AccT, dim_t conv_dim, bool Expand>
 void convolve2_separable(InT *optr, InT const * const iptr, AccT const * const fptr,
-                        af::dim4 const & oDims, af::dim4 const & sDims, af::dim4 const & orgDims, dim_t fDim,
-                        af::dim4 const & oStrides, af::dim4 const & sStrides, dim_t fStride)
+                         af::dim4 const & oDims, af::dim4 const & sDims, dim_t fDim,
+                         dim_t oStride, dim_t sStride,
+                         dim_t const nbatch, dim_t const outBatch, dim_t const inBatch)
 {
-    for(dim_t j=0; j<oDims[1]; ++j) {
-
-        dim_t jOff = j*oStrides[1];
-        dim_t cj = j + (conv_dim==1)*(Expand ? 0: fDim>>1);
-
-        for(dim_t i=0; i<oDims[0]; ++i) {
-
-            dim_t iOff = i*oStrides[0];
-            dim_t ci = i + (conv_dim==0)*(Expand ? 0 : fDim>>1);
-
-            AccT accum = scalar<AccT>(0);
-
-            for(dim_t f=0; f<fDim; ++f) {
-                InT f_val = fptr[f];
-                InT s_val;
-
-                if (conv_dim==0) {
-                    dim_t offi = ci - f;
-                    bool isCIValid = offi>=0 && offi<sDims[0];
-                    bool isCJValid = cj>=0 && cj<sDims[1];
-                    s_val = (isCJValid && isCIValid ? iptr[cj*sDims[0]+offi] : scalar<InT>(0));
-                } else {
-                    dim_t offj = cj - f;
-                    bool isCIValid = ci>=0 && ci<sDims[0];
-                    bool isCJValid = offj>=0 && offj<sDims[1];
-                    s_val = (isCJValid && isCIValid ? iptr[offj*sDims[0]+ci] : scalar<InT>(0));
+    dim_t const nCols = oDims[1] * nbatch;
+    dim_t blockSize = 0;
+    dim_t const nblocks = convolveBlocks(blockSize, nCols, oDims[0] * fDim);
+
+    parallelFor(nblocks, [&](dim_t blk) {
+        std::vector<ConvTerm<InT, AccT>> terms(fDim);
+        dim_t const colEnd = std::min(nCols, (blk + 1) * blockSize);
+        for (dim_t c = blk * blockSize; c < colEnd; ++c) {
+            dim_t const j = c % oDims[1];
+            dim_t const b = c / oDims[1];
+            InT *out      = optr + b * outBatch + j * oStride;
+            InT const *in = iptr + b * inBatch;
+
+            if (conv_dim == 0) {
+                // The filter runs down the column
+                terms[0].in   = in + j * sStride;
+                terms[0].filt = fptr;
+                dim_t const iStart = (Expand ? 0 : fDim>>1);
+                convolveColumn(out, terms.data(), 1, fDim, sDims[0], iStart, iStart + oDims[0]);
+            } else {
+                // Every tap scales a whole column
+                dim_t const cj = j + (Expand ? 0 : fDim>>1);
+                int nTerms = 0;
+                for (dim_t f = std::max<dim_t>(0, cj - sDims[1] + 1); f < std::min(fDim, cj + 1); ++f) {
+                    terms[nTerms].in   = in + (cj - f) * sStride;
+                    terms[nTerms].filt = fptr + f;
+                    ++nTerms;
                 }
-
-                accum += AccT(s_val * f_val);
+                convolveColumn(out, terms.data(), nTerms, 1, sDims[0], 0, oDims[0]);
             }
-            optr[iOff+jOff] = InT(accum);
         }
-    }
+    });
 }
 
 template<typename InT, typename AccT, bool Expand>
@@ -239,27 +272,87 @@ void convolve2(Array<InT> out, Array<InT> const signal,
     auto sStrides = signal.strides();
     auto tStrides = temp.strides();
 
+    // The matrices along dimension 2 are handled together by each pass
     for (dim_t b3=0; b3<oDims[3]; ++b3) {
+        InT const * const iptr = signal.get() + b3*sStrides[3];
+        InT *tptr = temp.get() + b3*tStrides[3];
+        InT *optr = out.get()  + b3*oStrides[3];
 
-        dim_t i_b3Off = b3*sStrides[3];
-        dim_t t_b3Off = b3*tStrides[3];
-        dim_t o_b3Off = b3*oStrides[3];
+        convolve2_separable<InT, AccT, 0, Expand>(tptr, iptr, c_filter.get(),
+                tDims, sDims, cflen, tStrides[1], sStrides[1],
+                oDims[2], tStrides[2], sStrides[2]);
 
-        for (dim_t b2=0; b2<oDims[2]; ++b2) {
+        convolve2_separable<InT, AccT, 1, Expand>(optr, tptr, r_filter.get(),
+                oDims, tDims, rflen, oStrides[1], tStrides[1],
+                oDims[2], oStrides[2], tStrides[2]);
+    }
+}
 
-            InT const * const iptr = signal.get()+ b2*sStrides[2] + i_b3Off;
-            InT *tptr = temp.get() + b2*tStrides[2] + t_b3Off;
-            InT *optr = out.get()  + b2*oStrides[2] + o_b3Off;
+// 2D convolution of every matrix of the signal with a filter given as a sum
+// of outer products. Each block of output columns first convolves the signal
+// columns it reads with the filter columns, keeping the results in the
+// accumulator type, then combines those with the filter rows.
+template<typename InT, typename AccT, bool Expand>
+void convolve2_lowrank(Array<InT> out, Array<InT> const signal, FilterRank<AccT> const &filter)
+{
+    af::dim4 const oDims = out.dims();
+    af::dim4 const sDims = signal.dims();
+    af::dim4 const oStrides = out.strides();
+    af::dim4 const sStrides = signal.strides();
 
-            convolve2_separable<InT, AccT, 0, Expand>(tptr, iptr, c_filter.get(),
-                    tDims, sDims, sDims, cflen,
-                    tStrides, sStrides, c_filter.strides()[0]);
+    dim_t const k0 = filter.k0;
+    dim_t const k1 = filter.k1;
+    dim_t const rank = filter.rank;
+
+    dim_t const tRows  = oDims[0];
+    dim_t const iStart = (Expand ? 0 : k0/2);
+    dim_t const jStart = (Expand ? 0 : k1/2);
+
+    // Blocks are wide enough for the columns shared with their neighbours
+    // to be a small part of the work
+    dim_t const nb = oDims[2] * oDims[3];
+    dim_t blockSize = 0;
+    dim_t const work = std::max<dim_t>(1, tRows * rank * (k0 + k1));
+    dim_t const nblocks = splitRange(blockSize, oDims[1], std::max(4 * k1, CONV_MIN_WORK / work));
+
+    parallelFor(nblocks * nb, [&](dim_t task) {
+        dim_t const b  = task / nblocks;
+        dim_t const j0 = (task % nblocks) * blockSize;
+        dim_t const j1 = std::min(oDims[1], j0 + blockSize);
+
+        InT const *in = signal.get() + (b % oDims[2]) * sStrides[2] + (b / oDims[2]) * sStrides[3];
+        InT *optr     = out.get()    + (b % oDims[2]) * oStrides[2] + (b / oDims[2]) * oStrides[3];
+
+        // Columns of the signal the block reads
+        dim_t const c0 = std::max<dim_t>(0, j0 + jStart - k1 + 1);
+        dim_t const c1 = std::min(sDims[1], j1 + jStart);
+        dim_t const nc = std::max<dim_t>(0, c1 - c0);
+
+        std::vector<AccT> temp(rank * nc * tRows);
+        ConvTerm<InT, AccT> colTerm;
+        for (dim_t r = 0; r < rank; ++r) {
+            colTerm.filt = &filter.cols[r * k0];
+            for (dim_t c = 0; c < nc; ++c) {
+                colTerm.in = in + (c0 + c) * sStrides[1];
+                convolveColumn(&temp[(r * nc + c) * tRows], &colTerm, 1,
+                               k0, sDims[0], iStart, iStart + tRows);
+            }
+        }
 
-            convolve2_separable<InT, AccT, 1, Expand>(optr, tptr, r_filter.get(),
-                    oDims, tDims, sDims, rflen,
-                    oStrides, tStrides, r_filter.strides()[0]);
+        std::vector<ConvTerm<AccT, AccT>> terms(rank * k1);
+        for (dim_t j = j0; j < j1; ++j) {
+            dim_t const jf = j + jStart;
+            int nTerms = 0;
+            for (dim_t r = 0; r < rank; ++r) {
+                for (dim_t f = std::max<dim_t>(0, jf - sDims[1] + 1); f < std::min(k1, jf + 1); ++f) {
+                    terms[nTerms].in   = &temp[(r * nc + jf - f - c0) * tRows];
+                    terms[nTerms].filt = &filter.rows[r * k1 + f];
+                    ++nTerms;
+                }
+            }
+            convolveColumn(optr + j * oStrides[1], terms.data(), nTerms, 1, tRows, 0, tRows);
         }
-    }
+    });
 }
 
 }
@@ -0,0 +1,184 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <Array.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Largest filter, in taps, whose rank is looked for
+static const dim_t FILTER_RANK_MAX_TAPS = 64 * 64;
+
+// Number of decompositions filterRank remembers
+static const size_t FILTER_RANK_CACHE = 16;
+
+// A k0 x k1 filter written as sum_r cols[r] * rows[r]^T, with columns of k0
+// taps and rows of k1 taps stored one after the other
+template<typename T>
+struct FilterRank
+{
+    dim_t k0;
+    dim_t k1;
+    dim_t rank;
+    std::vector<T> cols;
+    std::vector<T> rows;
+};
+
+// One sided Jacobi SVD of the k0 x k1 column major matrix a. On return the
+// columns of a are the left singular vectors scaled by the singular values
+// and v holds the right singular vectors, so that a * v^T is the input.
+static inline void jacobiSvd(std::vector<double> &a, std::vector<double> &v,
+                             const dim_t k0, const dim_t k1)
+{
+    v.assign(k1 * k1, 0);
+    for (dim_t j = 0; j < k1; ++j) v[j * k1 + j] = 1;
+
+    const double eps = std::numeric_limits<double>::epsilon();
+    for (int sweep = 0; sweep < 60; ++sweep) {
+        bool rotated = false;
+        for (dim_t p = 0; p < k1 - 1; ++p) {
+            for (dim_t q = p + 1; q < k1; ++q) {
+                double *ap = &a[p * k0];
+                double *aq = &a[q * k0];
+                double alpha = 0, beta = 0, gamma = 0;
+                for (dim_t i = 0; i < k0; ++i) {
+                    alpha += ap[i] * ap[i];
+                    beta  += aq[i] * aq[i];
+                    gamma += ap[i] * aq[i];
+                }
+                if (std::abs(gamma) <= eps * std::sqrt(alpha * beta)) continue;
+                rotated = true;
+
+                const double zeta = (beta - alpha) / (2 * gamma);
+                const double t = (zeta >= 0 ? 1 : -1) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                const double c = 1 / std::sqrt(1 + t * t);
+                const double s = c * t;
+                for (dim_t i = 0; i < k0; ++i) {
+                    const double x = ap[i], y = aq[i];
+                    ap[i] = c * x - s * y;
+                    aq[i] = s * x + c * y;
+                }
+                double *vp = &v[p * k1];
+                double *vq = &v[q * k1];
+                for (dim_t i = 0; i < k1; ++i) {
+                    const double x = vp[i], y = vq[i];
+                    vp[i] = c * x - s * y;
+                    vq[i] = s * x + c * y;
+                }
+            }
+        }
+        if (!rotated) break;
+    }
+}
+
+// Smallest number of outer products that reproduce a k0 x k1 filter to the
+// precision of T
+template<typename T>
+void decomposeFilter(FilterRank<T> &f, const T *filt, const dim_t ld)
+{
+    const dim_t k0 = f.k0, k1 = f.k1;
+    std::vector<double> a(k0 * k1), v;
+    for (dim_t j = 0; j < k1; ++j) {
+        for (dim_t i = 0; i < k0; ++i) a[j * k0 + i] = filt[j * ld + i];
+    }
+    jacobiSvd(a, v, k0, k1);
+
+    std::vector<std::pair<double, dim_t>> sigma(k1);
+    double total = 0;
+    for (dim_t j = 0; j < k1; ++j) {
+        double s = 0;
+        for (dim_t i = 0; i < k0; ++i) s += a[j * k0 + i] * a[j * k0 + i];
+        sigma[j] = std::make_pair(s, j);
+        total += s;
+    }
+    std::sort(sigma.begin(), sigma.end(), std::greater<std::pair<double, dim_t>>());
+
+    // Filters with NaN or infinite taps are left to the direct convolution
+    if (!std::isfinite(total)) {
+        f.rank = std::max(k0, k1);
+        return;
+    }
+
+    // The dropped terms are below the rounding error of the filter taps
+    const double tol = 16 * std::numeric_limits<T>::epsilon() * std::max(k0, k1);
+    double rest = total;
+    dim_t rank = 0;
+    while (rank < k1 && rest > tol * tol * total) rest -= sigma[rank++].first;
+
+    f.rank = rank;
+    f.cols.resize(rank * k0);
+    f.rows.resize(rank * k1);
+    for (dim_t r = 0; r < rank; ++r) {
+        const dim_t j = sigma[r].second;
+        for (dim_t i = 0; i < k0; ++i) f.cols[r * k0 + i] = T(a[j * k0 + i]);
+        for (dim_t i = 0; i < k1; ++i) f.rows[r * k1 + i] = T(v[j * k1 + i]);
+    }
+}
+
+// Complex filters are not decomposed
+template<typename T>
+typename std::enable_if<!std::is_floating_point<T>::value, bool>::type
+filterRank(FilterRank<T> &f, const T *filt, const dim_t k0, const dim_t k1, const dim_t ld)
+{
+    return false;
+}
+
+// Decomposition of a real 2D filter into outer products of columns and rows.
+// The last few decompositions are kept along with the taps they were made
+// from, so a filter that is used again is not decomposed again. Returns
+// false for filters too large to be decomposed.
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+filterRank(FilterRank<T> &f, const T *filt, const dim_t k0, const dim_t k1, const dim_t ld)
+{
+    if (k0 * k1 > FILTER_RANK_MAX_TAPS) return false;
+
+    typedef std::pair<std::vector<T>, FilterRank<T>> Entry;
+    static std::mutex lock;
+    static std::list<Entry> cache;
+
+    std::vector<T> taps(k0 * k1);
+    for (dim_t j = 0; j < k1; ++j) {
+        std::copy(filt + j * ld, filt + j * ld + k0, taps.begin() + j * k0);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            if (it->second.k0 == k0 && it->second.k1 == k1 && it->first == taps) {
+                cache.splice(cache.begin(), cache, it);
+                f = it->second;
+                return true;
+            }
+        }
+    }
+
+    f.k0 = k0;
+    f.k1 = k1;
+    decomposeFilter(f, &taps.front(), k0);
+
+    std::lock_guard<std::mutex> guard(lock);
+    cache.push_front(Entry(taps, f));
+    if (cache.size() > FILTER_RANK_CACHE) cache.pop_back();
+    return true;
+}
+
+}
+}
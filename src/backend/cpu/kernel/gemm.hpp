@@ -0,0 +1,253 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <types.hpp>
+#include <cmath>
+#include <complex>
+#include <type_traits>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Matrices up to this size in every dimension are multiplied by gemmSmall.
+// The call overhead of the BLAS library dominates below it.
+static const int GEMM_SMALL_DIM = 32;
+
+static inline float   conjValue(float   x) { return x; }
+static inline double  conjValue(double  x) { return x; }
+static inline cfloat  conjValue(cfloat  x) { return std::conj(x); }
+static inline cdouble conjValue(cdouble x) { return std::conj(x); }
+
+// Element (i, j) of op(A) where A is column major with leading dimension ld
+template<typename T>
+static inline T opElement(const T *A, const dim_t ld, const int i, const int j,
+                          const af_mat_prop opt)
+{
+    switch (opt) {
+    case AF_MAT_TRANS:  return A[j + i * ld];
+    case AF_MAT_CTRANS: return conjValue(A[j + i * ld]);
+    default:            return A[i + j * ld];
+    }
+}
+
+// C = alpha * op(A) * op(B) + beta * C for one column major M x N result
+// with leading dimension ldc. A and B are read through op according to optA
+// and optB. C is not read when beta is 0.
+template<typename T>
+void gemmSmall(T *C, const dim_t ldc,
+               const T *A, const dim_t lda, const af_mat_prop optA,
+               const T *B, const dim_t ldb, const af_mat_prop optB,
+               const int M, const int N, const int K,
+               const T alpha, const T beta)
+{
+    for (int j = 0; j < N; ++j) {
+        T *c = C + j * ldc;
+
+        if (optA == AF_MAT_NONE) {
+            if (beta == T(0)) {
+                for (int i = 0; i < M; ++i) c[i] = T(0);
+            } else {
+                for (int i = 0; i < M; ++i) c[i] *= beta;
+            }
+            // Columns of A are contiguous: accumulate c += A(:, k) * B(k, j)
+            for (int k = 0; k < K; ++k) {
+                const T b = alpha * opElement(B, ldb, k, j, optB);
+                const T *a = A + k * lda;
+                for (int i = 0; i < M; ++i) c[i] += a[i] * b;
+            }
+        } else {
+            // Rows of op(A) are contiguous: c(i) is a dot product
+            for (int i = 0; i < M; ++i) {
+                const T *a = A + i * lda;
+                T sum = T(0);
+                for (int k = 0; k < K; ++k) {
+                    const T av = (optA == AF_MAT_CTRANS) ? conjValue(a[k]) : a[k];
+                    sum += av * opElement(B, ldb, k, j, optB);
+                }
+                c[i] = alpha * sum + (beta == T(0) ? T(0) : beta * c[i]);
+            }
+        }
+    }
+}
+
+// Copies op(A) of size R x C into the column major R x C buffer out
+template<typename T, int R, int C>
+static inline void loadOp(T *out, const T *A, const dim_t ld, const af_mat_prop opt)
+{
+    switch (opt) {
+    case AF_MAT_TRANS:
+        for (int j = 0; j < C; ++j)
+            for (int i = 0; i < R; ++i) out[i + j * R] = A[j + i * ld];
+        break;
+    case AF_MAT_CTRANS:
+        for (int j = 0; j < C; ++j)
+            for (int i = 0; i < R; ++i) out[i + j * R] = conjValue(A[j + i * ld]);
+        break;
+    default:
+        for (int j = 0; j < C; ++j)
+            for (int i = 0; i < R; ++i) out[i + j * R] = A[i + j * ld];
+        break;
+    }
+}
+
+// Column j of C = alpha * A * B(:, j) + beta * C(:, j) where A is column
+// major M x K with leading dimension lda and b is the contiguous column B(:, j)
+template<typename T, int M, int K>
+static inline void gemmFixedColumn(T *c, const T *A, const dim_t lda, const T *b,
+                                   const T alpha, const T beta)
+{
+    T acc[M];
+    for (int i = 0; i < M; ++i) acc[i] = T(0);
+    for (int k = 0; k < K; ++k) {
+        const T bv = b[k];
+        const T *a = A + k * lda;
+        for (int i = 0; i < M; ++i) acc[i] += a[i] * bv;
+    }
+    if (beta == T(0)) {
+        for (int i = 0; i < M; ++i) c[i] = alpha * acc[i];
+    } else {
+        for (int i = 0; i < M; ++i) c[i] = alpha * acc[i] + beta * c[i];
+    }
+}
+
+// gemmSmall with the sizes known at compile time. Transposed operands are
+// first packed into local column major buffers so that the inner loops always
+// run over contiguous memory with constant trip counts, which the compiler
+// unrolls and vectorizes for the sizes instantiated below.
+template<typename T, int M, int N, int K>
+void gemmFixed(T *C, const dim_t ldc,
+               const T *A, const dim_t lda, const af_mat_prop optA,
+               const T *B, const dim_t ldb, const af_mat_prop optB,
+               const T alpha, const T beta)
+{
+    T a[M * K];
+    T b[K * N];
+
+    if (optA != AF_MAT_NONE) {
+        loadOp<T, M, K>(a, A, lda, optA);
+    }
+    loadOp<T, K, N>(b, B, ldb, optB);
+
+    for (int j = 0; j < N; ++j) {
+        if (optA == AF_MAT_NONE) {
+            gemmFixedColumn<T, M, K>(C + j * ldc, A, lda, b + j * K, alpha, beta);
+        } else {
+            gemmFixedColumn<T, M, K>(C + j * ldc, a, M, b + j * K, alpha, beta);
+        }
+    }
+}
+
+template<typename T>
+using gemm_fixed_func = void (*)(T *, const dim_t,
+                                 const T *, const dim_t, const af_mat_prop,
+                                 const T *, const dim_t, const af_mat_prop,
+                                 const T, const T);
+
+// Square S x S products and S x S times S x 1 products
+template<typename T, int S>
+static inline gemm_fixed_func<T> fixedFor(const int N)
+{
+    switch (N) {
+    case S: return gemmFixed<T, S, S, S>;
+    case 1: return gemmFixed<T, S, 1, S>;
+    default: return nullptr;
+    }
+}
+
+// Returns the compile time kernel for an M x N x K product or nullptr when
+// the sizes are not specialized
+template<typename T>
+gemm_fixed_func<T> getGemmFixed(const int M, const int N, const int K)
+{
+    if (M != K) return nullptr;
+    switch (M) {
+    case 2:  return fixedFor<T, 2 >(N);
+    case 3:  return fixedFor<T, 3 >(N);
+    case 4:  return fixedFor<T, 4 >(N);
+    case 8:  return fixedFor<T, 8 >(N);
+    case 16: return fixedFor<T, 16>(N);
+    case 32: return fixedFor<T, 32>(N);
+    default: return nullptr;
+    }
+}
+
+template<typename T, af_activation act>
+struct Activation
+{
+    T operator()(const T x) const { return x; }
+};
+
+template<typename T>
+struct Activation<T, AF_ACTIVATION_RELU>
+{
+    T operator()(const T x) const { return x > T(0) ? x : T(0); }
+};
+
+template<typename T>
+struct Activation<T, AF_ACTIVATION_SIGMOID>
+{
+    T operator()(const T x) const { return T(1) / (T(1) + std::exp(-x)); }
+};
+
+template<typename T>
+struct Activation<T, AF_ACTIVATION_TANH>
+{
+    T operator()(const T x) const { return std::tanh(x); }
+};
+
+template<typename T, af_activation act>
+void epilogueLoop(T *C, const int M, const int N, const T *bias, const bool biasPerRow)
+{
+    Activation<T, act> f;
+    for (int j = 0; j < N; ++j) {
+        T *c = C + j * M;
+        if (!bias) {
+            for (int i = 0; i < M; ++i) c[i] = f(c[i]);
+        } else if (biasPerRow) {
+            for (int i = 0; i < M; ++i) c[i] = f(c[i] + bias[i]);
+        } else {
+            const T bj = bias[j];
+            for (int i = 0; i < M; ++i) c[i] = f(c[i] + bj);
+        }
+    }
+}
+
+// Adds bias to the linear M x N matrix C and applies act in place. bias is
+// null, has M values added along the rows when biasPerRow is set, or has N
+// values added along the columns.
+template<typename T>
+typename std::enable_if<!is_complex<T>::value>::type
+gemmEpilogue(T *C, const int M, const int N, const T *bias, const bool biasPerRow,
+             const af_activation act)
+{
+    switch (act) {
+    case AF_ACTIVATION_RELU:    epilogueLoop<T, AF_ACTIVATION_RELU   >(C, M, N, bias, biasPerRow); break;
+    case AF_ACTIVATION_SIGMOID: epilogueLoop<T, AF_ACTIVATION_SIGMOID>(C, M, N, bias, biasPerRow); break;
+    case AF_ACTIVATION_TANH:    epilogueLoop<T, AF_ACTIVATION_TANH   >(C, M, N, bias, biasPerRow); break;
+    default:
+        if (bias) epilogueLoop<T, AF_ACTIVATION_NONE>(C, M, N, bias, biasPerRow);
+        break;
+    }
+}
+
+// Activations are only defined for real types
+template<typename T>
+typename std::enable_if<is_complex<T>::value>::type
+gemmEpilogue(T *C, const int M, const int N, const T *bias, const bool biasPerRow,
+             const af_activation act)
+{
+    if (bias) epilogueLoop<T, AF_ACTIVATION_NONE>(C, M, N, bias, biasPerRow);
+}
+
+}
+}
@@ -0,0 +1,158 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Normalizes values that compare equal but differ in their bit pattern
+// (-0.0 and 0.0) so that they land in the same bucket
+template<typename T>
+static inline T canonicalKey(T key)
+{
+    return (key == T(0)) ? T(0) : key;
+}
+
+// NaNs never compare equal to anything, so they are never stored in a table
+template<typename T>
+static inline bool isUnorderedKey(T key)
+{
+    return key != key;
+}
+
+template<typename T>
+static inline uint64_t hashKey(T key)
+{
+    static_assert(sizeof(T) <= sizeof(uint64_t), "Key type too large for hashKey");
+
+    key = canonicalKey(key);
+    uint64_t h = 0;
+    std::memcpy(&h, &key, sizeof(T));
+
+    // MurmurHash3 64-bit finalizer
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Open addressing hash table with linear probing.
+//
+// Every distinct key is assigned an id in the order in which it was first
+// inserted. The ids can be used to index into side arrays (for example to
+// keep per key aggregates) and to recover the first occurrence order.
+template<typename T>
+class HashTable
+{
+    std::vector<T>     keys;
+    std::vector<dim_t> ids;
+    dim_t              count;
+    dim_t              mask;
+
+    static dim_t initialCapacity(dim_t expected)
+    {
+        // Keep the load factor under 0.5 for the expected number of keys,
+        // but do not allocate more than 2^20 slots up front. Tables grow on
+        // demand when the number of distinct keys is larger than that.
+        dim_t target = std::min<dim_t>(std::max<dim_t>(2 * expected, 16), 1 << 20);
+        dim_t cap = 16;
+        while (cap < target) cap <<= 1;
+        return cap;
+    }
+
+    void grow()
+    {
+        std::vector<T>     oldKeys;
+        std::vector<dim_t> oldIds;
+        oldKeys.swap(keys);
+        oldIds.swap(ids);
+
+        dim_t cap = 2 * (mask + 1);
+        keys.resize(cap);
+        ids.assign(cap, -1);
+        mask = cap - 1;
+
+        for (size_t i = 0; i < oldIds.size(); ++i) {
+            if (oldIds[i] < 0) continue;
+            dim_t slot = hashKey(oldKeys[i]) & mask;
+            while (ids[slot] >= 0) slot = (slot + 1) & mask;
+            keys[slot] = oldKeys[i];
+            ids[slot]  = oldIds[i];
+        }
+    }
+
+public:
+    explicit HashTable(dim_t expected)
+        : count(0)
+    {
+        dim_t cap = initialCapacity(expected);
+        keys.resize(cap);
+        ids.assign(cap, -1);
+        mask = cap - 1;
+    }
+
+    // Returns the id of key and whether it was inserted by this call.
+    // NaN keys are never stored; each of them gets a fresh id.
+    std::pair<dim_t, bool> insert(T key)
+    {
+        if (isUnorderedKey(key)) return std::make_pair(count++, true);
+
+        if (2 * (count + 1) > mask + 1) grow();
+
+        key = canonicalKey(key);
+        dim_t slot = hashKey(key) & mask;
+        while (ids[slot] >= 0) {
+            if (keys[slot] == key) return std::make_pair(ids[slot], false);
+            slot = (slot + 1) & mask;
+        }
+
+        keys[slot] = key;
+        ids[slot]  = count;
+        return std::make_pair(count++, true);
+    }
+
+    // Returns the id of key or -1 if it is not in the table
+    dim_t find(T key) const
+    {
+        if (isUnorderedKey(key)) return -1;
+
+        key = canonicalKey(key);
+        dim_t slot = hashKey(key) & mask;
+        while (ids[slot] >= 0) {
+            if (keys[slot] == key) return ids[slot];
+            slot = (slot + 1) & mask;
+        }
+        return -1;
+    }
+
+    bool contains(T key) const
+    {
+        return find(key) >= 0;
+    }
+
+    // Number of ids handed out so far
+    dim_t size() const
+    {
+        return count;
+    }
+};
+
+}
+}
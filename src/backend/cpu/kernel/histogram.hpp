@@ -9,12 +9,164 @@
 
 #pragma once
 #include <Array.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace cpu
 {
 namespace kernel
 {
 
+// Upper limit on the memory used by the per block sub-histograms
+static const size_t HIST_PRIVATE_BYTES = 64 << 20;
+
+// Smallest number of elements handled by one block
+static const dim_t HIST_MIN_BLOCK = 1 << 16;
+
+template<typename InT>
+static inline int binIndex(InT val, double minval, float step, int nbins)
+{
+    int bin = (int)((val - minval) / step);
+    bin = std::max(bin, 0);
+    return std::min(bin, nbins - 1);
+}
+
+// 8 and 16 bit inputs are counted per value and the value counts are folded
+// into the bins afterwards. This replaces the bin computation per element
+// by a single table increment.
+template<typename T> struct DirectIndexed { static const int bits = 0; };
+template<> struct DirectIndexed<char>     { typedef unsigned char  key; static const int bits = 8;  };
+template<> struct DirectIndexed<uchar>    { typedef unsigned char  key; static const int bits = 8;  };
+template<> struct DirectIndexed<short>    { typedef unsigned short key; static const int bits = 16; };
+template<> struct DirectIndexed<ushort>   { typedef unsigned short key; static const int bits = 16; };
+
+// Index of element i of a batch of an array with dims[0] == d0 and
+// strides[1] == s1
+template<bool IsLinear>
+static inline dim_t elemIndex(dim_t i, dim_t d0, dim_t s1)
+{
+    return IsLinear ? i : ((i % d0) + (i / d0) * s1);
+}
+
+// Splits n elements into blocks that each get their own sub-histogram of
+// nbins values of type T
+template<typename T>
+static inline dim_t histBlocks(dim_t &blockSize, dim_t n, dim_t nbins)
+{
+    dim_t nblocks = splitRange(blockSize, n, HIST_MIN_BLOCK);
+    dim_t maxBlocks = std::max<dim_t>(1, HIST_PRIVATE_BYTES / (nbins * sizeof(T)));
+    if (nblocks > maxBlocks) {
+        nblocks   = maxBlocks;
+        blockSize = (n + nblocks - 1) / nblocks;
+    }
+    return nblocks;
+}
+
+// Adds the nblocks sub-histograms of length nbins in priv into out
+template<typename OutT, typename T>
+void mergeBlocks(OutT *out, const std::vector<T> &priv, dim_t nblocks, dim_t nbins)
+{
+    dim_t chunk = 0;
+    const dim_t nchunks = splitRange(chunk, nbins, 1024);
+    parallelFor(nchunks, [&](dim_t c) {
+        const dim_t end = std::min(nbins, (c + 1) * chunk);
+        for (dim_t k = c * chunk; k < end; ++k) {
+            T sum = T(0);
+            for (dim_t b = 0; b < nblocks; ++b) sum += priv[b * nbins + k];
+            out[k] += sum;
+        }
+    });
+}
+
+// Histogram of one batch. weight(i) is the contribution of element i.
+template<typename OutT, typename InT, bool IsLinear, typename Weight>
+void histogramBatch(OutT *out, const InT *in, dim_t n, dim_t d0, dim_t s1,
+                    unsigned nbins, double minval, float step, Weight weight)
+{
+    dim_t blockSize = 0;
+    const dim_t nblocks = histBlocks<OutT>(blockSize, n, nbins);
+
+    if (nblocks == 1) {
+        for (dim_t i = 0; i < n; ++i) {
+            const InT val = in[elemIndex<IsLinear>(i, d0, s1)];
+            out[binIndex(val, minval, step, nbins)] += weight(i);
+        }
+        return;
+    }
+
+    std::vector<OutT> priv(nblocks * nbins, OutT(0));
+    parallelFor(nblocks, [&](dim_t b) {
+        OutT *local = &priv[b * nbins];
+        const dim_t end = std::min(n, (b + 1) * blockSize);
+        for (dim_t i = b * blockSize; i < end; ++i) {
+            const InT val = in[elemIndex<IsLinear>(i, d0, s1)];
+            local[binIndex(val, minval, step, nbins)] += weight(i);
+        }
+    });
+    mergeBlocks(out, priv, nblocks, nbins);
+}
+
+// Unweighted histogram of one batch of 8 or 16 bit values
+template<typename OutT, typename InT, bool IsLinear>
+void histogramDirect(OutT *out, const InT *in, dim_t n, dim_t d0, dim_t s1,
+                     unsigned nbins, double minval, float step)
+{
+    typedef typename DirectIndexed<InT>::key Key;
+    const dim_t nvals = dim_t(1) << DirectIndexed<InT>::bits;
+
+    dim_t blockSize = 0;
+    const dim_t nblocks = histBlocks<uint>(blockSize, n, nvals);
+
+    std::vector<uint> counts(nblocks * nvals, 0);
+    parallelFor(nblocks, [&](dim_t b) {
+        uint *local = &counts[b * nvals];
+        const dim_t end = std::min(n, (b + 1) * blockSize);
+        for (dim_t i = b * blockSize; i < end; ++i) {
+            local[(Key)in[elemIndex<IsLinear>(i, d0, s1)]]++;
+        }
+    });
+
+    std::vector<uint> total(nvals, 0);
+    mergeBlocks(&total.front(), counts, nblocks, nvals);
+
+    for (dim_t v = 0; v < nvals; ++v) {
+        if (total[v] == 0) continue;
+        const InT val = (InT)(Key)v;
+        out[binIndex(val, minval, step, nbins)] += total[v];
+    }
+}
+
+template<typename OutT, typename InT, bool IsLinear>
+struct HistogramDispatch
+{
+    static void run(OutT *out, const InT *in, dim_t n, dim_t d0, dim_t s1,
+                    unsigned nbins, double minval, float step)
+    {
+        histogramBatch<OutT, InT, IsLinear>(out, in, n, d0, s1, nbins, minval, step,
+                                            [](dim_t) { return OutT(1); });
+    }
+};
+
+template<typename OutT, typename InT, bool IsLinear, bool Direct>
+struct HistogramPath : HistogramDispatch<OutT, InT, IsLinear> {};
+
+template<typename OutT, typename InT, bool IsLinear>
+struct HistogramPath<OutT, InT, IsLinear, true>
+{
+    static void run(OutT *out, const InT *in, dim_t n, dim_t d0, dim_t s1,
+                    unsigned nbins, double minval, float step)
+    {
+        // Folding the value table is only worth it when it is
+        // smaller than the input
+        if (n >= (dim_t(1) << DirectIndexed<InT>::bits)) {
+            histogramDirect<OutT, InT, IsLinear>(out, in, n, d0, s1, nbins, minval, step);
+        } else {
+            HistogramDispatch<OutT, InT, IsLinear>::run(out, in, n, d0, s1, nbins, minval, step);
+        }
+    }
+};
+
 template<typename OutT, typename InT, bool IsLinear>
 void histogram(Array<OutT> out, Array<InT> const in,
                unsigned const nbins, double const minval, double const maxval)
@@ -31,14 +183,38 @@ void histogram(Array<OutT> out, Array<InT> const in,
 
     for(dim_t b3 = 0; b3 < outDims[3]; b3++) {
         for(dim_t b2 = 0; b2 < outDims[2]; b2++) {
-            for(dim_t i=0; i<nElems; i++) {
-                int idx = IsLinear ? i : ((i % inDims[0]) + (i / inDims[0])*iStrides[1]);
-                int bin = (int)((inData[idx] - minval) / step);
-                bin = std::max(bin, 0);
-                bin = std::min(bin, (int)(nbins - 1));
-                outData[bin]++;
-            }
+            HistogramPath<OutT, InT, IsLinear, (DirectIndexed<InT>::bits > 0)>::run(
+                    outData, inData, nElems, inDims[0], iStrides[1], nbins, minval, step);
+            inData  += iStrides[2];
+            outData += oStrides[2];
+        }
+    }
+}
+
+// Same as histogram but element i adds weights[i] to its bin instead of 1.
+// Both in and weights are linear and have the same dimensions.
+template<typename OutT, typename InT>
+void weightedHistogram(Array<OutT> out, Array<InT> const in, Array<OutT> const weights,
+                       unsigned const nbins, double const minval, double const maxval)
+{
+    dim4 const outDims   = out.dims();
+    float const step     = (maxval - minval)/(float)nbins;
+    dim4 const inDims    = in.dims();
+    dim4 const iStrides  = in.strides();
+    dim4 const oStrides  = out.strides();
+    dim_t const nElems   = inDims[0]*inDims[1];
+
+    OutT *outData       = out.get();
+    const InT *inData   = in.get();
+    const OutT *wData   = weights.get();
+
+    for(dim_t b3 = 0; b3 < outDims[3]; b3++) {
+        for(dim_t b2 = 0; b2 < outDims[2]; b2++) {
+            histogramBatch<OutT, InT, true>(outData, inData, nElems, inDims[0], iStrides[1],
+                                            nbins, minval, step,
+                                            [wData](dim_t i) { return wData[i]; });
             inData  += iStrides[2];
+            wData   += iStrides[2];
             outData += oStrides[2];
         }
     }
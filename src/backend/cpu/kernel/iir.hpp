@@ -9,51 +9,328 @@
 
 #pragma once
 #include <Array.hpp>
+#include <dispatch.hpp>
+#include <math.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace cpu
 {
 namespace kernel
 {
 
+// Columns filtered side by side, one per vector lane. Filter states and
+// samples are stored lane minor: element i of lane l is at [i * IIR_COLS + l].
+static const dim_t IIR_COLS = 8;
+
+// Samples of each column copied to a lane minor buffer at a time
+static const dim_t IIR_CHUNK = 256;
+
+// Shortest piece a signal is cut into when its columns are too few to keep
+// the threads busy
+static const dim_t IIR_MIN_PIECE = 1 << 14;
+
+// Filters with more states than this are not cut into pieces, as the cost
+// of their transition matrix grows with the cube of it
+static const dim_t IIR_MAX_PIECE_STATES = 16;
+
+// Recursion of iir: y = (c + z[0]) / a[0], z[k - 1] = z[k] - a[k] * y, with
+// z[na - 1] always zero. Columns of a batched a have their own coefficients.
 template<typename T>
-void iir(Array<T> y, Array<T> c, Array<T> const a)
+struct IirDirect
+{
+    dim_t na;
+    std::vector<T> a;
+
+    IirDirect(Array<T> const &coefs, std::vector<dim_t> const &acols)
+    {
+        T const *aptr = coefs.get();
+        dim_t const s0 = coefs.strides()[0];
+        na = coefs.dims()[0];
+        a.assign(na * IIR_COLS, scalar<T>(0));
+        for (dim_t l = 0; l < IIR_COLS; l++) {
+            if (l >= (dim_t)acols.size()) {
+                a[l] = scalar<T>(1);
+                continue;
+            }
+            for (dim_t k = 0; k < na; k++) a[k * IIR_COLS + l] = aptr[acols[l] + k * s0];
+        }
+    }
+
+    dim_t states() const { return na - 1; }
+
+    // Filters n samples of the first W lanes of buf in place, starting from
+    // and updating z. Samples of buf are W lanes apart.
+    template<dim_t W>
+    void run(T *buf, dim_t const n, T *z) const
+    {
+        T const *a0 = &a[0];
+        if (na == 1) {
+            for (dim_t t = 0; t < n; t++) {
+                for (dim_t l = 0; l < W; l++) buf[t * W + l] = buf[t * W + l] / a0[l];
+            }
+            return;
+        }
+        for (dim_t t = 0; t < n; t++) {
+            T *x = buf + t * W;
+            T y[W];
+            for (dim_t l = 0; l < W; l++) x[l] = y[l] = (x[l] + z[l]) / a0[l];
+            for (dim_t k = 1; k < na - 1; k++) {
+                T const *ak = a0 + k * IIR_COLS;
+                T *zd = z + (k - 1) * IIR_COLS;
+                T const *zs = z + k * IIR_COLS;
+                for (dim_t l = 0; l < W; l++) zd[l] = zs[l] - ak[l] * y[l];
+            }
+            T const *an = a0 + (na - 1) * IIR_COLS;
+            T *zn = z + (na - 2) * IIR_COLS;
+            for (dim_t l = 0; l < W; l++) zn[l] = -an[l] * y[l];
+        }
+    }
+};
+
+// Cascade of second order sections in transposed direct form II. Section s
+// has coefficients b0, b1, b2, a1, a2 divided by a0 and states z1, z2.
+template<typename T>
+struct IirSos
+{
+    dim_t nsec;
+    std::vector<T> c;
+
+    IirSos(Array<T> const &sos)
+    {
+        T const *sptr = sos.get();
+        dim_t const s0 = sos.strides()[0], s1 = sos.strides()[1];
+        nsec = sos.dims()[1];
+        c.resize(5 * nsec);
+        for (dim_t s = 0; s < nsec; s++) {
+            T const *sec = sptr + s * s1;
+            T const a0 = sec[3 * s0];
+            c[5 * s + 0] = sec[0]      / a0;
+            c[5 * s + 1] = sec[s0]     / a0;
+            c[5 * s + 2] = sec[2 * s0] / a0;
+            c[5 * s + 3] = sec[4 * s0] / a0;
+            c[5 * s + 4] = sec[5 * s0] / a0;
+        }
+    }
+
+    dim_t states() const { return 2 * nsec; }
+
+    // Runs each section over the n samples of the first W lanes of buf in
+    // turn, in place
+    template<dim_t W>
+    void run(T *buf, dim_t const n, T *z) const
+    {
+        for (dim_t s = 0; s < nsec; s++) {
+            T const b0 = c[5 * s], b1 = c[5 * s + 1], b2 = c[5 * s + 2];
+            T const a1 = c[5 * s + 3], a2 = c[5 * s + 4];
+            T *z1 = z + 2 * s * IIR_COLS;
+            T *z2 = z1 + IIR_COLS;
+            for (dim_t t = 0; t < n; t++) {
+                T *x = buf + t * W;
+                for (dim_t l = 0; l < W; l++) {
+                    T const in = x[l];
+                    T const y  = b0 * in + z1[l];
+                    z1[l] = b1 * in - a1 * y + z2[l];
+                    z2[l] = b2 * in - a2 * y;
+                    x[l] = y;
+                }
+            }
+        }
+    }
+};
+
+// Offsets of the columns of an array of dimensions dims
+static inline std::vector<dim_t> iirColumns(af::dim4 const &dims, af::dim4 const &strides)
+{
+    std::vector<dim_t> offs;
+    for (dim_t w = 0; w < dims[3]; w++) {
+        for (dim_t z = 0; z < dims[2]; z++) {
+            for (dim_t j = 0; j < dims[1]; j++) {
+                offs.push_back(j * strides[1] + z * strides[2] + w * strides[3]);
+            }
+        }
+    }
+    return offs;
+}
+
+// Filters samples [t0, t1) of ncols columns, at most W, starting from state
+// z. Missing columns are filtered as zeros. The output is dropped when out is
+// null.
+template<typename T, dim_t W, typename Filter>
+void iirRange(T *out, dim_t const *ocols, T const *in, dim_t const *icols, dim_t const ncols,
+              dim_t const t0, dim_t const t1, Filter const &f, T *z)
 {
-    dim4 ydims = c.dims();
-    int num_a = a.dims()[0];
+    std::vector<T> buf(IIR_CHUNK * W);
+    for (dim_t c0 = t0; c0 < t1; c0 += IIR_CHUNK) {
+        dim_t const n = std::min(IIR_CHUNK, t1 - c0);
+        for (dim_t l = 0; l < W; l++) {
+            if (l < ncols) {
+                T const *src = in + icols[l] + c0;
+                for (dim_t t = 0; t < n; t++) buf[t * W + l] = src[t];
+            } else {
+                for (dim_t t = 0; t < n; t++) buf[t * W + l] = scalar<T>(0);
+            }
+        }
+
+        f.template run<W>(&buf[0], n, z);
+
+        if (!out) continue;
+        for (dim_t l = 0; l < ncols; l++) {
+            T *dst = out + ocols[l] + c0;
+            for (dim_t t = 0; t < n; t++) dst[t] = buf[t * W + l];
+        }
+    }
+}
+
+// Effect of the state after n samples of zero input on the state after them,
+// per lane: element (i, j) tells how much of state j ends up in state i. The
+// one sample matrix is found by filtering a single zero from each unit
+// state, and raised to the power n by repeated squaring.
+template<typename T, typename Filter>
+std::vector<T> iirTransition(Filter const &f, dim_t n)
+{
+    dim_t const S = f.states();
+    std::vector<T> step(S * S * IIR_COLS), z(S * IIR_COLS);
+    T x[IIR_COLS];
+    for (dim_t j = 0; j < S; j++) {
+        std::fill(z.begin(), z.end(), scalar<T>(0));
+        std::fill(x, x + IIR_COLS, scalar<T>(0));
+        for (dim_t l = 0; l < IIR_COLS; l++) z[j * IIR_COLS + l] = scalar<T>(1);
+        f.template run<IIR_COLS>(x, 1, &z[0]);
+        for (dim_t i = 0; i < S; i++) {
+            for (dim_t l = 0; l < IIR_COLS; l++) step[(i * S + j) * IIR_COLS + l] = z[i * IIR_COLS + l];
+        }
+    }
+
+    // r = m * r, per lane
+    auto mul = [S](std::vector<T> &r, std::vector<T> const &m) {
+        std::vector<T> res(S * S * IIR_COLS, scalar<T>(0));
+        for (dim_t i = 0; i < S; i++) {
+            for (dim_t k = 0; k < S; k++) {
+                T const *mik = &m[(i * S + k) * IIR_COLS];
+                for (dim_t j = 0; j < S; j++) {
+                    T const *rkj = &r[(k * S + j) * IIR_COLS];
+                    T *dst = &res[(i * S + j) * IIR_COLS];
+                    for (dim_t l = 0; l < IIR_COLS; l++) dst[l] = dst[l] + mik[l] * rkj[l];
+                }
+            }
+        }
+        r.swap(res);
+    };
 
-    for (int l = 0; l < (int)ydims[3]; l++) {
-        dim_t yidx3 = l * y.strides()[3];
-        dim_t cidx3 = l * c.strides()[3];
-        dim_t aidx3 = l * a.strides()[3];
+    std::vector<T> res(S * S * IIR_COLS, scalar<T>(0));
+    for (dim_t i = 0; i < S; i++) {
+        for (dim_t l = 0; l < IIR_COLS; l++) res[(i * S + i) * IIR_COLS + l] = scalar<T>(1);
+    }
+    for (; n > 0; n >>= 1) {
+        if (n & 1) mul(res, step);
+        if (n > 1) { std::vector<T> sq = step; mul(sq, step); step.swap(sq); }
+    }
+    return res;
+}
 
-        for (int k = 0; k < (int)ydims[2]; k++) {
+// Filters every column of in into out, IIR_COLS columns at a time, with the
+// filter of their block. When the blocks are too few to keep the threads
+// busy, long signals are also cut into pieces: each piece is filtered from
+// a zero state to find its final state, the true initial states of the
+// pieces are then chained from those with the transition matrix of a piece,
+// and each piece is filtered again from its true initial state.
+template<typename T, typename Filter>
+void iirFilter(Array<T> out, Array<T> const in, std::vector<Filter> const &filters)
+{
+    std::vector<dim_t> const icols = iirColumns(in.dims(), in.strides());
+    std::vector<dim_t> const ocols = iirColumns(out.dims(), out.strides());
+    T const *iptr = in.get();
+    T *optr = out.get();
 
-            dim_t yidx2 = k * y.strides()[2] + yidx3;
-            dim_t cidx2 = k * c.strides()[2] + cidx3;
-            dim_t aidx2 = k * a.strides()[2] + aidx3;
+    dim_t const len     = out.dims()[0];
+    dim_t const ncols   = icols.size();
+    dim_t const nBlocks = divup(ncols, IIR_COLS);
+    dim_t const S       = filters[0].states();
 
-            for (int j = 0; j < (int)ydims[1]; j++) {
+    auto range = [&](dim_t const blk, dim_t const t0, dim_t const t1, T *z, bool const write) {
+        dim_t const col0 = blk * IIR_COLS;
+        dim_t const n = std::min(IIR_COLS, ncols - col0);
+        T *dst = (write ? optr : (T *)NULL);
+        // A lone column is not spread over lanes it would leave idle
+        if (n == 1) iirRange<T, 1>(dst, &ocols[col0], iptr, &icols[col0], n, t0, t1, filters[blk], z);
+        else iirRange<T, IIR_COLS>(dst, &ocols[col0], iptr, &icols[col0], n, t0, t1, filters[blk], z);
+    };
 
-                dim_t yidx1 = j * y.strides()[1] + yidx2;
-                dim_t cidx1 = j * c.strides()[1] + cidx2;
-                dim_t aidx1 = j * a.strides()[1] + aidx2;
+    dim_t nPieces = 1;
+    if (nBlocks < getNumThreads() && S > 0 && S <= IIR_MAX_PIECE_STATES) {
+        nPieces = std::min(len / IIR_MIN_PIECE, divup(getNumThreads(), nBlocks));
+    }
+    if (nPieces < 2) {
+        parallelFor(nBlocks, [&](dim_t blk) {
+            std::vector<T> z(S * IIR_COLS, scalar<T>(0));
+            range(blk, 0, len, z.data(), true);
+        });
+        return;
+    }
 
-                std::vector<T> h_z(num_a);
+    dim_t const plen = divup(len, nPieces);
+    nPieces = divup(len, plen);
 
-                const T *h_a = a.get() + (a.ndims() > 1 ? aidx1 : 0);
-                T *h_c = c.get() + cidx1;
-                T *h_y = y.get() + yidx1;
+    // Final states of the pieces filtered from zero, replaced by the initial
+    // states of the next pieces. The first piece starts from zero and is
+    // final after the first pass.
+    std::vector<T> states(nBlocks * nPieces * S * IIR_COLS, scalar<T>(0));
+    auto state = [&](dim_t const blk, dim_t const p) { return &states[(blk * nPieces + p) * S * IIR_COLS]; };
 
-                for (int i = 0; i < (int)ydims[0]; i++) {
+    parallelFor(nBlocks * (nPieces - 1), [&](dim_t task) {
+        dim_t const blk = task / (nPieces - 1), p = task % (nPieces - 1);
+        range(blk, p * plen, (p + 1) * plen, state(blk, p), p == 0);
+    });
 
-                    T y = h_y[i] = (h_c[i] + h_z[0]) /  h_a[0];
-                    for (int ii = 1; ii < num_a; ii++) {
-                        h_z[ii - 1] = h_z[ii] - h_a[ii] * y;
-                    }
+    parallelFor(nBlocks, [&](dim_t blk) {
+        std::vector<T> const m = iirTransition<T>(filters[blk], plen);
+        std::vector<T> prev(S * IIR_COLS);
+        for (dim_t p = 1; p < nPieces - 1; p++) {
+            T const *last = state(blk, p - 1);
+            T *cur = state(blk, p);
+            std::copy(cur, cur + S * IIR_COLS, prev.begin());
+            for (dim_t i = 0; i < S; i++) {
+                for (dim_t j = 0; j < S; j++) {
+                    T const *mij = &m[(i * S + j) * IIR_COLS];
+                    T const *lj  = last + j * IIR_COLS;
+                    T *pi = &prev[i * IIR_COLS];
+                    for (dim_t l = 0; l < IIR_COLS; l++) pi[l] = pi[l] + mij[l] * lj[l];
                 }
             }
+            std::copy(prev.begin(), prev.end(), cur);
         }
+    });
+
+    parallelFor(nBlocks * (nPieces - 1), [&](dim_t task) {
+        dim_t const blk = task / (nPieces - 1), p = task % (nPieces - 1) + 1;
+        range(blk, p * plen, std::min(len, (p + 1) * plen), state(blk, p - 1), true);
+    });
+}
+
+template<typename T>
+void iir(Array<T> y, Array<T> c, Array<T> const a)
+{
+    // Columns of a batched a are matched to the columns of c
+    dim_t const ncols = c.elements() / c.dims()[0];
+    std::vector<dim_t> const acols = (a.ndims() > 1 ? iirColumns(c.dims(), a.strides())
+                                                    : std::vector<dim_t>(ncols, 0));
+
+    std::vector<IirDirect<T> > filters;
+    for (dim_t col0 = 0; col0 < ncols; col0 += IIR_COLS) {
+        dim_t const n = std::min(IIR_COLS, ncols - col0);
+        filters.push_back(IirDirect<T>(a, std::vector<dim_t>(acols.begin() + col0,
+                                                             acols.begin() + col0 + n)));
     }
+    iirFilter(y, c, filters);
+}
+
+template<typename T>
+void iirSos(Array<T> y, Array<T> const x, Array<T> const sos)
+{
+    dim_t const nBlocks = divup(x.elements() / x.dims()[0], IIR_COLS);
+    iirFilter(y, x, std::vector<IirSos<T> >(nBlocks, IirSos<T>(sos)));
 }
 
 }
@@ -0,0 +1,206 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <af/dim4.hpp>
+#include <types.hpp>
+#include <kernel/gemm.hpp>
+#include <algorithm>
+#include <cmath>
+
+// Unblocked column major factorizations and solves for small matrices. They
+// follow the conventions of the LAPACK routines of the same name: pivots are
+// 1 based, the return value is the LAPACK info and the triangle that is not
+// part of the result is left untouched.
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Square matrices up to this size are handled by the kernels below. The
+// call overhead of the LAPACK library dominates below it.
+static const int LAPACK_SMALL_DIM = 16;
+
+// Offset of matrix b of a batch along dimensions 2 and 3
+static inline dim_t matrixOffset(const af::dim4 &dims, const af::dim4 &strides, const dim_t b)
+{
+    return (b % dims[2]) * strides[2] + (b / dims[2]) * strides[3];
+}
+
+static inline float  realValue(float   x) { return x; }
+static inline double realValue(double  x) { return x; }
+static inline float  realValue(cfloat  x) { return x.real(); }
+static inline double realValue(cdouble x) { return x.real(); }
+
+// |re| + |im|, the magnitude LAPACK uses to choose pivots
+static inline float  pivotAbs(float   x) { return std::abs(x); }
+static inline double pivotAbs(double  x) { return std::abs(x); }
+static inline float  pivotAbs(cfloat  x) { return std::abs(x.real()) + std::abs(x.imag()); }
+static inline double pivotAbs(cdouble x) { return std::abs(x.real()) + std::abs(x.imag()); }
+
+// Cholesky factorization of the N x N matrix A. Only the upper (A = U^H U)
+// or the lower (A = L L^H) triangle is read and overwritten.
+template<typename T>
+int potrfSmall(T *A, const int N, const dim_t lda, const bool is_upper)
+{
+    if (is_upper) {
+        for (int j = 0; j < N; ++j) {
+            T *aj = A + j * lda;
+            for (int i = 0; i < j; ++i) {
+                const T *ai = A + i * lda;
+                T sum = aj[i];
+                for (int k = 0; k < i; ++k) sum -= conjValue(ai[k]) * aj[k];
+                aj[i] = sum / ai[i];
+            }
+            auto d = realValue(aj[j]);
+            for (int k = 0; k < j; ++k) d -= realValue(conjValue(aj[k]) * aj[k]);
+            if (!(d > 0)) return j + 1;
+            aj[j] = T(std::sqrt(d));
+        }
+    } else {
+        // Right looking so that all updates run down contiguous columns
+        for (int j = 0; j < N; ++j) {
+            T *aj = A + j * lda;
+            const auto d = realValue(aj[j]);
+            if (!(d > 0)) return j + 1;
+            const T ljj = T(std::sqrt(d));
+            aj[j] = ljj;
+            for (int i = j + 1; i < N; ++i) aj[i] /= ljj;
+            for (int c = j + 1; c < N; ++c) {
+                T *ac = A + c * lda;
+                const T t = conjValue(aj[c]);
+                for (int i = c; i < N; ++i) ac[i] -= aj[i] * t;
+            }
+        }
+    }
+    return 0;
+}
+
+// LU factorization with partial pivoting of the M x N matrix A
+template<typename T>
+int getrfSmall(T *A, const int M, const int N, const dim_t lda, int *ipiv)
+{
+    int info = 0;
+    const int K = std::min(M, N);
+    for (int j = 0; j < K; ++j) {
+        T *aj = A + j * lda;
+
+        int p = j;
+        for (int i = j + 1; i < M; ++i) {
+            if (pivotAbs(aj[i]) > pivotAbs(aj[p])) p = i;
+        }
+        ipiv[j] = p + 1;
+
+        if (aj[p] == T(0)) {
+            if (info == 0) info = j + 1;
+            continue;
+        }
+
+        if (p != j) {
+            for (int c = 0; c < N; ++c) std::swap(A[j + c * lda], A[p + c * lda]);
+        }
+
+        const T pivot = aj[j];
+        for (int i = j + 1; i < M; ++i) aj[i] /= pivot;
+
+        for (int c = j + 1; c < N; ++c) {
+            T *ac = A + c * lda;
+            const T t = ac[j];
+            if (t == T(0)) continue;
+            for (int i = j + 1; i < M; ++i) ac[i] -= aj[i] * t;
+        }
+    }
+    return info;
+}
+
+// Solves A X = B in place of the N x NRHS matrix B where A holds the
+// factors computed by getrfSmall
+template<typename T>
+void getrsSmall(const T *A, const int N, const dim_t lda, const int *ipiv,
+                T *B, const int NRHS, const dim_t ldb)
+{
+    for (int r = 0; r < NRHS; ++r) {
+        T *b = B + r * ldb;
+        for (int i = 0; i < N; ++i) {
+            const int p = ipiv[i] - 1;
+            if (p != i) std::swap(b[i], b[p]);
+        }
+        for (int k = 0; k < N; ++k) {
+            const T bk = b[k];
+            if (bk == T(0)) continue;
+            const T *ak = A + k * lda;
+            for (int i = k + 1; i < N; ++i) b[i] -= ak[i] * bk;
+        }
+        for (int k = N - 1; k >= 0; --k) {
+            const T *ak = A + k * lda;
+            b[k] /= ak[k];
+            const T bk = b[k];
+            for (int i = 0; i < k; ++i) b[i] -= ak[i] * bk;
+        }
+    }
+}
+
+// Solves A X = B in place of the N x NRHS matrix B where A is upper or lower
+// triangular. Fails without touching B when A has a zero on the diagonal.
+template<typename T>
+int trtrsSmall(const T *A, const int N, const dim_t lda,
+               const bool is_upper, const bool is_unit_diag,
+               T *B, const int NRHS, const dim_t ldb)
+{
+    if (!is_unit_diag) {
+        for (int i = 0; i < N; ++i) {
+            if (A[i + i * lda] == T(0)) return i + 1;
+        }
+    }
+
+    for (int r = 0; r < NRHS; ++r) {
+        T *b = B + r * ldb;
+        if (is_upper) {
+            for (int k = N - 1; k >= 0; --k) {
+                const T *ak = A + k * lda;
+                if (!is_unit_diag) b[k] /= ak[k];
+                const T bk = b[k];
+                for (int i = 0; i < k; ++i) b[i] -= ak[i] * bk;
+            }
+        } else {
+            for (int k = 0; k < N; ++k) {
+                const T *ak = A + k * lda;
+                if (!is_unit_diag) b[k] /= ak[k];
+                const T bk = b[k];
+                for (int i = k + 1; i < N; ++i) b[i] -= ak[i] * bk;
+            }
+        }
+    }
+    return 0;
+}
+
+// Inverse of the N x N matrix A from the factors computed by getrfSmall
+template<typename T>
+int getriSmall(T *A, const int N, const dim_t lda, const int *ipiv)
+{
+    for (int i = 0; i < N; ++i) {
+        if (A[i + i * lda] == T(0)) return i + 1;
+    }
+
+    T inv[LAPACK_SMALL_DIM * LAPACK_SMALL_DIM];
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) inv[i + j * N] = (i == j) ? T(1) : T(0);
+    }
+    getrsSmall(A, N, lda, ipiv, inv, N, N);
+
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) A[i + j * lda] = inv[i + j * N];
+    }
+    return 0;
+}
+
+}
+}
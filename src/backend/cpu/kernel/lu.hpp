@@ -64,14 +64,22 @@ void lu_split(Array<T> lower, Array<T> upper, const Array<T> in)
     }
 }
 
+// Applies the LAPACK row interchanges of every batch of pivot to the
+// permutations in p
 void convertPivot(Array<int> p, Array<int> pivot)
 {
     int *d_pi = pivot.get();
     int *d_po = p.get();
     dim_t d0  = pivot.dims()[0];
-    for(int j = 0; j < (int)d0; j++) {
-        // 1 indexed in pivot
-        std::swap(d_po[j], d_po[d_pi[j] - 1]);
+    dim_t m   = p.dims()[0];
+    dim_t nbatch = pivot.dims()[2] * pivot.dims()[3];
+    for(dim_t b = 0; b < nbatch; b++) {
+        for(int j = 0; j < (int)d0; j++) {
+            // 1 indexed in pivot
+            std::swap(d_po[j], d_po[d_pi[j] - 1]);
+        }
+        d_pi += d0;
+        d_po += m;
     }
 }
 
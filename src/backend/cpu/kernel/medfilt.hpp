@@ -9,7 +9,10 @@
 
 #pragma once
 #include <Array.hpp>
+#include <parallel.hpp>
 #include <vector>
+#include <limits>
+#include <utility>
 #include <algorithm>
 
 namespace cpu
@@ -17,185 +20,354 @@ namespace cpu
 namespace kernel
 {
 
-template<typename T, af_border_type Pad>
-void medfilt1(Array<T> out, const Array<T> in, dim_t w_wid)
+// Windows with at most this many elements go through a sorting network
+static const dim_t MEDFILT_NETWORK_MAX = 25;
+
+// Consecutive outputs of a column sorted together by the network
+static const int MEDFILT_LANES = 16;
+
+// Smallest number of rows of a column handled by one block
+static const dim_t MEDFILT_MIN_ROWS = 256;
+
+// 8 and 16 bit inputs are counted in a histogram of all their values
+template<typename T> struct MedianBins { static const int bits = 0; };
+template<> struct MedianBins<char>   { static const int bits = 8;  };
+template<> struct MedianBins<uchar>  { static const int bits = 8;  };
+template<> struct MedianBins<short>  { static const int bits = 16; };
+template<> struct MedianBins<ushort> { static const int bits = 16; };
+
+// Index into a dimension of length n of position i of the padded input, or
+// -1 when the position is in the zero padding
+template<af_border_type Pad>
+static inline dim_t padIndex(dim_t i, dim_t n)
+{
+    if (i >= 0 && i < n) return i;
+    if (Pad == AF_PAD_ZERO) return -1;
+    if (i < 0) i = -i;
+    if (i >= n) i = 2 * (n - 1) - i;
+    return std::min(std::max<dim_t>(i, 0), n - 1);
+}
+
+// Window of one output column. cols holds the input columns it covers, null
+// for the zero padding, and rows the offsets of the padded rows, -1 for the
+// zero padding. Output row r covers rows [r, r + wLen) of rows.
+template<typename T>
+struct MedianWindow
+{
+    std::vector<T const *> cols;
+    dim_t const *rows;
+
+    T operator()(dim_t r, dim_t c) const
+    {
+        return (cols[c] && rows[r] >= 0) ? cols[c][rows[r]] : T(0);
+    }
+};
+
+template<typename T>
+static inline T medianValue(T const lo, T const hi, bool const even)
+{
+    return even ? T((hi + lo) / 2) : hi;
+}
+
+// Orders NaN after all other values, which keeps sorting and searching
+// windows that hold NaN well defined
+template<typename T>
+static inline bool medianLess(T const a, T const b)
+{
+    return a < b || (a == a && b != b);
+}
+
+// Smaller and larger of a and b in the order of medianLess. Written as
+// selects, so that the sorting network stays branch free.
+template<typename T>
+static inline T medianMin(T const a, T const b)
+{
+    return (b < a || a != a) ? b : a;
+}
+
+template<typename T>
+static inline T medianMax(T const a, T const b)
 {
-    const af::dim4 dims     = in.dims();
-    const af::dim4 istrides = in.strides();
-    const af::dim4 ostrides = out.strides();
-
-    std::vector<T> wind_vals;
-    wind_vals.reserve(w_wid);
-
-    T const * in_ptr = in.get();
-    T * out_ptr = out.get();
-
-    for(int b3=0; b3<(int)dims[3]; b3++) {
-
-        for(int b2=0; b2<(int)dims[2]; b2++) {
-
-            for(int col=0; col<(int)dims[1]; col++) {
-
-                int ocol_off = col*ostrides[1];
-
-                for(int row=0; row<(int)dims[0]; row++) {
-
-                    wind_vals.clear();
-                    for(int wi=0; wi<(int)w_wid; ++wi) {
-
-                        int im_row = row + wi-w_wid/2;
-                        int im_roff;
-                        switch(Pad) {
-                            case AF_PAD_ZERO:
-                                im_roff = im_row * istrides[0];
-                                if (im_row < 0 || im_row>=(int)dims[0])
-                                    wind_vals.push_back(0);
-                                else
-                                    wind_vals.push_back(in_ptr[im_roff]);
-                                break;
-                            case AF_PAD_SYM:
-                                {
-                                    if (im_row < 0) {
-                                        im_row *= -1;
-                                    }
-
-                                    if (im_row>=(int)dims[0]) {
-                                        im_row = 2*((int)dims[0]-1) - im_row;
-                                    }
-
-                                    im_roff = im_row * istrides[0];
-                                    wind_vals.push_back(in_ptr[im_roff]);
-                                }
-                                break;
-                        }
-                    }
-
-                    int off = wind_vals.size()/2;
-                    std::stable_sort(wind_vals.begin(),wind_vals.end());
-                    if (wind_vals.size()%2==0)
-                        out_ptr[ocol_off+row*ostrides[0]] = (wind_vals[off]+wind_vals[off-1])/2;
-                    else {
-                        out_ptr[ocol_off+row*ostrides[0]] = wind_vals[off];
-                    }
+    return (b < a || a != a) ? a : b;
+}
+
+// Compare exchanges of Batcher's odd-even merge sort of n values, reduced to
+// the ones the middle values depend on
+static inline std::vector<std::pair<int, int>> medianNetwork(int const n)
+{
+    std::vector<std::pair<int, int>> pairs;
+    for (int p = 1; p < n; p *= 2) {
+        for (int k = p; k >= 1; k /= 2) {
+            for (int j = k % p; j <= n - 1 - k; j += 2 * k) {
+                for (int i = 0; i <= std::min(k - 1, n - j - k - 1); ++i) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p))
+                        pairs.push_back(std::make_pair(i + j, i + j + k));
                 }
             }
-            in_ptr  += istrides[2];
-            out_ptr += ostrides[2];
         }
     }
+
+    std::vector<bool> needed(n, false);
+    needed[n / 2] = true;
+    if (n % 2 == 0) needed[n / 2 - 1] = true;
+
+    std::vector<std::pair<int, int>> kept;
+    for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) {
+        if (needed[it->first] || needed[it->second]) {
+            needed[it->first] = needed[it->second] = true;
+            kept.push_back(*it);
+        }
+    }
+    std::reverse(kept.begin(), kept.end());
+    return kept;
 }
 
+// Small windows of MEDFILT_LANES consecutive outputs are sorted side by side,
+// which turns each compare exchange into a branch free min and max over the
+// outputs. NaN is ordered last, as in the sorted path.
+template<typename T>
+void medianNetworkColumn(T *out, dim_t const os0, MedianWindow<T> const &win,
+                         dim_t const r0, dim_t const r1, dim_t const wLen, dim_t const wWid,
+                         std::vector<std::pair<int, int>> const &pairs)
+{
+    int const n = wLen * wWid;
+    T vals[MEDFILT_NETWORK_MAX][MEDFILT_LANES];
+
+    for (dim_t t0 = r0; t0 < r1; t0 += MEDFILT_LANES) {
+        int const lanes = std::min<dim_t>(MEDFILT_LANES, r1 - t0);
+        for (dim_t c = 0; c < wWid; ++c) {
+            for (dim_t r = 0; r < wLen; ++r) {
+                T *v = vals[c * wLen + r];
+                for (int l = 0; l < lanes; ++l) v[l] = win(t0 + l + r, c);
+                for (int l = lanes; l < MEDFILT_LANES; ++l) v[l] = v[0];
+            }
+        }
 
-template<typename T, af_border_type Pad>
-void medfilt2(Array<T> out, const Array<T> in, dim_t w_len, dim_t w_wid)
+        // Both results are computed before either row is written, which
+        // keeps the loops free of dependences between a and b
+        for (size_t p = 0; p < pairs.size(); ++p) {
+            T *a = vals[pairs[p].first];
+            T *b = vals[pairs[p].second];
+            T lo[MEDFILT_LANES], hi[MEDFILT_LANES];
+            for (int l = 0; l < MEDFILT_LANES; ++l) lo[l] = medianMin(a[l], b[l]);
+            for (int l = 0; l < MEDFILT_LANES; ++l) hi[l] = medianMax(a[l], b[l]);
+            std::copy(lo, lo + MEDFILT_LANES, a);
+            std::copy(hi, hi + MEDFILT_LANES, b);
+        }
+
+        T const *hi = vals[n / 2];
+        T const *lo = vals[n / 2 - (n % 2 == 0)];
+        for (int l = 0; l < lanes; ++l) {
+            out[(t0 + l) * os0] = medianValue(lo[l], hi[l], n % 2 == 0);
+        }
+    }
+}
+
+// Large windows of other types are kept sorted as they slide down the
+// column. Each row that leaves the window is replaced by the one that
+// enters it, which moves the values in between by one place.
+template<typename T>
+void medianSortedColumn(T *out, dim_t const os0, MedianWindow<T> const &win,
+                        dim_t const r0, dim_t const r1, dim_t const wLen, dim_t const wWid,
+                        std::vector<T> &vals)
 {
-    const af::dim4 dims     = in.dims();
-    const af::dim4 istrides = in.strides();
-    const af::dim4 ostrides = out.strides();
-
-    std::vector<T> wind_vals;
-    wind_vals.reserve(w_len*w_wid);
-
-    T const * in_ptr = in.get();
-    T * out_ptr = out.get();
-
-    for(int b3=0; b3<(int)dims[3]; b3++) {
-
-        for(int b2=0; b2<(int)dims[2]; b2++) {
-
-            for(int col=0; col<(int)dims[1]; col++) {
-
-                int ocol_off = col*ostrides[1];
-
-                for(int row=0; row<(int)dims[0]; row++) {
-
-                    wind_vals.clear();
-
-                    for(int wj=0; wj<(int)w_wid; ++wj) {
-
-                        bool isColOff = false;
-
-                        int im_col = col + wj-w_wid/2;
-                        int im_coff;
-                        switch(Pad) {
-                            case AF_PAD_ZERO:
-                                im_coff = im_col * istrides[1];
-                                if (im_col < 0 || im_col>=(int)dims[1])
-                                    isColOff = true;
-                                break;
-                            case AF_PAD_SYM:
-                                {
-                                    if (im_col < 0) {
-                                        im_col *= -1;
-                                        isColOff = true;
-                                    }
-
-                                    if (im_col>=(int)dims[1]) {
-                                        im_col = 2*((int)dims[1]-1) - im_col;
-                                        isColOff = true;
-                                    }
-
-                                    im_coff = im_col * istrides[1];
-                                }
-                                break;
-                        }
-
-                        for(int wi=0; wi<(int)w_len; ++wi) {
-
-                            bool isRowOff = false;
-
-                            int im_row = row + wi-w_len/2;
-                            int im_roff;
-                            switch(Pad) {
-                                case AF_PAD_ZERO:
-                                    im_roff = im_row * istrides[0];
-                                    if (im_row < 0 || im_row>=(int)dims[0])
-                                        isRowOff = true;
-                                    break;
-                                case AF_PAD_SYM:
-                                    {
-                                        if (im_row < 0) {
-                                            im_row *= -1;
-                                            isRowOff = true;
-                                        }
-
-                                        if (im_row>=(int)dims[0]) {
-                                            im_row = 2*((int)dims[0]-1) - im_row;
-                                            isRowOff = true;
-                                        }
-
-                                        im_roff = im_row * istrides[0];
-                                    }
-                                    break;
-                            }
-
-                            if(isRowOff || isColOff) {
-                                switch(Pad) {
-                                    case AF_PAD_ZERO:
-                                        wind_vals.push_back(0);
-                                        break;
-                                    case AF_PAD_SYM:
-                                        wind_vals.push_back(in_ptr[im_coff+im_roff]);
-                                        break;
-                                }
-                            } else
-                                wind_vals.push_back(in_ptr[im_coff+im_roff]);
-                        }
-                    }
-
-                    std::stable_sort(wind_vals.begin(),wind_vals.end());
-                    int off = wind_vals.size()/2;
-                    if (wind_vals.size()%2==0)
-                        out_ptr[ocol_off+row*ostrides[0]] = (wind_vals[off]+wind_vals[off-1])/2;
-                    else
-                        out_ptr[ocol_off+row*ostrides[0]] = wind_vals[off];
+    dim_t const n   = wLen * wWid;
+    bool const even = (n % 2 == 0);
+    vals.resize(n);
+
+    for (dim_t c = 0; c < wWid; ++c) {
+        for (dim_t r = 0; r < wLen; ++r) vals[c * wLen + r] = win(r0 + r, c);
+    }
+    std::sort(vals.begin(), vals.end(), medianLess<T>);
+
+    T *v = vals.data();
+    for (dim_t row = r0; row < r1; ++row) {
+        if (row > r0) {
+            for (dim_t c = 0; c < wWid; ++c) {
+                T const gone  = win(row - 1, c);
+                T const added = win(row - 1 + wLen, c);
+                if (!medianLess(gone, added) && !medianLess(added, gone)) continue;
+
+                dim_t const i = std::lower_bound(v, v + n, gone, medianLess<T>) - v;
+                dim_t const j = std::lower_bound(v, v + n, added, medianLess<T>) - v;
+                if (j > i) {
+                    std::copy(v + i + 1, v + j, v + i);
+                    v[j - 1] = added;
+                } else {
+                    std::copy_backward(v + j, v + i, v + i + 1);
+                    v[j] = added;
                 }
             }
-            in_ptr  += istrides[2];
-            out_ptr += ostrides[2];
         }
+        out[row * os0] = medianValue(v[n / 2 - even], v[n / 2], even);
     }
 }
 
+// Histogram of the values in a window, split into coarse bins of the high
+// half of the bits and fine bins of all of them. The coarse bin holding the
+// median is tracked as values come and go, so finding the median scans at
+// most one coarse bin of fine bins.
+template<typename T>
+class MedianHistogram
+{
+    static const int bits     = MedianBins<T>::bits;
+    static const int fineBits = bits / 2;
+
+    std::vector<int> coarse;
+    std::vector<int> fine;
+    int mid;
+    int below;
+
+    static int bin(T const v)
+    {
+        return int(v) - int(std::numeric_limits<T>::lowest());
+    }
+
+public:
+    MedianHistogram() : coarse(1 << (bits - fineBits), 0), fine(1 << bits, 0), mid(0), below(0) {}
+
+    void add(T const v)
+    {
+        int const b = bin(v);
+        fine[b]++;
+        coarse[b >> fineBits]++;
+        below += ((b >> fineBits) < mid);
+    }
+
+    void remove(T const v)
+    {
+        int const b = bin(v);
+        fine[b]--;
+        coarse[b >> fineBits]--;
+        below -= ((b >> fineBits) < mid);
+    }
+
+    // Value of the given rank, counting from 0
+    T select(int const rank)
+    {
+        while (below > rank) below -= coarse[--mid];
+        while (below + coarse[mid] <= rank) below += coarse[mid++];
+
+        int b = mid << fineBits;
+        int count = below;
+        while (count + fine[b] <= rank) count += fine[b++];
+        return T(b + int(std::numeric_limits<T>::lowest()));
+    }
+};
+
+// 8 and 16 bit windows slide down the column, replacing one row of the
+// window in the histogram for every output
+template<typename T>
+void medianHistColumn(T *out, dim_t const os0, MedianWindow<T> const &win,
+                      dim_t const r0, dim_t const r1, dim_t const wLen, dim_t const wWid,
+                      MedianHistogram<T> &hist)
+{
+    int const n   = wLen * wWid;
+    bool const even = (n % 2 == 0);
+
+    for (dim_t c = 0; c < wWid; ++c) {
+        for (dim_t r = 0; r < wLen; ++r) hist.add(win(r0 + r, c));
+    }
+
+    for (dim_t row = r0; row < r1; ++row) {
+        if (row > r0) {
+            for (dim_t c = 0; c < wWid; ++c) {
+                T const gone  = win(row - 1, c);
+                T const added = win(row - 1 + wLen, c);
+                if (gone == added) continue;
+                hist.remove(gone);
+                hist.add(added);
+            }
+        }
+        T const hi = hist.select(n / 2);
+        T const lo = (even ? hist.select(n / 2 - 1) : hi);
+        out[row * os0] = medianValue(lo, hi, even);
+    }
+
+    // Leave the histogram empty for the next column
+    for (dim_t c = 0; c < wWid; ++c) {
+        for (dim_t r = 0; r < wLen; ++r) hist.remove(win(r1 - 1 + r, c));
+    }
+}
+
+// Median of the w_len x w_wid window around every element of the matrices
+// of in. The columns are spread over the threads, and so are the rows when
+// there are too few columns to keep the threads busy.
+template<typename T, af_border_type Pad>
+void medfilt(Array<T> out, const Array<T> in, dim_t const w_len, dim_t const w_wid)
+{
+    af::dim4 const dims     = in.dims();
+    af::dim4 const istrides = in.strides();
+    af::dim4 const ostrides = out.strides();
+    if (dims.elements() == 0) return;
+
+    std::vector<dim_t> rows(dims[0] + w_len - 1);
+    for (dim_t i = 0; i < (dim_t)rows.size(); ++i) {
+        dim_t const r = padIndex<Pad>(i - w_len / 2, dims[0]);
+        rows[i] = (r < 0 ? -1 : r * istrides[0]);
+    }
+
+    dim_t const n = w_len * w_wid;
+    bool const useNetwork = (n <= MEDFILT_NETWORK_MAX);
+    bool const useHist    = (!useNetwork && MedianBins<T>::bits > 0);
+    std::vector<std::pair<int, int>> const pairs =
+        (useNetwork ? medianNetwork(n) : std::vector<std::pair<int, int>>());
+
+    dim_t const nCols = dims[1] * dims[2] * dims[3];
+    dim_t colBlock = 0, rowBlock = 0;
+    dim_t const nColBlocks = splitRange(colBlock, nCols, 1);
+    dim_t const nRowBlocks = splitRange(rowBlock, dims[0],
+                                        std::max(MEDFILT_MIN_ROWS,
+                                                 dims[0] * nCols / (4 * getNumThreads())));
+
+    parallelFor(nColBlocks * nRowBlocks, [&](dim_t task) {
+        dim_t const r0 = (task % nRowBlocks) * rowBlock;
+        dim_t const r1 = std::min(dims[0], r0 + rowBlock);
+        dim_t const c0 = (task / nRowBlocks) * colBlock;
+        dim_t const c1 = std::min(nCols, c0 + colBlock);
+
+        MedianWindow<T> win;
+        win.rows = rows.data();
+        win.cols.resize(w_wid);
+
+        std::vector<T> vals;
+        std::vector<MedianHistogram<T>> hist(useHist ? 1 : 0);
+
+        for (dim_t c = c0; c < c1; ++c) {
+            dim_t const col = c % dims[1];
+            dim_t const b2  = (c / dims[1]) % dims[2];
+            dim_t const b3  = c / (dims[1] * dims[2]);
+
+            T const *iptr = in.get() + b2 * istrides[2] + b3 * istrides[3];
+            T *optr = out.get() + col * ostrides[1] + b2 * ostrides[2] + b3 * ostrides[3];
+
+            for (dim_t wj = 0; wj < w_wid; ++wj) {
+                dim_t const ic = padIndex<Pad>(col + wj - w_wid / 2, dims[1]);
+                win.cols[wj] = (ic < 0 ? NULL : iptr + ic * istrides[1]);
+            }
+
+            if (useNetwork) {
+                medianNetworkColumn(optr, ostrides[0], win, r0, r1, w_len, w_wid, pairs);
+            } else if (useHist) {
+                medianHistColumn(optr, ostrides[0], win, r0, r1, w_len, w_wid, hist[0]);
+            } else {
+                medianSortedColumn(optr, ostrides[0], win, r0, r1, w_len, w_wid, vals);
+            }
+        }
+    });
+}
+
+template<typename T, af_border_type Pad>
+void medfilt1(Array<T> out, const Array<T> in, dim_t w_wid)
+{
+    medfilt<T, Pad>(out, in, w_wid, 1);
+}
+
+template<typename T, af_border_type Pad>
+void medfilt2(Array<T> out, const Array<T> in, dim_t w_len, dim_t w_wid)
+{
+    medfilt<T, Pad>(out, in, w_len, w_wid);
+}
+
 }
 }
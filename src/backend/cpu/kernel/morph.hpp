@@ -12,134 +12,273 @@
 #include <Array.hpp>
 #include <utility.hpp>
 #include <ops.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace cpu
 {
 namespace kernel
 {
 
+// Lines processed side by side by a pass of the box filter: columns for the
+// pass along the first dimension and rows for the other passes
+static const dim_t MORPH_COLS = 16;
+static const dim_t MORPH_ROWS = 256;
+
 template<typename T, bool IsDilation>
-void morph(Array<T> out, Array<T> const in, Array<T> const mask)
+static inline T morphInit()
+{
+    return IsDilation ? Binary<T, af_max_t>().init() : Binary<T, af_min_t>().init();
+}
+
+// The running value is always the first argument, so NaN inputs are skipped
+template<typename T, bool IsDilation>
+static inline T morphOp(T const acc, T const val)
+{
+    return IsDilation ? std::max(acc, val) : std::min(acc, val);
+}
+
+// Bounding box of the taps of a mask that are set. Returns true when every
+// tap inside it is set, which makes the mask a flat box.
+template<typename T>
+bool morphBox(dim_t lo[3], dim_t hi[3], Array<T> const &mask)
 {
-    const af::dim4 ostrides = out.strides();
-    const af::dim4 istrides = in.strides();
-    const af::dim4 fstrides = mask.strides();
-    const af::dim4 dims     = in.dims();
-    const af::dim4 window   = mask.dims();
-    T* outData          = out.get();
-    const T*   inData   = in.get();
-    const T*   filter   = mask.get();
-    const dim_t R0      = window[0]/2;
-    const dim_t R1      = window[1]/2;
-
-    T init = IsDilation ? Binary<T, af_max_t>().init() : Binary<T, af_min_t>().init();
-
-    for(dim_t b3=0; b3<dims[3]; ++b3) {
-        for(dim_t b2=0; b2<dims[2]; ++b2) {
-            // either channels or batch is handled by outer most loop
-            for(dim_t j=0; j<dims[1]; ++j) {
-                // j steps along 2nd dimension
-                for(dim_t i=0; i<dims[0]; ++i) {
-                    // i steps along 1st dimension
-                    T filterResult = init;
-
-                    // wj,wi steps along 2nd & 1st dimensions of filter window respectively
-                    for(dim_t wj=0; wj<window[1]; wj++) {
-                        for(dim_t wi=0; wi<window[0]; wi++) {
-
-                            dim_t offj = j+wj-R1;
-                            dim_t offi = i+wi-R0;
-
-                            T maskValue = filter[ getIdx(fstrides, wi, wj) ];
-
-                            if ((maskValue > (T)0) && offi>=0 && offj>=0 && offi<dims[0] && offj<dims[1]) {
-
-                                T inValue   = inData[ getIdx(istrides, offi, offj) ];
-
-                                if (IsDilation)
-                                    filterResult = std::max(filterResult, inValue);
-                                else
-                                    filterResult = std::min(filterResult, inValue);
-                            }
-
-                        } // window 1st dimension loop ends here
-                    } // filter window loop ends here
-
-                    outData[ getIdx(ostrides, i, j) ] = filterResult;
-                } //1st dimension loop ends here
-            } // 2nd dimension loop ends here
-
-            // next iteration will be next batch if any
-            outData += ostrides[2];
-            inData  += istrides[2];
+    af::dim4 const mdims    = mask.dims();
+    af::dim4 const fstrides = mask.strides();
+    T const *filter = mask.get();
+
+    for (int d = 0; d < 3; ++d) { lo[d] = mdims[d]; hi[d] = -1; }
+    for (dim_t wk = 0; wk < mdims[2]; ++wk) {
+        for (dim_t wj = 0; wj < mdims[1]; ++wj) {
+            for (dim_t wi = 0; wi < mdims[0]; ++wi) {
+                if (!(filter[getIdx(fstrides, wi, wj, wk)] > (T)0)) continue;
+                lo[0] = std::min(lo[0], wi); hi[0] = std::max(hi[0], wi);
+                lo[1] = std::min(lo[1], wj); hi[1] = std::max(hi[1], wj);
+                lo[2] = std::min(lo[2], wk); hi[2] = std::max(hi[2], wk);
+            }
+        }
+    }
+    if (hi[0] < 0) return false;
+
+    for (dim_t wk = lo[2]; wk <= hi[2]; ++wk) {
+        for (dim_t wj = lo[1]; wj <= hi[1]; ++wj) {
+            for (dim_t wi = lo[0]; wi <= hi[0]; ++wi) {
+                if (!(filter[getIdx(fstrides, wi, wj, wk)] > (T)0)) return false;
+            }
         }
     }
+    return true;
 }
 
+// Maximum, or minimum for erosion, of w consecutive elements of a number of
+// lines processed side by side (van Herk / Gil-Werman). Element k of line l
+// is in[k * is + l * ils] and output i covers elements [i - R, i - R + w),
+// leaving out the ones outside [0, n). Cutting the lines into blocks of w
+// elements, every output combines a suffix of its block with a prefix of
+// the next one, so each element takes three comparisons whatever w is.
 template<typename T, bool IsDilation>
-void morph3d(Array<T> out, Array<T> const in, Array<T> const mask)
+void morphLines(T *out, dim_t const os, dim_t const ols,
+                T const *in, dim_t const is, dim_t const ils,
+                dim_t const n, dim_t const w, dim_t const R, dim_t const lanes,
+                std::vector<T> &buf)
+{
+    T const init = morphInit<T, IsDilation>();
+    buf.resize(2 * w * lanes);
+    T *suffix = buf.data();
+    T *prefix = suffix + w * lanes;
+
+    // acc = op(prev, element k of every line), with prev the identity when
+    // it is null
+    auto step = [&](T *acc, T const *prev, dim_t const k) {
+        dim_t const e = k - R;
+        if (e < 0 || e >= n) {
+            if (prev) std::copy(prev, prev + lanes, acc);
+            else      std::fill(acc, acc + lanes, init);
+            return;
+        }
+        T const *src = in + e * is;
+        if (prev) {
+            for (dim_t l = 0; l < lanes; ++l) acc[l] = morphOp<T, IsDilation>(prev[l], src[l * ils]);
+        } else {
+            for (dim_t l = 0; l < lanes; ++l) acc[l] = morphOp<T, IsDilation>(init, src[l * ils]);
+        }
+    };
+
+    for (dim_t b0 = 0; b0 < n; b0 += w) {
+        dim_t const iEnd = std::min(n, b0 + w);
+
+        step(suffix + (w - 1) * lanes, NULL, b0 + w - 1);
+        for (dim_t k = w - 2; k >= 0; --k) {
+            step(suffix + k * lanes, suffix + (k + 1) * lanes, b0 + k);
+        }
+
+        step(prefix, NULL, b0 + w);
+        for (dim_t k = 1; k < iEnd - b0 - 1; ++k) {
+            step(prefix + k * lanes, prefix + (k - 1) * lanes, b0 + w + k);
+        }
+
+        for (dim_t l = 0; l < lanes; ++l) out[b0 * os + l * ols] = suffix[l];
+        for (dim_t i = b0 + 1; i < iEnd; ++i) {
+            T const *s = suffix + (i - b0) * lanes;
+            T const *p = prefix + (i - b0 - 1) * lanes;
+            T *o = out + i * os;
+            for (dim_t l = 0; l < lanes; ++l) o[l * ols] = morphOp<T, IsDilation>(s[l], p[l]);
+        }
+    }
+}
+
+// One pass of the box filter along dimension dim, from src to dst
+template<typename T, bool IsDilation>
+void morphPass(T *dst, af::dim4 const &dstrides, T const *src, af::dim4 const &sstrides,
+               af::dim4 const &dims, int const dim, dim_t const w, dim_t const R)
+{
+    int const laneDim = (dim == 0 ? 1 : 0);
+    dim_t const laneBlock = (dim == 0 ? MORPH_COLS : MORPH_ROWS);
+    dim_t const nLaneBlocks = (dims[laneDim] + laneBlock - 1) / laneBlock;
+
+    int others[2], nOthers = 0;
+    for (int d = 0; d < 4; ++d) {
+        if (d != dim && d != laneDim) others[nOthers++] = d;
+    }
+
+    parallelFor(nLaneBlocks * dims[others[0]] * dims[others[1]], [&](dim_t task) {
+        dim_t idx[4] = {0, 0, 0, 0};
+        idx[laneDim]   = (task % nLaneBlocks) * laneBlock;
+        idx[others[0]] = (task / nLaneBlocks) % dims[others[0]];
+        idx[others[1]] = (task / nLaneBlocks) / dims[others[0]];
+
+        dim_t soff = 0, doff = 0;
+        for (int d = 0; d < 4; ++d) {
+            soff += idx[d] * sstrides[d];
+            doff += idx[d] * dstrides[d];
+        }
+
+        std::vector<T> buf;
+        morphLines<T, IsDilation>(dst + doff, dstrides[dim], dstrides[laneDim],
+                                  src + soff, sstrides[dim], sstrides[laneDim],
+                                  dims[dim], w, R,
+                                  std::min(laneBlock, dims[laneDim] - idx[laneDim]), buf);
+    });
+}
+
+// Flat box masks are separable, and are run as one running maximum or
+// minimum per dimension of the box
+template<typename T, bool IsDilation>
+void morphSeparable(Array<T> out, Array<T> const in, dim_t const lo[3], dim_t const hi[3],
+                    af::dim4 const &window, int const ndims)
 {
-    const af::dim4 dims     = in.dims();
-    const af::dim4 window   = mask.dims();
-    const dim_t R0      = window[0]/2;
-    const dim_t R1      = window[1]/2;
-    const dim_t R2      = window[2]/2;
-    const af::dim4 istrides = in.strides();
-    const af::dim4 fstrides = mask.strides();
-    const dim_t bCount  = dims[3];
-    const af::dim4 ostrides = out.strides();
-    T* outData          = out.get();
-    const T*   inData   = in.get();
-    const T*   filter   = mask.get();
-
-    T init = IsDilation ? Binary<T, af_max_t>().init() : Binary<T, af_min_t>().init();
-
-    for(dim_t batchId=0; batchId<bCount; ++batchId) {
-        // either channels or batch is handled by outer most loop
-        for(dim_t k=0; k<dims[2]; ++k) {
-            // k steps along 3rd dimension
-            for(dim_t j=0; j<dims[1]; ++j) {
-                // j steps along 2nd dimension
-                for(dim_t i=0; i<dims[0]; ++i) {
-                    // i steps along 1st dimension
-                    T filterResult = init;
-
-                    // wk, wj,wi steps along 2nd & 1st dimensions of filter window respectively
-                    for(dim_t wk=0; wk<window[2]; wk++) {
-                        for(dim_t wj=0; wj<window[1]; wj++) {
-                            for(dim_t wi=0; wi<window[0]; wi++) {
-
-                                dim_t offk = k+wk-R2;
-                                dim_t offj = j+wj-R1;
-                                dim_t offi = i+wi-R0;
-
-                                T maskValue = filter[ getIdx(fstrides, wi, wj, wk) ];
-
-                                if ((maskValue > (T)0) && offi>=0 && offj>=0 && offk>=0 &&
-                                        offi<dims[0] && offj<dims[1] && offk<dims[2]) {
-
-                                    T inValue   = inData[ getIdx(istrides, offi, offj, offk) ];
-
-                                    if (IsDilation)
-                                        filterResult = std::max(filterResult, inValue);
-                                    else
-                                        filterResult = std::min(filterResult, inValue);
-                                }
-
-                            } // window 1st dimension loop ends here
-                        }  // window 1st dimension loop ends here
-                    }// filter window loop ends here
-
-                    outData[ getIdx(ostrides, i, j, k) ] = filterResult;
-                } //1st dimension loop ends here
-            } // 2nd dimension loop ends here
-        } // 3rd dimension loop ends here
-        // next iteration will be next batch if any
-        outData += ostrides[3];
-        inData  += istrides[3];
+    af::dim4 const dims     = in.dims();
+    af::dim4 const istrides = in.strides();
+    af::dim4 const ostrides = out.strides();
+
+    std::vector<T> tmp(dims.elements());
+    af::dim4 const tstrides(1, dims[0], dims[0] * dims[1], dims[0] * dims[1] * dims[2]);
+
+    // The passes alternate between out and tmp and end in out
+    T const *src = in.get();
+    af::dim4 sstrides = istrides;
+    for (int d = 0; d < ndims; ++d) {
+        bool const toOut = ((ndims - 1 - d) % 2 == 0);
+        T *dst = (toOut ? out.get() : tmp.data());
+        af::dim4 const &dstrides = (toOut ? ostrides : tstrides);
+
+        morphPass<T, IsDilation>(dst, dstrides, src, sstrides, dims, d,
+                                 hi[d] - lo[d] + 1, window[d] / 2 - lo[d]);
+        src = dst;
+        sstrides = dstrides;
     }
 }
 
+// Any other mask is applied one set tap at a time to whole columns, which
+// keeps the inner loop free of bounds checks
+template<typename T, bool IsDilation>
+void morphTaps(Array<T> out, Array<T> const in, Array<T> const mask, int const ndims)
+{
+    af::dim4 const dims     = in.dims();
+    af::dim4 const istrides = in.strides();
+    af::dim4 const ostrides = out.strides();
+    af::dim4 const window   = mask.dims();
+    af::dim4 const fstrides = mask.strides();
+    T const *filter = mask.get();
+
+    // Offsets of the set taps from the center of the window
+    std::vector<dim_t> taps;
+    for (dim_t wk = 0; wk < window[2]; ++wk) {
+        for (dim_t wj = 0; wj < window[1]; ++wj) {
+            for (dim_t wi = 0; wi < window[0]; ++wi) {
+                if (!(filter[getIdx(fstrides, wi, wj, wk)] > (T)0)) continue;
+                taps.push_back(wi - window[0] / 2);
+                taps.push_back(wj - window[1] / 2);
+                taps.push_back(wk - window[2] / 2);
+            }
+        }
+    }
+    dim_t const nTaps = taps.size() / 3;
+
+    T const init = morphInit<T, IsDilation>();
+    dim_t const nCols = dims[1] * dims[2] * dims[3];
+    dim_t blockSize = 0;
+    dim_t const nblocks = splitRange(blockSize, nCols,
+                                     std::max<dim_t>(1, (1 << 16) / std::max<dim_t>(1, dims[0] * nTaps)));
+
+    parallelFor(nblocks, [&](dim_t blk) {
+        dim_t const cEnd = std::min(nCols, (blk + 1) * blockSize);
+        for (dim_t c = blk * blockSize; c < cEnd; ++c) {
+            dim_t const j = c % dims[1];
+            dim_t const k = (c / dims[1]) % dims[2];
+            dim_t const b = c / (dims[1] * dims[2]);
+
+            T *optr = out.get() + j * ostrides[1] + k * ostrides[2] + b * ostrides[3];
+            for (dim_t i = 0; i < dims[0]; ++i) optr[i * ostrides[0]] = init;
+
+            for (dim_t t = 0; t < nTaps; ++t) {
+                dim_t const oi = taps[3 * t], oj = taps[3 * t + 1], ok = taps[3 * t + 2];
+                dim_t const jj = j + oj, kk = k + ok;
+                if (jj < 0 || jj >= dims[1]) continue;
+                if (ndims == 3 && (kk < 0 || kk >= dims[2])) continue;
+
+                T const *iptr = in.get() + jj * istrides[1] + (ndims == 3 ? kk : k) * istrides[2] +
+                                b * istrides[3];
+                dim_t const iBeg = std::max<dim_t>(0, -oi);
+                dim_t const iEnd = std::min(dims[0], dims[0] - oi);
+                if (ostrides[0] == 1 && istrides[0] == 1) {
+                    T const *src = iptr + oi;
+                    for (dim_t i = iBeg; i < iEnd; ++i) {
+                        optr[i] = morphOp<T, IsDilation>(optr[i], src[i]);
+                    }
+                    continue;
+                }
+                for (dim_t i = iBeg; i < iEnd; ++i) {
+                    optr[i * ostrides[0]] = morphOp<T, IsDilation>(optr[i * ostrides[0]],
+                                                                   iptr[(i + oi) * istrides[0]]);
+                }
+            }
+        }
+    });
+}
+
+template<typename T, bool IsDilation>
+void morph(Array<T> out, Array<T> const in, Array<T> const mask)
+{
+    dim_t lo[3], hi[3];
+    if (morphBox(lo, hi, mask)) {
+        morphSeparable<T, IsDilation>(out, in, lo, hi, mask.dims(), 2);
+    } else {
+        morphTaps<T, IsDilation>(out, in, mask, 2);
+    }
+}
+
+template<typename T, bool IsDilation>
+void morph3d(Array<T> out, Array<T> const in, Array<T> const mask)
+{
+    dim_t lo[3], hi[3];
+    if (morphBox(lo, hi, mask)) {
+        morphSeparable<T, IsDilation>(out, in, lo, hi, mask.dims(), 3);
+    } else {
+        morphTaps<T, IsDilation>(out, in, mask, 3);
+    }
+}
 
 }
 }
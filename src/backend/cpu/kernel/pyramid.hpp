@@ -0,0 +1,166 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <Array.hpp>
+#include <dispatch.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Output rows handled by one task of a pyramid level
+static const dim_t PYRAMID_ROWS = 16;
+
+// Index i mirrored into [0, n), as AF_PAD_SYM pads
+static inline dim_t pyramidMirror(dim_t i, dim_t const n)
+{
+    if (i < 0)  i = -i - 1;
+    if (i >= n) i = 2 * n - i - 1;
+    return std::max<dim_t>(0, std::min(i, n - 1));
+}
+
+// Sizes of the images of a level, read once as dim4 accessors are not
+// inlined. Levels other than the input are dense.
+struct PyramidLevel
+{
+    dim_t w, h, s0, s1, s2, s3;
+
+    template<typename T>
+    PyramidLevel(Array<T> const &a) :
+        w(a.dims()[0]), h(a.dims()[1]),
+        s0(a.strides()[0]), s1(a.strides()[1]), s2(a.strides()[2]), s3(a.strides()[3]) {}
+};
+
+// Runs fn(row, channel, batch) over the rows of every image of a level, in
+// blocks of PYRAMID_ROWS rows spread over the threads
+template<typename Func>
+void pyramidRows(af::dim4 const &dims, Func const &fn)
+{
+    dim_t const nBlocks = divup(dims[1], PYRAMID_ROWS);
+    dim_t const nz = dims[2];
+    parallelFor(nBlocks * dims[2] * dims[3], [&](dim_t task) {
+        dim_t const blk = task % nBlocks;
+        dim_t const z   = (task / nBlocks) % nz;
+        dim_t const w   = (task / nBlocks) / nz;
+        dim_t const yEnd = std::min(dims[1], (blk + 1) * PYRAMID_ROWS);
+        for (dim_t y = blk * PYRAMID_ROWS; y < yEnd; y++) fn(y, z, w);
+    });
+}
+
+// Row tmp[0, n) with two mirrored samples added at either end
+template<typename T>
+static inline void pyramidPad(T *tmp, dim_t const n)
+{
+    tmp[-1] = tmp[pyramidMirror(-1, n)];
+    tmp[-2] = tmp[pyramidMirror(-2, n)];
+    tmp[n]     = tmp[pyramidMirror(n, n)];
+    tmp[n + 1] = tmp[pyramidMirror(n + 1, n)];
+}
+
+// Next level of a Gaussian pyramid: src blurred with the binomial filter
+// [1 4 6 4 1] / 16 along both dimensions and decimated by two. Only the
+// kept samples are computed: each output row blurs its five source rows
+// into a buffer, which is then blurred and decimated along the row.
+template<typename T>
+void pyramidReduce(Array<T> dst, Array<T> const src)
+{
+    PyramidLevel const o(dst), i(src);
+    T *optr = dst.get();
+    T const *iptr = src.get();
+
+    pyramidRows(dst.dims(), [&](dim_t const y, dim_t const z, dim_t const w) {
+        T const *img = iptr + z * i.s2 + w * i.s3;
+        T const *r[5];
+        for (int j = 0; j < 5; j++) r[j] = img + pyramidMirror(2 * y + j - 2, i.h) * i.s1;
+
+        std::vector<T> buf(i.w + 4);
+        T *tmp = &buf[2];
+        for (dim_t x = 0; x < i.w; x++) {
+            tmp[x] = (r[0][x] + r[4][x]) + T(4) * (r[1][x] + r[3][x]) + T(6) * r[2][x];
+        }
+        pyramidPad(tmp, i.w);
+
+        T *out = optr + z * o.s2 + w * o.s3 + y * o.s1;
+        for (dim_t x = 0; x < o.w; x++) {
+            T const *t = tmp + 2 * x;
+            out[x] = ((t[-2] + t[2]) + T(4) * (t[-1] + t[1]) + T(6) * t[0]) * T(1.0 / 256);
+        }
+    });
+}
+
+// Subtracts from fine the next level of its Gaussian pyramid, coarse, brought
+// back to its size: zeros are put between the samples of coarse, which is
+// then blurred with 4 * [1 4 6 4 1] / 16. Even and odd outputs take their
+// own taps, so the zeros are never formed.
+template<typename T>
+void pyramidExpandSub(Array<T> fine, Array<T> const coarse)
+{
+    PyramidLevel const f(fine), c(coarse);
+    T *fptr = fine.get();
+    T const *cptr = coarse.get();
+
+    pyramidRows(fine.dims(), [&](dim_t const y, dim_t const z, dim_t const w) {
+        T const *img = cptr + z * c.s2 + w * c.s3;
+        dim_t const k = y / 2;
+        T const *r0 = img + pyramidMirror(k - 1, c.h) * c.s1;
+        T const *r1 = img + k * c.s1;
+        T const *r2 = img + pyramidMirror(k + 1, c.h) * c.s1;
+
+        std::vector<T> buf(c.w + 4);
+        T *tmp = &buf[2];
+        if (y % 2 == 0) {
+            for (dim_t x = 0; x < c.w; x++) tmp[x] = (r0[x] + r2[x]) + T(6) * r1[x];
+        } else {
+            for (dim_t x = 0; x < c.w; x++) tmp[x] = T(4) * (r1[x] + r2[x]);
+        }
+        pyramidPad(tmp, c.w);
+
+        T *out = fptr + z * f.s2 + w * f.s3 + y * f.s1;
+        dim_t const nOdd = f.w / 2;
+        for (dim_t x = 0; x < c.w; x++) {
+            out[2 * x] -= ((tmp[x - 1] + tmp[x + 1]) + T(6) * tmp[x]) * T(1.0 / 64);
+        }
+        for (dim_t x = 0; x < nOdd; x++) {
+            out[2 * x + 1] -= (tmp[x] + tmp[x + 1]) * T(4.0 / 64);
+        }
+    });
+}
+
+// Fills levels, which share one allocation, with the Gaussian pyramid of in,
+// or with its Laplacian pyramid. The Laplacian levels are formed in place,
+// finest first, each from the Gaussian level below it, which is still intact.
+template<typename T>
+void pyramid(std::vector<Array<T> > levels, Array<T> const in, bool const laplacian)
+{
+    PyramidLevel const i(in), o(levels[0]);
+    T const *iptr = in.get();
+    T *optr = levels[0].get();
+    pyramidRows(in.dims(), [&](dim_t const y, dim_t const z, dim_t const w) {
+        T const *src = iptr + z * i.s2 + w * i.s3 + y * i.s1;
+        T *dst = optr + z * o.s2 + w * o.s3 + y * o.s1;
+        for (dim_t x = 0; x < i.w; x++) dst[x] = src[x * i.s0];
+    });
+
+    for (size_t l = 1; l < levels.size(); l++) {
+        pyramidReduce<T>(levels[l], levels[l - 1]);
+    }
+
+    if (!laplacian) return;
+    for (size_t l = 0; l + 1 < levels.size(); l++) {
+        pyramidExpandSub<T>(levels[l], levels[l + 1]);
+    }
+}
+
+}
+}
@@ -0,0 +1,89 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <Array.hpp>
+#include <ops.hpp>
+#include <kernel/hash_table.hpp>
+#include <algorithm>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Every run of equal consecutive keys becomes one group
+template<typename Tk>
+dim_t groupRuns(uint *groups, Tk *ukeys, const Tk *keys, const dim_t n)
+{
+    dim_t count = 0;
+    for (dim_t i = 0; i < n; ++i) {
+        if (i == 0 || keys[i] != keys[i - 1]) ukeys[count++] = keys[i];
+        groups[i] = count - 1;
+    }
+    return count;
+}
+
+// All equal keys become one group. Groups are numbered in the order in which
+// their key first occurs.
+template<typename Tk>
+dim_t groupHashed(uint *groups, Tk *ukeys, const Tk *keys, const dim_t n)
+{
+    HashTable<Tk> table(n);
+    for (dim_t i = 0; i < n; ++i) {
+        std::pair<dim_t, bool> res = table.insert(keys[i]);
+        if (res.second) ukeys[res.first] = keys[i];
+        groups[i] = res.first;
+    }
+    return table.size();
+}
+
+template<af_op_t op, typename Ti, typename To>
+void reduceByKey(Array<To> out, Array<Ti> const in, Array<uint> const groups, int const dim)
+{
+    Transform<Ti, To, op> transform;
+    Binary<To, op> reduce;
+
+    const dim4 idims    = in.dims();
+    const dim4 istrides = in.strides();
+    const dim4 ostrides = out.strides();
+
+    To *outPtr = out.get();
+    const Ti *inPtr = in.get();
+    const uint *gPtr = groups.get();
+
+    std::fill(outPtr, outPtr + out.elements(), reduce.init());
+
+    // The three dimensions that are not being reduced
+    int d[3];
+    for (int i = 0, j = 0; i < 4; ++i) {
+        if (i != dim) d[j++] = i;
+    }
+
+    const dim_t istride = istrides[dim];
+    const dim_t ostride = ostrides[dim];
+    const dim_t len     = idims[dim];
+
+    for (dim_t c2 = 0; c2 < idims[d[2]]; ++c2) {
+        for (dim_t c1 = 0; c1 < idims[d[1]]; ++c1) {
+            for (dim_t c0 = 0; c0 < idims[d[0]]; ++c0) {
+                const Ti *iptr = inPtr  + c0 * istrides[d[0]] + c1 * istrides[d[1]] + c2 * istrides[d[2]];
+                To *optr       = outPtr + c0 * ostrides[d[0]] + c1 * ostrides[d[1]] + c2 * ostrides[d[2]];
+
+                for (dim_t i = 0; i < len; ++i) {
+                    To &val = optr[gPtr[i] * ostride];
+                    val = reduce(val, transform(iptr[i * istride]));
+                }
+            }
+        }
+    }
+}
+
+}
+}
@@ -9,6 +9,12 @@
 
 #pragma once
 #include <Array.hpp>
+#include <dispatch.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "warp.hpp"
 
 namespace cpu
 {
@@ -29,131 +35,152 @@ dim_t round2int(float value)
     return (dim_t)(value+0.5f);
 }
 
-using std::conditional;
-using std::is_same;
+// Output rows handled by one task of resize
+static const dim_t RESIZE_ROWS = 16;
 
-template<typename T>
-using wtype_t = typename conditional<is_same<T, double>::value, double, float>::type;
+// Source positions of the output positions along one dimension: the nearest
+// or lower source index, or for bilinear the two source indices and the
+// weight of the second one
+struct ResizeTable
+{
+    std::vector<dim_t> i1;
+    std::vector<dim_t> i2;
+    std::vector<float> w;
+};
 
-template<typename T>
-using vtype_t = typename conditional<is_complex<T>::value,
-                                     T, wtype_t<T>
-                                    >::type;
+template<af_interp_type method>
+void resizeTable(ResizeTable &t, const dim_t odim, const dim_t idim)
+{
+    t.i1.resize(odim);
+    t.i2.resize(odim);
+    t.w.resize(odim);
+    for (dim_t o = 0; o < odim; o++) {
+        float f = (float)o / (odim / (float)idim);
+        dim_t i1;
+        if (method == AF_INTERP_NEAREST) i1 = round2int(f);
+        else                             i1 = floor(f);
+        if (i1 >= idim) i1 = idim - 1;
+
+        t.i1[o] = i1;
+        t.i2[o] = (i1 + 1 >= idim ? idim - 1 : i1 + 1);
+        t.w[o]  = f - i1;
+    }
+}
 
 template<typename T, af_interp_type method>
 struct resize_op
 {
-    void operator()(T *outPtr, const T *inPtr, const af::dim4 &odims, const af::dim4 &idims,
-              const af::dim4 &ostrides, const af::dim4 &istrides,
-              const dim_t x, const dim_t y)
-    {
-        return;
-    }
-};
+    resize_op(const ResizeTable &tx, const ResizeTable &ty, const af::dim4 &istrides) :
+        tx(tx), ty(ty), is0(istrides[0]), is1(istrides[1]) {}
 
-template<typename T>
-struct resize_op<T, AF_INTERP_NEAREST>
-{
-    void operator()(T *outPtr, const T *inPtr, const af::dim4 &odims, const af::dim4 &idims,
-            const af::dim4 &ostrides, const af::dim4 &istrides,
-            const dim_t x, const dim_t y)
+    void operator()(T *outRow, const T *inPtr, const dim_t y, const dim_t n)
     {
-        // Compute Indices
-        dim_t i_x = round2int((float)x / (odims[0] / (float)idims[0]));
-        dim_t i_y = round2int((float)y / (odims[1] / (float)idims[1]));
-
-        if (i_x >= idims[0]) i_x = idims[0] - 1;
-        if (i_y >= idims[1]) i_y = idims[1] - 1;
-
-        dim_t i_off = i_y * istrides[1] + i_x;
-        dim_t o_off =   y * ostrides[1] + x;
-        // Copy values from all channels
-        for(dim_t w = 0; w < odims[3]; w++) {
-            dim_t wost = w * ostrides[3];
-            dim_t wist = w * istrides[3];
-            for(dim_t z = 0; z < odims[2]; z++) {
-                outPtr[o_off + z * ostrides[2] + wost] = inPtr[i_off + z * istrides[2] + wist];
-            }
+        const T *row = inPtr + ty.i1[y] * is1;
+        for (dim_t x = 0; x < n; x++) {
+            outRow[x] = row[tx.i1[x] * is0];
         }
     }
+
+    const ResizeTable &tx;
+    const ResizeTable &ty;
+    const dim_t is0;
+    const dim_t is1;
 };
 
 template<typename T>
 struct resize_op<T, AF_INTERP_BILINEAR>
 {
-    void operator()(T *outPtr, const T *inPtr, const af::dim4 &odims, const af::dim4 &idims,
-            const af::dim4 &ostrides, const af::dim4 &istrides,
-            const dim_t x, const dim_t y)
-    {
-        // Compute Indices
-        float f_x = (float)x / (odims[0] / (float)idims[0]);
-        float f_y = (float)y / (odims[1] / (float)idims[1]);
-
-        dim_t i1_x  = floor(f_x);
-        dim_t i1_y  = floor(f_y);
-
-        if (i1_x >= idims[0]) i1_x = idims[0] - 1;
-        if (i1_y >= idims[1]) i1_y = idims[1] - 1;
-
-        float b   = f_x - i1_x;
-        float a   = f_y - i1_y;
-
-        dim_t i2_x  = (i1_x + 1 >= idims[0] ? idims[0] - 1 : i1_x + 1);
-        dim_t i2_y  = (i1_y + 1 >= idims[1] ? idims[1] - 1 : i1_y + 1);
+    resize_op(const ResizeTable &tx, const ResizeTable &ty, const af::dim4 &istrides) :
+        tx(tx), ty(ty), is0(istrides[0]), is1(istrides[1]) {}
 
+    void operator()(T *outRow, const T *inPtr, const dim_t y, const dim_t n)
+    {
         typedef typename dtype_traits<T>::base_type BT;
         typedef wtype_t<BT> WT;
         typedef vtype_t<T> VT;
 
-        dim_t o_off = y * ostrides[1] + x;
-        // Copy values from all channels
-        for(dim_t w = 0; w < odims[3]; w++) {
-            dim_t wst = w * istrides[3];
-            for(dim_t z = 0; z < odims[2]; z++) {
-                dim_t zst = z * istrides[2];
-                dim_t channel_off = zst + wst;
-                VT p1 = inPtr[i1_y * istrides[1] + i1_x + channel_off];
-                VT p2 = inPtr[i2_y * istrides[1] + i1_x + channel_off];
-                VT p3 = inPtr[i1_y * istrides[1] + i2_x + channel_off];
-                VT p4 = inPtr[i2_y * istrides[1] + i2_x + channel_off];
-
-                outPtr[o_off + z * ostrides[2] + w * ostrides[3]] =
-                                scalar<WT>((1.0f - a) * (1.0f - b)) * p1 +
-                                scalar<WT>((    a   ) * (1.0f - b)) * p2 +
-                                scalar<WT>((1.0f - a) * (    b   )) * p3 +
-                                scalar<WT>((    a   ) * (    b   )) * p4;
-            }
+        const float a = ty.w[y];
+        const T *row1 = inPtr + ty.i1[y] * is1;
+        const T *row2 = inPtr + ty.i2[y] * is1;
+        for (dim_t x = 0; x < n; x++) {
+            const float b  = tx.w[x];
+            const dim_t i1 = tx.i1[x] * is0;
+            const dim_t i2 = tx.i2[x] * is0;
+            VT p1 = row1[i1];
+            VT p2 = row2[i1];
+            VT p3 = row1[i2];
+            VT p4 = row2[i2];
+
+            outRow[x] = scalar<WT>((1.0f - a) * (1.0f - b)) * p1 +
+                        scalar<WT>((    a   ) * (1.0f - b)) * p2 +
+                        scalar<WT>((1.0f - a) * (    b   )) * p3 +
+                        scalar<WT>((    a   ) * (    b   )) * p4;
         }
     }
+
+    const ResizeTable &tx;
+    const ResizeTable &ty;
+    const dim_t is0;
+    const dim_t is1;
 };
 
-template<typename T>
-struct resize_op<T, AF_INTERP_LOWER>
+// 8-bit bilinear resize in fixed point, truncated like the float result is
+// by the other types and backends. Source rows are
+// interpolated along the first dimension once and kept while consecutive
+// output rows read them.
+template<>
+struct resize_op<uchar, AF_INTERP_BILINEAR>
 {
-    void operator()(T *outPtr, const T *inPtr, const af::dim4 &odims, const af::dim4 &idims,
-            const af::dim4 &ostrides, const af::dim4 &istrides,
-            const dim_t x, const dim_t y)
+    resize_op(const ResizeTable &tx, const ResizeTable &ty, const af::dim4 &istrides) :
+        tx(tx), ty(ty), is0(istrides[0]), is1(istrides[1]), cx(tx.w.size())
     {
-        // Compute Indices
-        dim_t i_x = floor((float)x / (odims[0] / (float)idims[0]));
-        dim_t i_y = floor((float)y / (odims[1] / (float)idims[1]));
-
-        if (i_x >= idims[0]) i_x = idims[0] - 1;
-        if (i_y >= idims[1]) i_y = idims[1] - 1;
-
-        dim_t i_off = i_y * istrides[1] + i_x;
-        dim_t o_off =   y * ostrides[1] + x;
-        // Copy values from all channels
-        for(dim_t w = 0; w < odims[3]; w++) {
-            dim_t wost = w * ostrides[3];
-            dim_t wist = w * istrides[3];
-            for(dim_t z = 0; z < odims[2]; z++) {
-                outPtr[o_off + z * ostrides[2] + wost] = inPtr[i_off + z * istrides[2] + wist];
-            }
+        for (size_t x = 0; x < cx.size(); x++) cx[x] = warpCoef(tx.w[x]);
+        for (int k = 0; k < 2; k++) {
+            cache[k].resize(cx.size());
+            cached[k] = -1;
         }
     }
+
+    // Source row r interpolated along the first dimension, without touching
+    // the cached row keep
+    const int *hrow(const uchar *inPtr, const dim_t r, const dim_t keep)
+    {
+        for (int k = 0; k < 2; k++) {
+            if (cached[k] == r) return &cache[k].front();
+        }
+        const int k = (cached[0] == keep ? 1 : 0);
+        const uchar *row = inPtr + r * is1;
+        int *h = &cache[k].front();
+        for (size_t x = 0; x < cx.size(); x++) {
+            h[x] = row[tx.i1[x] * is0] * (WARP_COEF_ONE - cx[x]) +
+                   row[tx.i2[x] * is0] * cx[x];
+        }
+        cached[k] = r;
+        return h;
+    }
+
+    void operator()(uchar *outRow, const uchar *inPtr, const dim_t y, const dim_t n)
+    {
+        const int *h1 = hrow(inPtr, ty.i1[y], -1);
+        const int *h2 = hrow(inPtr, ty.i2[y], ty.i1[y]);
+        const int cy  = warpCoef(ty.w[y]);
+        for (dim_t x = 0; x < n; x++) {
+            outRow[x] = (uchar)((h1[x] * (WARP_COEF_ONE - cy) + h2[x] * cy) >>
+                                (2 * WARP_COEF_BITS));
+        }
+    }
+
+    const ResizeTable &tx;
+    const ResizeTable &ty;
+    const dim_t is0;
+    const dim_t is1;
+    std::vector<int> cx;
+    std::vector<int> cache[2];
+    dim_t cached[2];
 };
 
+// The source positions are computed once per dimension. Blocks of output rows
+// of every channel and batch are spread over the threads.
 template<typename T, af_interp_type method>
 void resize(Array<T> out, const Array<T> in)
 {
@@ -164,12 +191,25 @@ void resize(Array<T> out, const Array<T> in)
     af::dim4 ostrides = out.strides();
     af::dim4 istrides = in.strides();
 
-    resize_op<T, method> op;
-    for(dim_t y = 0; y < odims[1]; y++) {
-        for(dim_t x = 0; x < odims[0]; x++) {
-            op(outPtr, inPtr, odims, idims, ostrides, istrides, x, y);
+    ResizeTable tx, ty;
+    resizeTable<method>(tx, odims[0], idims[0]);
+    resizeTable<method>(ty, odims[1], idims[1]);
+
+    const dim_t nBlocks = divup(odims[1], RESIZE_ROWS);
+    parallelFor(nBlocks * odims[2] * odims[3], [&](dim_t task) {
+        const dim_t blk = task % nBlocks;
+        const dim_t z   = (task / nBlocks) % odims[2];
+        const dim_t w   = (task / nBlocks) / odims[2];
+
+        const T *src = inPtr  + z * istrides[2] + w * istrides[3];
+              T *dst = outPtr + z * ostrides[2] + w * ostrides[3];
+
+        resize_op<T, method> op(tx, ty, istrides);
+        const dim_t yEnd = std::min(odims[1], (blk + 1) * RESIZE_ROWS);
+        for (dim_t y = blk * RESIZE_ROWS; y < yEnd; y++) {
+            op(dst + y * ostrides[1], src, y, odims[0]);
         }
-    }
+    });
 }
 
 }
@@ -11,7 +11,8 @@
 #include <Array.hpp>
 #include <math.hpp>
 #include <err_cpu.hpp>
-#include "interp.hpp"
+#include <vector>
+#include "warp.hpp"
 
 namespace cpu
 {
@@ -22,10 +23,6 @@ template<typename T, int order>
 void rotate(Array<T> output, const Array<T> input,
             const float theta, af_interp_type method)
 {
-    typedef typename dtype_traits<T>::base_type BT;
-    typedef wtype_t<BT> WT;
-    Interp2<T, WT, order> interp;
-
     const af::dim4 odims    = output.dims();
     const af::dim4 idims    = input.dims();
     const af::dim4 ostrides = output.strides();
@@ -52,39 +49,17 @@ void rotate(Array<T> output, const Array<T> input,
                            std::round(ty * 1000) / 1000.0f,
                           };
 
-    int nimages = odims[2];
-    T *out = output.get();
-
+    std::vector<WarpImage> images(odims[3]);
     for (int idw = 0; idw < (int)odims[3]; idw++) {
-
-        int out_offw = idw * ostrides[3];
-        int in_offw  = idw * istrides[3];
-
-        // Do transform for image
-        for(int idy = 0; idy < (int)odims[1]; idy++) {
-            for(int idx = 0; idx < (int)odims[0]; idx++) {
-                WT xidi = idx * tmat[0] + idy * tmat[1] + tmat[2];
-                WT yidi = idx * tmat[3] + idy * tmat[4] + tmat[5];
-
-                // Special conditions to deal with boundaries for bilinear and bicubic
-                // FIXME: Ideally this condition should be removed or be present for all methods
-                // But tests are expecting a different behavior for bilinear and nearest
-                bool condX = xidi >= -0.0001 && xidi < idims[0];
-                bool condY = yidi >= -0.0001 && yidi < idims[1];
-                int ooff = out_offw + idy * ostrides[1] + idx;
-                if (order == 1 || (condX && condY)) {
-                    // FIXME: Nearest and lower do not do clamping, but other methods do
-                    // Make it consistent
-                    bool clamp = order != 1;
-                    interp(output, ooff, input, in_offw, xidi, yidi, method, nimages, clamp);
-                } else {
-                    for (int n = 0; n < nimages; n++) {
-                        out[ooff + n * ostrides[2]] = scalar<T>(0);
-                    }
-                }
-            }
-        }
+        images[idw].ooff = idw * ostrides[3];
+        images[idw].ioff = idw * istrides[3];
+        std::copy(tmat, tmat + 6, images[idw].tmat);
     }
+
+    // Special conditions to deal with boundaries for bilinear and bicubic
+    // FIXME: Ideally this condition should be removed or be present for all methods
+    // But tests are expecting a different behavior for bilinear and nearest
+    warp<T, order>(output, input, images, odims[2], false, order == 1, method);
 }
 
 }
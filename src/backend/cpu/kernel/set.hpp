@@ -0,0 +1,87 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <Array.hpp>
+#include <kernel/hash_table.hpp>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Writes the distinct values of in[0, n) to out in the order of their first
+// occurrence. Returns the number of values written.
+template<typename T>
+dim_t uniqueStable(T *out, const T *in, const dim_t n)
+{
+    HashTable<T> table(n);
+    dim_t count = 0;
+    for (dim_t i = 0; i < n; ++i) {
+        if (table.insert(in[i]).second) out[count++] = in[i];
+    }
+    return count;
+}
+
+// Same as uniqueStable but on the concatenation of first and second
+template<typename T>
+dim_t unionStable(T *out,
+                  const T *first, const dim_t nFirst,
+                  const T *second, const dim_t nSecond)
+{
+    HashTable<T> table(nFirst + nSecond);
+    dim_t count = 0;
+    for (dim_t i = 0; i < nFirst; ++i) {
+        if (table.insert(first[i]).second) out[count++] = first[i];
+    }
+    for (dim_t i = 0; i < nSecond; ++i) {
+        if (table.insert(second[i]).second) out[count++] = second[i];
+    }
+    return count;
+}
+
+// Writes the distinct values of first that also occur in second, in the
+// order of their first occurrence in first.
+template<typename T>
+dim_t intersectStable(T *out,
+                      const T *first, const dim_t nFirst,
+                      const T *second, const dim_t nSecond)
+{
+    HashTable<T> lookup(nSecond);
+    for (dim_t i = 0; i < nSecond; ++i) lookup.insert(second[i]);
+
+    HashTable<T> seen(std::min(nFirst, lookup.size()));
+    dim_t count = 0;
+    for (dim_t i = 0; i < nFirst; ++i) {
+        if (lookup.contains(first[i]) && seen.insert(first[i]).second) {
+            out[count++] = first[i];
+        }
+    }
+    return count;
+}
+
+template<typename T>
+void contains(Array<char> out, Array<T> const elements, Array<T> const set)
+{
+    const T *sPtr = set.get();
+    const dim_t nSet = set.elements();
+
+    HashTable<T> lookup(nSet);
+    for (dim_t i = 0; i < nSet; ++i) lookup.insert(sPtr[i]);
+
+    const T *ePtr = elements.get();
+    char *oPtr = out.get();
+    const dim_t nElems = elements.elements();
+    for (dim_t i = 0; i < nElems; ++i) {
+        oPtr[i] = lookup.contains(ePtr[i]);
+    }
+}
+
+}
+}
@@ -0,0 +1,619 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <parallel.hpp>
+#include <kernel/gemm.hpp>
+#include <kernel/sparse.hpp>
+#include <kernel/sparse_blas.hpp>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Krylov solvers for A x = b. A whole solve runs inside one task of the
+// queue. The vector updates of an iteration are fused into as few passes
+// over memory as possible, and every pass is split over the threads.
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Smallest number of elements handled by one block of a vector operation
+static const dim_t KRYLOV_MIN_BLOCK = 1 << 14;
+
+static inline double absSquared(float   x) { return (double)x * x; }
+static inline double absSquared(double  x) { return x * x; }
+static inline double absSquared(cfloat  x) { return std::norm(cdouble(x.real(), x.imag())); }
+static inline double absSquared(cdouble x) { return std::norm(x); }
+
+// The blocks the vector operations of a solve are split into. Partial sums
+// are added in block order, so the results do not depend on the number of
+// threads.
+class VectorBlocks
+{
+    dim_t n;
+    dim_t blockSize;
+    dim_t nblocks;
+
+  public:
+    VectorBlocks(const dim_t n) : n(n)
+    {
+        nblocks = splitRange(blockSize, n, KRYLOV_MIN_BLOCK);
+    }
+
+    // Calls fn(begin, end) for every block
+    template<typename Fn>
+    void forEach(Fn fn) const
+    {
+        parallelFor(nblocks, [&](dim_t b) {
+            fn(b * blockSize, std::min(n, (b + 1) * blockSize));
+        });
+    }
+
+    // Sum of fn(begin, end) over the blocks
+    template<typename R, typename Fn>
+    R sum(Fn fn) const
+    {
+        std::vector<R> partial(nblocks, R(0));
+        parallelFor(nblocks, [&](dim_t b) {
+            partial[b] = fn(b * blockSize, std::min(n, (b + 1) * blockSize));
+        });
+        R total = R(0);
+        for (const R &p : partial) total += p;
+        return total;
+    }
+
+    // Sums of the two results fn(begin, end, first, second) writes
+    template<typename R, typename S, typename Fn>
+    void sum2(R &first, S &second, Fn fn) const
+    {
+        std::vector<std::pair<R, S>> partial(nblocks, std::make_pair(R(0), S(0)));
+        parallelFor(nblocks, [&](dim_t b) {
+            fn(b * blockSize, std::min(n, (b + 1) * blockSize),
+               partial[b].first, partial[b].second);
+        });
+        first  = R(0);
+        second = S(0);
+        for (const auto &p : partial) {
+            first  += p.first;
+            second += p.second;
+        }
+    }
+};
+
+template<typename T>
+static T dotBlock(const T *x, const T *y, const dim_t begin, const dim_t end)
+{
+    T s = T(0);
+    for (dim_t i = begin; i < end; ++i) s += conjValue(x[i]) * y[i];
+    return s;
+}
+
+template<typename T>
+static double normBlock(const T *x, const dim_t begin, const dim_t end)
+{
+    double s = 0;
+    for (dim_t i = begin; i < end; ++i) s += absSquared(x[i]);
+    return s;
+}
+
+// A matrix in CSR format
+template<typename T>
+class CsrOperator
+{
+    const T *val;
+    const int *rowPtr;
+    const int *colIdx;
+    int n;
+    std::vector<int> bounds;
+
+  public:
+    CsrOperator(const T *val, const int *rowPtr, const int *colIdx, const int n)
+        : val(val), rowPtr(rowPtr), colIdx(colIdx), n(n),
+          bounds(csrRowBlocks(rowPtr, n, csrmmBlocks(rowPtr, n, 1)))
+    {}
+
+    int size() const { return n; }
+
+    // y = A x. Returns w^H y when w is not null.
+    T apply(T *y, const T *x, const T *w) const
+    {
+        const dim_t nblocks = bounds.size() - 1;
+        std::vector<T> partial(nblocks, T(0));
+        parallelFor(nblocks, [&](dim_t b) {
+            CsrmmRows<T, false, 1>::run(y, n, val, rowPtr, colIdx, x, n, bounds[b], bounds[b + 1]);
+            if (w) partial[b] = dotBlock(w, y, bounds[b], bounds[b + 1]);
+        });
+        T total = T(0);
+        for (const T &p : partial) total += p;
+        return total;
+    }
+
+    void diagonal(std::vector<T> &diag) const
+    {
+        diag.assign(n, T(0));
+        for (int i = 0; i < n; ++i) {
+            for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) {
+                if (colIdx[j] == i) diag[i] += val[j];
+            }
+        }
+    }
+
+    void csr(std::vector<T> &outVal, std::vector<int> &outRowPtr, std::vector<int> &outColIdx) const
+    {
+        outRowPtr.assign(rowPtr, rowPtr + n + 1);
+        for (int i = 0; i <= n; ++i) outRowPtr[i] -= rowPtr[0];
+        outVal.assign(val + rowPtr[0], val + rowPtr[n]);
+        outColIdx.assign(colIdx + rowPtr[0], colIdx + rowPtr[n]);
+    }
+};
+
+// A dense column major matrix
+template<typename T>
+class DenseOperator
+{
+    const T *A;
+    dim_t ld;
+    int n;
+    dim_t blockRows;
+    dim_t nblocks;
+
+  public:
+    DenseOperator(const T *A, const dim_t ld, const int n)
+        : A(A), ld(ld), n(n)
+    {
+        nblocks = splitRange(blockRows, n, std::max<dim_t>(16, KRYLOV_MIN_BLOCK / std::max(1, n)));
+    }
+
+    int size() const { return n; }
+
+    // y = A x. Returns w^H y when w is not null. Every block of rows walks
+    // the columns of A so that it reads contiguous runs.
+    T apply(T *y, const T *x, const T *w) const
+    {
+        std::vector<T> partial(nblocks, T(0));
+        parallelFor(nblocks, [&](dim_t b) {
+            const dim_t begin = b * blockRows;
+            const dim_t end   = std::min<dim_t>(n, begin + blockRows);
+            std::fill(y + begin, y + end, T(0));
+            for (int j = 0; j < n; ++j) {
+                const T *col = A + j * ld;
+                const T xj = x[j];
+                for (dim_t i = begin; i < end; ++i) y[i] += col[i] * xj;
+            }
+            if (w) partial[b] = dotBlock(w, y, begin, end);
+        });
+        T total = T(0);
+        for (const T &p : partial) total += p;
+        return total;
+    }
+
+    void diagonal(std::vector<T> &diag) const
+    {
+        diag.resize(n);
+        for (int i = 0; i < n; ++i) diag[i] = A[i + i * ld];
+    }
+
+    void csr(std::vector<T> &val, std::vector<int> &rowPtr, std::vector<int> &colIdx) const
+    {
+        rowPtr.resize(n + 1);
+        const int nnz = denseCsrRowPtr(rowPtr.data(), A, ld, n, n);
+        val.resize(nnz);
+        colIdx.resize(nnz);
+        denseToCsr(val.data(), colIdx.data(), rowPtr.data(), A, ld, n, n);
+    }
+};
+
+// z = M^-1 r for the preconditioner M
+template<typename T>
+class Preconditioner
+{
+    af_preconditioner kind;
+    int n;
+    std::vector<T> invDiag;
+    // ILU(0) factors in the pattern of A: the unit lower triangle L below
+    // the diagonal and the upper triangle U from the diagonal on
+    std::vector<T> lu;
+    std::vector<int> rowPtr;
+    std::vector<int> colIdx;
+    std::vector<int> diagPos;
+
+    // Incomplete LU without fill in (Saad, Iterative Methods for Sparse
+    // Linear Systems, algorithm 10.4). Fails on a missing or zero pivot.
+    bool factorIlu0()
+    {
+        // The updates below walk the rows in increasing column order
+        for (int i = 0; i < n; ++i) {
+            std::vector<std::pair<int, T>> row;
+            for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) row.push_back(std::make_pair(colIdx[j], lu[j]));
+            std::sort(row.begin(), row.end(),
+                      [](const std::pair<int, T> &a, const std::pair<int, T> &b) { return a.first < b.first; });
+            for (size_t k = 0; k < row.size(); ++k) {
+                colIdx[rowPtr[i] + k] = row[k].first;
+                lu[rowPtr[i] + k]     = row[k].second;
+            }
+        }
+
+        diagPos.assign(n, -1);
+        std::vector<int> pos(n, -1);
+        for (int i = 0; i < n; ++i) {
+            for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) pos[colIdx[j]] = j;
+
+            for (int j = rowPtr[i]; j < rowPtr[i + 1] && colIdx[j] < i; ++j) {
+                const int k = colIdx[j];
+                lu[j] /= lu[diagPos[k]];
+                const T lik = lu[j];
+                for (int l = diagPos[k] + 1; l < rowPtr[k + 1]; ++l) {
+                    if (pos[colIdx[l]] >= 0) lu[pos[colIdx[l]]] -= lik * lu[l];
+                }
+            }
+
+            for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) {
+                if (colIdx[j] == i) diagPos[i] = j;
+                pos[colIdx[j]] = -1;
+            }
+            if (diagPos[i] < 0 || lu[diagPos[i]] == T(0)) return false;
+        }
+        return true;
+    }
+
+  public:
+    // Returns false when the preconditioner can not be built from A
+    template<typename Op>
+    bool init(const af_preconditioner precond, const Op &A)
+    {
+        kind = precond;
+        n = A.size();
+        switch (kind) {
+            case AF_PRECOND_JACOBI:
+                A.diagonal(invDiag);
+                // Rows without a diagonal are left unscaled
+                for (T &d : invDiag) d = (d == T(0)) ? T(1) : T(1) / d;
+                return true;
+            case AF_PRECOND_ILU0:
+                A.csr(lu, rowPtr, colIdx);
+                return factorIlu0();
+            default:
+                return true;
+        }
+    }
+
+    // z = M^-1 r. Returns r^H z.
+    T apply(T *z, const T *r, const VectorBlocks &blocks) const
+    {
+        switch (kind) {
+            case AF_PRECOND_JACOBI:
+                return blocks.sum<T>([&](dim_t begin, dim_t end) {
+                    for (dim_t i = begin; i < end; ++i) z[i] = invDiag[i] * r[i];
+                    return dotBlock(r, z, begin, end);
+                });
+            case AF_PRECOND_ILU0:
+                // The triangular solves are sequential
+                for (int i = 0; i < n; ++i) {
+                    T s = r[i];
+                    for (int j = rowPtr[i]; j < diagPos[i]; ++j) s -= lu[j] * z[colIdx[j]];
+                    z[i] = s;
+                }
+                for (int i = n - 1; i >= 0; --i) {
+                    T s = z[i];
+                    for (int j = diagPos[i] + 1; j < rowPtr[i + 1]; ++j) s -= lu[j] * z[colIdx[j]];
+                    z[i] = s / lu[diagPos[i]];
+                }
+                return blocks.sum<T>([&](dim_t begin, dim_t end) { return dotBlock(r, z, begin, end); });
+            default:
+                return blocks.sum<T>([&](dim_t begin, dim_t end) {
+                    std::copy(r + begin, r + end, z + begin);
+                    return dotBlock(r, z, begin, end);
+                });
+        }
+    }
+};
+
+// Preconditioned conjugate gradient. Returns the number of iterations and
+// sets residual to ||b - A x|| / ||b||, tracked by the recurrence.
+template<typename T, typename Op>
+int cg(T *x, const T *b, const Op &A, const Preconditioner<T> &M,
+       const double tol, const int maxIter, double &residual)
+{
+    const int n = A.size();
+    const VectorBlocks blocks(n);
+    std::vector<T> r(b, b + n), z(n), p(n), q(n);
+    std::fill(x, x + n, T(0));
+
+    const double bnorm = std::sqrt(blocks.sum<double>([&](dim_t i, dim_t e) { return normBlock(b, i, e); }));
+    residual = 0;
+    if (bnorm == 0) return 0;
+    residual = 1;
+
+    T rz = M.apply(z.data(), r.data(), blocks);
+    p = z;
+
+    for (int it = 1; it <= maxIter; ++it) {
+        const T pq = A.apply(q.data(), p.data(), p.data());
+        if (pq == T(0)) return it - 1;
+        const T alpha = rz / pq;
+
+        // x += alpha p and r -= alpha q in one pass, which also gives ||r||
+        const double rr = blocks.sum<double>([&](dim_t begin, dim_t end) {
+            double s = 0;
+            for (dim_t i = begin; i < end; ++i) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * q[i];
+                s += absSquared(r[i]);
+            }
+            return s;
+        });
+        residual = std::sqrt(rr) / bnorm;
+        if (residual <= tol) return it;
+
+        const T rzNew = M.apply(z.data(), r.data(), blocks);
+        const T beta = rzNew / rz;
+        rz = rzNew;
+        blocks.forEach([&](dim_t begin, dim_t end) {
+            for (dim_t i = begin; i < end; ++i) p[i] = z[i] + beta * p[i];
+        });
+    }
+    return maxIter;
+}
+
+// Right preconditioned BiCGSTAB (van der Vorst)
+template<typename T, typename Op>
+int bicgstab(T *x, const T *b, const Op &A, const Preconditioner<T> &M,
+             const double tol, const int maxIter, double &residual)
+{
+    const int n = A.size();
+    const VectorBlocks blocks(n);
+    // r is overwritten by s = r - alpha v within an iteration
+    std::vector<T> r(b, b + n), rhat(b, b + n), p(n, T(0)), v(n, T(0));
+    std::vector<T> phat(n), shat(n), t(n);
+    std::fill(x, x + n, T(0));
+
+    const double bb = blocks.sum<double>([&](dim_t i, dim_t e) { return normBlock(b, i, e); });
+    const double bnorm = std::sqrt(bb);
+    residual = 0;
+    if (bnorm == 0) return 0;
+    residual = 1;
+
+    T rho = T(bb), rhoOld = T(1), alpha = T(1), omega = T(1);
+
+    for (int it = 1; it <= maxIter; ++it) {
+        if (rho == T(0)) return it - 1;
+        const T beta = (rho / rhoOld) * (alpha / omega);
+        blocks.forEach([&](dim_t begin, dim_t end) {
+            for (dim_t i = begin; i < end; ++i) p[i] = r[i] + beta * (p[i] - omega * v[i]);
+        });
+
+        M.apply(phat.data(), p.data(), blocks);
+        const T rv = A.apply(v.data(), phat.data(), rhat.data());
+        if (rv == T(0)) return it - 1;
+        alpha = rho / rv;
+
+        const double ss = blocks.sum<double>([&](dim_t begin, dim_t end) {
+            double s = 0;
+            for (dim_t i = begin; i < end; ++i) {
+                r[i] -= alpha * v[i];
+                s += absSquared(r[i]);
+            }
+            return s;
+        });
+        if (std::sqrt(ss) / bnorm <= tol) {
+            blocks.forEach([&](dim_t begin, dim_t end) {
+                for (dim_t i = begin; i < end; ++i) x[i] += alpha * phat[i];
+            });
+            residual = std::sqrt(ss) / bnorm;
+            return it;
+        }
+
+        M.apply(shat.data(), r.data(), blocks);
+        A.apply(t.data(), shat.data(), nullptr);
+
+        T ts;
+        double tt;
+        blocks.sum2(ts, tt, [&](dim_t begin, dim_t end, T &a, double &c) {
+            a = dotBlock(t.data(), r.data(), begin, end);
+            c = normBlock(t.data(), begin, end);
+        });
+        omega = (tt == 0) ? T(0) : ts / T(tt);
+
+        // Updates x and r and computes ||r|| and rhat^H r for the next
+        // iteration in one pass
+        double rr;
+        T rhoNew;
+        blocks.sum2(rr, rhoNew, [&](dim_t begin, dim_t end, double &c, T &a) {
+            double s = 0;
+            T d = T(0);
+            for (dim_t i = begin; i < end; ++i) {
+                x[i] += alpha * phat[i] + omega * shat[i];
+                r[i] -= omega * t[i];
+                s += absSquared(r[i]);
+                d += conjValue(rhat[i]) * r[i];
+            }
+            c = s;
+            a = d;
+        });
+        residual = std::sqrt(rr) / bnorm;
+        if (residual <= tol || omega == T(0)) return it;
+
+        rhoOld = rho;
+        rho = rhoNew;
+    }
+    return maxIter;
+}
+
+// Right preconditioned GMRES restarted every restart iterations. The basis
+// is orthogonalized with modified Gram-Schmidt and the least squares problem
+// is kept triangular with Givens rotations.
+template<typename T, typename Op>
+int gmres(T *x, const T *b, const Op &A, const Preconditioner<T> &M,
+          const double tol, const int maxIter, const int restart, double &residual)
+{
+    const int n = A.size();
+    const int m = std::min(restart, std::max(1, n));
+    const VectorBlocks blocks(n);
+
+    std::vector<T> V((dim_t)(m + 1) * n), w(n), z(n), r(b, b + n);
+    std::vector<T> H((m + 1) * m), g(m + 1), sn(m), y(m);
+    std::vector<double> cs(m);
+    std::fill(x, x + n, T(0));
+
+    auto norm = [&](const T *v) {
+        return std::sqrt(blocks.sum<double>([&](dim_t i, dim_t e) { return normBlock(v, i, e); }));
+    };
+
+    const double bnorm = norm(b);
+    residual = 0;
+    if (bnorm == 0) return 0;
+
+    double beta = bnorm;
+    int it = 0;
+    while (true) {
+        residual = beta / bnorm;
+        if (residual <= tol || it >= maxIter) return it;
+
+        T *v0 = V.data();
+        blocks.forEach([&](dim_t begin, dim_t end) {
+            for (dim_t i = begin; i < end; ++i) v0[i] = r[i] / T(beta);
+        });
+        std::fill(g.begin(), g.end(), T(0));
+        g[0] = T(beta);
+
+        int k = 0;
+        while (k < m && it < maxIter) {
+            ++it;
+            T *h = &H[k * (m + 1)];
+            const T *vk = &V[(dim_t)k * n];
+
+            M.apply(z.data(), vk, blocks);
+            h[0] = A.apply(w.data(), z.data(), v0);
+
+            // w -= h[i] v_i fused with the projection on the next basis vector
+            double ww = 0;
+            for (int i = 0; i <= k; ++i) {
+                const T hi = h[i];
+                const T *vi   = &V[(dim_t)i * n];
+                const T *next = (i < k) ? &V[(dim_t)(i + 1) * n] : nullptr;
+                T d;
+                blocks.sum2(d, ww, [&](dim_t begin, dim_t end, T &a, double &c) {
+                    T s = T(0);
+                    double q = 0;
+                    for (dim_t e = begin; e < end; ++e) {
+                        w[e] -= hi * vi[e];
+                        if (next) s += conjValue(next[e]) * w[e];
+                        else      q += absSquared(w[e]);
+                    }
+                    a = s;
+                    c = q;
+                });
+                if (next) h[i + 1] = d;
+            }
+            const double hk = std::sqrt(ww);
+            h[k + 1] = T(hk);
+
+            if (hk != 0) {
+                T *vn = &V[(dim_t)(k + 1) * n];
+                blocks.forEach([&](dim_t begin, dim_t end) {
+                    for (dim_t e = begin; e < end; ++e) vn[e] = w[e] / T(hk);
+                });
+            }
+
+            // Applies the previous rotations to the new column and
+            // eliminates h[k + 1]
+            for (int i = 0; i < k; ++i) {
+                const T t = T(cs[i]) * h[i] + sn[i] * h[i + 1];
+                h[i + 1] = -conjValue(sn[i]) * h[i] + T(cs[i]) * h[i + 1];
+                h[i] = t;
+            }
+            const double ak = std::abs(h[k]);
+            const double d  = std::sqrt(ak * ak + hk * hk);
+            if (ak == 0) {
+                cs[k] = 0;
+                sn[k] = T(1);
+            } else {
+                cs[k] = ak / d;
+                sn[k] = (h[k] / T(ak)) * conjValue(h[k + 1]) / T(d);
+            }
+            h[k] = T(cs[k]) * h[k] + sn[k] * h[k + 1];
+            h[k + 1] = T(0);
+            g[k + 1] = -conjValue(sn[k]) * g[k];
+            g[k] = T(cs[k]) * g[k];
+            ++k;
+
+            if (std::abs(g[k]) / bnorm <= tol || hk == 0) break;
+        }
+
+        // y = H^-1 g and x += M^-1 V y
+        for (int i = k - 1; i >= 0; --i) {
+            T s = g[i];
+            for (int j = i + 1; j < k; ++j) s -= H[j * (m + 1) + i] * y[j];
+            y[i] = s / H[i * (m + 1) + i];
+        }
+        blocks.forEach([&](dim_t begin, dim_t end) {
+            for (dim_t e = begin; e < end; ++e) {
+                T s = T(0);
+                for (int j = 0; j < k; ++j) s += y[j] * V[(dim_t)j * n + e];
+                w[e] = s;
+            }
+        });
+        M.apply(z.data(), w.data(), blocks);
+
+        // The residual of the updated x is recomputed so that the test
+        // above does not rely on the rotations alone
+        blocks.forEach([&](dim_t begin, dim_t end) {
+            for (dim_t e = begin; e < end; ++e) x[e] += z[e];
+        });
+        A.apply(w.data(), x, nullptr);
+        beta = std::sqrt(blocks.sum<double>([&](dim_t begin, dim_t end) {
+            double s = 0;
+            for (dim_t e = begin; e < end; ++e) {
+                r[e] = b[e] - w[e];
+                s += absSquared(r[e]);
+            }
+            return s;
+        }));
+    }
+}
+
+// Solves A x = b for the nrhs columns of b, which has leading dimension ldb.
+// x holds nrhs contiguous columns. iterations and residual are the largest
+// values over the columns. Returns false when the preconditioner can not be
+// built.
+template<typename T, typename Op>
+bool krylovSolve(T *x, const T *b, const dim_t ldb, const int nrhs, const Op &A,
+                 const af_iterative_method method, const af_preconditioner precond,
+                 const double tol, const int maxIter, const int restart,
+                 unsigned &iterations, double &residual)
+{
+    iterations = 0;
+    residual = 0;
+
+    Preconditioner<T> M;
+    if (!M.init(precond, A)) return false;
+
+    const int n = A.size();
+    for (int c = 0; c < nrhs; ++c) {
+        T *xc = x + (dim_t)c * n;
+        const T *bc = b + c * ldb;
+        double res = 0;
+        int its = 0;
+        switch (method) {
+            case AF_ITERATIVE_BICGSTAB: its = bicgstab(xc, bc, A, M, tol, maxIter, res); break;
+            case AF_ITERATIVE_GMRES:    its = gmres(xc, bc, A, M, tol, maxIter, restart, res); break;
+            default:                    its = cg(xc, bc, A, M, tol, maxIter, res); break;
+        }
+        iterations = std::max<unsigned>(iterations, its);
+        residual = std::max(residual, res);
+    }
+    return true;
+}
+
+}
+}
@@ -11,6 +11,12 @@
 #include <Array.hpp>
 #include <utility.hpp>
 #include <math.hpp>
+#include <parallel.hpp>
+#include <kernel/sparse_blas.hpp>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 namespace cpu
 {
@@ -41,57 +47,187 @@ void coo2dense(Array<T> output,
     }
 }
 
+// Rows converted together between dense and CSR. A block walks its rows
+// one column at a time so that it reads contiguous runs of the dense matrix.
+static const int SPARSE_DENSE_ROWS = 256;
+
+static inline dim_t denseRowBlocks(const int M)
+{
+    return (M + SPARSE_DENSE_ROWS - 1) / SPARSE_DENSE_ROWS;
+}
+
+// Writes the row offsets of the CSR form of the M x N dense matrix in and
+// returns its number of non zeros
 template<typename T>
-struct dense_csr
+int denseCsrRowPtr(int *rowPtr, const T *in, const dim_t ld, const int M, const int N)
 {
-    void operator()(Array<T> values, Array<int> rowIdx, Array<int> colIdx,
-                    Array<T> const in)
-    {
-        T const * const iPtr = in.get();
-        T       * const vPtr = values.get();
-        int     * const rPtr = rowIdx.get();
-        int     * const cPtr = colIdx.get();
-
-        int stride = in.strides()[1];
-        af::dim4 dims = in.dims();
-
-        int offset = 0;
-        for (int i = 0; i < dims[0]; ++i) {
-            rPtr[i] = offset;
-            for (int j = 0; j < dims[1]; ++j) {
-                if (iPtr[j*stride + i] != scalar<T>(0)) {
-                    vPtr[offset] = iPtr[j*stride + i];
-                    cPtr[offset++] = j;
-                }
+    int *count = rowPtr + 1;
+    parallelFor(denseRowBlocks(M), [&](dim_t b) {
+        const int begin = b * SPARSE_DENSE_ROWS;
+        const int end   = std::min(M, begin + SPARSE_DENSE_ROWS);
+        std::fill(count + begin, count + end, 0);
+        for (int j = 0; j < N; ++j) {
+            const T *col = in + j * ld;
+            for (int i = begin; i < end; ++i) count[i] += (col[i] != scalar<T>(0));
+        }
+    });
+
+    rowPtr[0] = 0;
+    for (int i = 0; i < M; ++i) rowPtr[i + 1] += rowPtr[i];
+    return rowPtr[M];
+}
+
+// Fills the values and columns of the CSR form of in once rowPtr is known
+template<typename T>
+void denseToCsr(T *val, int *colIdx, const int *rowPtr,
+                const T *in, const dim_t ld, const int M, const int N)
+{
+    parallelFor(denseRowBlocks(M), [&](dim_t b) {
+        const int begin = b * SPARSE_DENSE_ROWS;
+        const int end   = std::min(M, begin + SPARSE_DENSE_ROWS);
+        std::vector<int> next(rowPtr + begin, rowPtr + end);
+        for (int j = 0; j < N; ++j) {
+            const T *col = in + j * ld;
+            for (int i = begin; i < end; ++i) {
+                if (col[i] == scalar<T>(0)) continue;
+                const int dst = next[i - begin]++;
+                val[dst]    = col[i];
+                colIdx[dst] = j;
             }
         }
-        rPtr[dims[0]] = offset;
-    }
-};
+    });
+}
 
+// Scatters the M row CSR matrix into the zero initialized dense matrix out
 template<typename T>
-struct csr_dense
+void csrToDense(T *out, const dim_t ld,
+                const T *val, const int *rowPtr, const int *colIdx, const int M)
+{
+    dim_t blockSize = 0;
+    const dim_t nblocks = splitRange(blockSize, (dim_t)rowPtr[M] - rowPtr[0] + M,
+                                     SPARSE_MIN_BLOCK);
+    const std::vector<int> bounds = csrRowBlocks(rowPtr, M, nblocks);
+
+    parallelFor(nblocks, [&](dim_t b) {
+        for (int i = bounds[b]; i < bounds[b + 1]; ++i) {
+            for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) out[i + colIdx[j] * ld] = val[j];
+        }
+    });
+}
+
+// The entries of a COO matrix in any order grouped by row
+struct CooRows
+{
+    // The entries of row i are order[rowPtr[i]] to order[rowPtr[i + 1] - 1],
+    // sorted by column and then by their position in the input
+    std::vector<int> rowPtr;
+    std::vector<int> order;
+    // Row offsets once the entries with the same column are combined
+    std::vector<int> outRowPtr;
+    // Blocks of rows with about the same number of entries
+    std::vector<int> bounds;
+};
+
+// Groups the nnz entries of an M x N COO matrix by row in three parallel
+// passes: the entries of every row are counted, the counts are scanned into
+// row offsets and the entries are scattered to their rows. Returns false
+// when an index is outside the matrix.
+static inline bool cooSortRows(CooRows &rows, const int *rowIdx, const int *colIdx,
+                               const int nnz, const int M, const int N)
 {
-    void operator()(Array<T> out,
-                    Array<T> const values, Array<int> const rowIdx, Array<int> const colIdx)
-    {
-        T         * const oPtr = out.get();
-        T   const * const vPtr = values.get();
-        int const * const rPtr = rowIdx.get();
-        int const * const cPtr = colIdx.get();
-
-        int stride = out.strides()[1];
-
-        int r = rowIdx.dims()[0];
-        for (int i = 0; i < r - 1; i++) {
-            for (int ii = rPtr[i]; ii < rPtr[i+1]; ++ii) {
-                int j = cPtr[ii];
-                T v = vPtr[ii];
-                oPtr[j*stride + i] = v;
+    dim_t blockSize = 0;
+    const dim_t nblocks = splitRange(blockSize, nnz, SPARSE_MIN_BLOCK);
+
+    std::unique_ptr<std::atomic<int>[]> next(new std::atomic<int>[M]);
+    for (int i = 0; i < M; ++i) next[i].store(0, std::memory_order_relaxed);
+
+    std::atomic<bool> valid(true);
+    parallelFor(nblocks, [&](dim_t b) {
+        const int end = std::min<dim_t>(nnz, (b + 1) * blockSize);
+        for (int e = b * blockSize; e < end; ++e) {
+            const int r = rowIdx[e], c = colIdx[e];
+            if (r < 0 || r >= M || c < 0 || c >= N) {
+                valid = false;
+                continue;
             }
+            next[r].fetch_add(1, std::memory_order_relaxed);
         }
+    });
+    if (!valid) return false;
+
+    rows.rowPtr.resize(M + 1);
+    rows.rowPtr[0] = 0;
+    for (int i = 0; i < M; ++i) {
+        rows.rowPtr[i + 1] = rows.rowPtr[i] + next[i].load(std::memory_order_relaxed);
+        next[i].store(rows.rowPtr[i], std::memory_order_relaxed);
     }
-};
+
+    rows.order.resize(nnz);
+    parallelFor(nblocks, [&](dim_t b) {
+        const int end = std::min<dim_t>(nnz, (b + 1) * blockSize);
+        for (int e = b * blockSize; e < end; ++e) {
+            rows.order[next[rowIdx[e]].fetch_add(1, std::memory_order_relaxed)] = e;
+        }
+    });
+
+    // The scatter leaves the entries of a row in any order. Sorting them by
+    // column and position makes the result independent of the threads.
+    const dim_t nrowBlocks = splitRange(blockSize, (dim_t)nnz + M, SPARSE_MIN_BLOCK);
+    rows.bounds = csrRowBlocks(rows.rowPtr.data(), M, nrowBlocks);
+    rows.outRowPtr.resize(M + 1);
+    rows.outRowPtr[0] = 0;
+    parallelFor(nrowBlocks, [&](dim_t b) {
+        std::vector<unsigned long long> keys;
+        for (int i = rows.bounds[b]; i < rows.bounds[b + 1]; ++i) {
+            int *first = rows.order.data() + rows.rowPtr[i];
+            int *last  = rows.order.data() + rows.rowPtr[i + 1];
+
+            keys.clear();
+            for (int *p = first; p != last; ++p) {
+                keys.push_back(((unsigned long long)colIdx[*p] << 32) | (unsigned)*p);
+            }
+            std::sort(keys.begin(), keys.end());
+
+            int unique = 0;
+            for (size_t k = 0; k < keys.size(); ++k) {
+                first[k] = (int)(keys[k] & 0xffffffffu);
+                unique += (k == 0 || (keys[k] >> 32) != (keys[k - 1] >> 32));
+            }
+            rows.outRowPtr[i + 1] = unique;
+        }
+    });
+    for (int i = 0; i < M; ++i) rows.outRowPtr[i + 1] += rows.outRowPtr[i];
+
+    return true;
+}
+
+// Fills the values and columns of the CSR matrix assembled from the entries
+// grouped by cooSortRows. Entries with the same position are added when sum
+// is true and the last one is kept otherwise.
+template<typename T>
+void cooToCsr(T *val, int *outColIdx, const CooRows &rows,
+              const T *values, const int *colIdx, const bool sum)
+{
+    parallelFor(rows.bounds.size() - 1, [&](dim_t b) {
+        for (int i = rows.bounds[b]; i < rows.bounds[b + 1]; ++i) {
+            int dst = rows.outRowPtr[i] - 1;
+            int prev = -1;
+            for (int j = rows.rowPtr[i]; j < rows.rowPtr[i + 1]; ++j) {
+                const int e = rows.order[j];
+                if (colIdx[e] != prev) {
+                    prev = colIdx[e];
+                    ++dst;
+                    outColIdx[dst] = prev;
+                    val[dst] = values[e];
+                } else if (sum) {
+                    val[dst] += values[e];
+                } else {
+                    val[dst] = values[e];
+                }
+            }
+        }
+    });
+}
 
 }
 }
@@ -0,0 +1,155 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <algorithm>
+#include <vector>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Collects the values of one row of a sparse result by column in an open
+// addressing hash table. The table is sized for the number of products of
+// the row, so its memory does not depend on the number of columns of the
+// result.
+template<typename T>
+class RowAccumulator
+{
+    std::vector<int> keys;
+    std::vector<T>   vals;
+    std::vector<int> used;
+    unsigned mask;
+    unsigned shift;
+
+    // The low bits of the product only depend on the low bits of col, so
+    // the slot comes from the high bits to spread strided columns
+    unsigned slot(const int col) const
+    {
+        unsigned s = ((unsigned)col * 2654435761u) >> shift;
+        while (keys[s] != col && keys[s] != -1) s = (s + 1) & mask;
+        return s;
+    }
+
+  public:
+    RowAccumulator() : mask(0), shift(32) {}
+
+    // Prepares an empty table for at most bound distinct columns
+    void reset(const dim_t bound)
+    {
+        for (int s : used) keys[s] = -1;
+        used.clear();
+
+        size_t size = 16;
+        unsigned bits = 4;
+        while (size < 2 * (size_t)bound) { size *= 2; ++bits; }
+        if (size > keys.size()) {
+            keys.resize(size, -1);
+            vals.resize(size);
+        }
+        mask  = size - 1;
+        shift = 32 - bits;
+    }
+
+    // Value of col, added as zero the first time col is seen
+    T &at(const int col)
+    {
+        const unsigned s = slot(col);
+        if (keys[s] == -1) {
+            keys[s] = col;
+            vals[s] = T(0);
+            used.push_back(s);
+        }
+        return vals[s];
+    }
+
+    // Value of col or null when col has not been added
+    const T *find(const int col) const
+    {
+        const unsigned s = slot(col);
+        return keys[s] == -1 ? nullptr : &vals[s];
+    }
+
+    int count() const { return used.size(); }
+
+    // Writes the columns in increasing order and their values
+    void extract(int *cols, T *values)
+    {
+        std::sort(used.begin(), used.end(),
+                  [&](int a, int b) { return keys[a] < keys[b]; });
+        for (size_t i = 0; i < used.size(); ++i) {
+            cols[i]   = keys[used[i]];
+            values[i] = vals[used[i]];
+        }
+    }
+};
+
+// Number of products of row i of lhs + rhs or lhs .* rhs
+static inline dim_t csrArithWork(const int *lRowPtr, const int *rRowPtr, const int i)
+{
+    return (lRowPtr[i + 1] - lRowPtr[i]) + (rRowPtr[i + 1] - rRowPtr[i]);
+}
+
+// Number of products of row i of lhs * rhs
+static inline dim_t csrGemmWork(const int *lRowPtr, const int *lColIdx,
+                                const int *rRowPtr, const int i)
+{
+    dim_t work = 0;
+    for (int j = lRowPtr[i]; j < lRowPtr[i + 1]; ++j) {
+        work += rRowPtr[lColIdx[j] + 1] - rRowPtr[lColIdx[j]];
+    }
+    return work;
+}
+
+// Row i of lhs + rhs over the union of the patterns
+template<typename T>
+void csrAddRow(RowAccumulator<T> &acc, RowAccumulator<T> &,
+               const T *lVal, const int *lRowPtr, const int *lColIdx,
+               const T *rVal, const int *rRowPtr, const int *rColIdx,
+               const int i)
+{
+    for (int j = lRowPtr[i]; j < lRowPtr[i + 1]; ++j) acc.at(lColIdx[j]) += lVal[j];
+    for (int j = rRowPtr[i]; j < rRowPtr[i + 1]; ++j) acc.at(rColIdx[j]) += rVal[j];
+}
+
+// Row i of lhs .* rhs over the intersection of the patterns. The row of lhs
+// is first gathered into lookup.
+template<typename T>
+void csrMulRow(RowAccumulator<T> &acc, RowAccumulator<T> &lookup,
+               const T *lVal, const int *lRowPtr, const int *lColIdx,
+               const T *rVal, const int *rRowPtr, const int *rColIdx,
+               const int i)
+{
+    lookup.reset(lRowPtr[i + 1] - lRowPtr[i]);
+    for (int j = lRowPtr[i]; j < lRowPtr[i + 1]; ++j) lookup.at(lColIdx[j]) += lVal[j];
+    for (int j = rRowPtr[i]; j < rRowPtr[i + 1]; ++j) {
+        const T *l = lookup.find(rColIdx[j]);
+        if (l) acc.at(rColIdx[j]) += *l * rVal[j];
+    }
+}
+
+// Row i of lhs * rhs: the rows of rhs selected by the columns of row i of
+// lhs, scaled and summed (Gustavson)
+template<typename T>
+void csrGemmRow(RowAccumulator<T> &acc, RowAccumulator<T> &,
+                const T *lVal, const int *lRowPtr, const int *lColIdx,
+                const T *rVal, const int *rRowPtr, const int *rColIdx,
+                const int i)
+{
+    for (int j = lRowPtr[i]; j < lRowPtr[i + 1]; ++j) {
+        const T   a = lVal[j];
+        const int k = lColIdx[j];
+        for (int l = rRowPtr[k]; l < rRowPtr[k + 1]; ++l) acc.at(rColIdx[l]) += a * rVal[l];
+    }
+}
+
+}
+}
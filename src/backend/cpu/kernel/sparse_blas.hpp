@@ -0,0 +1,244 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <kernel/gemm.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Smallest amount of work, counted as stored values plus rows, handled by
+// one block of rows
+static const dim_t SPARSE_MIN_BLOCK = 1 << 14;
+
+// Upper limit on the memory used by the per block outputs of the transposed
+// products
+static const size_t SPARSE_PRIVATE_BYTES = 64 << 20;
+
+// Number of dense columns that share one pass over a sparse row
+static const int SPARSE_MM_COLUMNS = 4;
+
+template<typename T, bool conjugate>
+static inline T sparseValue(const T v)
+{
+    return conjugate ? conjValue(v) : v;
+}
+
+// Splits the nRows rows of a CSR matrix into nblocks ranges with about the
+// same number of stored values plus rows each. Block b covers the rows
+// [bounds[b], bounds[b + 1]). Any prefix sum of the work per row can be
+// passed as rowPtr.
+template<typename I>
+std::vector<int> csrRowBlocks(const I *rowPtr, const int nRows, const dim_t nblocks)
+{
+    const dim_t total = (dim_t)rowPtr[nRows] - rowPtr[0] + nRows;
+
+    std::vector<int> bounds(nblocks + 1, nRows);
+    bounds[0] = 0;
+    for (dim_t b = 1; b < nblocks; ++b) {
+        const dim_t target = total * b / nblocks;
+        // First row whose start is at or past the target amount of work
+        int lo = bounds[b - 1], hi = nRows;
+        while (lo < hi) {
+            const int mid = lo + (hi - lo) / 2;
+            if ((dim_t)rowPtr[mid] - rowPtr[0] + mid < target) lo = mid + 1;
+            else hi = mid;
+        }
+        bounds[b] = lo;
+    }
+    return bounds;
+}
+
+// out(i, k) = sum_j op(A(i, j)) * right(j, k) for the rows [rowBegin, rowEnd)
+// and the NB columns starting at right and out
+template<typename T, bool conjugate, int NB>
+struct CsrmmRows
+{
+    static void run(T *out, const dim_t ldc,
+                    const T *val, const int *rowPtr, const int *colIdx,
+                    const T *right, const dim_t ldb,
+                    const int rowBegin, const int rowEnd)
+    {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            T acc[NB];
+            for (int k = 0; k < NB; ++k) acc[k] = T(0);
+            for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) {
+                const T v = sparseValue<T, conjugate>(val[j]);
+                const T *x = right + colIdx[j];
+                for (int k = 0; k < NB; ++k) acc[k] += v * x[k * ldb];
+            }
+            for (int k = 0; k < NB; ++k) out[i + k * ldc] = acc[k];
+        }
+    }
+};
+
+// out(c, k) += sum_i op(A(i, c)) * right(i, k) for the rows [rowBegin, rowEnd)
+// of A and the NB columns starting at right and out
+template<typename T, bool conjugate, int NB>
+struct CsrmtmRows
+{
+    static void run(T *out, const dim_t ldc,
+                    const T *val, const int *rowPtr, const int *colIdx,
+                    const T *right, const dim_t ldb,
+                    const int rowBegin, const int rowEnd)
+    {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            T x[NB];
+            for (int k = 0; k < NB; ++k) x[k] = right[i + k * ldb];
+            for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) {
+                const T v = sparseValue<T, conjugate>(val[j]);
+                T *o = out + colIdx[j];
+                for (int k = 0; k < NB; ++k) o[k * ldc] += v * x[k];
+            }
+        }
+    }
+};
+
+// Runs Rows over all N columns of right and out, SPARSE_MM_COLUMNS at a time
+template<typename T, bool conjugate,
+         template<typename, bool, int> class Rows>
+static void csrColumnGroups(T *out, const dim_t ldc,
+                            const T *val, const int *rowPtr, const int *colIdx,
+                            const T *right, const dim_t ldb, const int N,
+                            const int rowBegin, const int rowEnd)
+{
+    int k = 0;
+    for (; k + SPARSE_MM_COLUMNS <= N; k += SPARSE_MM_COLUMNS) {
+        Rows<T, conjugate, SPARSE_MM_COLUMNS>::run(out + k * ldc, ldc, val, rowPtr, colIdx,
+                                                   right + k * ldb, ldb, rowBegin, rowEnd);
+    }
+    for (; k < N; ++k) {
+        Rows<T, conjugate, 1>::run(out + k * ldc, ldc, val, rowPtr, colIdx,
+                                   right + k * ldb, ldb, rowBegin, rowEnd);
+    }
+}
+
+// Number of row blocks csrmm splits a product with N columns into
+static inline dim_t csrmmBlocks(const int *rowPtr, const int nRows, const int N)
+{
+    dim_t blockSize = 0;
+    const dim_t work = ((dim_t)rowPtr[nRows] - rowPtr[0] + nRows) * N;
+    return splitRange(blockSize, work, SPARSE_MIN_BLOCK);
+}
+
+// out = op(A) * right where A is an nRows x K CSR matrix and right has N
+// columns. The rows of A are split into the blocks given by bounds, see
+// csrRowBlocks, and every block writes its own rows of out.
+template<typename T, bool conjugate>
+void csrmm(T *out, const dim_t ldc,
+           const T *val, const int *rowPtr, const int *colIdx, const int nRows,
+           const T *right, const dim_t ldb, const int N,
+           const std::vector<int> &bounds)
+{
+    const dim_t nblocks = bounds.size() - 1;
+    parallelFor(nblocks, [&](dim_t b) {
+        csrColumnGroups<T, conjugate, CsrmmRows>(out, ldc, val, rowPtr, colIdx,
+                                                 right, ldb, N, bounds[b], bounds[b + 1]);
+    });
+}
+
+template<typename T, bool conjugate>
+void csrmm(T *out, const dim_t ldc,
+           const T *val, const int *rowPtr, const int *colIdx, const int nRows,
+           const T *right, const dim_t ldb, const int N)
+{
+    csrmm<T, conjugate>(out, ldc, val, rowPtr, colIdx, nRows, right, ldb, N,
+                        csrRowBlocks(rowPtr, nRows, csrmmBlocks(rowPtr, nRows, N)));
+}
+
+// Number of row blocks csrmtm splits a product with an M x N output into
+static inline dim_t csrmtmBlocks(const int *rowPtr, const int nRows, const int M,
+                                 const int N, const size_t elemSize)
+{
+    const dim_t outElems = (dim_t)M * N;
+    const dim_t work = ((dim_t)rowPtr[nRows] - rowPtr[0] + nRows) * N;
+    dim_t nblocks = csrmmBlocks(rowPtr, nRows, N);
+    // Clearing and summing a partial output should not cost more than the
+    // block of the product that fills it
+    nblocks = std::min(nblocks, std::max<dim_t>(1, work / std::max<dim_t>(1, outElems)));
+    nblocks = std::min(nblocks, std::max<dim_t>(1, SPARSE_PRIVATE_BYTES / (outElems * elemSize)));
+    return nblocks;
+}
+
+// out = op(A)^T * right where A is an nRows x M CSR matrix and right has N
+// columns. Every block of rows of A scatters into its own M x N partial
+// output and the partial outputs are summed afterwards, so no two threads
+// ever write to the same value.
+template<typename T, bool conjugate>
+void csrmtm(T *out, const dim_t ldc,
+            const T *val, const int *rowPtr, const int *colIdx, const int nRows,
+            const T *right, const dim_t ldb, const int M, const int N)
+{
+    const dim_t outElems = (dim_t)M * N;
+    const dim_t nblocks = csrmtmBlocks(rowPtr, nRows, M, N, sizeof(T));
+
+    for (int k = 0; k < N; ++k) {
+        std::fill(out + k * ldc, out + k * ldc + M, T(0));
+    }
+
+    if (nblocks == 1) {
+        csrColumnGroups<T, conjugate, CsrmtmRows>(out, ldc, val, rowPtr, colIdx,
+                                                  right, ldb, N, 0, nRows);
+        return;
+    }
+
+    const std::vector<int> bounds = csrRowBlocks(rowPtr, nRows, nblocks);
+    std::vector<T> priv((nblocks - 1) * outElems, T(0));
+
+    // Block 0 scatters directly into out
+    parallelFor(nblocks, [&](dim_t b) {
+        T *dst = b == 0 ? out : &priv[(b - 1) * outElems];
+        const dim_t ld = b == 0 ? ldc : M;
+        csrColumnGroups<T, conjugate, CsrmtmRows>(dst, ld, val, rowPtr, colIdx,
+                                                  right, ldb, N, bounds[b], bounds[b + 1]);
+    });
+
+    dim_t chunk = 0;
+    const dim_t nchunks = splitRange(chunk, outElems, 1024);
+    parallelFor(nchunks, [&](dim_t c) {
+        const dim_t end = std::min(outElems, (c + 1) * chunk);
+        for (dim_t e = c * chunk; e < end; ++e) {
+            T sum = out[(e % M) + (e / M) * ldc];
+            for (dim_t b = 0; b + 1 < nblocks; ++b) sum += priv[b * outElems + e];
+            out[(e % M) + (e / M) * ldc] = sum;
+        }
+    });
+}
+
+// Builds the CSR form of op(A)^T, an nCols x nRows matrix, from the nRows x
+// nCols CSR matrix A. outRowPtr must hold nCols + 1 values and outVal and
+// outColIdx the number of stored values of A.
+template<typename T, bool conjugate>
+void csrTranspose(T *outVal, int *outRowPtr, int *outColIdx,
+                  const T *val, const int *rowPtr, const int *colIdx,
+                  const int nRows, const int nCols)
+{
+    std::fill(outRowPtr, outRowPtr + nCols + 1, 0);
+    for (int j = rowPtr[0]; j < rowPtr[nRows]; ++j) outRowPtr[colIdx[j] + 1]++;
+    for (int c = 0; c < nCols; ++c) outRowPtr[c + 1] += outRowPtr[c];
+
+    // Rows of A are visited in order, so the columns of every row of the
+    // result stay sorted
+    std::vector<int> next(outRowPtr, outRowPtr + nCols);
+    for (int i = 0; i < nRows; ++i) {
+        for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) {
+            const int dst = next[colIdx[j]]++;
+            outVal[dst]    = sparseValue<T, conjugate>(val[j]);
+            outColIdx[dst] = i;
+        }
+    }
+}
+}
+}
@@ -0,0 +1,427 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <err_common.hpp>
+#include <kernel/sparse_blas.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+// Conversions and products for the blocked sparse storages.
+//
+// BSR stores an M x N matrix as bs x bs dense blocks. rowIdx holds the
+// M / bs + 1 offsets of the block rows into colIdx, colIdx the block column
+// of every block and values the blocks one after the other, each in column
+// major order. bs divides both M and N.
+//
+// SELL-C-sigma stores the rows in slices of SELL_C rows. Within a window of
+// SELL_SIGMA rows the rows are sorted by decreasing length, so the rows of
+// a slice have about the same length. A slice is stored as an SELL_C x width
+// column major block where width is the length of its longest row. rowIdx
+// holds the nSlices + 1 offsets of the slices into colIdx followed by the
+// original row of every stored row. Padding has a column of -1.
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Rows per slice of the SELL-C-sigma storage
+static const int SELL_C = 8;
+
+// Rows sorted by length together. A multiple of SELL_C so that the rows of a
+// slice are always sorted.
+static const int SELL_SIGMA = 32 * SELL_C;
+
+// Block sizes tried when converting to BSR
+static const int BSR_SIZES[] = {8, 6, 4, 3, 2};
+
+// Block size of an M x N BSR matrix with rowIdxElems block row offsets
+static inline int bsrSize(const dim_t M, const dim_t rowIdxElems)
+{
+    return rowIdxElems > 1 ? M / (rowIdxElems - 1) : 1;
+}
+
+static inline int sellSlices(const int nRows)
+{
+    return (nRows + SELL_C - 1) / SELL_C;
+}
+
+// Writes the M / bs + 1 block row offsets of the BSR form of the M x N CSR
+// matrix and returns the number of blocks
+static inline int bsrRowPtr(int *bRowPtr, const int *rowPtr, const int *colIdx,
+                            const int M, const int N, const int bs)
+{
+    const int nbr = M / bs;
+    std::vector<int> mark(N / bs, -1);
+    bRowPtr[0] = 0;
+    for (int br = 0; br < nbr; ++br) {
+        int count = 0;
+        for (int j = rowPtr[br * bs]; j < rowPtr[(br + 1) * bs]; ++j) {
+            const int bc = colIdx[j] / bs;
+            if (mark[bc] != br) {
+                mark[bc] = br;
+                count++;
+            }
+        }
+        bRowPtr[br + 1] = bRowPtr[br] + count;
+    }
+    return bRowPtr[nbr];
+}
+
+// Block size whose BSR form moves the fewest bytes in a product, or 1 when
+// none of BSR_SIZES beats CSR
+template<typename T>
+int bsrBlockSize(const int *rowPtr, const int *colIdx, const int M, const int N)
+{
+    const dim_t nnz = rowPtr[M] - rowPtr[0];
+    dim_t bestBytes = nnz * (sizeof(T) + sizeof(int)) + (M + 1) * sizeof(int);
+    int best = 1;
+
+    std::vector<int> bRowPtr;
+    for (int bs : BSR_SIZES) {
+        if (M % bs != 0 || N % bs != 0) continue;
+        bRowPtr.resize(M / bs + 1);
+        const dim_t nnzb  = bsrRowPtr(bRowPtr.data(), rowPtr, colIdx, M, N, bs);
+        const dim_t bytes = nnzb * (bs * bs * sizeof(T) + sizeof(int))
+                          + (M / bs + 1) * sizeof(int);
+        if (bytes < bestBytes) {
+            bestBytes = bytes;
+            best = bs;
+        }
+    }
+    return best;
+}
+
+// Fills the block columns and the blocks of the BSR form of a CSR matrix
+// once bRowPtr is known
+template<typename T>
+void csrToBsr(T *bVal, int *bColIdx, const int *bRowPtr,
+              const T *val, const int *rowPtr, const int *colIdx,
+              const int M, const int N, const int bs)
+{
+    const int nbr = M / bs;
+    const int bs2 = bs * bs;
+    std::fill(bVal, bVal + (dim_t)bRowPtr[nbr] * bs2, T(0));
+
+    // Position of every block column in the current block row. Positions
+    // below bRowPtr[br] belong to earlier block rows.
+    std::vector<int> slot(N / bs, -1);
+    for (int br = 0; br < nbr; ++br) {
+        const int first = bRowPtr[br];
+        int next = first;
+        for (int j = rowPtr[br * bs]; j < rowPtr[(br + 1) * bs]; ++j) {
+            const int bc = colIdx[j] / bs;
+            if (slot[bc] < first) {
+                slot[bc] = next;
+                bColIdx[next++] = bc;
+            }
+        }
+        std::sort(bColIdx + first, bColIdx + next);
+        for (int k = first; k < next; ++k) slot[bColIdx[k]] = k;
+
+        for (int r = 0; r < bs; ++r) {
+            const int i = br * bs + r;
+            for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) {
+                const int c = colIdx[j];
+                bVal[(dim_t)slot[c / bs] * bs2 + r + (c % bs) * bs] = val[j];
+            }
+        }
+    }
+}
+
+// Writes the M + 1 row offsets of the CSR form of a BSR matrix. Zeros in the
+// blocks are not kept.
+template<typename T>
+int bsrToCsrRowPtr(int *rowPtr, const T *bVal, const int *bRowPtr,
+                   const int M, const int bs)
+{
+    const int bs2 = bs * bs;
+    rowPtr[0] = 0;
+    for (int i = 0; i < M; ++i) {
+        const int br = i / bs, r = i % bs;
+        int count = 0;
+        for (int k = bRowPtr[br]; k < bRowPtr[br + 1]; ++k) {
+            const T *b = bVal + (dim_t)k * bs2 + r;
+            for (int c = 0; c < bs; ++c) count += (b[c * bs] != T(0));
+        }
+        rowPtr[i + 1] = rowPtr[i] + count;
+    }
+    return rowPtr[M];
+}
+
+template<typename T>
+void bsrToCsr(T *val, int *colIdx, const int *rowPtr,
+              const T *bVal, const int *bRowPtr, const int *bColIdx,
+              const int M, const int bs)
+{
+    const int bs2 = bs * bs;
+    for (int i = 0; i < M; ++i) {
+        const int br = i / bs, r = i % bs;
+        int dst = rowPtr[i];
+        for (int k = bRowPtr[br]; k < bRowPtr[br + 1]; ++k) {
+            const T *b = bVal + (dim_t)k * bs2 + r;
+            for (int c = 0; c < bs; ++c) {
+                if (b[c * bs] == T(0)) continue;
+                val[dst]    = b[c * bs];
+                colIdx[dst] = bColIdx[k] * bs + c;
+                dst++;
+            }
+        }
+    }
+}
+
+// Sorts the rows of every SELL_SIGMA window by decreasing length into perm
+// and writes the nSlices + 1 slice offsets. Returns the number of stored
+// values including padding.
+static inline int sellLayout(int *sliceOff, int *perm, const int *rowPtr, const int M)
+{
+    std::iota(perm, perm + M, 0);
+    for (int w = 0; w < M; w += SELL_SIGMA) {
+        std::stable_sort(perm + w, perm + std::min(M, w + SELL_SIGMA),
+                         [&](int a, int b) {
+                             return rowPtr[a + 1] - rowPtr[a] > rowPtr[b + 1] - rowPtr[b];
+                         });
+    }
+
+    const int nSlices = sellSlices(M);
+    sliceOff[0] = 0;
+    for (int s = 0; s < nSlices; ++s) {
+        // The first row of a slice is its longest
+        const int i = perm[s * SELL_C];
+        sliceOff[s + 1] = sliceOff[s] + SELL_C * (rowPtr[i + 1] - rowPtr[i]);
+    }
+    return sliceOff[nSlices];
+}
+
+template<typename T>
+void csrToSell(T *sVal, int *sColIdx, const int *sliceOff, const int *perm,
+               const T *val, const int *rowPtr, const int *colIdx, const int M)
+{
+    std::fill(sVal, sVal + sliceOff[sellSlices(M)], T(0));
+    std::fill(sColIdx, sColIdx + sliceOff[sellSlices(M)], -1);
+    for (int p = 0; p < M; ++p) {
+        const int i = perm[p];
+        const int base = sliceOff[p / SELL_C] + p % SELL_C;
+        for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) {
+            const int k = j - rowPtr[i];
+            sVal   [base + k * SELL_C] = val[j];
+            sColIdx[base + k * SELL_C] = colIdx[j];
+        }
+    }
+}
+
+// Number of stored values of the row at position p of a SELL-C-sigma matrix
+static inline int sellRowLength(const int *sliceOff, const int *sColIdx, const int p)
+{
+    const int s = p / SELL_C;
+    const int *c = sColIdx + sliceOff[s] + p % SELL_C;
+    const int width = (sliceOff[s + 1] - sliceOff[s]) / SELL_C;
+    int k = 0;
+    while (k < width && c[k * SELL_C] >= 0) k++;
+    return k;
+}
+
+static inline int sellToCsrRowPtr(int *rowPtr, const int *sliceOff, const int *perm,
+                                  const int *sColIdx, const int M)
+{
+    rowPtr[0] = 0;
+    for (int p = 0; p < M; ++p) rowPtr[perm[p] + 1] = sellRowLength(sliceOff, sColIdx, p);
+    for (int i = 0; i < M; ++i) rowPtr[i + 1] += rowPtr[i];
+    return rowPtr[M];
+}
+
+template<typename T>
+void sellToCsr(T *val, int *colIdx, const int *rowPtr,
+               const T *sVal, const int *sColIdx, const int *sliceOff, const int *perm,
+               const int M)
+{
+    for (int p = 0; p < M; ++p) {
+        const int i = perm[p];
+        const int base = sliceOff[p / SELL_C] + p % SELL_C;
+        for (int j = rowPtr[i]; j < rowPtr[i + 1]; ++j) {
+            const int k = j - rowPtr[i];
+            val[j]    = sVal   [base + k * SELL_C];
+            colIdx[j] = sColIdx[base + k * SELL_C];
+        }
+    }
+}
+
+// out(i, k) = sum_j A(i, j) * right(j, k) for the block rows [brBegin, brEnd)
+// of a BSR matrix with BS x BS blocks and the NB columns starting at right
+// and out
+template<typename T, int BS, int NB>
+struct BsrmmRows
+{
+    static void run(T *out, const dim_t ldc,
+                    const T *val, const int *bRowPtr, const int *bColIdx,
+                    const T *right, const dim_t ldb,
+                    const int brBegin, const int brEnd)
+    {
+        for (int br = brBegin; br < brEnd; ++br) {
+            T acc[NB][BS];
+            for (int n = 0; n < NB; ++n)
+                for (int r = 0; r < BS; ++r) acc[n][r] = T(0);
+
+            for (int k = bRowPtr[br]; k < bRowPtr[br + 1]; ++k) {
+                const T *b = val + (dim_t)k * BS * BS;
+                const T *x = right + (dim_t)bColIdx[k] * BS;
+                for (int c = 0; c < BS; ++c) {
+                    for (int n = 0; n < NB; ++n) {
+                        const T xc = x[c + n * ldb];
+                        for (int r = 0; r < BS; ++r) acc[n][r] += b[r + c * BS] * xc;
+                    }
+                }
+            }
+
+            T *o = out + br * BS;
+            for (int n = 0; n < NB; ++n)
+                for (int r = 0; r < BS; ++r) o[r + n * ldc] = acc[n][r];
+        }
+    }
+};
+
+template<typename T, int BS>
+void bsrmmBlock(T *out, const dim_t ldc,
+                const T *val, const int *bRowPtr, const int *bColIdx,
+                const T *right, const dim_t ldb, const int N,
+                const int brBegin, const int brEnd)
+{
+    int n = 0;
+    for (; n + SPARSE_MM_COLUMNS <= N; n += SPARSE_MM_COLUMNS) {
+        BsrmmRows<T, BS, SPARSE_MM_COLUMNS>::run(out + n * ldc, ldc, val, bRowPtr, bColIdx,
+                                                 right + n * ldb, ldb, brBegin, brEnd);
+    }
+    for (; n < N; ++n) {
+        BsrmmRows<T, BS, 1>::run(out + n * ldc, ldc, val, bRowPtr, bColIdx,
+                                 right + n * ldb, ldb, brBegin, brEnd);
+    }
+}
+
+template<typename T, int BS>
+void bsrmm(T *out, const dim_t ldc,
+           const T *val, const int *bRowPtr, const int *bColIdx, const int nbr,
+           const T *right, const dim_t ldb, const int N)
+{
+    dim_t blockSize = 0;
+    const dim_t work = ((dim_t)bRowPtr[nbr] * BS * BS + nbr * BS) * N;
+    const dim_t nblocks = splitRange(blockSize, work, SPARSE_MIN_BLOCK);
+    const std::vector<int> bounds = csrRowBlocks(bRowPtr, nbr, nblocks);
+
+    parallelFor(nblocks, [&](dim_t b) {
+        bsrmmBlock<T, BS>(out, ldc, val, bRowPtr, bColIdx, right, ldb, N,
+                          bounds[b], bounds[b + 1]);
+    });
+}
+
+// out = A * right where A is an M x K BSR matrix with bs x bs blocks
+template<typename T>
+void bsrmm(T *out, const dim_t ldc,
+           const T *val, const int *bRowPtr, const int *bColIdx, const int M, const int bs,
+           const T *right, const dim_t ldb, const int N)
+{
+    const int nbr = M / bs;
+    switch (bs) {
+        case 1: bsrmm<T, 1>(out, ldc, val, bRowPtr, bColIdx, nbr, right, ldb, N); break;
+        case 2: bsrmm<T, 2>(out, ldc, val, bRowPtr, bColIdx, nbr, right, ldb, N); break;
+        case 3: bsrmm<T, 3>(out, ldc, val, bRowPtr, bColIdx, nbr, right, ldb, N); break;
+        case 4: bsrmm<T, 4>(out, ldc, val, bRowPtr, bColIdx, nbr, right, ldb, N); break;
+        case 6: bsrmm<T, 6>(out, ldc, val, bRowPtr, bColIdx, nbr, right, ldb, N); break;
+        case 8: bsrmm<T, 8>(out, ldc, val, bRowPtr, bColIdx, nbr, right, ldb, N); break;
+        default: AF_ERROR("Unsupported BSR block size", AF_ERR_NOT_SUPPORTED);
+    }
+}
+
+// out(i, k) = sum_j A(i, j) * right(j, k) for the slices [sBegin, sEnd) of a
+// SELL-C-sigma matrix and the NB columns starting at right and out
+template<typename T, int NB>
+struct SellmmSlices
+{
+    static void run(T *out, const dim_t ldc,
+                    const T *val, const int *sliceOff, const int *perm, const int *colIdx,
+                    const int M, const T *right, const dim_t ldb,
+                    const int sBegin, const int sEnd)
+    {
+        for (int s = sBegin; s < sEnd; ++s) {
+            const T   *v = val    + sliceOff[s];
+            const int *c = colIdx + sliceOff[s];
+            const int width = (sliceOff[s + 1] - sliceOff[s]) / SELL_C;
+
+            // The last row of a slice is its shortest, so every row has a
+            // value in the columns before its length
+            int full = 0, hi = width;
+            while (full < hi) {
+                const int mid = full + (hi - full) / 2;
+                if (c[mid * SELL_C + SELL_C - 1] >= 0) full = mid + 1;
+                else hi = mid;
+            }
+
+            T acc[NB][SELL_C];
+            for (int n = 0; n < NB; ++n)
+                for (int l = 0; l < SELL_C; ++l) acc[n][l] = T(0);
+
+            for (int k = 0; k < full; ++k) {
+                for (int n = 0; n < NB; ++n) {
+                    const T *x = right + n * ldb;
+                    for (int l = 0; l < SELL_C; ++l) {
+                        acc[n][l] += v[k * SELL_C + l] * x[c[k * SELL_C + l]];
+                    }
+                }
+            }
+            for (int k = full; k < width; ++k) {
+                for (int l = 0; l < SELL_C; ++l) {
+                    const int col = c[k * SELL_C + l];
+                    if (col < 0) continue;
+                    for (int n = 0; n < NB; ++n) {
+                        acc[n][l] += v[k * SELL_C + l] * right[col + n * ldb];
+                    }
+                }
+            }
+
+            const int rows = std::min(SELL_C, M - s * SELL_C);
+            for (int l = 0; l < rows; ++l) {
+                const int i = perm[s * SELL_C + l];
+                for (int n = 0; n < NB; ++n) out[i + n * ldc] = acc[n][l];
+            }
+        }
+    }
+};
+
+// out = A * right where A is an M x K SELL-C-sigma matrix
+template<typename T>
+void sellmm(T *out, const dim_t ldc,
+            const T *val, const int *sliceOff, const int *perm, const int *colIdx,
+            const int M, const T *right, const dim_t ldb, const int N)
+{
+    const int nSlices = sellSlices(M);
+
+    dim_t blockSize = 0;
+    const dim_t work = ((dim_t)sliceOff[nSlices] + M) * N;
+    const dim_t nblocks = splitRange(blockSize, work, SPARSE_MIN_BLOCK);
+    const std::vector<int> bounds = csrRowBlocks(sliceOff, nSlices, nblocks);
+
+    parallelFor(nblocks, [&](dim_t b) {
+        int n = 0;
+        for (; n + SPARSE_MM_COLUMNS <= N; n += SPARSE_MM_COLUMNS) {
+            SellmmSlices<T, SPARSE_MM_COLUMNS>::run(out + n * ldc, ldc, val, sliceOff, perm,
+                                                    colIdx, M, right + n * ldb, ldb,
+                                                    bounds[b], bounds[b + 1]);
+        }
+        for (; n < N; ++n) {
+            SellmmSlices<T, 1>::run(out + n * ldc, ldc, val, sliceOff, perm, colIdx, M,
+                                    right + n * ldb, ldb, bounds[b], bounds[b + 1]);
+        }
+    });
+}
+
+}
+}
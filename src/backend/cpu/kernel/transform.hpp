@@ -11,7 +11,8 @@
 #include <Array.hpp>
 #include <err_cpu.hpp>
 #include <type_traits>
-#include "interp.hpp"
+#include <vector>
+#include "warp.hpp"
 
 namespace cpu
 {
@@ -74,9 +75,6 @@ void transform(Array<T> output, const Array<T> input,
                const bool perspective,
                af_interp_type method)
 {
-    typedef typename dtype_traits<T>::base_type BT;
-    typedef wtype_t<BT> WT;
-
     const af::dim4 idims    = input.dims();
     const af::dim4 odims    = output.dims();
     const af::dim4 tdims    = transform.dims();
@@ -84,57 +82,29 @@ void transform(Array<T> output, const Array<T> input,
     const af::dim4 istrides = input.strides();
     const af::dim4 ostrides = output.strides();
 
-    T * out = output.get();
     const float* tf = transform.get();
 
     int batch_size = 1;
     if (idims[2] != tdims[2]) batch_size = idims[2];
 
-    Interp2<T, WT, order> interp;
+    std::vector<WarpImage> images;
     for (int idw = 0; idw < (int)odims[3]; idw++) {
         dim_t out_offw = idw * ostrides[3];
         dim_t in_offw = (idims[3] > 1) * idw * istrides[3];
         dim_t tf_offw = (tdims[3] > 1) * idw * tstrides[3];
 
         for (int idz = 0; idz < (int)odims[2]; idz += batch_size) {
-            dim_t out_offzw = out_offw + idz * ostrides[2];
-            dim_t in_offzw = in_offw + (idims[2] > 1) * idz * istrides[2];
+            WarpImage img;
+            img.ooff = out_offw + idz * ostrides[2];
+            img.ioff = in_offw + (idims[2] > 1) * idz * istrides[2];
             dim_t tf_offzw = tf_offw + (tdims[2] > 1) * idz * tstrides[2];
 
-            const float *tptr = tf + tf_offzw;
-
-            float tmat[9];
-            calc_transform_inverse(tmat, tptr, inverse, perspective, perspective ? 9 : 6);
-
-            for (int idy = 0; idy < (int)odims[1]; idy++) {
-                for (int idx = 0; idx < (int)odims[0]; idx++) {
-                    WT xidi = idx * tmat[0] + idy * tmat[1] + tmat[2];
-                    WT yidi = idx * tmat[3] + idy * tmat[4] + tmat[5];
-
-                    if (perspective) {
-                        WT W    = idx * tmat[6] + idy * tmat[7] + tmat[8];
-                        xidi /= W;
-                        yidi /= W;
-                    }
-
-                    // FIXME: Nearest and lower do not do clamping, but other methods do
-                    // Make it consistent
-                    bool clamp = order != 1;
-                    bool condX = xidi >= -0.0001 && xidi < idims[0];
-                    bool condY = yidi >= -0.0001 && yidi < idims[1];
-
-                    int ooff = out_offzw + idy * ostrides[1] + idx;
-                    if (condX && condY) {
-                        interp(output, ooff, input, in_offzw, xidi, yidi, method, batch_size, clamp);
-                    } else {
-                        for (int n = 0; n < batch_size; n++) {
-                            out[ooff + n * ostrides[2]] =  scalar<T>(0);
-                        }
-                    }
-                }
-            }
+            calc_transform_inverse(img.tmat, tf + tf_offzw, inverse, perspective, perspective ? 9 : 6);
+            images.push_back(img);
         }
     }
+
+    warp<T, order>(output, input, images, batch_size, perspective, false, method);
 }
 
 }
@@ -0,0 +1,269 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <Array.hpp>
+#include <dispatch.hpp>
+#include <math.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "interp.hpp"
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Side of the square output tiles of a warp. The pixels read by a tile stay
+// close together in the input whatever the rotation.
+static const dim_t WARP_TILE = 32;
+
+// Fixed point interpolation weights of the 8-bit paths
+static const int WARP_COEF_BITS = 11;
+static const int WARP_COEF_ONE  = 1 << WARP_COEF_BITS;
+
+// One image, or one batch of nimages images sharing a transform, of a warp.
+// tmat maps output coordinates to input coordinates.
+struct WarpImage
+{
+    dim_t ooff;
+    dim_t ioff;
+    float tmat[9];
+};
+
+static inline int warpCoef(float const w)
+{
+    return (int)std::floor(w * WARP_COEF_ONE + 0.5f);
+}
+
+// Truncates a value with 2 * WARP_COEF_BITS fractional bits, as the float
+// result is truncated by the other types and backends, and saturates it
+static inline uchar warpTruncate(long long const v)
+{
+    long long const r = v >> (2 * WARP_COEF_BITS);
+    return (uchar)std::min<long long>(255, std::max<long long>(0, r));
+}
+
+// Weights of the taps at -1, 0, 1 and 2 of cubicInterpFunc for every
+// fraction q / WARP_COEF_ONE, in fixed point. The weight of tap 0 makes them
+// add up to one exactly.
+struct WarpCubicTable
+{
+    int c[WARP_COEF_ONE + 1][4];
+
+    WarpCubicTable(bool const spline)
+    {
+        for (int q = 0; q <= WARP_COEF_ONE; q++) {
+            float const t = q / (float)WARP_COEF_ONE;
+            float const t2 = t * t, t3 = t2 * t;
+            float w[4];
+            if (spline) {
+                w[0] = -0.5f * t3 +        t2 - 0.5f * t;
+                w[2] = -1.5f * t3 + 2.0f * t2 + 0.5f * t;
+                w[3] =  0.5f * t3 - 0.5f * t2;
+            } else {
+                w[0] = -t3 + 2.0f * t2 - t;
+                w[2] = -t3 +        t2 + t;
+                w[3] =  t3 -        t2;
+            }
+            c[q][0] = warpCoef(w[0]);
+            c[q][2] = warpCoef(w[2]);
+            c[q][3] = warpCoef(w[3]);
+            c[q][1] = WARP_COEF_ONE - c[q][0] - c[q][2] - c[q][3];
+        }
+    }
+};
+
+// Input coordinates of output pixel (idx, idy)
+template<typename WT>
+static inline bool warpCoords(WT &xidi, WT &yidi, float const *tmat, int const idx, int const idy,
+                              bool const perspective, dim_t const idim0, dim_t const idim1)
+{
+    xidi = idx * tmat[0] + idy * tmat[1] + tmat[2];
+    yidi = idx * tmat[3] + idy * tmat[4] + tmat[5];
+
+    if (perspective) {
+        WT W = idx * tmat[6] + idy * tmat[7] + tmat[8];
+        xidi /= W;
+        yidi /= W;
+    }
+
+    bool condX = xidi >= -0.0001 && xidi < idim0;
+    bool condY = yidi >= -0.0001 && yidi < idim1;
+    return condX && condY;
+}
+
+// Warps the output pixels [x0, x1) x [y0, y1) of an image with Interp2.
+// Pixels mapped outside the input are set to zero, unless interpOutside is
+// set, in which case they are left to Interp2.
+template<typename T, int order>
+struct WarpTile
+{
+    void operator()(Array<T> &output, Array<T> const &input, WarpImage const &img,
+                    int const nimages, bool const perspective, bool const interpOutside,
+                    af_interp_type const method,
+                    int const x0, int const x1, int const y0, int const y1)
+    {
+        typedef typename dtype_traits<T>::base_type BT;
+        typedef wtype_t<BT> WT;
+
+        dim_t const d0  = input.dims()[0];
+        dim_t const d1  = input.dims()[1];
+        dim_t const os1 = output.strides()[1];
+        dim_t const os2 = output.strides()[2];
+        T *out = output.get();
+
+        // FIXME: Nearest and lower do not do clamping, but other methods do
+        // Make it consistent
+        bool const clamp = order != 1;
+
+        Interp2<T, WT, order> interp;
+        for (int idy = y0; idy < y1; idy++) {
+            for (int idx = x0; idx < x1; idx++) {
+                WT xidi, yidi;
+                bool const inside = warpCoords(xidi, yidi, img.tmat, idx, idy, perspective, d0, d1);
+
+                int ooff = img.ooff + idy * os1 + idx;
+                if (interpOutside || inside) {
+                    interp(output, ooff, input, img.ioff, xidi, yidi,
+                           method, nimages, clamp);
+                } else {
+                    for (int n = 0; n < nimages; n++) {
+                        out[ooff + n * os2] = scalar<T>(0);
+                    }
+                }
+            }
+        }
+    }
+};
+
+// 8-bit bilinear and bicubic warps in fixed point. They read the same taps
+// as Interp2, with edges replicated, and truncate the result.
+template<int order>
+struct WarpTileFixed
+{
+    void operator()(Array<uchar> &output, Array<uchar> const &input, WarpImage const &img,
+                    int const nimages, bool const perspective, bool const interpOutside,
+                    af_interp_type const method,
+                    int const x0, int const x1, int const y0, int const y1)
+    {
+        // dim4 accessors are not inlined, so the sizes are read once
+        dim_t const d0  = input.dims()[0];
+        dim_t const d1  = input.dims()[1];
+        dim_t const is0 = input.strides()[0];
+        dim_t const is1 = input.strides()[1];
+        dim_t const is2 = input.strides()[2];
+        dim_t const os1 = output.strides()[1];
+        dim_t const os2 = output.strides()[2];
+        uchar const *in = input.get();
+        uchar *out = output.get();
+
+        static WarpCubicTable const cubic(false);
+        static WarpCubicTable const spline(true);
+        WarpCubicTable const &tab = (method == AF_INTERP_CUBIC_SPLINE ||
+                                     method == AF_INTERP_BICUBIC_SPLINE ? spline : cubic);
+
+        for (int idy = y0; idy < y1; idy++) {
+            for (int idx = x0; idx < x1; idx++) {
+                float xidi, yidi;
+                bool const inside = warpCoords(xidi, yidi, img.tmat, idx, idy, perspective, d0, d1);
+
+                uchar *dst = out + img.ooff + idy * os1 + idx;
+                if (!inside) {
+                    for (int n = 0; n < nimages; n++) dst[n * os2] = 0;
+                    continue;
+                }
+
+                // Coordinates just below zero are taken as zero
+                int const gx = std::max(0, (int)std::floor(xidi));
+                int const gy = std::max(0, (int)std::floor(yidi));
+                float const fx = std::max(0.f, xidi - gx);
+                float const fy = std::max(0.f, yidi - gy);
+                uchar const *src = in + img.ioff + gy * is1 + gx * is0;
+
+                if (order == 2) {
+                    dim_t const ox = (xidi + 1 < d0 ? is0 : 0);
+                    dim_t const oy = (yidi + 1 < d1 ? is1 : 0);
+                    int const cx = warpCoef(fx), cy = warpCoef(fy);
+                    for (int n = 0; n < nimages; n++) {
+                        uchar const *p = src + n * is2;
+                        int const r0 = p[0]  * (WARP_COEF_ONE - cx) + p[ox]      * cx;
+                        int const r1 = p[oy] * (WARP_COEF_ONE - cx) + p[oy + ox] * cx;
+                        dst[n * os2] = warpTruncate((long long)r0 * (WARP_COEF_ONE - cy) +
+                                                         (long long)r1 * cy);
+                    }
+                } else {
+                    dim_t ox[4], oy[4];
+                    ox[0] = (gx - 1 >= 0 ? -1 : 0);
+                    ox[1] = 0;
+                    ox[2] = (gx + 1 < d0 ? 1 : 0);
+                    ox[3] = (gx + 2 < d0 ? 2 : ox[2]);
+                    oy[0] = (gy - 1 >= 0 ? -1 : 0);
+                    oy[1] = 0;
+                    oy[2] = (gy + 1 < d1 ? 1 : 0);
+                    oy[3] = (gy + 2 < d1 ? 2 : oy[2]);
+                    for (int k = 0; k < 4; k++) {
+                        ox[k] *= is0;
+                        oy[k] *= is1;
+                    }
+
+                    int const *cx = tab.c[warpCoef(fx)];
+                    int const *cy = tab.c[warpCoef(fy)];
+                    for (int n = 0; n < nimages; n++) {
+                        uchar const *p = src + n * is2;
+                        long long v = 0;
+                        for (int j = 0; j < 4; j++) {
+                            uchar const *row = p + oy[j];
+                            int const r = row[ox[0]] * cx[0] + row[ox[1]] * cx[1] +
+                                          row[ox[2]] * cx[2] + row[ox[3]] * cx[3];
+                            v += (long long)r * cy[j];
+                        }
+                        dst[n * os2] = warpTruncate(v);
+                    }
+                }
+            }
+        }
+    }
+};
+
+template<>
+struct WarpTile<uchar, 2> : WarpTileFixed<2> {};
+
+template<>
+struct WarpTile<uchar, 3> : WarpTileFixed<3> {};
+
+// Warps every image of images, spreading the output tiles of all of them
+// over the threads
+template<typename T, int order>
+void warp(Array<T> output, Array<T> const input, std::vector<WarpImage> const &images,
+          int const nimages, bool const perspective, bool const interpOutside,
+          af_interp_type const method)
+{
+    af::dim4 const odims = output.dims();
+    dim_t const nTilesX = divup(odims[0], WARP_TILE);
+    dim_t const nTilesY = divup(odims[1], WARP_TILE);
+    dim_t const nTiles  = nTilesX * nTilesY;
+
+    parallelFor((dim_t)images.size() * nTiles, [&](dim_t task) {
+        WarpImage const &img = images[task / nTiles];
+        dim_t const tile = task % nTiles;
+        dim_t const x0 = (tile % nTilesX) * WARP_TILE;
+        dim_t const y0 = (tile / nTilesX) * WARP_TILE;
+
+        WarpTile<T, order> op;
+        op(output, input, img, nimages, perspective, interpOutside, method,
+           (int)x0, (int)std::min(odims[0], x0 + WARP_TILE),
+           (int)y0, (int)std::min(odims[1], y0 + WARP_TILE));
+    });
+}
+
+}
+}
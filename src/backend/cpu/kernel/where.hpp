@@ -0,0 +1,112 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/dim4.hpp>
+#include <parallel.hpp>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace cpu
+{
+namespace kernel
+{
+
+// Lines are the runs of elements along dimension 0. Returns the offset of
+// the first element of line l.
+static inline dim_t lineOffset(dim_t l, const af::dim4 &dims, const af::dim4 &strides)
+{
+    const dim_t y = l % dims[1];
+    l /= dims[1];
+    const dim_t z = l % dims[2];
+    const dim_t w = l / dims[2];
+    return y * strides[1] + z * strides[2] + w * strides[3];
+}
+
+// Two pass parallel stream compaction.
+//
+// The elements of an array with the given dims and strides are split into
+// blocks of whole lines. The first pass counts the selected elements of
+// every block, the counts are scanned into output positions, and the second
+// pass writes the selected elements of every block starting at its position.
+//
+// keep(offset) decides whether the element at offset is selected.
+// alloc(count) is called once with the total number of selected elements.
+// emit(pos, idx) writes the selected element with linear index idx to
+// position pos of the output.
+template<typename Keep, typename Alloc, typename Emit>
+void compactElements(const af::dim4 &dims, const af::dim4 &strides,
+                     Keep keep, Alloc alloc, Emit emit)
+{
+    const dim_t nlines = dims[1] * dims[2] * dims[3];
+    const dim_t minLines = std::max<dim_t>(1, (1 << 15) / std::max<dim_t>(1, dims[0]));
+
+    dim_t blockSize = 0;
+    const dim_t nblocks = splitRange(blockSize, nlines, minLines);
+
+    std::vector<dim_t> positions(nblocks + 1, 0);
+
+    parallelFor(nblocks, [&](dim_t b) {
+        const dim_t lEnd = std::min(nlines, (b + 1) * blockSize);
+        dim_t count = 0;
+        for (dim_t l = b * blockSize; l < lEnd; ++l) {
+            const dim_t off = lineOffset(l, dims, strides);
+            for (dim_t x = 0; x < dims[0]; ++x) {
+                count += keep(off + x) ? 1 : 0;
+            }
+        }
+        positions[b + 1] = count;
+    });
+
+    std::partial_sum(positions.begin(), positions.end(), positions.begin());
+    alloc(positions[nblocks]);
+
+    parallelFor(nblocks, [&](dim_t b) {
+        const dim_t lEnd = std::min(nlines, (b + 1) * blockSize);
+        dim_t pos = positions[b];
+        for (dim_t l = b * blockSize; l < lEnd; ++l) {
+            const dim_t off = lineOffset(l, dims, strides);
+            const dim_t idx = l * dims[0];
+            for (dim_t x = 0; x < dims[0]; ++x) {
+                if (keep(off + x)) emit(pos++, idx + x);
+            }
+        }
+    });
+}
+
+// Copies the rows listed in rows from in to out. out has rows.size() rows
+// and the remaining dimensions of in.
+template<typename T>
+void gatherRows(T *out, const T *in, const af::dim4 &idims, const af::dim4 &istrides,
+                const std::vector<uint> &rows)
+{
+    const dim_t nrows  = rows.size();
+    const dim_t nlines = idims[1] * idims[2] * idims[3];
+
+    // Split the rows too so that tall arrays with few columns are
+    // spread over all threads
+    dim_t rowBlock = 0;
+    const dim_t nrowBlocks = splitRange(rowBlock, nrows, 1 << 14);
+
+    parallelFor(nlines * nrowBlocks, [&](dim_t task) {
+        const dim_t l = task / nrowBlocks;
+        const dim_t b = task % nrowBlocks;
+        const dim_t rEnd = std::min(nrows, (b + 1) * rowBlock);
+
+        const T *iptr = in + lineOffset(l, idims, istrides);
+        T *optr = out + l * nrows;
+        for (dim_t r = b * rowBlock; r < rEnd; ++r) {
+            optr[r] = iptr[rows[r]];
+        }
+    });
+}
+
+}
+}
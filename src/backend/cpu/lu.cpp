@@ -18,8 +18,10 @@
 #include <range.hpp>
 #include <lapack_helper.hpp>
 #include <math.hpp>
+#include <parallel.hpp>
 #include <platform.hpp>
 #include <queue.hpp>
+#include <kernel/lapack.hpp>
 #include <kernel/lu.hpp>
 
 namespace cpu
@@ -58,8 +60,8 @@ void lu(Array<T> &lower, Array<T> &upper, Array<int> &pivot, const Array<T> &in)
     pivot = lu_inplace(in_copy);
 
     // SPLIT into lower and upper
-    dim4 ldims(M, min(M, N));
-    dim4 udims(min(M, N), N);
+    dim4 ldims(M, min(M, N), iDims[2], iDims[3]);
+    dim4 udims(min(M, N), N, iDims[2], iDims[3]);
     lower = createEmptyArray<T>(ldims);
     upper = createEmptyArray<T>(udims);
 
@@ -72,16 +74,27 @@ Array<int> lu_inplace(Array<T> &in, const bool convert_pivot)
     in.eval();
 
     dim4 iDims = in.dims();
-    Array<int> pivot = createEmptyArray<int>(af::dim4(min(iDims[0], iDims[1]), 1, 1, 1));
+    int M = iDims[0];
+    int N = iDims[1];
+    Array<int> pivot = createEmptyArray<int>(af::dim4(min(M, N), 1, iDims[2], iDims[3]));
 
     auto func = [=] (Array<T> in, Array<int> pivot) {
-        dim4 iDims = in.dims();
-        getrf_func<T>()(AF_LAPACK_COL_MAJOR, iDims[0], iDims[1], in.get(), in.strides()[1], pivot.get());
+        const int K = min(M, N);
+        const dim4 iStrides = in.strides();
+        forEachMatrix(iDims[2] * iDims[3], (dim_t)M * N * K, [&](dim_t b) {
+            T *A = in.get() + kernel::matrixOffset(iDims, iStrides, b);
+            int *ipiv = pivot.get() + b * K;
+            if (M <= kernel::LAPACK_SMALL_DIM && N <= kernel::LAPACK_SMALL_DIM) {
+                kernel::getrfSmall(A, M, N, iStrides[1], ipiv);
+            } else {
+                getrf_func<T>()(AF_LAPACK_COL_MAJOR, M, N, A, iStrides[1], ipiv);
+            }
+        });
     };
     getQueue().enqueue(func, in, pivot);
 
     if(convert_pivot) {
-        Array<int> p = range<int>(dim4(iDims[0]), 0);
+        Array<int> p = range<int>(dim4(M, 1, iDims[2], iDims[3]), 0);
         getQueue().enqueue(kernel::convertPivot, p, pivot);
         return p;
     } else {
@@ -125,6 +138,11 @@ bool isLAPACKAvailable()
 namespace cpu
 {
 
+bool isLAPACKBatchAvailable()
+{
+    return true;
+}
+
 #define INSTANTIATE_LU(T)                                                                           \
     template Array<int> lu_inplace<T>(Array<T> &in, const bool convert_pivot);                      \
     template void lu<T>(Array<T> &lower, Array<T> &upper, Array<int> &pivot, const Array<T> &in);
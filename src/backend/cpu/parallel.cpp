@@ -0,0 +1,173 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <parallel.hpp>
+#include <util.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cpu
+{
+
+namespace
+{
+
+// Set on pool threads and while a thread is driving a parallelFor so that
+// nested calls do not wait on the pool they are running on
+thread_local bool insideParallelRegion = false;
+
+class ThreadPool
+{
+    std::vector<std::thread> workers;
+
+    std::mutex               mtx;
+    std::condition_variable  start;
+    std::condition_variable  done;
+
+    // Serializes callers; only one job is in flight at a time
+    std::mutex               callMtx;
+
+    const std::function<void(dim_t)> *job;
+    dim_t                    jobCount;
+    std::atomic<dim_t>       next;
+    int                      pending;
+    unsigned                 generation;
+    bool                     stop;
+    std::exception_ptr       error;
+
+    void run()
+    {
+        dim_t i;
+        while ((i = next++) < jobCount) {
+            try {
+                (*job)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!error) error = std::current_exception();
+                // Skip the remaining work
+                next = jobCount;
+            }
+        }
+    }
+
+    void workerLoop()
+    {
+        insideParallelRegion = true;
+        unsigned seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                start.wait(lock, [&] { return stop || generation != seen; });
+                if (stop) return;
+                seen = generation;
+            }
+
+            run();
+
+            std::lock_guard<std::mutex> lock(mtx);
+            if (--pending == 0) done.notify_one();
+        }
+    }
+
+public:
+    explicit ThreadPool(int nthreads)
+        : job(nullptr), jobCount(0), next(0), pending(0),
+          generation(0), stop(false)
+    {
+        // The calling thread is one of the nthreads
+        for (int i = 1; i < nthreads; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        start.notify_all();
+        for (auto &w : workers) w.join();
+    }
+
+    int size() const
+    {
+        return (int)workers.size() + 1;
+    }
+
+    // Returns false if the pool is busy with another caller
+    bool tryExecute(const dim_t count, const std::function<void(dim_t)> &fn)
+    {
+        std::unique_lock<std::mutex> call(callMtx, std::try_to_lock);
+        if (!call.owns_lock()) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job      = &fn;
+            jobCount = count;
+            next     = 0;
+            pending  = (int)workers.size();
+            error    = nullptr;
+            ++generation;
+        }
+        start.notify_all();
+
+        insideParallelRegion = true;
+        run();
+        insideParallelRegion = false;
+
+        std::exception_ptr err;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            done.wait(lock, [&] { return pending == 0; });
+            job = nullptr;
+            std::swap(err, error);
+        }
+        if (err) std::rethrow_exception(err);
+        return true;
+    }
+};
+
+int readNumThreads()
+{
+    std::string env = getEnvVar("AF_CPU_NUM_THREADS");
+    int n = env.empty() ? 0 : std::atoi(env.c_str());
+    if (n <= 0) n = (int)std::thread::hardware_concurrency();
+    return std::max(n, 1);
+}
+
+ThreadPool &getPool()
+{
+    static ThreadPool pool(readNumThreads());
+    return pool;
+}
+
+}
+
+int getNumThreads()
+{
+    return getPool().size();
+}
+
+void parallelFor(const dim_t count, const std::function<void(dim_t)> &fn)
+{
+    if (count <= 0) return;
+
+    if (count == 1 || insideParallelRegion || getNumThreads() == 1 ||
+        !getPool().tryExecute(count, fn)) {
+        for (dim_t i = 0; i < count; ++i) fn(i);
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#pragma once
+#include <af/defines.h>
+#include <algorithm>
+#include <functional>
+
+namespace cpu
+{
+
+// Number of threads used by parallelFor. Defaults to the number of
+// hardware threads and can be overridden with AF_CPU_NUM_THREADS.
+int getNumThreads();
+
+// Calls fn(i) for every i in [0, count) using the backend thread pool and
+// returns once all calls have finished. The calling thread takes part in
+// the work. Calls made from within fn run serially on the calling thread.
+// The first exception thrown by fn is rethrown to the caller.
+void parallelFor(const dim_t count, const std::function<void(dim_t)> &fn);
+
+// Splits [0, n) into roughly equal ranges of at least minBlock elements.
+// The result is the number of blocks; block b covers
+// [b * blockSize, min(n, (b + 1) * blockSize)).
+static inline dim_t splitRange(dim_t &blockSize, const dim_t n, const dim_t minBlock)
+{
+    const dim_t maxBlocks = 4 * getNumThreads();
+    blockSize = std::max(minBlock, (n + maxBlocks - 1) / maxBlocks);
+    return std::max<dim_t>(1, (n + blockSize - 1) / blockSize);
+}
+
+// Batches of matrices with at most this many operations each are spread over
+// the threads one matrix at a time. Larger matrices are processed one after
+// the other and left to the threading of the BLAS and LAPACK libraries.
+static const dim_t BATCH_PARALLEL_WORK = 128 * 128 * 128;
+
+// Calls fn(b) for every matrix b of a batch of nbatch matrices with work
+// operations each
+template<typename Fn>
+void forEachMatrix(const dim_t nbatch, const dim_t work, Fn fn)
+{
+    if (work > BATCH_PARALLEL_WORK) {
+        for (dim_t b = 0; b < nbatch; ++b) fn(b);
+        return;
+    }
+    dim_t blockSize = 0;
+    const dim_t nblocks = splitRange(blockSize, nbatch,
+                                     std::max<dim_t>(1, (1 << 16) / std::max<dim_t>(1, work)));
+    parallelFor(nblocks, [&](dim_t blk) {
+        const dim_t end = std::min(nbatch, (blk + 1) * blockSize);
+        for (dim_t b = blk * blockSize; b < end; ++b) fn(b);
+    });
+}
+
+}
@@ -0,0 +1,62 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/dim4.hpp>
+#include <Array.hpp>
+#include <pyramid.hpp>
+#include <kernel/pyramid.hpp>
+#include <platform.hpp>
+#include <queue.hpp>
+
+using af::dim4;
+
+namespace cpu
+{
+
+template<typename T>
+std::vector<Array<T> > pyramid(const Array<T> &in, const unsigned levels, const bool laplacian)
+{
+    in.eval();
+
+    // Each level is half the size of the one before it, rounded up
+    std::vector<dim4> dims(levels, in.dims());
+    dim_t total = dims[0].elements();
+    for (unsigned l = 1; l < levels; l++) {
+        dims[l][0] = (dims[l - 1][0] + 1) / 2;
+        dims[l][1] = (dims[l - 1][1] + 1) / 2;
+        total += dims[l].elements();
+    }
+
+    Array<T> packed = createEmptyArray<T>(dim4(total));
+
+    std::vector<Array<T> > out;
+    dim_t offset = 0;
+    for (unsigned l = 0; l < levels; l++) {
+        std::vector<af_seq> index(4, af_span);
+        index[0].begin = offset;
+        index[0].end   = offset + dims[l].elements() - 1;
+        index[0].step  = 1;
+
+        Array<T> level = createSubArray<T>(packed, index, false);
+        level.modDims(dims[l]);
+        out.push_back(level);
+        offset += dims[l].elements();
+    }
+
+    getQueue().enqueue(kernel::pyramid<T>, out, in, laplacian);
+    return out;
+}
+
+#define INSTANTIATE(T)\
+template std::vector<Array<T> > pyramid<T>(const Array<T> &in, const unsigned levels, const bool laplacian);
+
+INSTANTIATE(float )
+INSTANTIATE(double)
+
+}
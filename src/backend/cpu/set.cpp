@@ -18,6 +18,7 @@
 #include <vector>
 #include <platform.hpp>
 #include <queue.hpp>
+#include <kernel/set.hpp>
 
 namespace cpu
 {
@@ -25,15 +26,94 @@ namespace cpu
 using namespace std;
 using af::dim4;
 
+// The set kernels work on raw pointers, so sub arrays have to be made
+// contiguous before they can be used
+template<typename T>
+static Array<T> linearArray(const Array<T> &in)
+{
+    in.eval();
+    return in.isLinear() ? in : copyArray<T>(in);
+}
+
+template<typename T>
+Array<T> setUniqueStable(const Array<T> &in)
+{
+    Array<T> lin = linearArray<T>(in);
+    Array<T> out = createEmptyArray<T>(dim4(lin.elements()));
+
+    getQueue().sync();
+
+    dim_t count = kernel::uniqueStable<T>(out.get(), lin.get(), lin.elements());
+
+    out.resetDims(dim4(count));
+    return out;
+}
+
+template<typename T>
+Array<T> setUnionStable(const Array<T> &first,
+                        const Array<T> &second)
+{
+    Array<T> lFirst  = linearArray<T>(first);
+    Array<T> lSecond = linearArray<T>(second);
+    Array<T> out = createEmptyArray<T>(dim4(lFirst.elements() + lSecond.elements()));
+
+    getQueue().sync();
+
+    dim_t count = kernel::unionStable<T>(out.get(),
+                                         lFirst.get() , lFirst.elements(),
+                                         lSecond.get(), lSecond.elements());
+
+    out.resetDims(dim4(count));
+    return out;
+}
+
+template<typename T>
+Array<T> setIntersectStable(const Array<T> &first,
+                            const Array<T> &second)
+{
+    Array<T> lFirst  = linearArray<T>(first);
+    Array<T> lSecond = linearArray<T>(second);
+    Array<T> out = createEmptyArray<T>(dim4(lFirst.elements()));
+
+    getQueue().sync();
+
+    dim_t count = kernel::intersectStable<T>(out.get(),
+                                             lFirst.get() , lFirst.elements(),
+                                             lSecond.get(), lSecond.elements());
+
+    out.resetDims(dim4(count));
+    return out;
+}
+
+template<typename T>
+Array<char> setContains(const Array<T> &elements,
+                        const Array<T> &set)
+{
+    Array<T> lElements = linearArray<T>(elements);
+    Array<T> lSet      = linearArray<T>(set);
+    Array<char> out = createEmptyArray<char>(elements.dims());
+
+    getQueue().enqueue(kernel::contains<T>, out, lElements, lSet);
+
+    return out;
+}
+
 template<typename T>
 Array<T> setUnique(const Array<T> &in,
                     const bool is_sorted)
 {
     in.eval();
 
-    Array<T> out = createEmptyArray<T>(af::dim4());
-    if (is_sorted) out = copyArray<T>(in);
-    else           out = sort<T>(in, 0, true);
+    if (!is_sorted) {
+        // Deduplicate through a hash table first so that only the distinct
+        // values have to be sorted
+        Array<T> out = setUniqueStable<T>(in);
+        T *ptr = out.get();
+        std::sort(ptr, ptr + out.elements());
+        return out;
+    }
+
+    Array<T> out = copyArray<T>(in);
 
     // Need to sync old jobs since we need to
     // operator on pointers directly in std::unique
@@ -53,19 +133,17 @@ Array<T> setUnion(const Array<T> &first,
                    const Array<T> &second,
                    const bool is_unique)
 {
-    first.eval();
-    second.eval();
-    getQueue().sync();
-
-    Array<T> uFirst = first;
-    Array<T> uSecond = second;
-
     if (!is_unique) {
-        // FIXME: Perhaps copy + unique would do ?
-        uFirst  = setUnique(first, false);
-        uSecond = setUnique(second, false);
+        Array<T> out = setUnionStable<T>(first, second);
+        T *ptr = out.get();
+        std::sort(ptr, ptr + out.elements());
+        return out;
     }
 
+    Array<T> uFirst  = linearArray<T>(first);
+    Array<T> uSecond = linearArray<T>(second);
+    getQueue().sync();
+
     dim_t first_elements  = uFirst.elements();
     dim_t second_elements = uSecond.elements();
     dim_t elements = first_elements + second_elements;
@@ -89,18 +167,17 @@ Array<T> setIntersect(const Array<T> &first,
                       const Array<T> &second,
                       const bool is_unique)
 {
-    first.eval();
-    second.eval();
-    getQueue().sync();
-
-    Array<T> uFirst = first;
-    Array<T> uSecond = second;
-
     if (!is_unique) {
-        uFirst  = setUnique(first, false);
-        uSecond = setUnique(second, false);
+        Array<T> out = setIntersectStable<T>(first, second);
+        T *ptr = out.get();
+        std::sort(ptr, ptr + out.elements());
+        return out;
     }
 
+    Array<T> uFirst  = linearArray<T>(first);
+    Array<T> uSecond = linearArray<T>(second);
+    getQueue().sync();
+
     dim_t first_elements  = uFirst.elements();
     dim_t second_elements = uSecond.elements();
     dim_t elements = std::max(first_elements, second_elements);
@@ -123,6 +200,10 @@ Array<T> setIntersect(const Array<T> &first,
     template Array<T> setUnique<T>(const Array<T> &in, const bool is_sorted); \
     template Array<T> setUnion<T>(const Array<T> &first, const Array<T> &second, const bool is_unique); \
     template Array<T> setIntersect<T>(const Array<T> &first, const Array<T> &second, const bool is_unique); \
+    template Array<T> setUniqueStable<T>(const Array<T> &in);           \
+    template Array<T> setUnionStable<T>(const Array<T> &first, const Array<T> &second); \
+    template Array<T> setIntersectStable<T>(const Array<T> &first, const Array<T> &second); \
+    template Array<char> setContains<T>(const Array<T> &elements, const Array<T> &set); \
 
 INSTANTIATE(float)
 INSTANTIATE(double)
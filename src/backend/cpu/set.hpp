@@ -21,4 +21,15 @@ namespace cpu
     template<typename T> Array<T> setIntersect(const Array<T> &first,
                                                const Array<T> &second,
                                                const bool is_unique);
+
+    template<typename T> Array<T> setUniqueStable(const Array<T> &in);
+
+    template<typename T> Array<T> setUnionStable(const Array<T> &first,
+                                                 const Array<T> &second);
+
+    template<typename T> Array<T> setIntersectStable(const Array<T> &first,
+                                                     const Array<T> &second);
+
+    template<typename T> Array<char> setContains(const Array<T> &elements,
+                                                 const Array<T> &set);
 }
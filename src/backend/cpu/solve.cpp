@@ -17,8 +17,10 @@
 #include <err_cpu.hpp>
 #include <lapack_helper.hpp>
 #include <math.hpp>
+#include <parallel.hpp>
 #include <platform.hpp>
 #include <queue.hpp>
+#include <kernel/lapack.hpp>
 
 namespace cpu
 {
@@ -85,9 +87,21 @@ Array<T> solveLU(const Array<T> &A, const Array<int> &pivot,
     Array< T > B = copyArray<T>(b);
 
     auto func = [=] (Array<T> A, Array<T> B, Array<int> pivot, int N, int NRHS) {
-        getrs_func<T>()(AF_LAPACK_COL_MAJOR, 'N',
-                        N, NRHS, A.get(), A.strides()[1],
-                        pivot.get(), B.get(), B.strides()[1]);
+        const dim4 aDims    = A.dims();
+        const dim4 aStrides = A.strides();
+        const dim4 bStrides = B.strides();
+        forEachMatrix(aDims[2] * aDims[3], (dim_t)N * N * NRHS, [&](dim_t b) {
+            const T *a = A.get() + kernel::matrixOffset(aDims, aStrides, b);
+            T *x = B.get() + kernel::matrixOffset(aDims, bStrides, b);
+            const int *ipiv = pivot.get() + kernel::matrixOffset(aDims, pivot.strides(), b);
+            if (N <= kernel::LAPACK_SMALL_DIM) {
+                kernel::getrsSmall(a, N, aStrides[1], ipiv, x, NRHS, bStrides[1]);
+            } else {
+                getrs_func<T>()(AF_LAPACK_COL_MAJOR, 'N',
+                                N, NRHS, a, aStrides[1],
+                                ipiv, x, bStrides[1]);
+            }
+        });
     };
     getQueue().enqueue(func, A, B, pivot, N, NRHS);
 
@@ -105,13 +119,27 @@ Array<T> triangleSolve(const Array<T> &A, const Array<T> &b, const af_mat_prop o
     int NRHS   = B.dims()[1];
 
     auto func = [=] (Array<T> A, Array<T> B, int N, int NRHS, const af_mat_prop options) {
-        trtrs_func<T>()(AF_LAPACK_COL_MAJOR,
-                        options & AF_MAT_UPPER ? 'U' : 'L',
-                        'N', // transpose flag
-                        options & AF_MAT_DIAG_UNIT ? 'U' : 'N',
-                        N, NRHS,
-                        A.get(), A.strides()[1],
-                        B.get(), B.strides()[1]);
+        const bool is_upper     = options & AF_MAT_UPPER;
+        const bool is_unit_diag = options & AF_MAT_DIAG_UNIT;
+        const dim4 aDims    = A.dims();
+        const dim4 aStrides = A.strides();
+        const dim4 bStrides = B.strides();
+        forEachMatrix(aDims[2] * aDims[3], (dim_t)N * N * NRHS / 2, [&](dim_t b) {
+            const T *a = A.get() + kernel::matrixOffset(aDims, aStrides, b);
+            T *x = B.get() + kernel::matrixOffset(aDims, bStrides, b);
+            if (N <= kernel::LAPACK_SMALL_DIM) {
+                kernel::trtrsSmall(a, N, aStrides[1], is_upper, is_unit_diag,
+                                   x, NRHS, bStrides[1]);
+            } else {
+                trtrs_func<T>()(AF_LAPACK_COL_MAJOR,
+                                is_upper ? 'U' : 'L',
+                                'N', // transpose flag
+                                is_unit_diag ? 'U' : 'N',
+                                N, NRHS,
+                                a, aStrides[1],
+                                x, bStrides[1]);
+            }
+        });
     };
     getQueue().enqueue(func, A, B, N, NRHS, options);
 
@@ -129,32 +157,47 @@ Array<T> solve(const Array<T> &a, const Array<T> &b, const af_mat_prop options)
         return triangleSolve<T>(a, b, options);
     }
 
-    int M = a.dims()[0];
-    int N = a.dims()[1];
+    dim4 aDims = a.dims();
+    int M = aDims[0];
+    int N = aDims[1];
     int K = b.dims()[1];
 
     Array<T> A = copyArray<T>(a);
-    Array<T> B = padArray<T, T>(b, dim4(max(M, N), K));
+    Array<T> B = padArray<T, T>(b, dim4(max(M, N), K, aDims[2], aDims[3]));
 
     if(M == N) {
-        Array<int> pivot = createEmptyArray<int>(dim4(N, 1, 1));
+        Array<int> pivot = createEmptyArray<int>(dim4(N, 1, aDims[2], aDims[3]));
 
         auto func = [=] (Array<T> A, Array<T> B, Array<int> pivot, int N, int K) {
-            gesv_func<T>()(AF_LAPACK_COL_MAJOR, N, K, A.get(), A.strides()[1],
-                           pivot.get(), B.get(), B.strides()[1]);
+            const dim4 aStrides = A.strides();
+            const dim4 bStrides = B.strides();
+            forEachMatrix(aDims[2] * aDims[3], (dim_t)N * N * (N / 3 + K), [&](dim_t b) {
+                T *a = A.get() + kernel::matrixOffset(aDims, aStrides, b);
+                T *x = B.get() + kernel::matrixOffset(aDims, bStrides, b);
+                int *ipiv = pivot.get() + b * N;
+                if (N <= kernel::LAPACK_SMALL_DIM) {
+                    if (kernel::getrfSmall(a, N, N, aStrides[1], ipiv) == 0) {
+                        kernel::getrsSmall(a, N, aStrides[1], ipiv, x, K, bStrides[1]);
+                    }
+                } else {
+                    gesv_func<T>()(AF_LAPACK_COL_MAJOR, N, K, a, aStrides[1],
+                                   ipiv, x, bStrides[1]);
+                }
+            });
         };
         getQueue().enqueue(func, A, B, pivot, N, K);
     } else {
         auto func = [=] (Array<T> A, Array<T> B, int M, int N, int K) {
-            int sM = A.strides()[1];
-            int sN = A.strides()[2] / sM;
-
-            gels_func<T>()(AF_LAPACK_COL_MAJOR, 'N',
-                    M, N, K,
-                    A.get(), A.strides()[1],
-                    B.get(), max(sM, sN));
+            const dim4 aStrides = A.strides();
+            const dim4 bStrides = B.strides();
+            forEachMatrix(aDims[2] * aDims[3], (dim_t)M * N * max(M, N), [&](dim_t b) {
+                gels_func<T>()(AF_LAPACK_COL_MAJOR, 'N',
+                        M, N, K,
+                        A.get() + kernel::matrixOffset(aDims, aStrides, b), aStrides[1],
+                        B.get() + kernel::matrixOffset(aDims, bStrides, b), bStrides[1]);
+            });
         };
-        B.resetDims(dim4(N, K));
+        B.resetDims(dim4(N, K, aDims[2], aDims[3]));
         getQueue().enqueue(func, A, B, M, N, K);
     }
 
@@ -0,0 +1,106 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <solve_iterative.hpp>
+
+#include <af/dim4.hpp>
+#include <copy.hpp>
+#include <err_common.hpp>
+#include <platform.hpp>
+#include <queue.hpp>
+#include <kernel/solve_iterative.hpp>
+
+namespace cpu
+{
+
+using namespace common;
+
+// Runs the whole solve as one task of the queue, so there is no round trip
+// to the caller between iterations
+template<typename T, typename Op, typename MakeOp>
+static Array<T> krylovSolve(MakeOp makeOp, const Array<T> &b_,
+                            const af_iterative_method method, const af_preconditioner precond,
+                            const double tol, const unsigned maxIter, const unsigned restart,
+                            unsigned &iterations, double &residual)
+{
+    const Array<T> b = b_.isLinear() ? b_ : copyArray<T>(b_);
+    b.eval();
+
+    Array<T> x = createEmptyArray<T>(b.dims());
+    x.eval();
+
+    bool valid = true;
+    auto func = [&] () {
+        const Op A = makeOp();
+        valid = kernel::krylovSolve(x.get(), b.get(), b.strides()[1], b.dims()[1], A,
+                                    method, precond, tol, maxIter, restart,
+                                    iterations, residual);
+    };
+    getQueue().enqueue(func);
+    getQueue().sync();
+
+    if (!valid) {
+        AF_ERROR("ILU(0) needs a non zero pivot on every row of the matrix", AF_ERR_ARG);
+    }
+
+    return x;
+}
+
+template<typename T>
+Array<T> solveIterative(const Array<T> &a, const Array<T> &b,
+                        const af_iterative_method method, const af_preconditioner precond,
+                        const double tol, const unsigned maxIter, const unsigned restart,
+                        unsigned &iterations, double &residual)
+{
+    a.eval();
+
+    auto makeOp = [&] () {
+        return kernel::DenseOperator<T>(a.get(), a.strides()[1], a.dims()[0]);
+    };
+    return krylovSolve<T, kernel::DenseOperator<T>>(makeOp, b, method, precond, tol,
+                                                    maxIter, restart, iterations, residual);
+}
+
+template<typename T>
+Array<T> solveIterative(const SparseArray<T> &a, const Array<T> &b,
+                        const af_iterative_method method, const af_preconditioner precond,
+                        const double tol, const unsigned maxIter, const unsigned restart,
+                        unsigned &iterations, double &residual)
+{
+    a.eval();
+
+    auto makeOp = [&] () {
+        return kernel::CsrOperator<T>(a.getValues().get(), a.getRowIdx().get(),
+                                      a.getColIdx().get(), a.dims()[0]);
+    };
+    return krylovSolve<T, kernel::CsrOperator<T>>(makeOp, b, method, precond, tol,
+                                                  maxIter, restart, iterations, residual);
+}
+
+#define INSTANTIATE_SOLVE_ITERATIVE(T, A)                                                           \
+    template Array<T> solveIterative<T>(const A &a, const Array<T> &b,                              \
+                                        const af_iterative_method method,                           \
+                                        const af_preconditioner precond,                            \
+                                        const double tol, const unsigned maxIter,                   \
+                                        const unsigned restart,                                     \
+                                        unsigned &iterations, double &residual);                    \
+
+#define INSTANTIATE(T)                                  \
+    INSTANTIATE_SOLVE_ITERATIVE(T, Array<T>)            \
+    INSTANTIATE_SOLVE_ITERATIVE(T, SparseArray<T>)      \
+
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(cfloat)
+INSTANTIATE(cdouble)
+
+#undef INSTANTIATE
+#undef INSTANTIATE_SOLVE_ITERATIVE
+
+}
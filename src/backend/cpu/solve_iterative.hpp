@@ -0,0 +1,32 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <Array.hpp>
+#include <SparseArray.hpp>
+
+namespace cpu
+{
+
+// Solves a x = b for every column of b with a Krylov method starting from
+// x = 0. iterations and residual are the largest number of iterations and
+// relative residual ||b - a x|| / ||b|| over the columns of b.
+template<typename T>
+Array<T> solveIterative(const Array<T> &a, const Array<T> &b,
+                        const af_iterative_method method, const af_preconditioner precond,
+                        const double tol, const unsigned maxIter, const unsigned restart,
+                        unsigned &iterations, double &residual);
+
+// Same as above for a matrix in CSR format
+template<typename T>
+Array<T> solveIterative(const common::SparseArray<T> &a, const Array<T> &b,
+                        const af_iterative_method method, const af_preconditioner precond,
+                        const double tol, const unsigned maxIter, const unsigned restart,
+                        unsigned &iterations, double &residual);
+
+}
@@ -9,6 +9,7 @@
 
 #include <sparse.hpp>
 #include <kernel/sparse.hpp>
+#include <kernel/sparse_blocked.hpp>
 
 #include <stdexcept>
 #include <string>
@@ -25,99 +26,13 @@
 #include <reduce.hpp>
 #include <where.hpp>
 
+#include <vector>
+
 namespace cpu
 {
 
 using namespace common;
 
-using std::add_const;
-using std::add_pointer;
-using std::enable_if;
-using std::is_floating_point;
-using std::remove_const;
-using std::conditional;
-using std::is_same;
-
-template<typename T, class Enable = void>
-struct blas_base {
-    using type = T;
-};
-
-template<typename T>
-struct blas_base <T, typename enable_if<is_complex<T>::value>::type> {
-    using type = typename conditional<is_same<T, cdouble>::value,
-                                      sp_cdouble, sp_cfloat>
-                                     ::type;
-};
-
-template<typename T>
-using cptr_type     =   typename conditional<   is_complex<T>::value,
-                                                const typename blas_base<T>::type *,
-                                                const T*>::type;
-template<typename T>
-using ptr_type     =    typename conditional<   is_complex<T>::value,
-                                                typename blas_base<T>::type *,
-                                                T*>::type;
-template<typename T>
-using scale_type   =    typename conditional<   is_complex<T>::value,
-                                                const typename blas_base<T>::type *,
-                                                const T *>::type;
-
-#ifdef USE_MKL
-
-// void mkl_zdnscsr (const MKL_INT *job ,
-//                   const MKL_INT *m , const MKL_INT *n ,
-//                   MKL_Complex16 *adns , const MKL_INT *lda ,
-//                   MKL_Complex16 *acsr ,
-//                   MKL_INT *ja , MKL_INT *ia ,
-//                   MKL_INT *info );
-template<typename T>
-using dnscsr_func_def = void (*)(const int *,
-                                 const int *, const int *,
-                                 ptr_type<T>, const int *,
-                                 ptr_type<T>,
-                                 int *, int *,
-                                 int *);
-
-//void mkl_zcsrcsc (const MKL_INT *job ,
-//                  const MKL_INT *n ,
-//                  MKL_Complex16 *acsr ,
-//                  MKL_INT *ja , MKL_INT *ia ,
-//                  MKL_Complex16 *acsc ,
-//                  MKL_INT *ja1 , MKL_INT *ia1 ,
-//                  MKL_INT *info );
-template<typename T>
-using csrcsc_func_def = void (*)(const int *,
-                                 const int *,
-                                 ptr_type<T>, int *, int *,
-                                 ptr_type<T>,
-                                 int *, int *,
-                                 int *);
-
-#define SPARSE_FUNC_DEF( FUNC )                         \
-template<typename T> FUNC##_func_def<T> FUNC##_func();
-
-#define SPARSE_FUNC( FUNC, TYPE, PREFIX )               \
-  template<> FUNC##_func_def<TYPE> FUNC##_func<TYPE>()  \
-{ return &mkl_##PREFIX##FUNC; }
-
-SPARSE_FUNC_DEF(dnscsr)
-SPARSE_FUNC(dnscsr, float,  s)
-SPARSE_FUNC(dnscsr, double, d)
-SPARSE_FUNC(dnscsr, cfloat, c)
-SPARSE_FUNC(dnscsr, cdouble,z)
-
-SPARSE_FUNC_DEF(csrcsc)
-SPARSE_FUNC(csrcsc, float,  s)
-SPARSE_FUNC(csrcsc, double, d)
-SPARSE_FUNC(csrcsc, cfloat, c)
-SPARSE_FUNC(csrcsc, cdouble,z)
-
-#undef SPARSE_FUNC
-#undef SPARSE_FUNC_DEF
-
-#endif // USE_MKL
-
 ////////////////////////////////////////////////////////////////////////////////
 // Common to MKL and Not MKL
 ////////////////////////////////////////////////////////////////////////////////
@@ -166,68 +81,45 @@ Array<T> sparseConvertCOOToDense(const SparseArray<T> &in)
     return dense;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-#ifdef USE_MKL // Implementation using MKL
-////////////////////////////////////////////////////////////////////////////////
-
+// Both conversions run in two passes over blocks of rows: the first counts
+// the values of every row, the second writes them at their final position
 template<typename T, af_storage stype>
 SparseArray<T> sparseConvertDenseToStorage(const Array<T> &in_)
 {
+    if(stype != AF_STORAGE_CSR)
+        AF_ERROR("CPU Backend only supports Dense to CSR or COO", AF_ERR_NOT_SUPPORTED);
+
     in_.eval();
 
-    // MKL only has dns->csr.
-    // CSR <-> CSC is only supported if input is square
-    uint nNZ = reduce_all<af_notzero_t, T, uint>(in_);
+    const int M = in_.dims()[0];
+    const int N = in_.dims()[1];
+
+    std::vector<int> rowPtr(M + 1);
+    auto count = [&] () {
+        kernel::denseCsrRowPtr(rowPtr.data(), in_.get(), in_.strides()[1], M, N);
+    };
+    getQueue().enqueue(count);
+    getQueue().sync();
 
-    SparseArray<T> sparse_ = createEmptySparseArray<T>(in_.dims(), nNZ, AF_STORAGE_CSR);
+    SparseArray<T> sparse_ = createEmptySparseArray<T>(in_.dims(), rowPtr[M], AF_STORAGE_CSR);
     sparse_.eval();
 
     auto func = [=] (SparseArray<T> sparse, const Array<T> in) {
-        // Read: https://software.intel.com/en-us/node/520848
-        // But job description is incorrect with regards to job[1]
-        // 0 implies row major and 1 implies column major
-        int j1 = 1, j2 = 0;
-        const int job[] = {0, j1, j2, 2, (int)sparse.elements(), 1};
-
-        const int M = in.dims()[0];
-        const int N = in.dims()[1];
-
-        int ldd = in.strides()[1];
-
-        int info = 0;
-
-        // Have to mess up all const correctness because MKL dnscsr function
-        // is bidirectional and has input/output on all pointers
-        Array<T  > &values = sparse.getValues();
-        Array<int> &rowIdx = sparse.getRowIdx();
-        Array<int> &colIdx = sparse.getColIdx();
-
-        dnscsr_func<T>()(
-                job, &M, &N,
-                reinterpret_cast<ptr_type<T>>(const_cast<T*>(in.get())), &ldd,
-                reinterpret_cast<ptr_type<T>>(values.get()),
-                colIdx.get(),
-                rowIdx.get(),
-                &info);
+        int *rowIdx = sparse.getRowIdx().get();
+        std::copy(rowPtr.begin(), rowPtr.end(), rowIdx);
+        kernel::denseToCsr(sparse.getValues().get(), sparse.getColIdx().get(), rowIdx,
+                           in.get(), in.strides()[1], M, N);
     };
 
     getQueue().enqueue(func, sparse_, in_);
 
-    if(stype == AF_STORAGE_CSR)
-        return sparse_;
-    else
-        AF_ERROR("CPU Backend only supports Dense to CSR or COO", AF_ERR_NOT_SUPPORTED);
-
     return sparse_;
 }
 
 template<typename T, af_storage stype>
 Array<T> sparseConvertStorageToDense(const SparseArray<T> &in_)
 {
-    // MKL only has dns<->csr.
-    // CSR <-> CSC is only supported if input is square
-
-    if(stype == AF_STORAGE_CSC)
+    if(stype != AF_STORAGE_CSR)
         AF_ERROR("CPU Backend only supports Dense to CSR or COO", AF_ERR_NOT_SUPPORTED);
 
     in_.eval();
@@ -236,121 +128,205 @@ Array<T> sparseConvertStorageToDense(const SparseArray<T> &in_)
     dense_.eval();
 
     auto func = [=] (Array<T> dense, const SparseArray<T> in) {
-        // Read: https://software.intel.com/en-us/node/520848
-        // But job description is incorrect with regards to job[1]
-        // 0 implies row major and 1 implies column major
-        int j1 = 1, j2 = 0;
-        const int job[] = {1, j1, j2, 2, (int)dense.elements(), 1};
-
-        const int M = dense.dims()[0];
-        const int N = dense.dims()[1];
-
-        int ldd = dense.strides()[1];
-
-        int info = 0;
-
-        Array<T  > values = in.getValues();
-        Array<int> rowIdx = in.getRowIdx();
-        Array<int> colIdx = in.getColIdx();
-
-        // Have to mess up all const correctness because MKL dnscsr function
-        // is bidirectional and has input/output on all pointers
-        dnscsr_func<T>()(
-                job, &M, &N,
-                reinterpret_cast<ptr_type<T>>(dense.get()), &ldd,
-                reinterpret_cast<ptr_type<T>>(const_cast<T*>(values.get())),
-                const_cast<int*>(colIdx.get()),
-                const_cast<int*>(rowIdx.get()),
-                &info);
+        kernel::csrToDense(dense.get(), dense.strides()[1],
+                           in.getValues().get(), in.getRowIdx().get(), in.getColIdx().get(),
+                           in.dims()[0]);
     };
 
     getQueue().enqueue(func, dense_, in_);
 
-    if(stype == AF_STORAGE_CSR)
-        return dense_;
-    else
-        AF_ERROR("CPU Backend only supports Dense to CSR or COO", AF_ERR_NOT_SUPPORTED);
-
     return dense_;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-#else // Implementation without using MKL
-////////////////////////////////////////////////////////////////////////////////
-
-template<typename T, af_storage stype>
-SparseArray<T> sparseConvertDenseToStorage(const Array<T> &in_)
+template<typename T>
+SparseArray<T> sparseAssemble(const af::dim4 &dims, const Array<T> &values_,
+                              const Array<int> &rowIdx_, const Array<int> &colIdx_,
+                              const af_sparse_duplicates dups)
 {
-    in_.eval();
+    const Array<T  > values = values_.isLinear() ? values_ : copyArray<T  >(values_);
+    const Array<int> rowIdx = rowIdx_.isLinear() ? rowIdx_ : copyArray<int>(rowIdx_);
+    const Array<int> colIdx = colIdx_.isLinear() ? colIdx_ : copyArray<int>(colIdx_);
+    values.eval();
+    rowIdx.eval();
+    colIdx.eval();
+
+    const int M   = dims[0];
+    const int N   = dims[1];
+    const int nNZ = values.elements();
+
+    std::shared_ptr<kernel::CooRows> rows = std::make_shared<kernel::CooRows>();
+    bool valid = true;
+    auto sortRows = [&] () {
+        valid = kernel::cooSortRows(*rows, rowIdx.get(), colIdx.get(), nNZ, M, N);
+    };
+    getQueue().enqueue(sortRows);
+    getQueue().sync();
 
-    uint nNZ = reduce_all<af_notzero_t, T, uint>(in_);
+    if(!valid)
+        AF_ERROR("Sparse indices are outside of the matrix", AF_ERR_ARG);
 
-    SparseArray<T> sparse_ = createEmptySparseArray<T>(in_.dims(), nNZ, AF_STORAGE_CSR);
-    sparse_.eval();
+    SparseArray<T> out_ = createEmptySparseArray<T>(dims, rows->outRowPtr.back(), AF_STORAGE_CSR);
+    out_.eval();
 
-    auto func = [=] (SparseArray<T> sparse, const Array<T> in) {
-        Array<T  > values = sparse.getValues();
-        Array<int> rowIdx = sparse.getRowIdx();
-        Array<int> colIdx = sparse.getColIdx();
-
-        kernel::dense_csr<T>()(values, rowIdx, colIdx, in);
+    const bool sum = (dups == AF_SPARSE_DUPLICATES_SUM);
+    auto fill = [=] (SparseArray<T> out, const Array<T> val, const Array<int> col) {
+        std::copy(rows->outRowPtr.begin(), rows->outRowPtr.end(), out.getRowIdx().get());
+        kernel::cooToCsr(out.getValues().get(), out.getColIdx().get(), *rows,
+                         val.get(), col.get(), sum);
     };
+    getQueue().enqueue(fill, out_, values, colIdx);
 
-    getQueue().enqueue(func, sparse_, in_);
+    return out_;
+}
 
-    if(stype == AF_STORAGE_CSR)
-        return sparse_;
-    else
-        AF_ERROR("CPU Backend only supports Dense to CSR or COO", AF_ERR_NOT_SUPPORTED);
+////////////////////////////////////////////////////////////////////////////////
+// Common to MKL and Not MKL
+////////////////////////////////////////////////////////////////////////////////
+template<typename T, af_storage src, af_storage dest>
+SparseArray<T> sparseConvertStorageToStorage(const SparseArray<T> &in)
+{
+    // Dummy function
+    // TODO finish this function when support is required
+    AF_ERROR("CPU Backend only supports Dense to CSR or COO", AF_ERR_NOT_SUPPORTED);
 
-    return sparse_;
+    in.eval();
+
+    SparseArray<T> dense = createEmptySparseArray<T>(in.dims(), (int)in.getNNZ(), dest);
+
+    return dense;
 }
 
-template<typename T, af_storage stype>
-Array<T> sparseConvertStorageToDense(const SparseArray<T> &in_)
+////////////////////////////////////////////////////////////////////////////////
+// Blocked storages, converted from and to CSR
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+SparseArray<T> sparseConvertCSRToBSR(const SparseArray<T> &in)
 {
-    in_.eval();
+    in.eval();
 
-    Array<T> dense_ = createValueArray<T>(in_.dims(), scalar<T>(0));
-    dense_.eval();
+    const int M = in.dims()[0];
+    const int N = in.dims()[1];
+
+    int bs = 1;
+    std::vector<int> bRowPtr;
+    auto layout = [&] () {
+        const int *rowPtr = in.getRowIdx().get();
+        const int *colIdx = in.getColIdx().get();
+        bs = kernel::bsrBlockSize<T>(rowPtr, colIdx, M, N);
+        bRowPtr.resize(M / bs + 1);
+        kernel::bsrRowPtr(bRowPtr.data(), rowPtr, colIdx, M, N, bs);
+    };
+    getQueue().enqueue(layout);
+    getQueue().sync();
+
+    const dim_t nnzb = bRowPtr.back();
+    Array<T  > values = createEmptyArray<T  >(dim4(nnzb * bs * bs));
+    Array<int> rowIdx = createHostDataArray<int>(dim4(bRowPtr.size()), bRowPtr.data());
+    Array<int> colIdx = createEmptyArray<int>(dim4(nnzb));
+
+    auto fill = [=] (Array<T> bVal, Array<int> bCol, const Array<int> bRow,
+                     const SparseArray<T> csr) {
+        kernel::csrToBsr(bVal.get(), bCol.get(), bRow.get(),
+                         csr.getValues().get(), csr.getRowIdx().get(), csr.getColIdx().get(),
+                         M, N, bs);
+    };
+    getQueue().enqueue(fill, values, colIdx, rowIdx, in);
 
-    auto func = [=] (Array<T> dense, const SparseArray<T> in) {
-        Array<T  > values = in.getValues();
-        Array<int> rowIdx = in.getRowIdx();
-        Array<int> colIdx = in.getColIdx();
+    return createArrayDataSparseArray<T>(in.dims(), values, rowIdx, colIdx, AF_STORAGE_BSR);
+}
+
+template<typename T>
+SparseArray<T> sparseConvertBSRToCSR(const SparseArray<T> &in)
+{
+    in.eval();
 
-        kernel::csr_dense<T>()(dense, values, rowIdx, colIdx);
+    const int M  = in.dims()[0];
+    const int bs = kernel::bsrSize(M, in.getRowIdx().elements());
+
+    std::vector<int> rowPtr(M + 1);
+    auto layout = [&] () {
+        kernel::bsrToCsrRowPtr(rowPtr.data(), in.getValues().get(), in.getRowIdx().get(), M, bs);
     };
+    getQueue().enqueue(layout);
+    getQueue().sync();
 
-    getQueue().enqueue(func, dense_, in_);
+    SparseArray<T> out_ = createEmptySparseArray<T>(in.dims(), rowPtr.back(), AF_STORAGE_CSR);
+    out_.eval();
 
-    if(stype == AF_STORAGE_CSR)
-        return dense_;
-    else
-        AF_ERROR("CPU Backend only supports Dense to CSR or COO", AF_ERR_NOT_SUPPORTED);
+    auto fill = [=] (SparseArray<T> out, const SparseArray<T> bsr) {
+        std::copy(rowPtr.begin(), rowPtr.end(), out.getRowIdx().get());
+        kernel::bsrToCsr(out.getValues().get(), out.getColIdx().get(), out.getRowIdx().get(),
+                         bsr.getValues().get(), bsr.getRowIdx().get(), bsr.getColIdx().get(),
+                         M, bs);
+    };
+    getQueue().enqueue(fill, out_, in);
 
-    return dense_;
+    return out_;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-#endif //USE_MKL
-////////////////////////////////////////////////////////////////////////////////
-
-////////////////////////////////////////////////////////////////////////////////
-// Common to MKL and Not MKL
-////////////////////////////////////////////////////////////////////////////////
-template<typename T, af_storage src, af_storage dest>
-SparseArray<T> sparseConvertStorageToStorage(const SparseArray<T> &in)
+template<typename T>
+SparseArray<T> sparseConvertCSRToSELL(const SparseArray<T> &in)
 {
-    // Dummy function
-    // TODO finish this function when support is required
-    AF_ERROR("CPU Backend only supports Dense to CSR or COO", AF_ERR_NOT_SUPPORTED);
+    in.eval();
+
+    const int M = in.dims()[0];
+    const int nSlices = kernel::sellSlices(M);
 
+    // Slice offsets followed by the row of every position
+    std::vector<int> layoutIdx(nSlices + 1 + M);
+    auto layout = [&] () {
+        kernel::sellLayout(layoutIdx.data(), layoutIdx.data() + nSlices + 1,
+                           in.getRowIdx().get(), M);
+    };
+    getQueue().enqueue(layout);
+    getQueue().sync();
+
+    const dim_t nStored = layoutIdx[nSlices];
+    Array<T  > values = createEmptyArray<T  >(dim4(nStored));
+    Array<int> rowIdx = createHostDataArray<int>(dim4(layoutIdx.size()), layoutIdx.data());
+    Array<int> colIdx = createEmptyArray<int>(dim4(nStored));
+
+    auto fill = [=] (Array<T> sVal, Array<int> sCol, const Array<int> sRow,
+                     const SparseArray<T> csr) {
+        kernel::csrToSell(sVal.get(), sCol.get(), sRow.get(), sRow.get() + nSlices + 1,
+                          csr.getValues().get(), csr.getRowIdx().get(), csr.getColIdx().get(),
+                          M);
+    };
+    getQueue().enqueue(fill, values, colIdx, rowIdx, in);
+
+    return createArrayDataSparseArray<T>(in.dims(), values, rowIdx, colIdx, AF_STORAGE_SELL);
+}
+
+template<typename T>
+SparseArray<T> sparseConvertSELLToCSR(const SparseArray<T> &in)
+{
     in.eval();
 
-    SparseArray<T> dense = createEmptySparseArray<T>(in.dims(), (int)in.getNNZ(), dest);
+    const int M = in.dims()[0];
+    const int nSlices = kernel::sellSlices(M);
 
-    return dense;
+    std::vector<int> rowPtr(M + 1);
+    auto layout = [&] () {
+        const int *sRow = in.getRowIdx().get();
+        kernel::sellToCsrRowPtr(rowPtr.data(), sRow, sRow + nSlices + 1,
+                                in.getColIdx().get(), M);
+    };
+    getQueue().enqueue(layout);
+    getQueue().sync();
+
+    SparseArray<T> out_ = createEmptySparseArray<T>(in.dims(), rowPtr.back(), AF_STORAGE_CSR);
+    out_.eval();
+
+    auto fill = [=] (SparseArray<T> out, const SparseArray<T> sell) {
+        const int *sRow = sell.getRowIdx().get();
+        std::copy(rowPtr.begin(), rowPtr.end(), out.getRowIdx().get());
+        kernel::sellToCsr(out.getValues().get(), out.getColIdx().get(), out.getRowIdx().get(),
+                          sell.getValues().get(), sell.getColIdx().get(),
+                          sRow, sRow + nSlices + 1, M);
+    };
+    getQueue().enqueue(fill, out_, in);
+
+    return out_;
 }
 
 #define INSTANTIATE_TO_STORAGE(T, S)                                                                        \
@@ -363,8 +339,32 @@ SparseArray<T> sparseConvertStorageToStorage(const SparseArray<T> &in)
     { return sparseConvertDenseToCOO<T>(in); }                                                          \
     template<> Array<T> sparseConvertStorageToDense<T, AF_STORAGE_COO>(const SparseArray<T> &in)        \
     { return sparseConvertCOOToDense<T>(in); }                                                          \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_COO>(const SparseArray<T> &in)          \
+    { return sparseAssemble<T>(in.dims(), in.getValues(), in.getRowIdx(), in.getColIdx(),              \
+                               AF_SPARSE_DUPLICATES_SUM); }                                             \
+
+// The destination storage is the first storage argument, as in the calls
+// made by the API
+#define INSTANTIATE_BLOCKED_SPECIAL(T)                                                                  \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_BSR, AF_STORAGE_CSR>(const SparseArray<T> &in)          \
+    { return sparseConvertCSRToBSR<T>(in); }                                                            \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_BSR>(const SparseArray<T> &in)          \
+    { return sparseConvertBSRToCSR<T>(in); }                                                            \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_SELL, AF_STORAGE_CSR>(const SparseArray<T> &in)         \
+    { return sparseConvertCSRToSELL<T>(in); }                                                           \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_SELL>(const SparseArray<T> &in)         \
+    { return sparseConvertSELLToCSR<T>(in); }                                                           \
 
 #define INSTANTIATE_SPARSE(T)                                                                           \
+    template SparseArray<T> sparseAssemble<T>(const af::dim4 &dims, const Array<T> &values,             \
+                                              const Array<int> &rowIdx, const Array<int> &colIdx,       \
+                                              const af_sparse_duplicates dups);                         \
+                                                                                                        \
     template SparseArray<T> sparseConvertDenseToStorage<T, AF_STORAGE_CSR>(const Array<T> &in);         \
     template SparseArray<T> sparseConvertDenseToStorage<T, AF_STORAGE_CSC>(const Array<T> &in);         \
                                                                                                         \
@@ -372,6 +372,7 @@ SparseArray<T> sparseConvertStorageToStorage(const SparseArray<T> &in)
     template Array<T> sparseConvertStorageToDense<T, AF_STORAGE_CSC>(const SparseArray<T> &in);         \
                                                                                                         \
     INSTANTIATE_COO_SPECIAL(T)                                                                          \
+    INSTANTIATE_BLOCKED_SPECIAL(T)                                                                      \
                                                                                                         \
     INSTANTIATE_TO_STORAGE(T, AF_STORAGE_CSR)                                                           \
     INSTANTIATE_TO_STORAGE(T, AF_STORAGE_CSC)                                                           \
@@ -385,6 +386,7 @@ INSTANTIATE_SPARSE(cdouble)
 
 #undef INSTANTIATE_TO_STORAGE
 #undef INSTANTIATE_COO_SPECIAL
+#undef INSTANTIATE_BLOCKED_SPECIAL
 #undef INSTANTIATE_SPARSE
 
 }
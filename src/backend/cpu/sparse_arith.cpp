@@ -0,0 +1,165 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <sparse_arith.hpp>
+
+#include <af/dim4.hpp>
+#include <err_common.hpp>
+#include <math.hpp>
+#include <parallel.hpp>
+#include <platform.hpp>
+#include <queue.hpp>
+#include <kernel/sparse_arith.hpp>
+#include <kernel/sparse_blas.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace cpu
+{
+
+using namespace common;
+
+template<typename T>
+using csr_row_func = void (*)(kernel::RowAccumulator<T> &, kernel::RowAccumulator<T> &,
+                              const T *, const int *, const int *,
+                              const T *, const int *, const int *,
+                              const int);
+
+// Rows of a result computed block by block before their positions in the
+// output are known
+template<typename T>
+struct CsrRows
+{
+    std::vector<int> rowPtr;
+    std::vector<int> bounds;
+    std::vector<std::vector<int>> cols;
+    std::vector<std::vector<T>> vals;
+};
+
+// Builds the CSR result with dims whose row i is computed by rowFn from row i
+// of lhs (and of rhs for element wise operations). The rows are split into
+// blocks with the same number of products. Every block collects its rows in
+// its own buffers, which are copied into the result once the number of
+// values is known.
+template<typename T>
+static SparseArray<T> csrFromRows(const af::dim4 &dims,
+                                  const SparseArray<T> &lhs, const SparseArray<T> &rhs,
+                                  csr_row_func<T> rowFn, const bool gemm)
+{
+    lhs.eval();
+    rhs.eval();
+
+    std::shared_ptr<CsrRows<T>> rows = std::make_shared<CsrRows<T>>();
+
+    auto func = [&] () {
+        const T   *lVal    = lhs.getValues().get();
+        const int *lRowPtr = lhs.getRowIdx().get();
+        const int *lColIdx = lhs.getColIdx().get();
+        const T   *rVal    = rhs.getValues().get();
+        const int *rRowPtr = rhs.getRowIdx().get();
+        const int *rColIdx = rhs.getColIdx().get();
+
+        const int nRows = dims[0];
+        const int nCols = dims[1];
+
+        std::vector<dim_t> work(nRows + 1, 0);
+        for (int i = 0; i < nRows; ++i) {
+            work[i + 1] = work[i] + (gemm ? kernel::csrGemmWork(lRowPtr, lColIdx, rRowPtr, i)
+                                          : kernel::csrArithWork(lRowPtr, rRowPtr, i));
+        }
+
+        dim_t blockSize = 0;
+        const dim_t nblocks = splitRange(blockSize, work[nRows] + nRows, kernel::SPARSE_MIN_BLOCK);
+
+        rows->bounds = kernel::csrRowBlocks(work.data(), nRows, nblocks);
+        rows->rowPtr.assign(nRows + 1, 0);
+        rows->cols.resize(nblocks);
+        rows->vals.resize(nblocks);
+
+        parallelFor(nblocks, [&](dim_t b) {
+            kernel::RowAccumulator<T> acc, lookup;
+            std::vector<int> &cols = rows->cols[b];
+            std::vector<T>   &vals = rows->vals[b];
+            const dim_t blockWork = work[rows->bounds[b + 1]] - work[rows->bounds[b]];
+            cols.reserve(blockWork);
+            vals.reserve(blockWork);
+            for (int i = rows->bounds[b]; i < rows->bounds[b + 1]; ++i) {
+                acc.reset(std::min<dim_t>(nCols, work[i + 1] - work[i]));
+                rowFn(acc, lookup, lVal, lRowPtr, lColIdx, rVal, rRowPtr, rColIdx, i);
+
+                const int n = acc.count();
+                const size_t offset = cols.size();
+                cols.resize(offset + n);
+                vals.resize(offset + n);
+                acc.extract(cols.data() + offset, vals.data() + offset);
+                rows->rowPtr[i + 1] = n;
+            }
+        });
+
+        for (int i = 0; i < nRows; ++i) rows->rowPtr[i + 1] += rows->rowPtr[i];
+    };
+
+    getQueue().enqueue(func);
+    getQueue().sync();
+
+    const dim_t nNZ = rows->rowPtr.back();
+    SparseArray<T> out_ = createEmptySparseArray<T>(dims, nNZ, AF_STORAGE_CSR);
+    out_.eval();
+
+    auto fill = [=] (SparseArray<T> out) {
+        T   *values = out.getValues().get();
+        int *rowIdx = out.getRowIdx().get();
+        int *colIdx = out.getColIdx().get();
+
+        std::copy(rows->rowPtr.begin(), rows->rowPtr.end(), rowIdx);
+        parallelFor(rows->cols.size(), [&](dim_t b) {
+            const int offset = rows->rowPtr[rows->bounds[b]];
+            std::copy(rows->cols[b].begin(), rows->cols[b].end(), colIdx + offset);
+            std::copy(rows->vals[b].begin(), rows->vals[b].end(), values + offset);
+        });
+    };
+
+    getQueue().enqueue(fill, out_);
+
+    return out_;
+}
+
+template<typename T>
+SparseArray<T> sparseAdd(const SparseArray<T> &lhs, const SparseArray<T> &rhs)
+{
+    return csrFromRows<T>(lhs.dims(), lhs, rhs, kernel::csrAddRow<T>, false);
+}
+
+template<typename T>
+SparseArray<T> sparseMul(const SparseArray<T> &lhs, const SparseArray<T> &rhs)
+{
+    return csrFromRows<T>(lhs.dims(), lhs, rhs, kernel::csrMulRow<T>, false);
+}
+
+template<typename T>
+SparseArray<T> sparseMatmul(const SparseArray<T> &lhs, const SparseArray<T> &rhs)
+{
+    return csrFromRows<T>(af::dim4(lhs.dims()[0], rhs.dims()[1]), lhs, rhs,
+                          kernel::csrGemmRow<T>, true);
+}
+
+#define INSTANTIATE_SPARSE_ARITH(T)                                                         \
+    template SparseArray<T> sparseAdd<T>(const SparseArray<T> &lhs, const SparseArray<T> &rhs);    \
+    template SparseArray<T> sparseMul<T>(const SparseArray<T> &lhs, const SparseArray<T> &rhs);    \
+    template SparseArray<T> sparseMatmul<T>(const SparseArray<T> &lhs, const SparseArray<T> &rhs); \
+
+INSTANTIATE_SPARSE_ARITH(float)
+INSTANTIATE_SPARSE_ARITH(double)
+INSTANTIATE_SPARSE_ARITH(cfloat)
+INSTANTIATE_SPARSE_ARITH(cdouble)
+
+#undef INSTANTIATE_SPARSE_ARITH
+
+}
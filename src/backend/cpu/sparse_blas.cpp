@@ -19,6 +19,8 @@
 #include <math.hpp>
 #include <platform.hpp>
 #include <queue.hpp>
+#include <kernel/sparse_blas.hpp>
+#include <kernel/sparse_blocked.hpp>
 
 namespace cpu
 {
@@ -205,8 +207,8 @@ scale_type<T> getScale()
 #ifdef USE_MKL // Implementation using MKL
 ////////////////////////////////////////////////////////////////////////////////
 template<typename T>
-Array<T> matmul(const common::SparseArray<T> lhs, const Array<T> rhs,
-                af_mat_prop optLhs, af_mat_prop optRhs)
+static Array<T> csrMatmul(const common::SparseArray<T> lhs, const Array<T> rhs,
+                          af_mat_prop optLhs, af_mat_prop optRhs)
 {
     // MKL: CSRMM Does not support optRhs
 
@@ -285,208 +287,303 @@ Array<T> matmul(const common::SparseArray<T> lhs, const Array<T> rhs,
 ////////////////////////////////////////////////////////////////////////////////
 
 template<typename T>
-T getConjugate(const T &in)
+static Array<T> csrMatmul(const common::SparseArray<T> lhs, const Array<T> rhs,
+                          af_mat_prop optLhs, af_mat_prop optRhs)
 {
-    // For non-complex types return same
-    return in;
-}
+    lhs.eval();
+    rhs.eval();
 
-template<>
-cfloat getConjugate(const cfloat &in)
-{
-    return std::conj(in);
-}
+    // Similar Operations to GEMM
+    sparse_operation_t lOpts = toSparseTranspose(optLhs);
 
-template<>
-cdouble getConjugate(const cdouble &in)
-{
-    return std::conj(in);
-}
+    int lRowDim = (lOpts == SPARSE_OPERATION_NON_TRANSPOSE) ? 0 : 1;
 
-template<typename T, bool conjugate>
-void mv(Array<T> output,
-        const Array<T> values,
-        const Array<int> rowIdx,
-        const Array<int> colIdx,
-        const Array<T> right,
-        int M)
-{
-    T   const * const   valPtr = values.get();
-    int const * const   rowPtr = rowIdx.get();
-    int const * const   colPtr = colIdx.get();
-    T   const * const rightPtr = right.get();
-    T         * const   outPtr = output.get();
-
-    for (int i = 0; i < rowIdx.dims()[0]-1; ++i) {
-        outPtr[i] = scalar<T>(0);
-        for (int j = rowPtr[i]; j < rowPtr[i+1]; ++j) {
-            //If stride[0] of right is not 1 then rightPtr[colPtr[j]*stride]
-            if (conjugate) {
-                outPtr[i] += getConjugate(valPtr[j]) * rightPtr[colPtr[j]];
-            } else {
-                outPtr[i] += valPtr[j] * rightPtr[colPtr[j]];
-            }
+    static const int rColDim = 1;
+
+    dim4 lDims = lhs.dims();
+    dim4 rDims = rhs.dims();
+    int M = lDims[lRowDim];
+    int N = rDims[rColDim];
+
+    Array<T> out = createValueArray<T>(af::dim4(M, N, 1, 1), scalar<T>(0));
+    out.eval();
+
+    auto func = [=] (Array<T> output, const SparseArray<T> left, const Array<T> right) {
+        int ldb = right.strides()[1];
+        int ldc = output.strides()[1];
+
+        Array<T  > values = left.getValues();
+        Array<int> rowIdx = left.getRowIdx();
+        Array<int> colIdx = left.getColIdx();
+
+        const T   *valPtr = values.get();
+        const int *rowPtr = rowIdx.get();
+        const int *colPtr = colIdx.get();
+        const int nRows   = rowIdx.dims()[0] - 1;
+
+        if (lOpts == SPARSE_OPERATION_NON_TRANSPOSE) {
+            kernel::csrmm<T, false>(output.get(), ldc, valPtr, rowPtr, colPtr, nRows,
+                                    right.get(), ldb, N);
+        } else if (lOpts == SPARSE_OPERATION_TRANSPOSE) {
+            kernel::csrmtm<T, false>(output.get(), ldc, valPtr, rowPtr, colPtr, nRows,
+                                     right.get(), ldb, M, N);
+        } else if (lOpts == SPARSE_OPERATION_CONJUGATE_TRANSPOSE) {
+            kernel::csrmtm<T, true>(output.get(), ldc, valPtr, rowPtr, colPtr, nRows,
+                                    right.get(), ldb, M, N);
         }
-    }
+    };
+
+    getQueue().enqueue(func, out, lhs, rhs);
+
+    return out;
 }
 
-template<typename T, bool conjugate>
-void mtv(Array<T> output,
-        const Array<T> values,
-        const Array<int> rowIdx,
-        const Array<int> colIdx,
-        const Array<T> right,
-        int M)
+////////////////////////////////////////////////////////////////////////////////
+#endif
+////////////////////////////////////////////////////////////////////////////////
+
+// Products with the blocked storages. Only op(A) = A is supported.
+template<typename T>
+static Array<T> blockedMatmul(const common::SparseArray<T> lhs, const Array<T> rhs)
 {
-    T   const * const   valPtr = values.get();
-    int const * const   rowPtr = rowIdx.get();
-    int const * const   colPtr = colIdx.get();
-    T   const * const rightPtr = right.get();
-    T         * const   outPtr = output.get();
-
-    for (int i = 0; i < M; ++i) {
-        outPtr[i] = scalar<T>(0);
-    }
+    lhs.eval();
+    rhs.eval();
+
+    const int M = lhs.dims()[0];
+    const int N = rhs.dims()[1];
+    const af_storage stype = lhs.getStorage();
+
+    Array<T> out = createEmptyArray<T>(af::dim4(M, N, 1, 1));
 
-    for (int i = 0; i < rowIdx.dims()[0]-1; ++i) {
-        for (int j = rowPtr[i]; j < rowPtr[i+1]; ++j) {
-            //If stride[0] of right is not 1 then rightPtr[i*stride]
-            if (conjugate) {
-                outPtr[colPtr[j]] += getConjugate(valPtr[j]) * rightPtr[i];
-            } else {
-                outPtr[colPtr[j]] += valPtr[j] * rightPtr[i];
-            }
+    auto func = [=] (Array<T> output, const SparseArray<T> left, const Array<T> right) {
+        const T   *valPtr = left.getValues().get();
+        const int *rowPtr = left.getRowIdx().get();
+        const int *colPtr = left.getColIdx().get();
+
+        const int ldb = right.strides()[1];
+        const int ldc = output.strides()[1];
+
+        if (stype == AF_STORAGE_BSR) {
+            const int bs = kernel::bsrSize(M, left.getRowIdx().elements());
+            kernel::bsrmm(output.get(), ldc, valPtr, rowPtr, colPtr, M, bs,
+                          right.get(), ldb, N);
+        } else {
+            kernel::sellmm(output.get(), ldc, valPtr, rowPtr,
+                           rowPtr + kernel::sellSlices(M) + 1, colPtr, M,
+                           right.get(), ldb, N);
         }
-    }
+    };
+
+    getQueue().enqueue(func, out, lhs, rhs);
+
+    return out;
 }
 
-template<typename T, bool conjugate>
-void mm(Array<T> output,
-        const Array<T> values,
-        const Array<int> rowIdx,
-        const Array<int> colIdx,
-        const Array<T> right,
-        int M, int N,
-        int ldb, int ldc)
+template<typename T>
+Array<T> matmul(const common::SparseArray<T> lhs, const Array<T> rhs,
+                af_mat_prop optLhs, af_mat_prop optRhs)
 {
-    T   const * const   valPtr = values.get();
-    int const * const   rowPtr = rowIdx.get();
-    int const * const   colPtr = colIdx.get();
-    T   const *       rightPtr = right.get();
-    T         *         outPtr = output.get();
-
-    for (int o = 0; o < N; ++o) {
-        for (int i = 0; i < rowIdx.dims()[0]-1; ++i) {
-            outPtr[i] = scalar<T>(0);
-            for (int j = rowPtr[i]; j < rowPtr[i+1]; ++j) {
-                //If stride[0] of right is not 1 then rightPtr[colPtr[j]*stride]
-                if (conjugate) {
-                    outPtr[i] += getConjugate(valPtr[j]) * rightPtr[colPtr[j]];
-                } else {
-                    outPtr[i] += valPtr[j] * rightPtr[colPtr[j]];
-                }
-            }
-        }
-        rightPtr += ldb;
-        outPtr += ldc;
+    if (lhs.getStorage() == AF_STORAGE_BSR || lhs.getStorage() == AF_STORAGE_SELL) {
+        return blockedMatmul<T>(lhs, rhs);
     }
+    return csrMatmul<T>(lhs, rhs, optLhs, optRhs);
 }
 
-template<typename T, bool conjugate>
-void mtm(Array<T> output,
-        const Array<T> values,
-        const Array<int> rowIdx,
-        const Array<int> colIdx,
-        const Array<T> right,
-        int M, int N,
-        int ldb, int ldc)
+////////////////////////////////////////////////////////////////////////////////
+// Sparse operators
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+struct SparseAnalysis
 {
-    T   const * const   valPtr = values.get();
-    int const * const   rowPtr = rowIdx.get();
-    int const * const   colPtr = colIdx.get();
-    T   const *       rightPtr = right.get();
-    T         *         outPtr = output.get();
-
-    for (int o = 0; o < N; ++o) {
-        for (int i = 0; i < M; ++i) {
-            outPtr[i] = scalar<T>(0);
-        }
+    Array<T  > values;
+    Array<int> rowIdx;
+    Array<int> colIdx;
 
-        for (int i = 0; i < rowIdx.dims()[0]-1; ++i) {
-            for (int j = rowPtr[i]; j < rowPtr[i+1]; ++j) {
-                //If stride[0] of right is not 1 then rightPtr[i*stride]
-                if (conjugate) {
-                    outPtr[colPtr[j]] += getConjugate(valPtr[j]) * rightPtr[i];
-                } else {
-                    outPtr[colPtr[j]] += valPtr[j] * rightPtr[i];
-                }
-            }
-        }
-        rightPtr += ldb;
-        outPtr += ldc;
+#ifdef USE_MKL
+    sparse_matrix_t handle;
+
+    SparseAnalysis(const Array<T> &values, const Array<int> &rowIdx, const Array<int> &colIdx)
+        : values(values), rowIdx(rowIdx), colIdx(colIdx), handle(0)
+    {}
+
+    ~SparseAnalysis()
+    {
+        if (handle) mkl_sparse_destroy(handle);
     }
-}
+#else
+    // Row blocks for products with the expected number of columns
+    std::vector<int> bounds;
+
+    SparseAnalysis(const Array<T> &values, const Array<int> &rowIdx, const Array<int> &colIdx)
+        : values(values), rowIdx(rowIdx), colIdx(colIdx)
+    {}
+#endif
+};
+
+#ifdef USE_MKL
+
+// Number of products MKL is told to optimize a sparse operator for
+static const int SPARSE_OPERATOR_CALLS = 1000;
+
 template<typename T>
-Array<T> matmul(const common::SparseArray<T> lhs, const Array<T> rhs,
-                af_mat_prop optLhs, af_mat_prop optRhs)
+SparseOperator<T>::SparseOperator(const SparseArray<T> &lhs, const af_mat_prop optLhs,
+                                  const dim_t ncols)
+    : optLhs(optLhs), lhsDims(lhs.dims())
 {
     lhs.eval();
+
+    const sparse_operation_t lOpts = toSparseTranspose(optLhs);
+    analysis = std::make_shared<SparseAnalysis<T>>(lhs.getValues(), lhs.getRowIdx(), lhs.getColIdx());
+
+    const af::dim4 lDims = lhsDims;
+    auto func = [=] (std::shared_ptr<SparseAnalysis<T>> a) {
+        create_csr_func<T>()(&a->handle, SPARSE_INDEX_BASE_ZERO, lDims[0], lDims[1],
+                             a->rowIdx.get(), a->rowIdx.get() + 1, a->colIdx.get(),
+                             reinterpret_cast<ptr_type<T>>(a->values.get()));
+
+        struct matrix_descr descr;
+        descr.type = SPARSE_MATRIX_TYPE_GENERAL;
+
+        if (ncols == 1) {
+            mkl_sparse_set_mv_hint(a->handle, lOpts, descr, SPARSE_OPERATOR_CALLS);
+        } else {
+            mkl_sparse_set_mm_hint(a->handle, lOpts, descr, SPARSE_LAYOUT_COLUMN_MAJOR,
+                                   ncols, SPARSE_OPERATOR_CALLS);
+        }
+        mkl_sparse_optimize(a->handle);
+    };
+
+    getQueue().enqueue(func, analysis);
+}
+
+template<typename T>
+Array<T> SparseOperator<T>::matmul(const Array<T> &rhs) const
+{
     rhs.eval();
 
-    // Similar Operations to GEMM
-    sparse_operation_t lOpts = toSparseTranspose(optLhs);
+    const sparse_operation_t lOpts = toSparseTranspose(optLhs);
+    const int M = lhsDims[optLhs == AF_MAT_NONE ? 0 : 1];
+    const int N = rhs.dims()[1];
 
-    int lRowDim = (lOpts == SPARSE_OPERATION_NON_TRANSPOSE) ? 0 : 1;
+    Array<T> out = createEmptyArray<T>(af::dim4(M, N, 1, 1));
 
-    static const int rColDim = 1;
+    auto func = [=] (Array<T> output, std::shared_ptr<const SparseAnalysis<T>> a,
+                     const Array<T> right) {
+        auto alpha = getScale<T, 1>();
+        auto beta  = getScale<T, 0>();
 
-    dim4 lDims = lhs.dims();
-    dim4 rDims = rhs.dims();
-    int M = lDims[lRowDim];
-    int N = rDims[rColDim];
+        struct matrix_descr descr;
+        descr.type = SPARSE_MATRIX_TYPE_GENERAL;
 
-    Array<T> out = createValueArray<T>(af::dim4(M, N, 1, 1), scalar<T>(0));
-    out.eval();
+        if (N == 1) {
+            mv_func<T>()(lOpts, alpha, a->handle, descr,
+                         reinterpret_cast<cptr_type<T>>(right.get()),
+                         beta, reinterpret_cast<ptr_type<T>>(output.get()));
+        } else {
+            mm_func<T>()(lOpts, alpha, a->handle, descr, SPARSE_LAYOUT_COLUMN_MAJOR,
+                         reinterpret_cast<cptr_type<T>>(right.get()),
+                         N, right.strides()[1], beta,
+                         reinterpret_cast<ptr_type<T>>(output.get()), output.strides()[1]);
+        }
+    };
 
-    auto func = [=] (Array<T> output, const SparseArray<T> left, const Array<T> right) {
-        int ldb = right.strides()[1];
-        int ldc = output.strides()[1];
+    getQueue().enqueue(func, out, analysis, rhs);
+
+    return out;
+}
+
+#else
 
+// Transposed operators keep the CSR form of op(A) so that every product is a
+// plain row parallel csrmm without partial outputs
+template<typename T>
+SparseOperator<T>::SparseOperator(const SparseArray<T> &lhs, const af_mat_prop optLhs,
+                                  const dim_t ncols)
+    : optLhs(optLhs), lhsDims(lhs.dims())
+{
+    lhs.eval();
+
+    const sparse_operation_t lOpts = toSparseTranspose(optLhs);
+    const int nnz = lhs.getNNZ();
+
+    if (lOpts == SPARSE_OPERATION_NON_TRANSPOSE) {
+        analysis = std::make_shared<SparseAnalysis<T>>(lhs.getValues(), lhs.getRowIdx(),
+                                                       lhs.getColIdx());
+    } else {
+        analysis = std::make_shared<SparseAnalysis<T>>(
+            createEmptyArray<T  >(af::dim4(nnz)),
+            createEmptyArray<int>(af::dim4(lhsDims[1] + 1)),
+            createEmptyArray<int>(af::dim4(nnz)));
+    }
+
+    const int nRows = lhsDims[0];
+    const int nCols = lhsDims[1];
+    auto func = [=] (std::shared_ptr<SparseAnalysis<T>> a, const SparseArray<T> left) {
         Array<T  > values = left.getValues();
         Array<int> rowIdx = left.getRowIdx();
         Array<int> colIdx = left.getColIdx();
 
-        if(rDims[rColDim] == 1) {
-            if (lOpts == SPARSE_OPERATION_NON_TRANSPOSE) {
-                mv<T, false>(output, values, rowIdx, colIdx, right, M);
-            } else if (lOpts == SPARSE_OPERATION_TRANSPOSE) {
-                mtv<T, false>(output, values, rowIdx, colIdx, right, M);
-            } else if (lOpts == SPARSE_OPERATION_CONJUGATE_TRANSPOSE) {
-                mtv<T, true>(output, values, rowIdx, colIdx, right, M);
-            }
+        if (lOpts == SPARSE_OPERATION_TRANSPOSE) {
+            kernel::csrTranspose<T, false>(a->values.get(), a->rowIdx.get(), a->colIdx.get(),
+                                           values.get(), rowIdx.get(), colIdx.get(),
+                                           nRows, nCols);
+        } else if (lOpts == SPARSE_OPERATION_CONJUGATE_TRANSPOSE) {
+            kernel::csrTranspose<T, true>(a->values.get(), a->rowIdx.get(), a->colIdx.get(),
+                                          values.get(), rowIdx.get(), colIdx.get(),
+                                          nRows, nCols);
+        }
+
+        const int *rowPtr = a->rowIdx.get();
+        const int  opRows = a->rowIdx.dims()[0] - 1;
+        a->bounds = kernel::csrRowBlocks(rowPtr, opRows,
+                                         kernel::csrmmBlocks(rowPtr, opRows, ncols));
+    };
+
+    getQueue().enqueue(func, analysis, lhs);
+}
+
+template<typename T>
+Array<T> SparseOperator<T>::matmul(const Array<T> &rhs) const
+{
+    rhs.eval();
+
+    const int M = lhsDims[optLhs == AF_MAT_NONE ? 0 : 1];
+    const int N = rhs.dims()[1];
+
+    Array<T> out = createEmptyArray<T>(af::dim4(M, N, 1, 1));
+
+    auto func = [=] (Array<T> output, std::shared_ptr<const SparseAnalysis<T>> a,
+                     const Array<T> right) {
+        const T   *valPtr = a->values.get();
+        const int *rowPtr = a->rowIdx.get();
+        const int *colPtr = a->colIdx.get();
+
+        const int ldb = right.strides()[1];
+        const int ldc = output.strides()[1];
+
+        // The cached row blocks are used whenever the product splits into
+        // as many blocks as the one the operator was prepared for
+        if (kernel::csrmmBlocks(rowPtr, M, N) + 1 == (dim_t)a->bounds.size()) {
+            kernel::csrmm<T, false>(output.get(), ldc, valPtr, rowPtr, colPtr, M,
+                                    right.get(), ldb, N, a->bounds);
         } else {
-            if (lOpts == SPARSE_OPERATION_NON_TRANSPOSE) {
-                mm<T, false>(output, values, rowIdx, colIdx, right, M, N, ldb, ldc);
-            } else if (lOpts == SPARSE_OPERATION_TRANSPOSE) {
-                mtm<T, false>(output, values, rowIdx, colIdx, right, M, N, ldb, ldc);
-            } else if (lOpts == SPARSE_OPERATION_CONJUGATE_TRANSPOSE) {
-                mtm<T, true>(output, values, rowIdx, colIdx, right, M, N, ldb, ldc);
-            }
+            kernel::csrmm<T, false>(output.get(), ldc, valPtr, rowPtr, colPtr, M,
+                                    right.get(), ldb, N);
         }
     };
 
-    getQueue().enqueue(func, out, lhs, rhs);
+    getQueue().enqueue(func, out, analysis, rhs);
 
     return out;
 }
 
-////////////////////////////////////////////////////////////////////////////////
 #endif
-////////////////////////////////////////////////////////////////////////////////
 
 #define INSTANTIATE_SPARSE(T)                                                           \
     template Array<T> matmul<T>(const common::SparseArray<T> lhs, const Array<T> rhs,   \
                                 af_mat_prop optLhs, af_mat_prop optRhs);                \
+    template class SparseOperator<T>;                                                   \
 
 
 INSTANTIATE_SPARSE(float)
@@ -10,6 +10,7 @@
 #include <Array.hpp>
 #include <SparseArray.hpp>
 #include <sparse.hpp>
+#include <memory>
 
 namespace cpu
 {
@@ -18,5 +19,27 @@ template<typename T>
 Array<T> matmul(const common::SparseArray<T> lhs, const Array<T> rhs,
                 af_mat_prop optLhs, af_mat_prop optRhs);
 
+// Everything about a sparse matrix that is worked out once and reused by every
+// product with it. Defined in sparse_blas.cpp.
+template<typename T>
+struct SparseAnalysis;
+
+// A CSR matrix and the op applied to it, prepared for repeated products with
+// dense matrices of about ncols columns
+template<typename T>
+class SparseOperator
+{
+    af_mat_prop optLhs;
+    af::dim4 lhsDims;
+    std::shared_ptr<SparseAnalysis<T>> analysis;
+
+  public:
+    SparseOperator(const common::SparseArray<T> &lhs, const af_mat_prop optLhs,
+                   const dim_t ncols);
+
+    // op(lhs) * rhs
+    Array<T> matmul(const Array<T> &rhs) const;
+};
+
 }
 
@@ -10,11 +10,13 @@
 #include <complex>
 #include <af/dim4.hpp>
 #include <Array.hpp>
-#include <memory.hpp>
+#include <copy.hpp>
 #include <where.hpp>
 #include <ops.hpp>
 #include <vector>
 #include <platform.hpp>
+#include <queue.hpp>
+#include <kernel/where.hpp>
 
 using af::dim4;
 
@@ -27,43 +29,70 @@ Array<uint> where(const Array<T> &in)
     in.eval();
     getQueue().sync();
 
-    const dim_t *dims    = in.dims().get();
-    const dim_t *strides = in.strides().get();
     static const T zero = scalar<T>(0);
-
     const T *iptr = in.get();
-    uint *out_vec  = memAlloc<uint>(in.elements());
-
-    dim_t count = 0;
-    dim_t idx = 0;
-    for (dim_t w = 0; w < dims[3]; w++) {
-        uint offw = w * strides[3];
-
-        for (dim_t z = 0; z < dims[2]; z++) {
-            uint offz = offw + z * strides[2];
-
-            for (dim_t y = 0; y < dims[1]; y++) {
-                uint offy = y * strides[1] + offz;
-
-                for (dim_t x = 0; x < dims[0]; x++) {
-
-                    T val = iptr[offy + x];
-                    if (val != zero) {
-                        out_vec[count] = idx;
-                        count++;
-                    }
-                    idx++;
-                }
-            }
-        }
+
+    Array<uint> out = createEmptyArray<uint>(dim4(0));
+    uint *optr = NULL;
+
+    kernel::compactElements(in.dims(), in.strides(),
+                            [&](dim_t off) { return iptr[off] != zero; },
+                            [&](dim_t count) {
+                                out = createEmptyArray<uint>(dim4(count));
+                                optr = out.get();
+                            },
+                            [&](dim_t pos, dim_t idx) { optr[pos] = (uint)idx; });
+
+    return out;
+}
+
+template<typename T>
+Array<T> compact(const Array<T> &in, const Array<char> &mask)
+{
+    in.eval();
+    mask.eval();
+    getQueue().sync();
+
+    const char *mptr = mask.get();
+
+    if (mask.elements() == in.elements()) {
+        // Select single elements. The output index is the linear index of
+        // the element, so the values are read from a linear copy.
+        Array<T> lin = in.isLinear() ? in : copyArray<T>(in);
+        const T *iptr = lin.get();
+
+        Array<T> out = createEmptyArray<T>(dim4(0));
+        T *optr = NULL;
+
+        kernel::compactElements(mask.dims(), mask.strides(),
+                                [&](dim_t off) { return mptr[off] != 0; },
+                                [&](dim_t count) {
+                                    out = createEmptyArray<T>(dim4(count));
+                                    optr = out.get();
+                                },
+                                [&](dim_t pos, dim_t idx) { optr[pos] = iptr[idx]; });
+        return out;
     }
 
-    Array<uint> out = createDeviceDataArray<uint>(dim4(count), out_vec);
+    // Select rows: mask has one entry per row of in
+    std::vector<uint> rows;
+    kernel::compactElements(mask.dims(), mask.strides(),
+                            [&](dim_t off) { return mptr[off] != 0; },
+                            [&](dim_t count) { rows.resize(count); },
+                            [&](dim_t pos, dim_t idx) { rows[pos] = (uint)idx; });
+
+    dim4 odims = in.dims();
+    odims[0] = rows.size();
+    Array<T> out = createEmptyArray<T>(odims);
+    if (out.elements() > 0) {
+        kernel::gatherRows<T>(out.get(), in.get(), in.dims(), in.strides(), rows);
+    }
     return out;
 }
 
-#define INSTANTIATE(T)                                  \
-    template Array<uint> where<T>(const Array<T> &in);    \
+#define INSTANTIATE(T)                                                          \
+    template Array<uint> where<T>(const Array<T> &in);                          \
+    template Array<T> compact<T>(const Array<T> &in, const Array<char> &mask);  \
 
 INSTANTIATE(float  )
 INSTANTIATE(cfloat )
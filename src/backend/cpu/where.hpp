@@ -13,4 +13,11 @@ namespace cpu
 {
     template<typename T>
     Array<uint> where(const Array<T>& in);
+
+    // Returns the values of in where mask is non-zero. If mask has as many
+    // elements as in, the selected elements are returned as a vector.
+    // Otherwise mask has one entry per row of in and the selected rows are
+    // returned.
+    template<typename T>
+    Array<T> compact(const Array<T>& in, const Array<char>& mask);
 }
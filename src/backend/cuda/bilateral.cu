@@ -11,6 +11,7 @@
 #include <Array.hpp>
 #include <bilateral.hpp>
 #include <kernel/bilateral.hpp>
+#include <err_cuda.hpp>
 
 using af::dim4;
 
@@ -25,9 +26,17 @@ Array<outType> bilateral(const Array<inType> &in, const float &s_sigma, const fl
     return out;
 }
 
+template<typename inType, typename outType, bool isColor>
+Array<outType> bilateralGrid(const Array<inType> &in, const float &s_sigma, const float &c_sigma)
+{
+    CUDA_NOT_SUPPORTED();
+}
+
 #define INSTANTIATE(inT, outT)\
 template Array<outT> bilateral<inT, outT,true >(const Array<inT> &in, const float &s_sigma, const float &c_sigma);\
-template Array<outT> bilateral<inT, outT,false>(const Array<inT> &in, const float &s_sigma, const float &c_sigma);
+template Array<outT> bilateral<inT, outT,false>(const Array<inT> &in, const float &s_sigma, const float &c_sigma);\
+template Array<outT> bilateralGrid<inT, outT,true >(const Array<inT> &in, const float &s_sigma, const float &c_sigma);\
+template Array<outT> bilateralGrid<inT, outT,false>(const Array<inT> &in, const float &s_sigma, const float &c_sigma);
 
 INSTANTIATE(double, double)
 INSTANTIATE(float ,  float)
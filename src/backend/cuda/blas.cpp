@@ -14,6 +14,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <algorithm>
 #include <cassert>
 #include <math.hpp>
 #include <err_common.hpp>
@@ -21,6 +22,9 @@
 #include <arith.hpp>
 #include <reduce.hpp>
 #include <complex.hpp>
+#include <tile.hpp>
+#include <unary.hpp>
+#include <type_traits>
 
 namespace cuda
 {
@@ -164,13 +168,17 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
     int N = rDims[bColDim];
     int K = lDims[aColDim];
 
-    Array<T> out = createEmptyArray<T>(af::dim4(M, N, 1, 1));
+    dim_t batch2 = std::max(lDims[2], rDims[2]);
+    dim_t batch3 = std::max(lDims[3], rDims[3]);
+
+    Array<T> out = createEmptyArray<T>(af::dim4(M, N, batch2, batch3));
     T alpha = scalar<T>(1);
     T beta  = scalar<T>(0);
 
     dim4 lStrides = lhs.strides();
     dim4 rStrides = rhs.strides();
-    if(rDims[bColDim] == 1) {
+    dim4 oStrides = out.strides();
+    if(rDims[bColDim] == 1 && batch2 * batch3 == 1) {
         N = lDims[aColDim];
         CUBLAS_CHECK(gemv_func<T>()(
                          getHandle(),
@@ -183,23 +191,110 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
                          &beta,
                          out.get(), 1));
     } else {
-        CUBLAS_CHECK(gemm_func<T>()(
-                         getHandle(),
-                         lOpts,
-                         rOpts,
-                         M, N, K,
-                         &alpha,
-                         lhs.get(), lStrides[1],
-                         rhs.get(), rStrides[1],
-                         &beta,
-                         out.get(),
-                         out.dims()[0]));
+        // One gemm per matrix of the batch. Dimensions of size 1 are
+        // broadcast against the other side.
+        for (dim_t b3 = 0; b3 < batch3; b3++) {
+            for (dim_t b2 = 0; b2 < batch2; b2++) {
+                dim_t lOff = (lDims[2] == 1 ? 0 : b2 * lStrides[2]) +
+                             (lDims[3] == 1 ? 0 : b3 * lStrides[3]);
+                dim_t rOff = (rDims[2] == 1 ? 0 : b2 * rStrides[2]) +
+                             (rDims[3] == 1 ? 0 : b3 * rStrides[3]);
+                dim_t oOff = b2 * oStrides[2] + b3 * oStrides[3];
+                CUBLAS_CHECK(gemm_func<T>()(
+                                 getHandle(),
+                                 lOpts,
+                                 rOpts,
+                                 M, N, K,
+                                 &alpha,
+                                 lhs.get() + lOff, lStrides[1],
+                                 rhs.get() + rOff, rStrides[1],
+                                 &beta,
+                                 out.get() + oOff,
+                                 out.dims()[0]));
+            }
+        }
     }
 
     return out;
 
 }
 
+// Activations are only defined for real types
+template<typename T>
+typename std::enable_if<!is_complex<T>::value, Array<T>>::type
+activation(const Array<T> &in, af_activation act)
+{
+    switch (act) {
+    case AF_ACTIVATION_RELU:
+        return arithOp<T, af_max_t>(in, createValueArray<T>(in.dims(), scalar<T>(0)), in.dims());
+    case AF_ACTIVATION_SIGMOID:
+        return unaryOp<T, af_sigmoid_t>(in);
+    case AF_ACTIVATION_TANH:
+        return unaryOp<T, af_tanh_t>(in);
+    default:
+        return in;
+    }
+}
+
+template<typename T>
+typename std::enable_if<is_complex<T>::value, Array<T>>::type
+activation(const Array<T> &in, af_activation act)
+{
+    return in;
+}
+
+template<typename T>
+void gemm(Array<T> &out, af_mat_prop optLhs, af_mat_prop optRhs,
+          const T *alpha, const Array<T> &lhs, const Array<T> &rhs, const T *beta,
+          const Array<T> *bias, af_activation act)
+{
+    cublasOperation_t lOpts = toCblasTranspose(optLhs);
+    cublasOperation_t rOpts = toCblasTranspose(optRhs);
+
+    dim4 lDims = lhs.dims();
+    dim4 rDims = rhs.dims();
+    dim4 oDims = out.dims();
+    int M = oDims[0];
+    int N = oDims[1];
+    int K = lDims[optLhs == AF_MAT_NONE ? 1 : 0];
+
+    dim4 lStrides = lhs.strides();
+    dim4 rStrides = rhs.strides();
+    dim4 oStrides = out.strides();
+    for (dim_t b3 = 0; b3 < oDims[3]; b3++) {
+        for (dim_t b2 = 0; b2 < oDims[2]; b2++) {
+            dim_t lOff = (lDims[2] == 1 ? 0 : b2 * lStrides[2]) +
+                         (lDims[3] == 1 ? 0 : b3 * lStrides[3]);
+            dim_t rOff = (rDims[2] == 1 ? 0 : b2 * rStrides[2]) +
+                         (rDims[3] == 1 ? 0 : b3 * rStrides[3]);
+            dim_t oOff = b2 * oStrides[2] + b3 * oStrides[3];
+            CUBLAS_CHECK(gemm_func<T>()(
+                             getHandle(),
+                             lOpts,
+                             rOpts,
+                             M, N, K,
+                             alpha,
+                             lhs.get() + lOff, lStrides[1],
+                             rhs.get() + rOff, rStrides[1],
+                             beta,
+                             out.get() + oOff,
+                             oDims[0]));
+        }
+    }
+
+    // The epilogue is applied with the JIT after the product
+    if (bias) {
+        dim4 tileDims(bias->dims()[0] == M ? 1 : M,
+                      bias->dims()[0] == M ? N : 1,
+                      oDims[2], oDims[3]);
+        out = arithOp<T, af_add_t>(out, tile<T>(*bias, tileDims), oDims);
+    }
+    if (act != AF_ACTIVATION_NONE) {
+        out = activation<T>(out, act);
+    }
+    out.eval();
+}
+
 template<typename T>
 Array<T> dot(const Array<T> &lhs, const Array<T> &rhs,
              af_mat_prop optLhs, af_mat_prop optRhs)
@@ -240,7 +335,12 @@ void trsm(const Array<T> &lhs, Array<T> &rhs, af_mat_prop trans,
 
 #define INSTANTIATE_BLAS(TYPE)                                                          \
     template Array<TYPE> matmul<TYPE>(const Array<TYPE> &lhs, const Array<TYPE> &rhs,   \
-                                      af_mat_prop optLhs, af_mat_prop optRhs);
+                                      af_mat_prop optLhs, af_mat_prop optRhs);          \
+    template void gemm<TYPE>(Array<TYPE> &out, af_mat_prop optLhs, af_mat_prop optRhs,  \
+                             const TYPE *alpha,                                         \
+                             const Array<TYPE> &lhs, const Array<TYPE> &rhs,            \
+                             const TYPE *beta,                                          \
+                             const Array<TYPE> *bias, af_activation act);
 
 INSTANTIATE_BLAS(float)
 INSTANTIATE_BLAS(cfloat)
@@ -35,6 +35,13 @@ Array<outType> histogram(const Array<inType> &in, const unsigned &nbins, const d
     return out;
 }
 
+template<typename inType, typename outType>
+Array<outType> weightedHistogram(const Array<inType> &in, const Array<outType> &weights,
+                                 const unsigned &nbins, const double &minval, const double &maxval)
+{
+    CUDA_NOT_SUPPORTED();
+}
+
 #define INSTANTIATE(in_t,out_t)\
 template Array<out_t> histogram<in_t, out_t, true>(const Array<in_t> &in, const unsigned &nbins, const double &minval, const double &maxval); \
 template Array<out_t> histogram<in_t, out_t, false>(const Array<in_t> &in, const unsigned &nbins, const double &minval, const double &maxval);
@@ -50,4 +57,19 @@ INSTANTIATE(ushort, uint)
 INSTANTIATE(intl  , uint)
 INSTANTIATE(uintl , uint)
 
+#define INSTANTIATE_WEIGHTED(in_t)\
+template Array<float > weightedHistogram<in_t, float >(const Array<in_t> &in, const Array<float > &weights, const unsigned &nbins, const double &minval, const double &maxval); \
+template Array<double> weightedHistogram<in_t, double>(const Array<in_t> &in, const Array<double> &weights, const unsigned &nbins, const double &minval, const double &maxval);
+
+INSTANTIATE_WEIGHTED(float )
+INSTANTIATE_WEIGHTED(double)
+INSTANTIATE_WEIGHTED(char  )
+INSTANTIATE_WEIGHTED(int   )
+INSTANTIATE_WEIGHTED(uint  )
+INSTANTIATE_WEIGHTED(uchar )
+INSTANTIATE_WEIGHTED(short )
+INSTANTIATE_WEIGHTED(ushort)
+INSTANTIATE_WEIGHTED(intl  )
+INSTANTIATE_WEIGHTED(uintl )
+
 }
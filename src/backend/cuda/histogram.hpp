@@ -15,4 +15,9 @@ namespace cuda
 template<typename inType, typename outType, bool isLinear>
 Array<outType> histogram(const Array<inType> &in, const unsigned &nbins, const double &minval, const double &maxval);
 
+// Each element adds its weight to its bin. weights has the dimensions of in.
+template<typename inType, typename outType>
+Array<outType> weightedHistogram(const Array<inType> &in, const Array<outType> &weights,
+                                 const unsigned &nbins, const double &minval, const double &maxval);
+
 }
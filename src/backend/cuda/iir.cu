@@ -50,10 +50,18 @@ namespace cuda
         return y;
     }
 
-#define INSTANTIATE(T)                          \
-    template Array<T> iir(const Array<T> &b,    \
-                          const Array<T> &a,    \
-                          const Array<T> &x);   \
+    template<typename T>
+    Array<T> iirSos(const Array<T> &sos, const Array<T> &x)
+    {
+        CUDA_NOT_SUPPORTED();
+    }
+
+#define INSTANTIATE(T)                              \
+    template Array<T> iir(const Array<T> &b,        \
+                          const Array<T> &a,        \
+                          const Array<T> &x);       \
+    template Array<T> iirSos(const Array<T> &sos,   \
+                             const Array<T> &x);    \
 
     INSTANTIATE(float)
     INSTANTIATE(double)
@@ -14,4 +14,7 @@ namespace cuda
 
 template<typename T>
 Array<T> iir(const Array<T> &b, const Array<T> &a, const Array<T> &x);
+
+template<typename T>
+Array<T> iirSos(const Array<T> &sos, const Array<T> &x);
 }
@@ -161,6 +161,11 @@ bool isLAPACKAvailable()
     return true;
 }
 
+bool isLAPACKBatchAvailable()
+{
+    return false;
+}
+
 #define INSTANTIATE_LU(T)                                                                           \
     template Array<int> lu_inplace<T>(Array<T> &in, const bool convert_pivot);                      \
     template void lu<T>(Array<T> &lower, Array<T> &upper, Array<int> &pivot, const Array<T> &in);
@@ -196,6 +201,11 @@ bool isLAPACKAvailable()
     return true;
 }
 
+bool isLAPACKBatchAvailable()
+{
+    return false;
+}
+
 #define INSTANTIATE_LU(T)                                                                           \
     template Array<int> lu_inplace<T>(Array<T> &in, const bool convert_pivot);                      \
     template void lu<T>(Array<T> &lower, Array<T> &upper, Array<int> &pivot, const Array<T> &in);
@@ -228,6 +238,11 @@ bool isLAPACKAvailable()
     return false;
 }
 
+bool isLAPACKBatchAvailable()
+{
+    return false;
+}
+
 #define INSTANTIATE_LU(T)                                                                           \
     template Array<int> lu_inplace<T>(Array<T> &in, const bool convert_pivot);                      \
     template void lu<T>(Array<T> &lower, Array<T> &upper, Array<int> &pivot, const Array<T> &in);
@@ -18,4 +18,8 @@ namespace cuda
     Array<int> lu_inplace(Array<T> &in, const bool convert_pivot = true);
 
     bool isLAPACKAvailable();
+
+    // Whether the linear algebra functions accept batches of matrices along
+    // dimensions 2 and 3
+    bool isLAPACKBatchAvailable();
 }
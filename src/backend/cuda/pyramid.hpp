@@ -0,0 +1,21 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <Array.hpp>
+#include <vector>
+
+namespace cuda
+{
+
+// Gaussian or Laplacian pyramid of levels levels. The levels are views into
+// a single allocation.
+template<typename T>
+std::vector<Array<T> > pyramid(const Array<T> &in, const unsigned levels, const bool laplacian);
+
+}
@@ -0,0 +1,19 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+#pragma once
+#include <Array.hpp>
+#include <ops.hpp>
+
+namespace cuda
+{
+    template<af_op_t op, typename Ti, typename Tk, typename To>
+    void reduce_by_key(Array<Tk> &keys_out, Array<To> &vals_out,
+                       const Array<Tk> &keys, const Array<Ti> &vals,
+                       const int dim, const bool is_sorted);
+}
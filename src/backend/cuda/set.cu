@@ -18,6 +18,11 @@
 #include <thrust/sort.h>
 #include <thrust/unique.h>
 #include <thrust/set_operations.h>
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/sequence.h>
 
 namespace cuda
 {
@@ -104,10 +109,104 @@ namespace cuda
         return out;
     }
 
+    template<typename T>
+    Array<T> setUniqueStable(const Array<T> &in)
+    {
+        Array<T> keys = copyArray<T>(in);
+        Array<T> vals = copyArray<T>(in);
+        Array<uint> idx = createEmptyArray<uint>(dim4(keys.elements()));
+
+        thrust::device_ptr<T> keys_ptr = thrust::device_pointer_cast<T>(keys.get());
+        thrust::device_ptr<T> keys_ptr_end = keys_ptr + keys.elements();
+        thrust::device_ptr<uint> idx_ptr = thrust::device_pointer_cast<uint>(idx.get());
+
+        // The first index of every run of equal keys after a stable sort is
+        // the position of the first occurrence of that key
+        THRUST_SELECT(thrust::sequence, idx_ptr, idx_ptr + idx.elements());
+        THRUST_SELECT(thrust::stable_sort_by_key, keys_ptr, keys_ptr_end, idx_ptr);
+
+        thrust::pair<thrust::device_ptr<T>, thrust::device_ptr<uint> > last;
+        THRUST_SELECT_OUT(last, thrust::unique_by_key, keys_ptr, keys_ptr_end, idx_ptr);
+        dim_t count = thrust::distance(idx_ptr, last.second);
+
+        THRUST_SELECT(thrust::sort, idx_ptr, last.second);
+
+        Array<T> out = createEmptyArray<T>(dim4(count));
+        thrust::device_ptr<T> vals_ptr = thrust::device_pointer_cast<T>(vals.get());
+        thrust::device_ptr<T> out_ptr = thrust::device_pointer_cast<T>(out.get());
+        THRUST_SELECT(thrust::gather, idx_ptr, last.second, vals_ptr, out_ptr);
+
+        return out;
+    }
+
+    template<typename T>
+    Array<T> setUnionStable(const Array<T> &first,
+                            const Array<T> &second)
+    {
+        Array<T> lin_first  = first.isLinear()  ? first  : copyArray<T>(first);
+        Array<T> lin_second = second.isLinear() ? second : copyArray<T>(second);
+        Array<T> both = createEmptyArray<T>(dim4(first.elements() + second.elements()));
+
+        thrust::device_ptr<T> first_ptr = thrust::device_pointer_cast<T>(lin_first.get());
+        thrust::device_ptr<T> second_ptr = thrust::device_pointer_cast<T>(lin_second.get());
+        thrust::device_ptr<T> both_ptr = thrust::device_pointer_cast<T>(both.get());
+
+        THRUST_SELECT(thrust::copy, first_ptr, first_ptr + first.elements(), both_ptr);
+        THRUST_SELECT(thrust::copy, second_ptr, second_ptr + second.elements(),
+                      both_ptr + first.elements());
+
+        return setUniqueStable<T>(both);
+    }
+
+    template<typename T>
+    Array<T> setIntersectStable(const Array<T> &first,
+                                const Array<T> &second)
+    {
+        Array<T> unique_first = setUniqueStable<T>(first);
+        Array<char> mask = setContains<T>(unique_first, second);
+        Array<T> out = createEmptyArray<T>(unique_first.dims());
+
+        thrust::device_ptr<T> first_ptr = thrust::device_pointer_cast<T>(unique_first.get());
+        thrust::device_ptr<T> first_ptr_end = first_ptr + unique_first.elements();
+        thrust::device_ptr<char> mask_ptr = thrust::device_pointer_cast<char>(mask.get());
+        thrust::device_ptr<T> out_ptr = thrust::device_pointer_cast<T>(out.get());
+
+        thrust::device_ptr<T> out_ptr_last;
+        THRUST_SELECT_OUT(out_ptr_last, thrust::copy_if, first_ptr, first_ptr_end,
+                          mask_ptr, out_ptr, thrust::identity<char>());
+
+        out.resetDims(dim4(thrust::distance(out_ptr, out_ptr_last)));
+        return out;
+    }
+
+    template<typename T>
+    Array<char> setContains(const Array<T> &elements,
+                            const Array<T> &set)
+    {
+        Array<T> unique_set = setUnique<T>(set, false);
+        Array<T> lin_elements = elements.isLinear() ? elements : copyArray<T>(elements);
+        Array<char> out = createEmptyArray<char>(elements.dims());
+
+        thrust::device_ptr<T> set_ptr = thrust::device_pointer_cast<T>(unique_set.get());
+        thrust::device_ptr<T> set_ptr_end = set_ptr + unique_set.elements();
+        thrust::device_ptr<T> elem_ptr = thrust::device_pointer_cast<T>(lin_elements.get());
+        thrust::device_ptr<T> elem_ptr_end = elem_ptr + lin_elements.elements();
+        thrust::device_ptr<char> out_ptr = thrust::device_pointer_cast<char>(out.get());
+
+        THRUST_SELECT(thrust::binary_search, set_ptr, set_ptr_end,
+                      elem_ptr, elem_ptr_end, out_ptr);
+
+        return out;
+    }
+
 #define INSTANTIATE(T)                                                  \
     template Array<T> setUnique<T>(const Array<T> &in, const bool is_sorted); \
     template Array<T> setUnion<T>(const Array<T> &first, const Array<T> &second, const bool is_unique); \
     template Array<T> setIntersect<T>(const Array<T> &first, const Array<T> &second, const bool is_unique); \
+    template Array<T> setUniqueStable<T>(const Array<T> &in);           \
+    template Array<T> setUnionStable<T>(const Array<T> &first, const Array<T> &second); \
+    template Array<T> setIntersectStable<T>(const Array<T> &first, const Array<T> &second); \
+    template Array<char> setContains<T>(const Array<T> &elements, const Array<T> &set); \
 
     INSTANTIATE(float)
     INSTANTIATE(double)
@@ -0,0 +1,56 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <solve_iterative.hpp>
+#include <err_cuda.hpp>
+
+namespace cuda
+{
+
+using namespace common;
+
+template<typename T>
+Array<T> solveIterative(const Array<T> &a, const Array<T> &b,
+                        const af_iterative_method method, const af_preconditioner precond,
+                        const double tol, const unsigned maxIter, const unsigned restart,
+                        unsigned &iterations, double &residual)
+{
+    CUDA_NOT_SUPPORTED();
+}
+
+template<typename T>
+Array<T> solveIterative(const SparseArray<T> &a, const Array<T> &b,
+                        const af_iterative_method method, const af_preconditioner precond,
+                        const double tol, const unsigned maxIter, const unsigned restart,
+                        unsigned &iterations, double &residual)
+{
+    CUDA_NOT_SUPPORTED();
+}
+
+#define INSTANTIATE_SOLVE_ITERATIVE(T, A)                                                           \
+    template Array<T> solveIterative<T>(const A &a, const Array<T> &b,                              \
+                                        const af_iterative_method method,                           \
+                                        const af_preconditioner precond,                            \
+                                        const double tol, const unsigned maxIter,                   \
+                                        const unsigned restart,                                     \
+                                        unsigned &iterations, double &residual);                    \
+
+#define INSTANTIATE(T)                                  \
+    INSTANTIATE_SOLVE_ITERATIVE(T, Array<T>)            \
+    INSTANTIATE_SOLVE_ITERATIVE(T, SparseArray<T>)      \
+
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(cfloat)
+INSTANTIATE(cdouble)
+
+#undef INSTANTIATE
+#undef INSTANTIATE_SOLVE_ITERATIVE
+
+}
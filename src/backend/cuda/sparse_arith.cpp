@@ -0,0 +1,48 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <sparse_arith.hpp>
+#include <err_cuda.hpp>
+
+namespace cuda
+{
+
+using namespace common;
+
+template<typename T>
+SparseArray<T> sparseAdd(const SparseArray<T> &lhs, const SparseArray<T> &rhs)
+{
+    CUDA_NOT_SUPPORTED();
+}
+
+template<typename T>
+SparseArray<T> sparseMul(const SparseArray<T> &lhs, const SparseArray<T> &rhs)
+{
+    CUDA_NOT_SUPPORTED();
+}
+
+template<typename T>
+SparseArray<T> sparseMatmul(const SparseArray<T> &lhs, const SparseArray<T> &rhs)
+{
+    CUDA_NOT_SUPPORTED();
+}
+
+#define INSTANTIATE_SPARSE_ARITH(T)                                                         \
+    template SparseArray<T> sparseAdd<T>(const SparseArray<T> &lhs, const SparseArray<T> &rhs);    \
+    template SparseArray<T> sparseMul<T>(const SparseArray<T> &lhs, const SparseArray<T> &rhs);    \
+    template SparseArray<T> sparseMatmul<T>(const SparseArray<T> &lhs, const SparseArray<T> &rhs); \
+
+INSTANTIATE_SPARSE_ARITH(float)
+INSTANTIATE_SPARSE_ARITH(double)
+INSTANTIATE_SPARSE_ARITH(cfloat)
+INSTANTIATE_SPARSE_ARITH(cdouble)
+
+#undef INSTANTIATE_SPARSE_ARITH
+
+}
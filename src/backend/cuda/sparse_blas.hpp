@@ -17,5 +17,22 @@ template<typename T>
 Array<T> matmul(const common::SparseArray<T> lhs, const Array<T> rhs,
                 af_mat_prop optLhs, af_mat_prop optRhs);
 
+// A CSR matrix and the op applied to it, prepared for repeated products with
+// dense matrices of about ncols columns. Nothing is cached on this backend yet,
+// every product runs the same as matmul.
+template<typename T>
+class SparseOperator
+{
+    common::SparseArray<T> lhs;
+    af_mat_prop optLhs;
+
+  public:
+    SparseOperator(const common::SparseArray<T> &lhs, const af_mat_prop optLhs,
+                   const dim_t ncols);
+
+    // op(lhs) * rhs
+    Array<T> matmul(const Array<T> &rhs) const;
+};
+
 }
 
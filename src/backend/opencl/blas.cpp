@@ -9,6 +9,7 @@
 
 #include <blas.hpp>
 #include <Array.hpp>
+#include <algorithm>
 #include <cassert>
 #include <string>
 #include <functional>
@@ -21,6 +22,9 @@
 #include <arith.hpp>
 #include <reduce.hpp>
 #include <complex.hpp>
+#include <tile.hpp>
+#include <unary.hpp>
+#include <type_traits>
 
 #if defined(WITH_OPENCL_LINEAR_ALGEBRA)
 #include <cpu/cpu_blas.hpp>
@@ -139,15 +143,19 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
     int N = rDims[bColDim];
     int K = lDims[aColDim];
 
+    dim_t batch2 = std::max(lDims[2], rDims[2]);
+    dim_t batch3 = std::max(lDims[3], rDims[3]);
+
     //FIXME: Leaks on errors.
-    Array<T> out = createEmptyArray<T>(af::dim4(M, N, 1, 1));
+    Array<T> out = createEmptyArray<T>(af::dim4(M, N, batch2, batch3));
     auto alpha = scalar<T>(1);
     auto beta  = scalar<T>(0);
 
     dim4 lStrides = lhs.strides();
     dim4 rStrides = rhs.strides();
+    dim4 oStrides = out.strides();
     cl::Event event;
-    if(rDims[bColDim] == 1) {
+    if(rDims[bColDim] == 1 && batch2 * batch3 == 1) {
         N = lDims[aColDim];
         gemv_func<T> gemv;
         CLBLAS_CHECK(
@@ -162,24 +170,113 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
                 1, &getQueue()(), 0, nullptr, &event())
             );
     } else {
+        // One gemm per matrix of the batch. Dimensions of size 1 are
+        // broadcast against the other side.
         gemm_func<T> gemm;
-        CLBLAS_CHECK(
-            gemm(
-                clblasColumnMajor, lOpts, rOpts,
-                M, N, K,
-                alpha,
-                (*lhs.get())(),    lhs.getOffset(),   lStrides[1],
-                (*rhs.get())(),    rhs.getOffset(),   rStrides[1],
-                beta,
-                (*out.get())(),   out.getOffset(),  out.dims()[0],
-                1, &getQueue()(), 0, nullptr, &event())
-            );
-
+        for (dim_t b3 = 0; b3 < batch3; b3++) {
+            for (dim_t b2 = 0; b2 < batch2; b2++) {
+                dim_t lOff = (lDims[2] == 1 ? 0 : b2 * lStrides[2]) +
+                             (lDims[3] == 1 ? 0 : b3 * lStrides[3]);
+                dim_t rOff = (rDims[2] == 1 ? 0 : b2 * rStrides[2]) +
+                             (rDims[3] == 1 ? 0 : b3 * rStrides[3]);
+                dim_t oOff = b2 * oStrides[2] + b3 * oStrides[3];
+                CLBLAS_CHECK(
+                    gemm(
+                        clblasColumnMajor, lOpts, rOpts,
+                        M, N, K,
+                        alpha,
+                        (*lhs.get())(),    lhs.getOffset() + lOff,   lStrides[1],
+                        (*rhs.get())(),    rhs.getOffset() + rOff,   rStrides[1],
+                        beta,
+                        (*out.get())(),   out.getOffset() + oOff,  out.dims()[0],
+                        1, &getQueue()(), 0, nullptr, &event())
+                    );
+            }
+        }
     }
 
     return out;
 }
 
+// Activations are only defined for real types
+template<typename T>
+typename std::enable_if<!is_complex<T>::value, Array<T>>::type
+activation(const Array<T> &in, af_activation act)
+{
+    switch (act) {
+    case AF_ACTIVATION_RELU:
+        return arithOp<T, af_max_t>(in, createValueArray<T>(in.dims(), scalar<T>(0)), in.dims());
+    case AF_ACTIVATION_SIGMOID:
+        return unaryOp<T, af_sigmoid_t>(in);
+    case AF_ACTIVATION_TANH:
+        return unaryOp<T, af_tanh_t>(in);
+    default:
+        return in;
+    }
+}
+
+template<typename T>
+typename std::enable_if<is_complex<T>::value, Array<T>>::type
+activation(const Array<T> &in, af_activation act)
+{
+    return in;
+}
+
+template<typename T>
+void gemm(Array<T> &out, af_mat_prop optLhs, af_mat_prop optRhs,
+          const T *alpha, const Array<T> &lhs, const Array<T> &rhs, const T *beta,
+          const Array<T> *bias, af_activation act)
+{
+    initBlas();
+    clblasTranspose lOpts = toClblasTranspose(optLhs);
+    clblasTranspose rOpts = toClblasTranspose(optRhs);
+
+    dim4 lDims = lhs.dims();
+    dim4 rDims = rhs.dims();
+    dim4 oDims = out.dims();
+    int M = oDims[0];
+    int N = oDims[1];
+    int K = lDims[optLhs == AF_MAT_NONE ? 1 : 0];
+
+    dim4 lStrides = lhs.strides();
+    dim4 rStrides = rhs.strides();
+    dim4 oStrides = out.strides();
+    cl::Event event;
+    gemm_func<T> gemm;
+    for (dim_t b3 = 0; b3 < oDims[3]; b3++) {
+        for (dim_t b2 = 0; b2 < oDims[2]; b2++) {
+            dim_t lOff = (lDims[2] == 1 ? 0 : b2 * lStrides[2]) +
+                         (lDims[3] == 1 ? 0 : b3 * lStrides[3]);
+            dim_t rOff = (rDims[2] == 1 ? 0 : b2 * rStrides[2]) +
+                         (rDims[3] == 1 ? 0 : b3 * rStrides[3]);
+            dim_t oOff = b2 * oStrides[2] + b3 * oStrides[3];
+            CLBLAS_CHECK(
+                gemm(
+                    clblasColumnMajor, lOpts, rOpts,
+                    M, N, K,
+                    *alpha,
+                    (*lhs.get())(),    lhs.getOffset() + lOff,   lStrides[1],
+                    (*rhs.get())(),    rhs.getOffset() + rOff,   rStrides[1],
+                    *beta,
+                    (*out.get())(),   out.getOffset() + oOff,  oDims[0],
+                    1, &getQueue()(), 0, nullptr, &event())
+                );
+        }
+    }
+
+    // The epilogue is applied with the JIT after the product
+    if (bias) {
+        dim4 tileDims(bias->dims()[0] == M ? 1 : M,
+                      bias->dims()[0] == M ? N : 1,
+                      oDims[2], oDims[3]);
+        out = arithOp<T, af_add_t>(out, tile<T>(*bias, tileDims), oDims);
+    }
+    if (act != AF_ACTIVATION_NONE) {
+        out = activation<T>(out, act);
+    }
+    out.eval();
+}
+
 template<typename T>
 Array<T> dot(const Array<T> &lhs, const Array<T> &rhs,
              af_mat_prop optLhs, af_mat_prop optRhs)
@@ -193,7 +290,12 @@ Array<T> dot(const Array<T> &lhs, const Array<T> &rhs,
 
 #define INSTANTIATE_BLAS(TYPE)                                                          \
     template Array<TYPE> matmul<TYPE>(const Array<TYPE> &lhs, const Array<TYPE> &rhs,   \
-                    af_mat_prop optLhs, af_mat_prop optRhs);
+                    af_mat_prop optLhs, af_mat_prop optRhs);                            \
+    template void gemm<TYPE>(Array<TYPE> &out, af_mat_prop optLhs, af_mat_prop optRhs,  \
+                             const TYPE *alpha,                                         \
+                             const Array<TYPE> &lhs, const Array<TYPE> &rhs,            \
+                             const TYPE *beta,                                          \
+                             const Array<TYPE> *bias, af_activation act);
 
 INSTANTIATE_BLAS(float)
 INSTANTIATE_BLAS(cfloat)
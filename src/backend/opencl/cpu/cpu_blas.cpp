@@ -11,6 +11,7 @@
 #include <cpu/cpu_helper.hpp>
 #include <cpu/cpu_blas.hpp>
 #include <math.hpp>
+#include <algorithm>
 
 namespace opencl
 {
@@ -158,13 +159,17 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
     int N = rDims[bColDim];
     int K = lDims[aColDim];
 
+    dim_t batch2 = std::max(lDims[2], rDims[2]);
+    dim_t batch3 = std::max(lDims[3], rDims[3]);
+
     //FIXME: Leaks on errors.
-    Array<T> out = createValueArray<T>(af::dim4(M, N, 1, 1), scalar<T>(0));
+    Array<T> out = createValueArray<T>(af::dim4(M, N, batch2, batch3), scalar<T>(0));
     auto alpha = getScale<T, 1>();
     auto beta  = getScale<T, 0>();
 
     dim4 lStrides = lhs.strides();
     dim4 rStrides = rhs.strides();
+    dim4 oStrides = out.strides();
     using BT  =       typename blas_base<T>::type;
 
     // get host pointers from mapped memory
@@ -172,7 +177,7 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
     auto rPtr = rhs.getMappedPtr();
     auto oPtr = out.getMappedPtr();
 
-    if(rDims[bColDim] == 1) {
+    if(rDims[bColDim] == 1 && batch2 * batch3 == 1) {
         N = lDims[aColDim];
         gemv_func<T>()(
             CblasColMajor, lOpts,
@@ -183,14 +188,25 @@ Array<T> matmul(const Array<T> &lhs, const Array<T> &rhs,
             beta,
             (BT*)oPtr.get(), 1);
     } else {
-        gemm_func<T>()(
-            CblasColMajor, lOpts, rOpts,
-            M, N, K,
-            alpha,
-            (BT*)lPtr.get(), lStrides[1],
-            (BT*)rPtr.get(), rStrides[1],
-            beta,
-            (BT*)oPtr.get(), out.dims()[0]);
+        // One gemm per matrix of the batch. Dimensions of size 1 are
+        // broadcast against the other side.
+        for (dim_t b3 = 0; b3 < batch3; b3++) {
+            for (dim_t b2 = 0; b2 < batch2; b2++) {
+                dim_t lOff = (lDims[2] == 1 ? 0 : b2 * lStrides[2]) +
+                             (lDims[3] == 1 ? 0 : b3 * lStrides[3]);
+                dim_t rOff = (rDims[2] == 1 ? 0 : b2 * rStrides[2]) +
+                             (rDims[3] == 1 ? 0 : b3 * rStrides[3]);
+                dim_t oOff = b2 * oStrides[2] + b3 * oStrides[3];
+                gemm_func<T>()(
+                    CblasColMajor, lOpts, rOpts,
+                    M, N, K,
+                    alpha,
+                    (BT*)(lPtr.get() + lOff), lStrides[1],
+                    (BT*)(rPtr.get() + rOff), rStrides[1],
+                    beta,
+                    (BT*)(oPtr.get() + oOff), out.dims()[0]);
+            }
+        }
     }
 
     return out;
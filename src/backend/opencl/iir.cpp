@@ -55,10 +55,18 @@ namespace opencl
         }
     }
 
-#define INSTANTIATE(T)                          \
-    template Array<T> iir(const Array<T> &b,    \
-                          const Array<T> &a,    \
-                          const Array<T> &x);   \
+    template<typename T>
+    Array<T> iirSos(const Array<T> &sos, const Array<T> &x)
+    {
+        OPENCL_NOT_SUPPORTED();
+    }
+
+#define INSTANTIATE(T)                              \
+    template Array<T> iir(const Array<T> &b,        \
+                          const Array<T> &a,        \
+                          const Array<T> &x);       \
+    template Array<T> iirSos(const Array<T> &sos,   \
+                             const Array<T> &x);    \
 
     INSTANTIATE(float)
     INSTANTIATE(double)
@@ -102,6 +102,11 @@ bool isLAPACKAvailable()
     return true;
 }
 
+bool isLAPACKBatchAvailable()
+{
+    return false;
+}
+
 #define INSTANTIATE_LU(T)                                                                           \
     template Array<int> lu_inplace<T>(Array<T> &in, const bool convert_pivot);                      \
     template void lu<T>(Array<T> &lower, Array<T> &upper, Array<int> &pivot, const Array<T> &in);
@@ -135,6 +140,11 @@ bool isLAPACKAvailable()
     return false;
 }
 
+bool isLAPACKBatchAvailable()
+{
+    return false;
+}
+
 #define INSTANTIATE_LU(T)                                                                           \
     template Array<int> lu_inplace<T>(Array<T> &in, const bool convert_pivot);                      \
     template void lu<T>(Array<T> &lower, Array<T> &upper, Array<int> &pivot, const Array<T> &in);
@@ -0,0 +1,29 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <Array.hpp>
+#include <pyramid.hpp>
+#include <err_opencl.hpp>
+
+namespace opencl
+{
+
+template<typename T>
+std::vector<Array<T> > pyramid(const Array<T> &in, const unsigned levels, const bool laplacian)
+{
+    OPENCL_NOT_SUPPORTED();
+}
+
+#define INSTANTIATE(T)\
+template std::vector<Array<T> > pyramid<T>(const Array<T> &in, const unsigned levels, const bool laplacian);
+
+INSTANTIATE(float )
+INSTANTIATE(double)
+
+}
@@ -0,0 +1,66 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <af/dim4.hpp>
+#include <Array.hpp>
+#include <reduce_by_key.hpp>
+#include <ops.hpp>
+#include <err_opencl.hpp>
+
+namespace opencl
+{
+
+template<af_op_t op, typename Ti, typename Tk, typename To>
+void reduce_by_key(Array<Tk> &keys_out, Array<To> &vals_out,
+                   const Array<Tk> &keys, const Array<Ti> &vals,
+                   const int dim, const bool is_sorted)
+{
+    OPENCL_NOT_SUPPORTED();
+}
+
+#define INSTANTIATE(ROp, Ti, Tk, To)                                        \
+    template void reduce_by_key<ROp, Ti, Tk, To>(Array<Tk> &keys_out,       \
+                                                 Array<To> &vals_out,       \
+                                                 const Array<Tk> &keys,     \
+                                                 const Array<Ti> &vals,     \
+                                                 const int dim,             \
+                                                 const bool is_sorted);
+
+#define INSTANTIATE_KEYS(ROp, Ti, To)   \
+    INSTANTIATE(ROp, Ti, int  , To)     \
+    INSTANTIATE(ROp, Ti, uint , To)     \
+    INSTANTIATE(ROp, Ti, intl , To)     \
+    INSTANTIATE(ROp, Ti, uintl, To)
+
+#define INSTANTIATE_ALL(ROp)                        \
+    INSTANTIATE_KEYS(ROp, float  , float  )         \
+    INSTANTIATE_KEYS(ROp, double , double )         \
+    INSTANTIATE_KEYS(ROp, cfloat , cfloat )         \
+    INSTANTIATE_KEYS(ROp, cdouble, cdouble)         \
+    INSTANTIATE_KEYS(ROp, int    , int    )         \
+    INSTANTIATE_KEYS(ROp, uint   , uint   )         \
+    INSTANTIATE_KEYS(ROp, intl   , intl   )         \
+    INSTANTIATE_KEYS(ROp, uintl  , uintl  )
+
+#define INSTANTIATE_COUNT(Ti) INSTANTIATE_KEYS(af_notzero_t, Ti, uint)
+
+    INSTANTIATE_ALL(af_add_t)
+    INSTANTIATE_ALL(af_mul_t)
+    INSTANTIATE_ALL(af_min_t)
+    INSTANTIATE_ALL(af_max_t)
+
+    INSTANTIATE_COUNT(float  )
+    INSTANTIATE_COUNT(double )
+    INSTANTIATE_COUNT(cfloat )
+    INSTANTIATE_COUNT(cdouble)
+    INSTANTIATE_COUNT(int    )
+    INSTANTIATE_COUNT(uint   )
+    INSTANTIATE_COUNT(intl   )
+    INSTANTIATE_COUNT(uintl  )
+}
@@ -13,6 +13,8 @@
 #include <copy.hpp>
 #include <sort.hpp>
 #include <err_opencl.hpp>
+#include <unordered_set>
+#include <vector>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
@@ -148,10 +150,88 @@ namespace opencl
         }
     }
 
+    // The order preserving variants and the membership query are computed on
+    // the host. Boost.Compute does not provide a vectorized binary search or
+    // unique by key which are needed to do these on the device.
+    template<typename T>
+    Array<T> setUniqueStable(const Array<T> &in)
+    {
+        std::vector<T> h_in(in.elements());
+        copyData(h_in.data(), in);
+
+        std::unordered_set<T> seen;
+        std::vector<T> h_out;
+        for (size_t i = 0; i < h_in.size(); ++i) {
+            if (seen.insert(h_in[i]).second) h_out.push_back(h_in[i]);
+        }
+
+        return createHostDataArray<T>(dim4(h_out.size()), h_out.data());
+    }
+
+    template<typename T>
+    Array<T> setUnionStable(const Array<T> &first,
+                            const Array<T> &second)
+    {
+        std::vector<T> h_in(first.elements() + second.elements());
+        copyData(h_in.data(), first);
+        copyData(h_in.data() + first.elements(), second);
+
+        std::unordered_set<T> seen;
+        std::vector<T> h_out;
+        for (size_t i = 0; i < h_in.size(); ++i) {
+            if (seen.insert(h_in[i]).second) h_out.push_back(h_in[i]);
+        }
+
+        return createHostDataArray<T>(dim4(h_out.size()), h_out.data());
+    }
+
+    template<typename T>
+    Array<T> setIntersectStable(const Array<T> &first,
+                                const Array<T> &second)
+    {
+        std::vector<T> h_first(first.elements());
+        std::vector<T> h_second(second.elements());
+        copyData(h_first.data(), first);
+        copyData(h_second.data(), second);
+
+        std::unordered_set<T> lookup(h_second.begin(), h_second.end());
+        std::unordered_set<T> seen;
+        std::vector<T> h_out;
+        for (size_t i = 0; i < h_first.size(); ++i) {
+            if (lookup.count(h_first[i]) && seen.insert(h_first[i]).second) {
+                h_out.push_back(h_first[i]);
+            }
+        }
+
+        return createHostDataArray<T>(dim4(h_out.size()), h_out.data());
+    }
+
+    template<typename T>
+    Array<char> setContains(const Array<T> &elements,
+                            const Array<T> &set)
+    {
+        std::vector<T> h_elements(elements.elements());
+        std::vector<T> h_set(set.elements());
+        copyData(h_elements.data(), elements);
+        copyData(h_set.data(), set);
+
+        std::unordered_set<T> lookup(h_set.begin(), h_set.end());
+        std::vector<char> h_out(h_elements.size());
+        for (size_t i = 0; i < h_elements.size(); ++i) {
+            h_out[i] = lookup.count(h_elements[i]) > 0;
+        }
+
+        return createHostDataArray<char>(elements.dims(), h_out.data());
+    }
+
 #define INSTANTIATE(T)                                                  \
     template Array<T> setUnique<T>(const Array<T> &in, const bool is_sorted); \
     template Array<T> setUnion<T>(const Array<T> &first, const Array<T> &second, const bool is_unique); \
     template Array<T> setIntersect<T>(const Array<T> &first, const Array<T> &second, const bool is_unique); \
+    template Array<T> setUniqueStable<T>(const Array<T> &in);           \
+    template Array<T> setUnionStable<T>(const Array<T> &first, const Array<T> &second); \
+    template Array<T> setIntersectStable<T>(const Array<T> &first, const Array<T> &second); \
+    template Array<char> setContains<T>(const Array<T> &elements, const Array<T> &set); \
 
     INSTANTIATE(float)
     INSTANTIATE(double)
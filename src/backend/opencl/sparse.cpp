@@ -18,6 +18,7 @@
 #include <complex.hpp>
 #include <copy.hpp>
 #include <err_common.hpp>
+#include <err_opencl.hpp>
 #include <lookup.hpp>
 #include <math.hpp>
 #include <platform.hpp>
@@ -137,6 +138,21 @@ SparseArray<T> sparseConvertStorageToStorage(const SparseArray<T> &in)
 }
 
 
+// BSR and SELL-C-sigma storages are only available in the CPU backend
+template<typename T>
+SparseArray<T> sparseConvertBlocked(const SparseArray<T> &in)
+{
+    OPENCL_NOT_SUPPORTED();
+}
+
+template<typename T>
+SparseArray<T> sparseAssemble(const af::dim4 &dims, const Array<T> &values,
+                              const Array<int> &rowIdx, const Array<int> &colIdx,
+                              const af_sparse_duplicates dups)
+{
+    OPENCL_NOT_SUPPORTED();
+}
+
 #define INSTANTIATE_TO_STORAGE(T, S)                                                                        \
     template SparseArray<T> sparseConvertStorageToStorage<T, S, AF_STORAGE_CSR>(const SparseArray<T> &in);  \
     template SparseArray<T> sparseConvertStorageToStorage<T, S, AF_STORAGE_CSC>(const SparseArray<T> &in);  \
@@ -148,7 +164,25 @@ SparseArray<T> sparseConvertStorageToStorage(const SparseArray<T> &in)
     template<> Array<T> sparseConvertStorageToDense<T, AF_STORAGE_COO>(const SparseArray<T> &in)        \
     { return sparseConvertCOOToDense<T>(in); }                                                          \
 
+#define INSTANTIATE_BLOCKED_SPECIAL(T)                                                                  \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_BSR, AF_STORAGE_CSR>(const SparseArray<T> &in)          \
+    { return sparseConvertBlocked<T>(in); }                                                             \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_BSR>(const SparseArray<T> &in)          \
+    { return sparseConvertBlocked<T>(in); }                                                             \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_SELL, AF_STORAGE_CSR>(const SparseArray<T> &in)         \
+    { return sparseConvertBlocked<T>(in); }                                                             \
+    template<> SparseArray<T>                                                                           \
+    sparseConvertStorageToStorage<T, AF_STORAGE_CSR, AF_STORAGE_SELL>(const SparseArray<T> &in)         \
+    { return sparseConvertBlocked<T>(in); }                                                             \
+
 #define INSTANTIATE_SPARSE(T)                                                                           \
+    template SparseArray<T> sparseAssemble<T>(const af::dim4 &dims, const Array<T> &values,             \
+                                              const Array<int> &rowIdx, const Array<int> &colIdx,       \
+                                              const af_sparse_duplicates dups);                         \
+                                                                                                        \
     template SparseArray<T> sparseConvertDenseToStorage<T, AF_STORAGE_CSR>(const Array<T> &in);         \
     template SparseArray<T> sparseConvertDenseToStorage<T, AF_STORAGE_CSC>(const Array<T> &in);         \
                                                                                                         \
@@ -156,6 +190,7 @@ SparseArray<T> sparseConvertStorageToStorage(const SparseArray<T> &in)
     template Array<T> sparseConvertStorageToDense<T, AF_STORAGE_CSC>(const SparseArray<T> &in);         \
                                                                                                         \
     INSTANTIATE_COO_SPECIAL(T)                                                                          \
+    INSTANTIATE_BLOCKED_SPECIAL(T)                                                                      \
                                                                                                         \
     INSTANTIATE_TO_STORAGE(T, AF_STORAGE_CSR)                                                           \
     INSTANTIATE_TO_STORAGE(T, AF_STORAGE_CSC)                                                           \
@@ -169,6 +204,7 @@ INSTANTIATE_SPARSE(cdouble)
 
 #undef INSTANTIATE_TO_STORAGE
 #undef INSTANTIATE_COO_SPECIAL
+#undef INSTANTIATE_BLOCKED_SPECIAL
 #undef INSTANTIATE_SPARSE
 
 }
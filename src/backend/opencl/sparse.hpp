@@ -22,4 +22,11 @@ Array<T> sparseConvertStorageToDense(const common::SparseArray<T> &in);
 template<typename T, af_storage src, af_storage dest>
 common::SparseArray<T> sparseConvertStorageToStorage(const common::SparseArray<T> &in);
 
+// CSR matrix of size dims from the triplets (rowIdx, colIdx, values) given in
+// any order. dups tells how values sharing a position are combined.
+template<typename T>
+common::SparseArray<T> sparseAssemble(const af::dim4 &dims, const Array<T> &values,
+                                      const Array<int> &rowIdx, const Array<int> &colIdx,
+                                      const af_sparse_duplicates dups);
+
 }
@@ -0,0 +1,32 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <Array.hpp>
+#include <SparseArray.hpp>
+#include <sparse.hpp>
+
+namespace opencl
+{
+
+// lhs + rhs over the union of the patterns of two CSR matrices
+template<typename T>
+common::SparseArray<T> sparseAdd(const common::SparseArray<T> &lhs,
+                                 const common::SparseArray<T> &rhs);
+
+// lhs .* rhs over the intersection of the patterns of two CSR matrices
+template<typename T>
+common::SparseArray<T> sparseMul(const common::SparseArray<T> &lhs,
+                                 const common::SparseArray<T> &rhs);
+
+// lhs * rhs for two CSR matrices
+template<typename T>
+common::SparseArray<T> sparseMatmul(const common::SparseArray<T> &lhs,
+                                    const common::SparseArray<T> &rhs);
+
+}
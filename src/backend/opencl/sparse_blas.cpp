@@ -82,9 +82,23 @@ Array<T> matmul(const common::SparseArray<T> lhs, const Array<T> rhsIn,
     return out;
 }
 
+template<typename T>
+SparseOperator<T>::SparseOperator(const common::SparseArray<T> &lhs, const af_mat_prop optLhs,
+                                  const dim_t ncols)
+    : lhs(lhs), optLhs(optLhs)
+{
+}
+
+template<typename T>
+Array<T> SparseOperator<T>::matmul(const Array<T> &rhs) const
+{
+    return opencl::matmul<T>(lhs, rhs, optLhs, AF_MAT_NONE);
+}
+
 #define INSTANTIATE_SPARSE(T)                                                           \
     template Array<T> matmul<T>(const common::SparseArray<T> lhs, const Array<T> rhs,   \
                                 af_mat_prop optLhs, af_mat_prop optRhs);                \
+    template class SparseOperator<T>;                                                   \
 
 
 INSTANTIATE_SPARSE(float)
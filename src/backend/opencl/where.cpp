@@ -13,6 +13,10 @@
 #include <where.hpp>
 #include <complex>
 #include <kernel/where.hpp>
+#include <copy.hpp>
+#include <lookup.hpp>
+
+using af::dim4;
 
 namespace opencl
 {
@@ -26,8 +30,28 @@ namespace opencl
     }
 
 
-#define INSTANTIATE(T)                                  \
-    template Array<uint> where<T>(const Array<T> &in);  \
+    template<typename T>
+    Array<T> compact(const Array<T> &in, const Array<char> &mask)
+    {
+        Array<uint> idx = where<char>(mask);
+
+        const bool byElement = mask.elements() == in.elements();
+
+        dim4 odims = byElement ? dim4(idx.elements()) : in.dims();
+        odims[0] = idx.elements();
+        if (idx.elements() == 0) return createEmptyArray<T>(odims);
+
+        if (byElement) {
+            Array<T> flat = in.isLinear() ? in : copyArray<T>(in);
+            flat.modDims(dim4(in.elements()));
+            return lookup<T, uint>(flat, idx, 0);
+        }
+        return lookup<T, uint>(in, idx, 0);
+    }
+
+#define INSTANTIATE(T)                                                          \
+    template Array<uint> where<T>(const Array<T> &in);                          \
+    template Array<T> compact<T>(const Array<T> &in, const Array<char> &mask);  \
 
     INSTANTIATE(float  )
     INSTANTIATE(cfloat )
@@ -203,3 +203,39 @@ TEST(bilateral, GFOR)
         ASSERT_EQ(max<double>(abs(c_ii - b_ii)) < 1E-5, true);
     }
 }
+
+TEST(Bilateral, GridMatchesExact)
+{
+    using namespace af;
+
+    if (noCPUOnlyTests()) return;
+
+    // A noisy step, which the filter smooths on both sides but keeps
+    array x   = range(dim4(200, 150), 0) / 200.f;
+    array y   = range(dim4(200, 150), 1) / 150.f;
+    array img = 0.5f * (x > 0.5f).as(f32) + 0.3f * y + 0.05f * randn(200, 150);
+
+    array exact = bilateral(img, 4, 0.1f);
+    array grid  = bilateralGrid(img, 4, 0.1f);
+    ASSERT_EQ(img.dims(), grid.dims());
+    ASSERT_EQ(f32, grid.type());
+
+    float smoothing = std::sqrt(mean<float>((img - exact) * (img - exact)));
+    float error     = std::sqrt(mean<float>((grid - exact) * (grid - exact)));
+    ASSERT_LT(error, 0.1f * smoothing);
+}
+
+TEST(Bilateral, GridInvalidArgs)
+{
+    if (noCPUOnlyTests()) return;
+
+    af_array inArray  = 0;
+    af_array outArray = 0;
+    vector<float> in(100, 1);
+    dim4 dims(10, 10);
+
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&inArray, &in.front(), dims.ndims(), dims.get(), f32));
+    ASSERT_EQ(AF_ERR_ARG, af_bilateral_grid(&outArray, inArray, 0.f, 0.1f, false));
+    ASSERT_EQ(AF_ERR_ARG, af_bilateral_grid(&outArray, inArray, 2.f, 0.f, false));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(inArray));
+}
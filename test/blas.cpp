@@ -245,3 +245,252 @@ TYPED_TEST(MatrixMultiply, MultiGPURectangleVector_CPP)
 }
 
 #undef DEVICE_ITERATE
+
+static inline float  hostConj(float  x) { return x; }
+static inline double hostConj(double x) { return x; }
+static inline af::cfloat  hostConj(af::cfloat  x) { return af::conj(x); }
+static inline af::cdouble hostConj(af::cdouble x) { return af::conj(x); }
+
+static inline double hostAbs(float  x) { return std::abs(x); }
+static inline double hostAbs(double x) { return std::abs(x); }
+static inline double hostAbs(af::cfloat  x) { return af::abs(x); }
+static inline double hostAbs(af::cdouble x) { return af::abs(x); }
+
+// Element (i, j) of op(A) where A is column major with ld rows
+template<typename T>
+static T hostOpElement(const T *A, dim_t ld, dim_t i, dim_t j, af::matProp opt)
+{
+    switch (opt) {
+    case AF_MAT_TRANS:  return A[j + i * ld];
+    case AF_MAT_CTRANS: return hostConj(A[j + i * ld]);
+    default:            return A[i + j * ld];
+    }
+}
+
+template<typename T>
+void batchedMatMulCheck(const af::dim4 &ldims, const af::dim4 &rdims,
+                        af::matProp optLhs, af::matProp optRhs)
+{
+    if (noDoubleTests<T>()) return;
+
+    af::dtype ty = (af::dtype)af::dtype_traits<T>::af_type;
+    af::array a = af::randu(ldims, ty);
+    af::array b = af::randu(rdims, ty);
+
+    af::array c = af::matmul(a, b, optLhs, optRhs);
+
+    const dim_t M = optLhs == AF_MAT_NONE ? ldims[0] : ldims[1];
+    const dim_t K = optLhs == AF_MAT_NONE ? ldims[1] : ldims[0];
+    const dim_t N = optRhs == AF_MAT_NONE ? rdims[1] : rdims[0];
+    const dim_t batch2 = std::max(ldims[2], rdims[2]);
+    const dim_t batch3 = std::max(ldims[3], rdims[3]);
+    ASSERT_EQ(af::dim4(M, N, batch2, batch3), c.dims());
+
+    vector<T> ha(a.elements()), hb(b.elements()), hc(c.elements());
+    a.host(&ha.front());
+    b.host(&hb.front());
+    c.host(&hc.front());
+
+    const dim_t lsize = ldims[0] * ldims[1];
+    const dim_t rsize = rdims[0] * rdims[1];
+
+    for (dim_t j = 0; j < batch3; j++) {
+        for (dim_t i = 0; i < batch2; i++) {
+            const T *pa = &ha.front() + lsize * ((ldims[2] == 1 ? 0 : i) + (ldims[3] == 1 ? 0 : j) * ldims[2]);
+            const T *pb = &hb.front() + rsize * ((rdims[2] == 1 ? 0 : i) + (rdims[3] == 1 ? 0 : j) * rdims[2]);
+            const T *pc = &hc.front() + M * N * (i + j * batch2);
+            for (dim_t n = 0; n < N; n++) {
+                for (dim_t m = 0; m < M; m++) {
+                    T gold = T(0);
+                    for (dim_t k = 0; k < K; k++) {
+                        gold = gold + hostOpElement(pa, ldims[0], m, k, optLhs) *
+                                      hostOpElement(pb, rdims[0], k, n, optRhs);
+                    }
+                    ASSERT_NEAR(0, hostAbs(pc[m + n * M] - gold), 1e-4 * K)
+                        << "at (" << m << ", " << n << ", " << i << ", " << j << ")";
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST(MatrixMultiply, BatchedSmall)
+{
+    batchedMatMulCheck<TypeParam>(af::dim4(16, 8, 10, 3), af::dim4(8, 12, 10, 3),
+                                  AF_MAT_NONE, AF_MAT_NONE);
+}
+
+TYPED_TEST(MatrixMultiply, BatchedSmallTrans)
+{
+    batchedMatMulCheck<TypeParam>(af::dim4(8, 16, 20), af::dim4(12, 8, 20),
+                                  AF_MAT_TRANS, AF_MAT_TRANS);
+    batchedMatMulCheck<TypeParam>(af::dim4(8, 16, 20), af::dim4(8, 12, 20),
+                                  AF_MAT_CTRANS, AF_MAT_NONE);
+    batchedMatMulCheck<TypeParam>(af::dim4(16, 8, 20), af::dim4(12, 8, 20),
+                                  AF_MAT_NONE, AF_MAT_CTRANS);
+}
+
+TYPED_TEST(MatrixMultiply, BatchedLarge)
+{
+    batchedMatMulCheck<TypeParam>(af::dim4(64, 48, 6), af::dim4(48, 40, 6),
+                                  AF_MAT_NONE, AF_MAT_NONE);
+    batchedMatMulCheck<TypeParam>(af::dim4(48, 64, 2, 3), af::dim4(40, 48, 2, 3),
+                                  AF_MAT_TRANS, AF_MAT_TRANS);
+}
+
+TYPED_TEST(MatrixMultiply, BatchedVector)
+{
+    batchedMatMulCheck<TypeParam>(af::dim4(40, 36, 5), af::dim4(36, 1, 5),
+                                  AF_MAT_NONE, AF_MAT_NONE);
+}
+
+TYPED_TEST(MatrixMultiply, BatchedBroadcast)
+{
+    batchedMatMulCheck<TypeParam>(af::dim4(16, 16), af::dim4(16, 16, 7, 2),
+                                  AF_MAT_NONE, AF_MAT_NONE);
+    batchedMatMulCheck<TypeParam>(af::dim4(40, 36, 3, 1), af::dim4(36, 50, 1, 4),
+                                  AF_MAT_NONE, AF_MAT_NONE);
+}
+
+TEST(MatrixMultiply, BatchedMismatch)
+{
+    af::array a = af::randu(4, 4, 3);
+    af::array b = af::randu(4, 4, 2);
+    af_array out = 0;
+    ASSERT_EQ(AF_ERR_BATCH, af_matmul(&out, a.get(), b.get(), AF_MAT_NONE, AF_MAT_NONE));
+}
+
+TYPED_TEST(MatrixMultiply, SmallFixedSizes)
+{
+    const int sizes[] = {2, 3, 4, 8, 16, 32};
+    for (int s = 0; s < 6; s++) {
+        const int n = sizes[s];
+        batchedMatMulCheck<TypeParam>(af::dim4(n, n), af::dim4(n, n),
+                                      AF_MAT_NONE, AF_MAT_NONE);
+        batchedMatMulCheck<TypeParam>(af::dim4(n, n, 50), af::dim4(n, n, 50),
+                                      AF_MAT_TRANS, AF_MAT_CTRANS);
+        batchedMatMulCheck<TypeParam>(af::dim4(n, n), af::dim4(n, 1, 40),
+                                      AF_MAT_CTRANS, AF_MAT_NONE);
+    }
+}
+
+TYPED_TEST(MatrixMultiply, SmallGeneric)
+{
+    batchedMatMulCheck<TypeParam>(af::dim4(5, 7), af::dim4(7, 3),
+                                  AF_MAT_NONE, AF_MAT_NONE);
+    batchedMatMulCheck<TypeParam>(af::dim4(7, 5), af::dim4(3, 7),
+                                  AF_MAT_TRANS, AF_MAT_TRANS);
+    batchedMatMulCheck<TypeParam>(af::dim4(32, 31), af::dim4(31, 1),
+                                  AF_MAT_NONE, AF_MAT_NONE);
+}
+
+static double maxRelDiff(const af::array &a, const af::array &b)
+{
+    return af::max<double>(af::abs(a - b)) / (1 + af::max<double>(af::abs(b)));
+}
+
+TYPED_TEST(MatrixMultiply, GemmAlphaBeta)
+{
+    if (noDoubleTests<TypeParam>()) return;
+
+    af::dtype ty = (af::dtype)af::dtype_traits<TypeParam>::af_type;
+    const int sizes[] = {4, 13, 40};
+    for (int s = 0; s < 3; s++) {
+        const int n = sizes[s];
+        af::array a  = af::randu(n, n + 3, 3, ty);
+        af::array b  = af::randu(n + 3, n - 1, 3, ty);
+        af::array c0 = af::randu(n, n - 1, 3, ty);
+
+        af::array c = c0.copy();
+        af::gemm(c, a, b, 2.0, 0.5);
+        af::array gold = 2.0 * af::matmul(a, b) + 0.5 * c0;
+        ASSERT_NEAR(0, maxRelDiff(c, gold), 1e-5);
+
+        af::array t;
+        af::gemm(t, b, a, 3.0, 0.5, AF_MAT_TRANS, AF_MAT_TRANS);
+        gold = 3.0 * af::matmul(b, a, AF_MAT_TRANS, AF_MAT_TRANS);
+        ASSERT_EQ(gold.dims(), t.dims());
+        ASSERT_NEAR(0, maxRelDiff(t, gold), 1e-5);
+    }
+}
+
+TEST(Gemm, InPlaceKeepsCopies)
+{
+    af::array a = af::randu(8, 8);
+    af::array b = af::randu(8, 8);
+    af::array c = af::randu(8, 8);
+    af::array shared = c;
+    af::array before = c.copy();
+
+    af::gemm(c, a, b, 1.0, 1.0);
+
+    ASSERT_EQ(0, af::max<float>(af::abs(shared - before)));
+    ASSERT_NEAR(0, maxRelDiff(c, af::matmul(a, b) + before), 1e-5);
+}
+
+TEST(Gemm, InPlaceOperand)
+{
+    af::array a = af::randu(16, 16);
+    af::array b = af::randu(16, 16);
+    af::array gold = af::matmul(a, b) + 0.5 * a;
+
+    // C is also the left operand
+    af::gemm(a, a, b, 1.0, 0.5);
+    ASSERT_NEAR(0, maxRelDiff(a, gold), 1e-5);
+}
+
+TEST(Gemm, BiasActivation)
+{
+    const af::activation acts[] = {AF_ACTIVATION_NONE, AF_ACTIVATION_RELU,
+                                   AF_ACTIVATION_SIGMOID, AF_ACTIVATION_TANH};
+    const int sizes[] = {4, 9, 50};
+    for (int s = 0; s < 3; s++) {
+        const int m = sizes[s], k = sizes[s] + 2, n = sizes[s] + 1;
+        af::array a = af::randn(m, k, 4);
+        af::array b = af::randn(k, n, 4);
+        af::array rowBias = af::randn(1, n);
+        af::array colBias = af::randn(m, 1);
+
+        for (int i = 0; i < 4; i++) {
+            for (int perColumn = 0; perColumn < 2; perColumn++) {
+                af::array bias = perColumn ? colBias : rowBias;
+                af::array c;
+                af::gemm(c, a, b, bias, acts[i], 0.5);
+
+                af::array gold = 0.5 * af::matmul(a, b) +
+                                 (perColumn ? af::tile(colBias, 1, n, 4) : af::tile(rowBias, m, 1, 4));
+                switch (acts[i]) {
+                case AF_ACTIVATION_RELU:    gold = af::max(gold, 0.0); break;
+                case AF_ACTIVATION_SIGMOID: gold = af::sigmoid(gold);  break;
+                case AF_ACTIVATION_TANH:    gold = af::tanh(gold);     break;
+                default: break;
+                }
+                ASSERT_NEAR(0, maxRelDiff(c, gold), 1e-5)
+                    << "size " << m << " activation " << acts[i] << " column bias " << perColumn;
+            }
+        }
+    }
+}
+
+TEST(Gemm, InvalidArgs)
+{
+    af::array a = af::randu(4, 5);
+    af::array b = af::randu(5, 6);
+    float one = 1, zero = 0;
+
+    af_array out = 0;
+    af::array bias = af::randu(5, 1);
+    ASSERT_EQ(AF_ERR_SIZE, af_gemm_fused(&out, AF_MAT_NONE, AF_MAT_NONE, &one, a.get(), b.get(),
+                                         &zero, bias.get(), AF_ACTIVATION_NONE));
+
+    af::array c = af::randu(4, 5);
+    out = c.get();
+    ASSERT_EQ(AF_ERR_SIZE, af_gemm(&out, AF_MAT_NONE, AF_MAT_NONE, &one, a.get(), b.get(), &zero));
+
+    af::array ca = af::randu(4, 5, c32);
+    af::array cb = af::randu(5, 6, c32);
+    af::cfloat cone(1, 0), czero(0, 0);
+    out = 0;
+    ASSERT_EQ(AF_ERR_ARG, af_gemm_fused(&out, AF_MAT_NONE, AF_MAT_NONE, &cone, ca.get(), cb.get(),
+                                        &czero, 0, AF_ACTIVATION_RELU));
+}
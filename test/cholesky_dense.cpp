@@ -87,3 +87,72 @@ CHOLESKY_BIG_TESTS(float, 0.05)
 CHOLESKY_BIG_TESTS(double, 1E-8)
 CHOLESKY_BIG_TESTS(cfloat, 0.05)
 CHOLESKY_BIG_TESTS(cdouble, 1E-8)
+
+template<typename T>
+void choleskyBatchTester(const int n, double eps, bool is_upper)
+{
+    if (noDoubleTests<T>()) return;
+    if (noLAPACKTests()) return;
+    if (noBatchedLAPACKTests()) return;
+
+    af::dtype ty = (af::dtype)af::dtype_traits<T>::af_type;
+
+    af::array a = cpu_randu<T>(af::dim4(n, n, 3, 2));
+    af::array b = 10 * n * af::identity(af::dim4(n, n, 3, 2), ty);
+    af::array in = matmul(a.H(), a) + b;
+
+    af::array out;
+    ASSERT_EQ(0, cholesky(out, in, is_upper));
+    ASSERT_EQ(in.dims(), out.dims());
+
+    af::array re = is_upper ? matmul(out.H(), out) : matmul(out, out.H());
+
+    ASSERT_NEAR(0, af::max<double>(af::abs(real(in - re))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(imag(in - re))), eps);
+
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 3; i++) {
+            af::array slice;
+            cholesky(slice, in(af::span, af::span, i, j), is_upper);
+            af::array diff = slice - out(af::span, af::span, i, j);
+            ASSERT_NEAR(0, af::max<double>(af::abs(real(diff))), eps);
+            ASSERT_NEAR(0, af::max<double>(af::abs(imag(diff))), eps);
+        }
+    }
+}
+
+#define CHOLESKY_BATCH_TESTS(T, eps)                \
+    TEST(CholeskyBatch, T##SmallUpper)              \
+    {                                               \
+        choleskyBatchTester<T>( 6, eps, true );     \
+    }                                               \
+    TEST(CholeskyBatch, T##SmallLower)              \
+    {                                               \
+        choleskyBatchTester<T>( 6, eps, false);     \
+    }                                               \
+    TEST(CholeskyBatch, T##Upper)                   \
+    {                                               \
+        choleskyBatchTester<T>(40, eps, true );     \
+    }                                               \
+    TEST(CholeskyBatch, T##Lower)                   \
+    {                                               \
+        choleskyBatchTester<T>(40, eps, false);     \
+    }                                               \
+
+CHOLESKY_BATCH_TESTS(float, 0.05)
+CHOLESKY_BATCH_TESTS(double, 1E-8)
+CHOLESKY_BATCH_TESTS(cfloat, 0.05)
+CHOLESKY_BATCH_TESTS(cdouble, 1E-8)
+
+TEST(CholeskyBatch, InfoOfFirstFailure)
+{
+    if (noLAPACKTests()) return;
+    if (noBatchedLAPACKTests()) return;
+
+    af::array in = af::identity(af::dim4(4, 4, 3));
+    in(2, 2, 1) = -1;
+    in(1, 1, 2) = -1;
+
+    af::array out;
+    ASSERT_EQ(3, af::cholesky(out, in));
+}
@@ -11,6 +11,11 @@
 #include <arrayfire.h>
 #include <af/dim4.hpp>
 #include <af/traits.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <testHelpers.hpp>
@@ -201,6 +206,142 @@ TYPED_TEST(Convolve, Same_Cuboid_One2Many)
     convolveTest<TypeParam>(string(TEST_DIR"/convolve/cuboid_same_one2many.test"), 3, false);
 }
 
+// Convolution of small integers, so that every type holds the exact result
+template<typename T>
+class ConvolveReference : public ::testing::Test
+{
+    public:
+        virtual void SetUp() {}
+};
+
+typedef ::testing::Types<float, double, int, uint, uchar, short, ushort, intl> ReferenceTypes;
+TYPED_TEST_CASE(ConvolveReference, ReferenceTypes);
+
+// Convolution computed one output at a time. The dimensions from baseDim on
+// are batched: a dimension of 1 in the signal or the filter is shared by
+// every batch.
+void convolveReference(vector<double> &out, af::dim4 &oDims,
+                       const vector<double> &s, const af::dim4 &sDims,
+                       const vector<double> &f, const af::dim4 &fDims,
+                       const int baseDim, const bool expand)
+{
+    for (int d = 0; d < 4; ++d) {
+        if (d < baseDim) oDims[d] = expand ? sDims[d] + fDims[d] - 1 : sDims[d];
+        else             oDims[d] = std::max(sDims[d], fDims[d]);
+    }
+    out.assign(oDims.elements(), 0);
+
+    for (dim_t o = 0; o < oDims.elements(); ++o) {
+        dim_t oi[4] = {o % oDims[0], (o / oDims[0]) % oDims[1],
+                       (o / (oDims[0] * oDims[1])) % oDims[2],
+                       o / (oDims[0] * oDims[1] * oDims[2])};
+        for (dim_t w = 0; w < fDims.elements(); ++w) {
+            dim_t wi[4] = {w % fDims[0], (w / fDims[0]) % fDims[1],
+                           (w / (fDims[0] * fDims[1])) % fDims[2],
+                           w / (fDims[0] * fDims[1] * fDims[2])};
+            dim_t si[4];
+            bool inside = true;
+            for (int d = 0; d < 4; ++d) {
+                if (d < baseDim) {
+                    si[d] = oi[d] + (expand ? 0 : fDims[d] / 2) - wi[d];
+                    inside = inside && si[d] >= 0 && si[d] < sDims[d];
+                } else {
+                    si[d] = (sDims[d] == 1 ? 0 : oi[d]);
+                    inside = inside && wi[d] == (fDims[d] == 1 ? 0 : oi[d]);
+                }
+            }
+            if (!inside) continue;
+            dim_t sIdx = si[0] + sDims[0] * (si[1] + sDims[1] * (si[2] + sDims[2] * si[3]));
+            out[o] += s[sIdx] * f[w];
+        }
+    }
+}
+
+template<typename T>
+void convolveReferenceTest(const int baseDim, const af::dim4 &sDims, const af::dim4 &fDims)
+{
+    if (noDoubleTests<T>()) return;
+
+    // Results of the 8 bit types stay below 256
+    const int sRange = (sizeof(T) == 1 ? 2 : 5);
+    const int fRange = (sizeof(T) == 1 ? 2 : 4);
+
+    vector<double> s(sDims.elements()), f(fDims.elements());
+    vector<T> sHost(s.size());
+    vector<float> fHost(f.size());
+    for (size_t i = 0; i < s.size(); ++i) sHost[i] = (T)(s[i] = (double)(rand() % sRange));
+    for (size_t i = 0; i < f.size(); ++i) fHost[i] = (float)(f[i] = (double)(rand() % fRange));
+
+    af::array signal(sDims, &sHost.front());
+    af::array filter(fDims, &fHost.front());
+
+    for (int e = 0; e < 2; ++e) {
+        const bool expand = (e == 1);
+        const af::convMode mode = expand ? AF_CONV_EXPAND : AF_CONV_DEFAULT;
+
+        vector<double> gold;
+        af::dim4 oDims;
+        convolveReference(gold, oDims, s, sDims, f, fDims, baseDim, expand);
+
+        af::array out;
+        switch (baseDim) {
+            case 1: out = af::convolve1(signal, filter, mode, AF_CONV_SPATIAL); break;
+            case 2: out = af::convolve2(signal, filter, mode, AF_CONV_SPATIAL); break;
+            case 3: out = af::convolve3(signal, filter, mode, AF_CONV_SPATIAL); break;
+        }
+        ASSERT_EQ(oDims, out.dims()) << "for signal " << sDims << " and filter " << fDims;
+
+        vector<T> outHost(out.elements());
+        out.host(&outHost.front());
+        for (size_t i = 0; i < gold.size(); ++i) {
+            ASSERT_EQ((T)gold[i], outHost[i]) << "at " << i << (expand ? " expanded" : "")
+                                              << " for signal " << sDims << " and filter " << fDims;
+        }
+    }
+}
+
+// Filter lengths inside and outside of the lengths the CPU backend unrolls,
+// signals longer than a tile of outputs and filters longer than the signal
+TYPED_TEST(ConvolveReference, Vector)
+{
+    const dim_t sLen[] = {700, 700, 700, 700, 10, 1};
+    const dim_t fLen[] = {5, 4, 13, 40, 40, 3};
+    for (int i = 0; i < 6; ++i) {
+        convolveReferenceTest<TypeParam>(1, af::dim4(sLen[i]), af::dim4(fLen[i]));
+        convolveReferenceTest<TypeParam>(1, af::dim4(sLen[i], 3), af::dim4(fLen[i]));
+        convolveReferenceTest<TypeParam>(1, af::dim4(sLen[i]), af::dim4(fLen[i], 3));
+        convolveReferenceTest<TypeParam>(1, af::dim4(sLen[i], 2, 3), af::dim4(fLen[i], 2, 3));
+    }
+}
+
+TYPED_TEST(ConvolveReference, Rectangle)
+{
+    const dim_t sDims[][2] = {{270, 8}, {270, 8}, {40, 30}, {5, 3}, {3, 12}};
+    const dim_t fDims[][2] = {{3, 3}, {4, 6}, {13, 17}, {9, 7}, {2, 15}};
+    for (int i = 0; i < 5; ++i) {
+        const af::dim4 s(sDims[i][0], sDims[i][1]);
+        const af::dim4 f(fDims[i][0], fDims[i][1]);
+        convolveReferenceTest<TypeParam>(2, s, f);
+        convolveReferenceTest<TypeParam>(2, af::dim4(s[0], s[1], 3), f);
+        convolveReferenceTest<TypeParam>(2, s, af::dim4(f[0], f[1], 3));
+        convolveReferenceTest<TypeParam>(2, af::dim4(s[0], s[1], 3), af::dim4(f[0], f[1], 3));
+    }
+}
+
+TYPED_TEST(ConvolveReference, Cuboid)
+{
+    const dim_t sDims[][3] = {{20, 9, 7}, {30, 6, 5}, {3, 2, 4}};
+    const dim_t fDims[][3] = {{3, 3, 3}, {2, 4, 5}, {5, 5, 5}};
+    for (int i = 0; i < 3; ++i) {
+        const af::dim4 s(sDims[i][0], sDims[i][1], sDims[i][2]);
+        const af::dim4 f(fDims[i][0], fDims[i][1], fDims[i][2]);
+        convolveReferenceTest<TypeParam>(3, s, f);
+        convolveReferenceTest<TypeParam>(3, af::dim4(s[0], s[1], s[2], 2), f);
+        convolveReferenceTest<TypeParam>(3, s, af::dim4(f[0], f[1], f[2], 2));
+        convolveReferenceTest<TypeParam>(3, af::dim4(s[0], s[1], s[2], 2), af::dim4(f[0], f[1], f[2], 2));
+    }
+}
+
 template<typename T>
 void sepConvolveTest(string pTestFile, bool expand)
 {
@@ -668,3 +809,100 @@ TEST(GFOR, convolve2_MM)
         ASSERT_EQ(max<double>(abs(c_ii - b_ii)) < 1E-5, true);
     }
 }
+
+TEST(Convolve, Auto_MatchesSpatial)
+{
+    // Filter sizes on both sides of where the frequency domain becomes
+    // cheaper. The GPU backends only convolve filters of up to 129 taps in
+    // 1D and 17x17 in 2D in the spatial domain, so the larger filters are
+    // checked against the frequency domain.
+    const int taps[] = {3, 17, 63, 127, 255, 511};
+    for (int i = 0; i < 6; ++i) {
+        array s = randu(4000);
+        array f = randu(taps[i]) / taps[i];
+        array a = convolve1(s, f, AF_CONV_DEFAULT, AF_CONV_AUTO);
+        array b = (taps[i] <= 129 ? convolve1(s, f, AF_CONV_DEFAULT, AF_CONV_SPATIAL)
+                                  : fftConvolve1(s, f, AF_CONV_DEFAULT));
+        ASSERT_LT(max<double>(abs(a - b)), 1E-4) << "for " << taps[i] << " taps";
+    }
+
+    const int taps2[] = {3, 9, 17, 33};
+    for (int i = 0; i < 4; ++i) {
+        array s = randu(120, 80, 2);
+        array f = randu(taps2[i], taps2[i]) / (taps2[i] * taps2[i]);
+        array a = convolve2(s, f, AF_CONV_EXPAND, AF_CONV_AUTO);
+        array b = (taps2[i] <= 17 ? convolve2(s, f, AF_CONV_EXPAND, AF_CONV_SPATIAL)
+                                  : fftConvolve2(s, f, AF_CONV_EXPAND));
+        ASSERT_LT(max<double>(abs(a - b)), 1E-4) << "for " << taps2[i] << " taps";
+    }
+}
+
+TEST(Convolve, Calibrate)
+{
+    const char *tmp = getenv("TMPDIR");
+    if (!tmp) tmp = getenv("TEMP");
+    const string path = string(tmp ? tmp : "/tmp") + "/af_convolve_calibration_test.txt";
+    {
+        std::ofstream file(path.c_str());
+        file << "99 1 0 1 1\n";
+    }
+
+    // Calibrating leaves the default random sequence where it was
+    setSeed(7);
+    array before = randu(16);
+    setSeed(7);
+    calibrateConvolve(path.c_str());
+    array after = randu(16);
+
+    // The file is removed before anything is checked
+    vector<string> lines;
+    {
+        std::ifstream file(path.c_str());
+        string line;
+        while (std::getline(file, line)) lines.push_back(line);
+    }
+    std::remove(path.c_str());
+
+    ASSERT_EQ(0, count<int>(before != after));
+
+    int backend = -1, own = 0, other = 0;
+    af_get_active_backend((af_backend *)&backend);
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (lines[i].empty() || lines[i][0] == '#') continue;
+        std::istringstream entry(lines[i]);
+        int b, dims, type;
+        double spatial, freq;
+        ASSERT_TRUE((bool)(entry >> b >> dims >> type >> spatial >> freq));
+        if (b == backend) {
+            ASSERT_GT(spatial, 0);
+            ASSERT_GT(freq, 0);
+            ++own;
+        } else {
+            ++other;
+        }
+    }
+    ASSERT_EQ(12, own);
+    ASSERT_EQ(1, other);
+}
+
+TEST(Convolve, LowRank_MatchesSeparable)
+{
+    // A Gaussian is separable and a sum of two box filters has rank two
+    array col = gaussianKernel(15, 1);
+    array row = gaussianKernel(1, 13).T();
+    array box = constant(1, 15, 13) / 195.0;
+    box(seq(3, 11), seq(2, 10)) += 1 / 81.0;
+
+    array s = randu(200, 150, 3);
+    for (int e = 0; e < 2; ++e) {
+        convMode mode = e ? AF_CONV_EXPAND : AF_CONV_DEFAULT;
+        array a = convolve2(s, matmul(col, row.T()), mode, AF_CONV_SPATIAL);
+        array b = convolve(col, row, s, mode);
+        ASSERT_LT(max<double>(abs(a - b)), 1E-5);
+
+        array c = convolve2(s, box, mode, AF_CONV_SPATIAL);
+        array d = fftConvolve2(s, box, mode);
+        ASSERT_LT(max<double>(abs(c - d)), 1E-4);
+    }
+}
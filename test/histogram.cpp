@@ -275,3 +275,111 @@ TEST(histogram, IndexedArray)
     ASSERT_EQ(true, out[2] ==  8);
     ASSERT_EQ(true, out[3] ==  8);
 }
+
+template<typename T>
+static vector<unsigned> hostHistogram(const vector<T> &in, unsigned nbins,
+                                      double minval, double maxval)
+{
+    vector<unsigned> out(nbins, 0);
+    float step = (maxval - minval) / (float)nbins;
+    for (size_t i = 0; i < in.size(); i++) {
+        int bin = (int)((in[i] - minval) / step);
+        bin = std::max(bin, 0);
+        bin = std::min(bin, (int)nbins - 1);
+        out[bin]++;
+    }
+    return out;
+}
+
+TEST(histogram, LargeFloat)
+{
+    using namespace af;
+
+    const unsigned nbins = 4096;
+    array A = randn(1 << 20);
+
+    vector<float> h_A(A.elements());
+    A.host(&h_A.front());
+    vector<unsigned> gold = hostHistogram(h_A, nbins, -3.0, 3.0);
+
+    vector<unsigned> h_out(nbins);
+    histogram(A, nbins, -3.0, 3.0).host(&h_out.front());
+
+    for (unsigned i = 0; i < nbins; i++) {
+        ASSERT_EQ(gold[i], h_out[i]) << "at: " << i;
+    }
+}
+
+TEST(histogram, DirectIndexedU8)
+{
+    using namespace af;
+
+    const unsigned nbins = 100;
+    array A = (255 * randu(300, 400)).as(u8);
+
+    vector<unsigned char> h_A(A.elements());
+    A.host(&h_A.front());
+    vector<unsigned> gold = hostHistogram(h_A, nbins, 0.0, 255.0);
+
+    vector<unsigned> h_out(nbins);
+    histogram(A, nbins, 0.0, 255.0).host(&h_out.front());
+
+    for (unsigned i = 0; i < nbins; i++) {
+        ASSERT_EQ(gold[i], h_out[i]) << "at: " << i;
+    }
+}
+
+TEST(histogram, DirectIndexedS16)
+{
+    using namespace af;
+
+    const unsigned nbins = 4096;
+    array A = (2000 * randn(1 << 18)).as(s16);
+
+    vector<short> h_A(A.elements());
+    A.host(&h_A.front());
+    vector<unsigned> gold = hostHistogram(h_A, nbins, -5000.0, 5000.0);
+
+    vector<unsigned> h_out(nbins);
+    histogram(A, nbins, -5000.0, 5000.0).host(&h_out.front());
+
+    for (unsigned i = 0; i < nbins; i++) {
+        ASSERT_EQ(gold[i], h_out[i]) << "at: " << i;
+    }
+}
+
+TEST(histogram, Weighted)
+{
+    using namespace af;
+
+    if (noCPUOnlyTests()) return;
+
+    const float h_in[] = {0.5f, 1.5f, 1.7f, 3.2f, 0.1f, 2.9f};
+    const float h_wt[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+
+    array in(6, h_in);
+    array wt(6, h_wt);
+
+    array out = histogram(in, wt, 4, 0.0, 4.0);
+    ASSERT_EQ(f32, out.type());
+
+    float h_out[4];
+    out.host(h_out);
+    ASSERT_FLOAT_EQ( 6.0f, h_out[0]);
+    ASSERT_FLOAT_EQ( 5.0f, h_out[1]);
+    ASSERT_FLOAT_EQ( 6.0f, h_out[2]);
+    ASSERT_FLOAT_EQ( 4.0f, h_out[3]);
+}
+
+TEST(histogram, WeightedOnesMatchesCount)
+{
+    using namespace af;
+
+    if (noCPUOnlyTests()) return;
+
+    array A = randu(1 << 20);
+    array counts  = histogram(A, 256, 0.0, 1.0);
+    array weights = histogram(A, constant(1, A.dims(), f64), 256, 0.0, 1.0);
+
+    ASSERT_EQ(0, count<unsigned>(counts.as(f64) != weights));
+}
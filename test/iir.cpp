@@ -186,3 +186,83 @@ TYPED_TEST(filter, iirMatMat)
 {
     iirTest<TypeParam>(TEST_DIR"/iir/iir_mm.test");
 }
+
+template<typename T>
+void iirSosTest(const int xrows, const int xcols)
+{
+    if (noDoubleTests<T>()) return;
+    if (noCPUOnlyTests()) return;
+    try {
+        af::dtype ty = (af::dtype)af::dtype_traits<T>::af_type;
+        af::array x = af::randu(xrows, xcols, ty);
+
+        double hsos[12] = {0.2,  0.3, 0.1,  1.0, -0.6, 0.2,
+                           0.5, -0.1, 0.05, 2.0, -1.0, 0.3};
+        af::array sos = af::array(6, 2, hsos).as(ty);
+
+        af::array y = af::iirSos(sos, x);
+        af::array c = af::iir(sos(af::seq(0, 2), 1), sos(af::seq(3, 5), 1),
+                              af::iir(sos(af::seq(0, 2), 0), sos(af::seq(3, 5), 0), x));
+
+        ASSERT_EQ(x.dims(), y.dims());
+
+        vector<T> hy(y.elements());
+        vector<T> hc(c.elements());
+        y.host(&hy[0]);
+        c.host(&hc[0]);
+
+        for (size_t i = 0; i < hy.size(); i++) {
+            ASSERT_NEAR(real(hc[i]), real(hy[i]), 1e-3) << "at: " << i;
+        }
+    } catch (af::exception &ex) {
+        FAIL() << ex.what();
+    }
+}
+
+TYPED_TEST(filter, iirSosVec)
+{
+    iirSosTest<TypeParam>(10000, 1);
+}
+
+TYPED_TEST(filter, iirSosMat)
+{
+    iirSosTest<TypeParam>(5000, 11);
+}
+
+// Long enough to be cut into pieces when there are several threads, with a
+// pole close to one so that the state carried between pieces matters
+TEST(filter, iirLongSignal)
+{
+    if (noDoubleTests<double>()) return;
+    const int n = 1 << 17;
+    af::array x = af::randu(n, f64) - 0.5;
+    double hb[1] = {1.0};
+    double ha[2] = {1.0, -0.999};
+
+    af::array y = af::iir(af::array(1, hb), af::array(2, ha), x);
+
+    vector<double> hx(n), hy(n);
+    x.host(&hx[0]);
+    y.host(&hy[0]);
+
+    double gold = 0;
+    for (int i = 0; i < n; i++) {
+        gold = hx[i] - ha[1] * gold;
+        ASSERT_NEAR(gold, hy[i], 1e-9) << "at: " << i;
+    }
+}
+
+TEST(filter, iirSosInvalidArgs)
+{
+    if (noCPUOnlyTests()) return;
+
+    af_array sos = 0, x = 0, y = 0;
+    vector<float> in(100, 1);
+    dim4 sdims(5, 2), xdims(100);
+
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&sos, &in.front(), sdims.ndims(), sdims.get(), f32));
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&x, &in.front(), xdims.ndims(), xdims.get(), f32));
+    ASSERT_EQ(AF_ERR_ARG, af_iir_sos(&y, sos, x));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(sos));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(x));
+}
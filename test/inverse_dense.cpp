@@ -65,3 +65,43 @@ INVERSE_TESTS(float, 0.01)
 INVERSE_TESTS(double, 1E-5)
 INVERSE_TESTS(cfloat, 0.01)
 INVERSE_TESTS(cdouble, 1E-5)
+
+template<typename T>
+void inverseBatchTester(const int n, double eps)
+{
+    if (noDoubleTests<T>()) return;
+    if (noLAPACKTests()) return;
+    if (noBatchedLAPACKTests()) return;
+
+    af::array A  = cpu_randu<T>(af::dim4(n, n, 3, 2));
+
+    af::array IA = inverse(A);
+    af::array I  = af::matmul(A, IA);
+    af::array I2 = af::identity(A.dims(), (af::dtype)af::dtype_traits<T>::af_type);
+
+    ASSERT_NEAR(0, af::max<double>(af::abs(real(I - I2))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(imag(I - I2))), eps);
+
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 3; i++) {
+            af::array diff = inverse(A(af::span, af::span, i, j)) - IA(af::span, af::span, i, j);
+            ASSERT_NEAR(0, af::max<double>(af::abs(real(diff))), eps);
+            ASSERT_NEAR(0, af::max<double>(af::abs(imag(diff))), eps);
+        }
+    }
+}
+
+#define INVERSE_BATCH_TESTS(T, eps)             \
+    TEST(INVERSE, T##BatchSmall)                \
+    {                                           \
+        inverseBatchTester<T>(6, eps);          \
+    }                                           \
+    TEST(INVERSE, T##Batch)                     \
+    {                                           \
+        inverseBatchTester<T>(40, eps);         \
+    }                                           \
+
+INVERSE_BATCH_TESTS(float, 0.01)
+INVERSE_BATCH_TESTS(double, 1E-5)
+INVERSE_BATCH_TESTS(cfloat, 0.01)
+INVERSE_BATCH_TESTS(cdouble, 1E-5)
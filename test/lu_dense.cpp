@@ -197,3 +197,72 @@ LU_BIG_TESTS(float, 1E-3)
 LU_BIG_TESTS(double, 1E-8)
 LU_BIG_TESTS(cfloat, 1E-3)
 LU_BIG_TESTS(cdouble, 1E-8)
+
+template<typename T>
+void luBatchTester(const int m, const int n, double eps)
+{
+    if (noDoubleTests<T>()) return;
+    if (noLAPACKTests()) return;
+    if (noBatchedLAPACKTests()) return;
+
+    af::array a_orig = cpu_randu<T>(af::dim4(m, n, 3, 2));
+
+    af::array l, u, pivot;
+    af::lu(l, u, pivot, a_orig);
+
+    af::array out = a_orig.copy();
+    af::array pivot2;
+    af::luInPlace(pivot2, out, false);
+
+    int mn = std::min(m, n);
+    ASSERT_EQ(af::dim4(m, mn, 3, 2), l.dims());
+    ASSERT_EQ(af::dim4(mn, n, 3, 2), u.dims());
+    ASSERT_EQ(af::dim4(m, 1, 3, 2), pivot.dims());
+
+    af::array a_recon = af::matmul(l, u);
+
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 3; i++) {
+            af::array a = a_orig(af::span, af::span, i, j);
+            af::array p = pivot(af::span, 0, i, j);
+            af::array diff = a_recon(af::span, af::span, i, j) - a(p, af::span);
+            ASSERT_NEAR(0, af::max<double>(af::abs(real(diff))), eps);
+            ASSERT_NEAR(0, af::max<double>(af::abs(imag(diff))), eps);
+
+            af::array ls, us, ps;
+            af::lu(ls, us, ps, a);
+            ASSERT_EQ(af::count<uint>(ps == p), ps.elements());
+
+            af::array packed = a.copy();
+            af::array ps2;
+            af::luInPlace(ps2, packed, false);
+            ASSERT_EQ(af::count<uint>(ps2 == pivot2(af::span, 0, i, j)), ps2.elements());
+            af::array pdiff = packed - out(af::span, af::span, i, j);
+            ASSERT_NEAR(0, af::max<double>(af::abs(real(pdiff))), eps);
+            ASSERT_NEAR(0, af::max<double>(af::abs(imag(pdiff))), eps);
+        }
+    }
+}
+
+#define LU_BATCH_TESTS(T, eps)                  \
+    TEST(LUBatch, T##SmallSquare)               \
+    {                                           \
+        luBatchTester<T>(6, 6, eps);            \
+    }                                           \
+    TEST(LUBatch, T##SmallRect)                 \
+    {                                           \
+        luBatchTester<T>(8, 5, eps);            \
+    }                                           \
+    TEST(LUBatch, T##Square)                    \
+    {                                           \
+        luBatchTester<T>(40, 40, eps);          \
+    }                                           \
+    TEST(LUBatch, T##Rect)                      \
+    {                                           \
+        luBatchTester<T>(30, 50, eps);          \
+    }                                           \
+
+LU_BATCH_TESTS(float, 1E-3)
+LU_BATCH_TESTS(double, 1E-8)
+LU_BATCH_TESTS(cfloat, 1E-3)
+LU_BATCH_TESTS(cdouble, 1E-8)
@@ -11,6 +11,8 @@
 #include <arrayfire.h>
 #include <af/dim4.hpp>
 #include <af/traits.hpp>
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 #include <testHelpers.hpp>
@@ -480,3 +482,85 @@ TEST(MedianFilter1d, GFOR)
         ASSERT_EQ(max<double>(abs(c_ii - b_ii)) < 1E-5, true);
     }
 }
+
+// Every window size goes through one of the sorting network, the sliding
+// histogram and the sorted window, depending on its size and the type
+TEST(MedianFilter, MatchesWindowMedian)
+{
+    const dtype types[] = {f32, s32, u8, u16, s16};
+    const int windows[] = {3, 5, 7, 15};
+    for (int t = 0; t < 5; ++t) {
+        array img = (randu(61, 47, f32) * 200).as(types[t]);
+        for (int w = 0; w < 4; ++w) {
+            const int wind = windows[w];
+            array gold = moddims(median(unwrap(img.as(f32), wind, wind, 1, 1, wind / 2, wind / 2), 0),
+                                 img.dims());
+            array out = medfilt(img, wind, wind, AF_PAD_ZERO);
+            ASSERT_EQ(0, max<double>(abs(out.as(f32) - gold)))
+                << "for type " << types[t] << " and a " << wind << "x" << wind << " window";
+        }
+    }
+}
+
+TEST(MedianFilter1d, MatchesWindowMedian)
+{
+    array sig = (randu(5000, 2, f32) * 200).as(u16);
+    for (int wind = 3; wind <= 39; wind += 18) {
+        array gold = median(unwrap(sig.as(f32), wind, 1, 1, 1, wind / 2, 0), 0);
+        array out = medfilt1(sig, wind, AF_PAD_ZERO);
+        ASSERT_EQ(0, max<double>(abs(out.as(f32) - moddims(gold, sig.dims()))))
+            << "for a window of " << wind;
+        ASSERT_EQ(0, max<double>(abs(medfilt1(sig.as(f32), wind, AF_PAD_ZERO) - out.as(f32))));
+    }
+}
+
+// Median of the w x w window around every pixel of a zero padded image,
+// with NaN ordered after all other values
+static vector<float> nanMedian(const vector<float> &img, const int n, const int w)
+{
+    vector<float> out(n * n);
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) {
+            vector<float> win;
+            for (int c = j - w / 2; c <= j + w / 2; c++) {
+                for (int r = i - w / 2; r <= i + w / 2; r++) {
+                    bool inside = r >= 0 && r < n && c >= 0 && c < n;
+                    win.push_back(inside ? img[c * n + r] : 0.f);
+                }
+            }
+            std::sort(win.begin(), win.end(), [](float a, float b) {
+                return a < b || (a == a && b != b);
+            });
+            out[j * n + i] = win[win.size() / 2];
+        }
+    }
+    return out;
+}
+
+TEST(MedianFilter, NaN)
+{
+    const int n = 40;
+    array img = randu(n, n);
+    // Enough NaN for some windows to have a NaN median
+    img(seq(4, 7), seq(4, 7)) = af::NaN;
+    img(20, 31) = af::NaN;
+    img(seq(30, 34), 10) = af::NaN;
+
+    vector<float> h(n * n);
+    img.host(&h[0]);
+
+    // 3x3 windows go through the sorting network, 7x7 ones are kept sorted
+    for (int w = 3; w <= 7; w += 4) {
+        array out = medfilt(img, w, w, AF_PAD_ZERO);
+        vector<float> res(n * n);
+        out.host(&res[0]);
+        vector<float> gold = nanMedian(h, n, w);
+        for (int i = 0; i < n * n; i++) {
+            if (std::isnan(gold[i])) {
+                ASSERT_TRUE(std::isnan(res[i])) << "at " << i << " for a window of " << w;
+            } else {
+                ASSERT_EQ(gold[i], res[i]) << "at " << i << " for a window of " << w;
+            }
+        }
+    }
+}
@@ -12,6 +12,8 @@
 #include <af/data.h>
 #include <af/dim4.hpp>
 #include <af/traits.hpp>
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <vector>
 #include <testHelpers.hpp>
@@ -459,3 +461,164 @@ TEST(Morph, EdgeIssue1564)
         ASSERT_EQ((int)outData[i], goldData[i]);
     }
 }
+
+TEST(Morph, BoxMatchesWindowMax)
+{
+    // Flat box masks take a separate path from masks with holes. The input
+    // is non negative, so the zero padding of unwrap does not change the max
+    const dim_t wx = 7, wy = 5;
+    array input = randu(41, 37, 3);
+    array mask  = constant(1, wx, wy);
+
+    array windows = unwrap(input, wx, wy, 1, 1, wx / 2, wy / 2);
+    array gold    = moddims(max(windows, 0), input.dims());
+
+    array dilated = dilate(input, mask);
+    array eroded  = erode(-input, mask);
+
+    vector<float> goldData(gold.elements());
+    vector<float> dilData(dilated.elements());
+    vector<float> eroData(eroded.elements());
+    gold.host(&goldData.front());
+    dilated.host(&dilData.front());
+    eroded.host(&eroData.front());
+
+    for (size_t i = 0; i < goldData.size(); ++i) {
+        ASSERT_EQ(goldData[i], dilData[i]) << "at " << i;
+        ASSERT_EQ(-goldData[i], eroData[i]) << "at " << i;
+    }
+}
+
+// Brute force dilation, or erosion, of a column major volume. The window is
+// centred on element dims / 2 of the mask and taps outside the input are
+// left out
+template<typename T>
+static vector<T> morphReference(const vector<T> &in, const dim4 &idims,
+                                const vector<char> &mask, const dim4 &mdims,
+                                const bool isDilation)
+{
+    // Outputs with no tap inside the input keep the identity of max or min
+    typedef std::numeric_limits<T> limits;
+    T const lowest  = limits::has_infinity ? -limits::infinity() : limits::lowest();
+    T const highest = limits::has_infinity ?  limits::infinity() : limits::max();
+
+    vector<T> out(in.size());
+    for (dim_t k = 0; k < idims[2]; ++k) {
+        for (dim_t j = 0; j < idims[1]; ++j) {
+            for (dim_t i = 0; i < idims[0]; ++i) {
+                T acc = isDilation ? lowest : highest;
+                for (dim_t wk = 0; wk < mdims[2]; ++wk) {
+                    for (dim_t wj = 0; wj < mdims[1]; ++wj) {
+                        for (dim_t wi = 0; wi < mdims[0]; ++wi) {
+                            if (!mask[wi + mdims[0] * (wj + mdims[1] * wk)]) continue;
+                            dim_t const ii = i + wi - mdims[0] / 2;
+                            dim_t const jj = j + wj - mdims[1] / 2;
+                            dim_t const kk = k + wk - mdims[2] / 2;
+                            if (ii < 0 || ii >= idims[0] || jj < 0 || jj >= idims[1] ||
+                                kk < 0 || kk >= idims[2]) continue;
+                            T const val = in[ii + idims[0] * (jj + idims[1] * kk)];
+                            acc = isDilation ? std::max(acc, val) : std::min(acc, val);
+                        }
+                    }
+                }
+                out[i + idims[0] * (j + idims[1] * k)] = acc;
+            }
+        }
+    }
+    return out;
+}
+
+// Runs dilate and erode, or their 3D versions when the mask has a third
+// dimension, and checks them against morphReference
+template<typename T>
+static void morphReferenceTest(const dim4 &idims, const dim4 &mdims, const vector<char> &mask)
+{
+    const bool volume = mdims[2] > 1;
+    af::dtype ty = (af::dtype)af::dtype_traits<T>::af_type;
+    array input = (ty == u8 ? randu(idims, u8) : randu(idims, ty));
+    array mk    = array(mdims, &mask.front()).as(ty);
+
+    vector<T> in(input.elements());
+    input.host(&in.front());
+
+    for (int d = 0; d < 2; ++d) {
+        const bool isDilation = (d == 0);
+        array result = volume ? (isDilation ? dilate3(input, mk) : erode3(input, mk))
+                              : (isDilation ? dilate(input, mk)  : erode(input, mk));
+        vector<T> out(result.elements());
+        result.host(&out.front());
+
+        vector<T> gold = morphReference(in, idims, mask, mdims, isDilation);
+        for (size_t i = 0; i < gold.size(); ++i) {
+            ASSERT_EQ(gold[i], out[i]) << (isDilation ? "dilation" : "erosion") << " at " << i;
+        }
+    }
+}
+
+// A box of ones that does not sit on the centre of a larger mask
+static vector<char> offCentreBox(const dim4 &mdims, const dim4 &lo, const dim4 &hi)
+{
+    vector<char> mask(mdims.elements(), 0);
+    for (dim_t k = lo[2]; k <= hi[2]; ++k)
+        for (dim_t j = lo[1]; j <= hi[1]; ++j)
+            for (dim_t i = lo[0]; i <= hi[0]; ++i)
+                mask[i + mdims[0] * (j + mdims[1] * k)] = 1;
+    return mask;
+}
+
+TEST(Morph, OffCentreBoxReference)
+{
+    if (noCPUOnlyTests()) return;
+    dim4 mdims(7, 5);
+    vector<char> mask = offCentreBox(mdims, dim4(0, 2, 0), dim4(2, 4, 0));
+    morphReferenceTest<float>(dim4(41, 37, 2), mdims, mask);
+    morphReferenceTest<uchar>(dim4(41, 37, 2), mdims, mask);
+}
+
+TEST(Morph, EvenBoxReference)
+{
+    if (noCPUOnlyTests()) return;
+    dim4 mdims(4, 6);
+    vector<char> mask(mdims.elements(), 1);
+    morphReferenceTest<float>(dim4(33, 29), mdims, mask);
+    morphReferenceTest<uchar>(dim4(33, 29), mdims, mask);
+}
+
+// Masks with holes are not flat boxes and take the tap by tap path
+TEST(Morph, MaskWithHolesReference)
+{
+    if (noCPUOnlyTests()) return;
+    dim4 mdims(5, 5);
+    vector<char> mask(mdims.elements(), 1);
+    mask[12] = 0;
+    mask[3]  = 0;
+    morphReferenceTest<float>(dim4(41, 37, 2), mdims, mask);
+    morphReferenceTest<uchar>(dim4(41, 37, 2), mdims, mask);
+
+    dim4 evenDims(4, 6);
+    vector<char> evenMask = offCentreBox(evenDims, dim4(1, 0, 0), dim4(3, 2, 0));
+    evenMask[evenDims[0] * 5] = 1;
+    morphReferenceTest<float>(dim4(33, 29), evenDims, evenMask);
+    morphReferenceTest<uchar>(dim4(33, 29), evenDims, evenMask);
+}
+
+TEST(Morph, VolumeReference)
+{
+    if (noCPUOnlyTests()) return;
+    dim4 idims(19, 17, 13);
+    dim4 mdims(3, 4, 5);
+
+    vector<char> box(mdims.elements(), 1);
+    morphReferenceTest<float>(idims, mdims, box);
+    morphReferenceTest<uchar>(idims, mdims, box);
+
+    vector<char> offBox = offCentreBox(mdims, dim4(1, 0, 2), dim4(2, 1, 4));
+    morphReferenceTest<float>(idims, mdims, offBox);
+    morphReferenceTest<uchar>(idims, mdims, offBox);
+
+    vector<char> holes(mdims.elements(), 1);
+    holes[1 + 3 * (2 + 4 * 2)] = 0;
+    holes[0] = 0;
+    morphReferenceTest<float>(idims, mdims, holes);
+    morphReferenceTest<uchar>(idims, mdims, holes);
+}
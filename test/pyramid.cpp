@@ -0,0 +1,159 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <gtest/gtest.h>
+#include <arrayfire.h>
+#include <af/dim4.hpp>
+#include <af/traits.hpp>
+#include <vector>
+#include <testHelpers.hpp>
+
+using std::vector;
+using af::array;
+using af::dim4;
+
+template<typename T>
+class Pyramid : public ::testing::Test
+{
+    public:
+        virtual void SetUp() {}
+};
+
+typedef ::testing::Types<float, double> TestTypes;
+
+TYPED_TEST_CASE(Pyramid, TestTypes);
+
+static const double binomial[5] = {1 / 16., 4 / 16., 6 / 16., 4 / 16., 1 / 16.};
+
+static dim_t mirror(dim_t i, dim_t n)
+{
+    if (i < 0)  i = -i - 1;
+    if (i >= n) i = 2 * n - i - 1;
+    return std::max<dim_t>(0, std::min(i, n - 1));
+}
+
+// Blurs every image of in with the 5x5 binomial filter and keeps the even samples
+static vector<double> reduce(const vector<double> &in, dim4 idims, dim4 odims)
+{
+    vector<double> out(odims.elements());
+    for (dim_t z = 0; z < idims[2]; z++) {
+        const double *img = &in[z * idims[0] * idims[1]];
+        for (dim_t y = 0; y < odims[1]; y++) {
+            for (dim_t x = 0; x < odims[0]; x++) {
+                double sum = 0;
+                for (int j = 0; j < 5; j++) {
+                    for (int i = 0; i < 5; i++) {
+                        dim_t yy = mirror(2 * y + j - 2, idims[1]);
+                        dim_t xx = mirror(2 * x + i - 2, idims[0]);
+                        sum += binomial[j] * binomial[i] * img[yy * idims[0] + xx];
+                    }
+                }
+                out[z * odims[0] * odims[1] + y * odims[0] + x] = sum;
+            }
+        }
+    }
+    return out;
+}
+
+// Puts zeros between the samples of every image of in and blurs the result
+// with four times the 5x5 binomial filter
+static vector<double> expand(const vector<double> &in, dim4 idims, dim4 odims)
+{
+    vector<double> out(odims.elements());
+    for (dim_t z = 0; z < idims[2]; z++) {
+        const double *img = &in[z * idims[0] * idims[1]];
+        for (dim_t y = 0; y < odims[1]; y++) {
+            for (dim_t x = 0; x < odims[0]; x++) {
+                double sum = 0;
+                for (int j = -2; j <= 2; j++) {
+                    if ((y - j) % 2) continue;
+                    for (int i = -2; i <= 2; i++) {
+                        if ((x - i) % 2) continue;
+                        dim_t yy = mirror((y - j) / 2, idims[1]);
+                        dim_t xx = mirror((x - i) / 2, idims[0]);
+                        sum += 4 * binomial[j + 2] * binomial[i + 2] * img[yy * idims[0] + xx];
+                    }
+                }
+                out[z * odims[0] * odims[1] + y * odims[0] + x] = sum;
+            }
+        }
+    }
+    return out;
+}
+
+template<typename T>
+void pyramidTest(bool laplacian)
+{
+    if (noDoubleTests<T>()) return;
+    if (noCPUOnlyTests()) return;
+
+    const unsigned levels = 4;
+    dim4 dims(37, 22, 2);
+    array in = af::randu(dims, (af_dtype)af::dtype_traits<T>::af_type);
+
+    vector<array> out(levels);
+    if (laplacian) af::pyramidLaplacian(&out.front(), in, levels);
+    else           af::pyramidGaussian(&out.front(), in, levels);
+
+    vector<T> h(in.elements());
+    in.host(&h.front());
+    vector<vector<double> > gauss(1, vector<double>(h.begin(), h.end()));
+    vector<dim4> gdims(1, dims);
+    for (unsigned l = 1; l < levels; l++) {
+        dim4 d((gdims[l - 1][0] + 1) / 2, (gdims[l - 1][1] + 1) / 2, dims[2]);
+        gauss.push_back(reduce(gauss[l - 1], gdims[l - 1], d));
+        gdims.push_back(d);
+    }
+
+    for (unsigned l = 0; l < levels; l++) {
+        ASSERT_EQ(gdims[l], out[l].dims()) << "at level " << l;
+
+        vector<double> gold = gauss[l];
+        if (laplacian && l + 1 < levels) {
+            vector<double> up = expand(gauss[l + 1], gdims[l + 1], gdims[l]);
+            for (size_t i = 0; i < gold.size(); i++) gold[i] -= up[i];
+        }
+
+        vector<T> res(out[l].elements());
+        out[l].host(&res.front());
+        for (size_t i = 0; i < gold.size(); i++) {
+            ASSERT_NEAR(gold[i], res[i], 1e-5) << "at level " << l << " index " << i;
+        }
+    }
+}
+
+TYPED_TEST(Pyramid, Gaussian)
+{
+    pyramidTest<TypeParam>(false);
+}
+
+TYPED_TEST(Pyramid, Laplacian)
+{
+    pyramidTest<TypeParam>(true);
+}
+
+TEST(Pyramid, InvalidArgs)
+{
+    if (noCPUOnlyTests()) return;
+
+    af_array inArray = 0;
+    af_array out[2] = {0, 0};
+    vector<float> in(100, 1);
+    dim4 dims(10, 10);
+
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&inArray, &in.front(), dims.ndims(), dims.get(), f32));
+    ASSERT_EQ(AF_ERR_ARG, af_pyramid_gaussian(out, inArray, 0));
+    ASSERT_EQ(AF_ERR_ARG, af_pyramid_laplacian(NULL, inArray, 2));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(inArray));
+
+    vector<int> iin(100, 1);
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&inArray, &iin.front(), dims.ndims(), dims.get(), s32));
+    ASSERT_EQ(AF_ERR_TYPE, af_pyramid_gaussian(out, inArray, 2));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(inArray));
+}
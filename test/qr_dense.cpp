@@ -168,3 +168,67 @@ QR_BIG_TESTS(cdouble, 1E-5)
 #endif
 
 #undef QR_BIG_TESTS
+
+template<typename T>
+void qrBatchTester(const int m, const int n, double eps)
+{
+    if (noDoubleTests<T>()) return;
+    if (noLAPACKTests()) return;
+    if (noBatchedLAPACKTests()) return;
+
+    af::array in = cpu_randu<T>(af::dim4(m, n, 3, 2));
+
+    af::array q, r, tau;
+    af::qr(q, r, tau, in);
+
+    ASSERT_EQ(af::dim4(m, m, 3, 2), q.dims());
+    ASSERT_EQ(af::dim4(m, n, 3, 2), r.dims());
+    ASSERT_EQ(af::dim4(std::min(m, n), 1, 3, 2), tau.dims());
+
+    af::array qq = af::matmul(q, q.H());
+    af::array ii = af::identity(qq.dims(), qq.type());
+
+    ASSERT_NEAR(0, af::max<double>(af::abs(real(qq - ii))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(imag(qq - ii))), eps);
+
+    af::array re = af::matmul(q, r);
+
+    ASSERT_NEAR(0, af::max<double>(af::abs(real(re - in))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(imag(re - in))), eps);
+
+    af::array out = in.copy();
+    af::array tau2;
+    qrInPlace(tau2, out);
+
+    ASSERT_NEAR(0, af::max<double>(af::abs(real(tau - tau2))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(imag(tau - tau2))), eps);
+
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 3; i++) {
+            af::array qs, rs, ts;
+            af::qr(qs, rs, ts, in(af::span, af::span, i, j));
+            af::array diff = rs - r(af::span, af::span, i, j);
+            ASSERT_NEAR(0, af::max<double>(af::abs(real(diff))), eps);
+            ASSERT_NEAR(0, af::max<double>(af::abs(imag(diff))), eps);
+        }
+    }
+}
+
+#define QR_BATCH_TESTS(T, eps)                  \
+    TEST(QRBatch, T##Small)                     \
+    {                                           \
+        qrBatchTester<T>(6, 6, eps);            \
+    }                                           \
+    TEST(QRBatch, T##Rect0)                     \
+    {                                           \
+        qrBatchTester<T>(20, 40, eps);          \
+    }                                           \
+    TEST(QRBatch, T##Rect1)                     \
+    {                                           \
+        qrBatchTester<T>(40, 20, eps);          \
+    }                                           \
+
+QR_BATCH_TESTS(float, 1E-3)
+QR_BATCH_TESTS(double, 1E-5)
+QR_BATCH_TESTS(cfloat, 1E-3)
+QR_BATCH_TESTS(cdouble, 1E-5)
@@ -578,3 +578,109 @@ TEST(Reduce, AllSmallIndexed)
     array b = a(af::seq(LEN/2), af::span);
     ASSERT_EQ(af::max<float>(b), LEN/2-1);
 }
+
+TEST(ReduceByKey, SortedRuns)
+{
+    if (noCPUOnlyTests()) return;
+
+    const int   hkeys[] = {0, 0, 1, 1, 1, 0, 2, 2};
+    const float hvals[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    array keys(8, hkeys);
+    array vals(8, hvals);
+
+    array okeys, ovals;
+    af::reduceByKey(okeys, ovals, keys, vals, 0, AF_BINARY_ADD, true);
+
+    const int   gold_keys[] = {0, 1, 0, 2};
+    const float gold_vals[] = {3, 12, 6, 15};
+
+    ASSERT_EQ(4, (int)okeys.elements());
+    ASSERT_EQ(4, (int)ovals.elements());
+
+    std::vector<int>   rkeys(4);
+    std::vector<float> rvals(4);
+    okeys.host(&rkeys.front());
+    ovals.host(&rvals.front());
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(gold_keys[i], rkeys[i]) << "at: " << i;
+        ASSERT_EQ(gold_vals[i], rvals[i]) << "at: " << i;
+    }
+}
+
+TEST(ReduceByKey, UnsortedKeys)
+{
+    if (noCPUOnlyTests()) return;
+
+    const int   hkeys[] = {3, 1, 3, 2, 1, 3};
+    const float hvals[] = {1, 2, 3, 4, 5, 6};
+
+    array keys(6, hkeys);
+    array vals(6, hvals);
+
+    array okeys, ovals;
+    af::reduceByKey(okeys, ovals, keys, vals, 0, AF_BINARY_MAX);
+
+    // Groups are returned in the order of first occurrence
+    const int   gold_keys[] = {3, 1, 2};
+    const float gold_vals[] = {6, 5, 4};
+
+    ASSERT_EQ(3, (int)okeys.elements());
+
+    std::vector<int>   rkeys(3);
+    std::vector<float> rvals(3);
+    okeys.host(&rkeys.front());
+    ovals.host(&rvals.front());
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(gold_keys[i], rkeys[i]) << "at: " << i;
+        ASSERT_EQ(gold_vals[i], rvals[i]) << "at: " << i;
+    }
+}
+
+TEST(ReduceByKey, Dim1MatchesSum)
+{
+    if (noCPUOnlyTests()) return;
+
+    const int m = 7;
+    const int n = 100;
+
+    array in   = af::randu(m, n);
+    array keys = (af::range(af::dim4(n), 0, s32) % 5).as(s32);
+
+    array okeys, ovals;
+    af::reduceByKey(okeys, ovals, keys, in, 1);
+
+    ASSERT_EQ(m, ovals.dims(0));
+    ASSERT_EQ(5, ovals.dims(1));
+
+    for (int k = 0; k < 5; k++) {
+        array gold = af::sum(in(af::span, af::seq(k, n - 1, 5)), 1);
+        float err = af::max<float>(af::abs(gold - ovals(af::span, k)));
+        ASSERT_LT(err, 1E-5);
+    }
+}
+
+TEST(ReduceByKey, Count)
+{
+    if (noCPUOnlyTests()) return;
+
+    const unsigned hkeys[] = {5, 5, 9, 9, 9};
+    const int      hvals[] = {1, 0, 2, 0, 3};
+
+    array keys(5, hkeys);
+    array vals(5, hvals);
+
+    array okeys, ovals;
+    af::countByKey(okeys, ovals, keys, vals, 0, true);
+
+    ASSERT_EQ(u32, okeys.type());
+    ASSERT_EQ(u32, ovals.type());
+
+    std::vector<unsigned> rvals(2);
+    ovals.host(&rvals.front());
+
+    ASSERT_EQ(1u, rvals[0]);
+    ASSERT_EQ(2u, rvals[1]);
+}
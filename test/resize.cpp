@@ -454,3 +454,20 @@ TEST(Resize, ExtractGFOR)
         ASSERT_EQ(max<double>(abs(c_ii - b_ii)) < 1E-5, true);
     }
 }
+
+TEST(Resize, BilinearU8MatchesFloat)
+{
+    using namespace af;
+    array A = (255 * randu(97, 61, 3)).as(u8);
+
+    dim_t sizes[2][2] = {{250, 131}, {40, 23}};
+    for (int i = 0; i < 2; i++) {
+        array u = resize(A, sizes[i][0], sizes[i][1], AF_INTERP_BILINEAR);
+        array f = resize(A.as(f32), sizes[i][0], sizes[i][1], AF_INTERP_BILINEAR);
+        ASSERT_EQ(u8, u.type());
+        // Truncated like the float result, off by one only where the fixed
+        // point weights fall on the other side of an integer
+        ASSERT_LE(max<float>(abs(u.as(f32) - floor(f))), 1.0f);
+        ASSERT_LT(count<float>(u.as(f32) != floor(f)), 0.05f * u.elements());
+    }
+}
@@ -197,3 +197,55 @@ TEST(Rotate, CPP)
     // Delete
     delete[] outData;
 }
+
+// Quarter and half turns map every output pixel onto an input pixel, so
+// every method returns the input pixels moved around
+TEST(Rotate, RightAngles)
+{
+    using namespace af;
+
+    const int n = 37;
+    array square = (255 * randu(n, n, 3, 2)).as(u8);
+    array rect   = (255 * randu(n, 20, 3)).as(u8);
+
+    // Output (x, y) of the quarter turn reads input (y, n - 1 - x)
+    array quarter = flip(square.T(), 0);
+    array half    = flip(flip(rect, 0), 1);
+
+    const af_interp_type methods[] = {AF_INTERP_NEAREST, AF_INTERP_BILINEAR, AF_INTERP_BICUBIC};
+    const dtype types[] = {u8, f32, s32};
+    for (int m = 0; m < 3; m++) {
+        for (int t = 0; t < 3; t++) {
+            array q = rotate(square.as(types[t]), PI / 2, true, methods[m]);
+            array h = rotate(rect.as(types[t]), PI, true, methods[m]);
+            ASSERT_EQ(types[t], q.type());
+            ASSERT_EQ(square.dims(), q.dims());
+            ASSERT_EQ(rect.dims(), h.dims());
+            ASSERT_EQ(0, count<int>(q != quarter.as(types[t])))
+                << "for method " << methods[m] << " and type " << types[t];
+            ASSERT_EQ(0, count<int>(h != half.as(types[t])))
+                << "for method " << methods[m] << " and type " << types[t];
+        }
+    }
+}
+
+// A constant image keeps its value where the rotated image covers it, and is
+// zero in the corners it leaves uncovered
+TEST(Rotate, ConstantImage)
+{
+    using namespace af;
+
+    const int n = 41;
+    const af_interp_type methods[] = {AF_INTERP_NEAREST, AF_INTERP_BILINEAR, AF_INTERP_BICUBIC};
+    const dtype types[] = {u8, f32};
+    for (int m = 0; m < 3; m++) {
+        for (int t = 0; t < 2; t++) {
+            array out = rotate(constant(7, n, n, 2, types[t]), PI / 4, true, methods[m]).as(f32);
+            array centre = out(seq(n / 2 - 10, n / 2 + 10), seq(n / 2 - 10, n / 2 + 10), span);
+            ASSERT_EQ(0, max<float>(abs(centre - 7)))
+                << "for method " << methods[m] << " and type " << types[t];
+            ASSERT_EQ(0, max<float>(out(seq(3), seq(3), span)))
+                << "for method " << methods[m] << " and type " << types[t];
+        }
+    }
+}
@@ -13,6 +13,7 @@
 #include <af/traits.hpp>
 #include <af/algorithm.h>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <testHelpers.hpp>
@@ -169,3 +170,86 @@ SET_TESTS(short)
 SET_TESTS(ushort)
 SET_TESTS(intl)
 SET_TESTS(uintl)
+
+TEST(Set, UniqueStable)
+{
+    int h_in[]  = {5, 3, 5, 1, 3, 7, 1, 5};
+    int h_gold[] = {5, 3, 1, 7};
+
+    af::array in(8, h_in);
+    af::array out = af::setUniqueStable(in);
+
+    ASSERT_EQ(4, (int)out.elements());
+    vector<int> h_out(out.elements());
+    out.host(&h_out.front());
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(h_gold[i], h_out[i]) << "at: " << i;
+    }
+}
+
+TEST(Set, UnionIntersectStable)
+{
+    float h_first[]  = {4, 2, 4, 9, 0};
+    float h_second[] = {9, 1, 2, 1, -0.0f};
+
+    af::array first(5, h_first);
+    af::array second(5, h_second);
+
+    float h_union_gold[] = {4, 2, 9, 0, 1};
+    af::array u = af::setUnionStable(first, second);
+    ASSERT_EQ(5, (int)u.elements());
+    vector<float> h_union(u.elements());
+    u.host(&h_union.front());
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(h_union_gold[i], h_union[i]) << "at: " << i;
+    }
+
+    float h_inter_gold[] = {2, 9, 0};
+    af::array n = af::setIntersectStable(first, second);
+    ASSERT_EQ(3, (int)n.elements());
+    vector<float> h_inter(n.elements());
+    n.host(&h_inter.front());
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(h_inter_gold[i], h_inter[i]) << "at: " << i;
+    }
+}
+
+TEST(Set, Contains)
+{
+    int h_elements[] = {1, 2, 3, 4, 5, 6};
+    int h_set[]      = {6, 2, 2, 9};
+    char h_gold[]    = {0, 1, 0, 0, 0, 1};
+
+    af::array elements(3, 2, h_elements);
+    af::array set(4, h_set);
+    af::array out = af::setContains(elements, set);
+
+    ASSERT_EQ(b8, out.type());
+    ASSERT_EQ(elements.dims(), out.dims());
+    vector<char> h_out(out.elements());
+    out.host(&h_out.front());
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_EQ(h_gold[i], h_out[i]) << "at: " << i;
+    }
+}
+
+TEST(Set, UnsortedLargeMatchesSorted)
+{
+    af::array in = (af::randu(100000) * 5000).as(s32);
+
+    vector<int> h_in(in.elements());
+    in.host(&h_in.front());
+    std::sort(h_in.begin(), h_in.end());
+    h_in.erase(std::unique(h_in.begin(), h_in.end()), h_in.end());
+
+    af::array out = af::setUnique(in);
+    ASSERT_EQ(h_in.size(), out.elements());
+    vector<int> h_out(out.elements());
+    out.host(&h_out.front());
+    for (size_t i = 0; i < h_in.size(); ++i) {
+        ASSERT_EQ(h_in[i], h_out[i]) << "at: " << i;
+    }
+
+    af::array mask = af::setContains(in, out);
+    ASSERT_TRUE(af::allTrue<bool>(mask));
+}
@@ -0,0 +1,140 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <gtest/gtest.h>
+#include <arrayfire.h>
+#include <testHelpers.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace af;
+using std::vector;
+
+// Fraction of the sorted values that are smaller than val
+static double rankOf(const vector<float> &sorted, double val)
+{
+    return (std::lower_bound(sorted.begin(), sorted.end(), val) - sorted.begin())
+           / (double)sorted.size();
+}
+
+TEST(QuantileSketch, Accuracy)
+{
+    const int num = 1 << 20;
+    array in = randn(num);
+
+    vector<float> h_in(num);
+    in.host(&h_in.front());
+    std::sort(h_in.begin(), h_in.end());
+
+    const double h_probs[] = {0.0, 0.01, 0.25, 0.5, 0.75, 0.95, 0.99, 0.999, 1.0};
+    const int nprobs = sizeof(h_probs) / sizeof(h_probs[0]);
+    array probs(nprobs, h_probs);
+
+    array sketch = quantileSketch(in, 200);
+    ASSERT_EQ(f64, sketch.type());
+    ASSERT_EQ(2, sketch.dims(1));
+    ASSERT_LT(sketch.dims(0), 1000);
+
+    vector<double> res(nprobs);
+    quantileSketchQuery(sketch, probs).host(&res.front());
+
+    ASSERT_EQ(h_in.front(), res[0]);
+    ASSERT_EQ(h_in.back(), res[nprobs - 1]);
+    // The rank error is smallest at the tails
+    for (int i = 1; i < nprobs - 1; i++) {
+        double tol = 2E-3 * std::sqrt(4 * h_probs[i] * (1 - h_probs[i]));
+        ASSERT_NEAR(h_probs[i], rankOf(h_in, res[i]), tol) << "at q = " << h_probs[i];
+    }
+}
+
+TEST(QuantileSketch, Merge)
+{
+    const int num = 100000;
+    array a = randu(num);
+    array b = randu(num) + 1;
+
+    array merged = quantileSketchMerge(quantileSketch(a), quantileSketch(b));
+
+    vector<float> h_all(2 * num);
+    join(0, a, b).host(&h_all.front());
+    std::sort(h_all.begin(), h_all.end());
+
+    const double h_probs[] = {0.1, 0.3, 0.7, 0.9};
+    array probs(4, h_probs);
+
+    vector<double> res(4);
+    quantileSketchQuery(merged, probs).host(&res.front());
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_NEAR(h_probs[i], rankOf(h_all, res[i]), 5E-3) << "at q = " << h_probs[i];
+    }
+}
+
+TEST(QuantileSketch, IgnoresNaN)
+{
+    const float h_in[] = {1, 2, NAN, 3, 4};
+    array in(5, h_in);
+
+    double h_prob = 0.5;
+    array res = quantileSketchQuery(quantileSketch(in), array(1, &h_prob));
+    ASSERT_DOUBLE_EQ(2.5, res.scalar<double>());
+}
+
+TEST(DistinctSketch, Count)
+{
+    const int distinct = 50000;
+    array in = join(0, range(dim4(distinct), 0, s32), range(dim4(distinct), 0, s32));
+
+    array sketch = distinctSketch(in, 14);
+    ASSERT_EQ(u8, sketch.type());
+    ASSERT_EQ(1 << 14, sketch.elements());
+
+    double count = distinctSketchCount(sketch);
+    ASSERT_NEAR(distinct, count, 0.03 * distinct);
+}
+
+TEST(DistinctSketch, Merge)
+{
+    array a = range(dim4(20000), 0, s32);
+    array b = range(dim4(20000), 0, s32) + 10000;
+
+    array merged = distinctSketchMerge(distinctSketch(a), distinctSketch(b));
+    ASSERT_NEAR(30000, distinctSketchCount(merged), 0.03 * 30000);
+}
+
+TEST(FrequencySketch, HeavyHitters)
+{
+    // Value 7 occurs 5000 times and value 11 occurs 3000 times among
+    // 100000 mostly distinct values
+    array in = range(dim4(100000), 0, s32) + 100;
+    in(seq(0, 4999)) = 7;
+    in(seq(5000, 7999)) = 11;
+
+    array sketch = frequencySketch(in, 4096, 4);
+    ASSERT_EQ(u64, sketch.type());
+
+    const int h_values[] = {7, 11, 50000};
+    array counts = frequencySketchQuery(sketch, array(3, h_values));
+
+    vector<unsigned long long> res(3);
+    counts.host(&res.front());
+
+    ASSERT_GE(res[0], 5000u);
+    ASSERT_GE(res[1], 3000u);
+    ASSERT_GE(res[2], 1u);
+    ASSERT_LT(res[0], 5000u + 100);
+    ASSERT_LT(res[1], 3000u + 100);
+    ASSERT_LT(res[2], 100u);
+
+    array twice = frequencySketchMerge(sketch, sketch);
+    unsigned long long h_twice;
+    frequencySketchQuery(twice, array(1, h_values)).host(&h_twice);
+    ASSERT_EQ(2 * res[0], h_twice);
+}
@@ -200,3 +200,123 @@ SOLVE_TESTS(cfloat, 0.01)
 SOLVE_TESTS(cdouble, 1E-5)
 
 #undef SOLVE_TESTS
+
+template<typename T>
+void solveBatchTester(const int m, const int n, const int k, af_mat_prop options, double eps)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+    if (noLAPACKTests()) return;
+    if (noBatchedLAPACKTests()) return;
+
+    af::array A  = cpu_randu<T>(af::dim4(m, n, 3, 2));
+    af::array X0 = cpu_randu<T>(af::dim4(n, k, 3, 2));
+
+    if (options == AF_MAT_UPPER) A = upper(A) + 2 * n * af::identity(A.dims(), A.type());
+    if (options == AF_MAT_LOWER) A = lower(A) + 2 * n * af::identity(A.dims(), A.type());
+
+    af::array B0 = af::matmul(A, X0);
+    af::array X1 = af::solve(A, B0, options);
+    af::array B1 = af::matmul(A, X1);
+
+    ASSERT_EQ(af::dim4(n, k, 3, 2), X1.dims());
+    ASSERT_NEAR(0, af::max<double>(af::abs(real(B0 - B1))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(imag(B0 - B1))), eps);
+
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 3; i++) {
+            af::array Xs = af::solve(A(af::span, af::span, i, j), B0(af::span, af::span, i, j), options);
+            af::array diff = Xs - X1(af::span, af::span, i, j);
+            ASSERT_NEAR(0, af::max<double>(af::abs(real(diff))), eps);
+            ASSERT_NEAR(0, af::max<double>(af::abs(imag(diff))), eps);
+        }
+    }
+}
+
+template<typename T>
+void solveLUBatchTester(const int n, const int k, double eps)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+    if (noLAPACKTests()) return;
+    if (noBatchedLAPACKTests()) return;
+
+    af::array A  = cpu_randu<T>(af::dim4(n, n, 3, 2));
+    af::array X0 = cpu_randu<T>(af::dim4(n, k, 3, 2));
+    af::array B0 = af::matmul(A, X0);
+
+    af::array A_lu, pivot;
+    af::lu(A_lu, pivot, A);
+    af::array X1 = af::solveLU(A_lu, pivot, B0);
+    af::array B1 = af::matmul(A, X1);
+
+    ASSERT_NEAR(0, af::max<double>(af::abs(real(B0 - B1))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(imag(B0 - B1))), eps);
+}
+
+#define SOLVE_BATCH_TESTS(T, eps)                               \
+    TEST(SOLVE_Batch, T##SmallSquare)                           \
+    {                                                           \
+        solveBatchTester<T>(6, 6, 3, AF_MAT_NONE, eps);         \
+    }                                                           \
+    TEST(SOLVE_Batch, T##Square)                                \
+    {                                                           \
+        solveBatchTester<T>(40, 40, 5, AF_MAT_NONE, eps);       \
+    }                                                           \
+    TEST(SOLVE_Batch, T##RectOver)                              \
+    {                                                           \
+        solveBatchTester<T>(40, 20, 5, AF_MAT_NONE, eps);       \
+    }                                                           \
+    TEST(SOLVE_Batch, T##SmallUpper)                            \
+    {                                                           \
+        solveBatchTester<T>(6, 6, 3, AF_MAT_UPPER, eps);        \
+    }                                                           \
+    TEST(SOLVE_Batch, T##Lower)                                 \
+    {                                                           \
+        solveBatchTester<T>(40, 40, 5, AF_MAT_LOWER, eps);      \
+    }                                                           \
+    TEST(SOLVE_Batch, T##SmallLU)                               \
+    {                                                           \
+        solveLUBatchTester<T>(6, 3, eps);                       \
+    }                                                           \
+    TEST(SOLVE_Batch, T##LU)                                    \
+    {                                                           \
+        solveLUBatchTester<T>(40, 5, eps);                      \
+    }                                                           \
+
+SOLVE_BATCH_TESTS(float, 0.01)
+SOLVE_BATCH_TESTS(double, 1E-5)
+SOLVE_BATCH_TESTS(cfloat, 0.01)
+SOLVE_BATCH_TESTS(cdouble, 1E-5)
+
+TEST(SOLVE_Batch, LUPivotMismatch)
+{
+    if (noLAPACKTests()) return;
+    if (noBatchedLAPACKTests()) return;
+
+    af::array A = cpu_randu<float>(af::dim4(6, 6, 3, 2));
+    af::array B = cpu_randu<float>(af::dim4(6, 2, 3, 2));
+
+    af::array A_lu, pivot;
+    af::lu(A_lu, pivot, A);
+
+    af_array out = 0;
+
+    // Pivots of a single matrix for a batch of them
+    af::array single = pivot(af::span, af::span, 0, 0);
+    ASSERT_EQ(AF_ERR_SIZE, af_solve_lu(&out, A_lu.get(), single.get(), B.get(), AF_MAT_NONE));
+
+    // Too few pivots for each matrix
+    af::array shorter = pivot(af::seq(4), af::span, af::span, af::span);
+    ASSERT_EQ(AF_ERR_SIZE, af_solve_lu(&out, A_lu.get(), shorter.get(), B.get(), AF_MAT_NONE));
+
+    // Pivots are s32
+    af::array floats = pivot.as(f32);
+    ASSERT_EQ(AF_ERR_DIFF_TYPE, af_solve_lu(&out, A_lu.get(), floats.get(), B.get(), AF_MAT_NONE));
+
+    // The pivots af::lu returned are accepted
+    ASSERT_EQ(AF_SUCCESS, af_solve_lu(&out, A_lu.get(), pivot.get(), B.get(), AF_MAT_NONE));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(out));
+}
@@ -0,0 +1,185 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <gtest/gtest.h>
+#include <arrayfire.h>
+#include <af/dim4.hpp>
+#include <af/defines.h>
+#include <af/traits.hpp>
+#include <vector>
+#include <iostream>
+#include <complex>
+#include <string>
+#include <testHelpers.hpp>
+
+using std::vector;
+using std::string;
+using std::cout;
+using std::endl;
+using std::abs;
+using af::cfloat;
+using af::cdouble;
+
+///////////////////////////////// CPP ////////////////////////////////////
+//
+
+// Five point finite differences of -laplacian(u) + c * du/dx on a g x g
+// grid. The matrix is symmetric positive definite when c is 0.
+template<typename T>
+af::array convectionDiffusion(const int g, const float c)
+{
+    const int n = g * g;
+    vector<int> rowPtr(1, 0), colIdx;
+    vector<float> values;
+    for (int j = 0; j < g; ++j) {
+        for (int i = 0; i < g; ++i) {
+            const int row = i + j * g;
+            if (j > 0)     { colIdx.push_back(row - g); values.push_back(-1); }
+            if (i > 0)     { colIdx.push_back(row - 1); values.push_back(-1 - c); }
+            colIdx.push_back(row); values.push_back(4);
+            if (i < g - 1) { colIdx.push_back(row + 1); values.push_back(-1 + c); }
+            if (j < g - 1) { colIdx.push_back(row + g); values.push_back(-1); }
+            rowPtr.push_back(colIdx.size());
+        }
+    }
+
+    const af::dtype type = (af::dtype)af::dtype_traits<T>::af_type;
+    af::array val = af::array(values.size(), &values.front()).as(type);
+    af::array row = af::array(rowPtr.size(), &rowPtr.front());
+    af::array col = af::array(colIdx.size(), &colIdx.front());
+    return af::sparse(n, n, val, row, col);
+}
+
+template<typename T>
+void solveIterativeTester(const int g, const float c, const af::iterativeMethod method,
+                          const af::preconditioner precond, const bool dense, double eps)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+    if (noCPUOnlyTests()) return;
+
+    af::array A = convectionDiffusion<T>(g, c);
+    if (dense) A = af::dense(A);
+
+    const int n = g * g;
+    af::array X0 = cpu_randu<T>(af::dim4(n, 2));
+    af::array B = af::matmul(A, X0);
+
+    unsigned iterations = 0;
+    double residual = 1;
+    af::array X = af::solveIterative(A, B, method, precond, eps, 2000, 40,
+                                     &iterations, &residual);
+
+    ASSERT_LE(residual, eps);
+    ASSERT_GT(iterations, 0u);
+
+    // The true residual matches the reported one
+    af::array R = B - af::matmul(A, X);
+    for (int k = 0; k < 2; ++k) {
+        const double rnorm = af::norm(R(af::span, k)) / af::norm(B(af::span, k));
+        ASSERT_LE(rnorm, 10 * eps);
+    }
+}
+
+#define SOLVE_ITERATIVE_TESTS(T, eps)                                                               \
+    TEST(SOLVE_ITERATIVE, T##CG)                                                                    \
+    {                                                                                               \
+        solveIterativeTester<T>(40, 0, AF_ITERATIVE_CG, AF_PRECOND_NONE, false, eps);               \
+    }                                                                                               \
+    TEST(SOLVE_ITERATIVE, T##CGJacobi)                                                              \
+    {                                                                                               \
+        solveIterativeTester<T>(40, 0, AF_ITERATIVE_CG, AF_PRECOND_JACOBI, false, eps);             \
+    }                                                                                               \
+    TEST(SOLVE_ITERATIVE, T##CGILU0Dense)                                                           \
+    {                                                                                               \
+        solveIterativeTester<T>(12, 0, AF_ITERATIVE_CG, AF_PRECOND_ILU0, true, eps);                \
+    }                                                                                               \
+    TEST(SOLVE_ITERATIVE, T##BiCGSTAB)                                                              \
+    {                                                                                               \
+        solveIterativeTester<T>(40, 0.5, AF_ITERATIVE_BICGSTAB, AF_PRECOND_NONE, false, eps);       \
+    }                                                                                               \
+    TEST(SOLVE_ITERATIVE, T##BiCGSTABILU0)                                                          \
+    {                                                                                               \
+        solveIterativeTester<T>(40, 0.5, AF_ITERATIVE_BICGSTAB, AF_PRECOND_ILU0, false, eps);       \
+    }                                                                                               \
+    TEST(SOLVE_ITERATIVE, T##GMRES)                                                                 \
+    {                                                                                               \
+        solveIterativeTester<T>(40, 0.5, AF_ITERATIVE_GMRES, AF_PRECOND_NONE, false, eps);          \
+    }                                                                                               \
+    TEST(SOLVE_ITERATIVE, T##GMRESJacobiDense)                                                      \
+    {                                                                                               \
+        solveIterativeTester<T>(12, 0.5, AF_ITERATIVE_GMRES, AF_PRECOND_JACOBI, true, eps);         \
+    }                                                                                               \
+    TEST(SOLVE_ITERATIVE, T##GMRESILU0)                                                             \
+    {                                                                                               \
+        solveIterativeTester<T>(40, 0.5, AF_ITERATIVE_GMRES, AF_PRECOND_ILU0, false, eps);          \
+    }                                                                                               \
+
+SOLVE_ITERATIVE_TESTS(float, 1E-4)
+SOLVE_ITERATIVE_TESTS(double, 1E-8)
+SOLVE_ITERATIVE_TESTS(cfloat, 1E-4)
+SOLVE_ITERATIVE_TESTS(cdouble, 1E-8)
+
+#undef SOLVE_ITERATIVE_TESTS
+
+TEST(SOLVE_ITERATIVE, ILU0Iterations)
+{
+    if (noCPUOnlyTests()) return;
+
+    af::array A = convectionDiffusion<float>(60, 0);
+    af::array b = af::matmul(A, af::randu(60 * 60));
+
+    unsigned plain = 0, ilu = 0;
+    af::solveIterative(A, b, AF_ITERATIVE_CG, AF_PRECOND_NONE, 1e-5, 1000, 30, &plain);
+    af::solveIterative(A, b, AF_ITERATIVE_CG, AF_PRECOND_ILU0, 1e-5, 1000, 30, &ilu);
+    ASSERT_LT(ilu, plain);
+}
+
+TEST(SOLVE_ITERATIVE, MaxIter)
+{
+    if (noCPUOnlyTests()) return;
+
+    af::array A = convectionDiffusion<float>(30, 0);
+    af::array b = af::matmul(A, af::randu(30 * 30));
+
+    unsigned iterations = 0;
+    double residual = 0;
+    af::solveIterative(A, b, AF_ITERATIVE_CG, AF_PRECOND_NONE, 1e-6, 5, 30, &iterations, &residual);
+    ASSERT_EQ(5u, iterations);
+    ASSERT_GT(residual, 1e-6);
+}
+
+TEST(SOLVE_ITERATIVE, Args)
+{
+    if (noCPUOnlyTests()) return;
+
+    af::array A = convectionDiffusion<float>(8, 0);
+    af::array b = af::randu(64);
+
+    ASSERT_THROW(af::solveIterative(af::randu(64, 32), af::randu(64)), af::exception);
+    ASSERT_THROW(af::solveIterative(A, af::randu(32)), af::exception);
+    ASSERT_THROW(af::solveIterative(A, af::randu(64, 1, f64)), af::exception);
+    ASSERT_THROW(af::solveIterative(af::sparseConvertTo(A, AF_STORAGE_SELL), b), af::exception);
+    ASSERT_THROW(af::solveIterative(A, b, AF_ITERATIVE_GMRES, AF_PRECOND_NONE, 1e-6, 100, 0),
+                 af::exception);
+
+    // ILU(0) needs the diagonal
+    af::array Z = af::randu(64, 64);
+    Z = Z * (1 - af::identity(64, 64));
+    ASSERT_THROW(af::solveIterative(af::sparse(Z), b, AF_ITERATIVE_GMRES, AF_PRECOND_ILU0),
+                 af::exception);
+
+    // A zero right hand side gives a zero solution
+    unsigned iterations = 1;
+    af::array x = af::solveIterative(A, af::constant(0, 64), AF_ITERATIVE_CG,
+                                     AF_PRECOND_NONE, 1e-6, 100, 30, &iterations);
+    ASSERT_EQ(0u, iterations);
+    ASSERT_EQ(0, af::max<float>(af::abs(x)));
+}
@@ -226,3 +226,370 @@ CREATE_TESTS(AF_STORAGE_CSR)
 CREATE_TESTS(AF_STORAGE_COO)
 
 #undef CREATE_TESTS
+
+// Rows with very different numbers of values, including empty rows and a few
+// dense rows, so that the work is split unevenly across the rows
+template<typename T>
+void sparseSkewedTester(const int m, const int n, const int k, double eps)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+
+    af::array A = cpu_randu<T>(af::dim4(m, n));
+    af::array keep = (af::range(af::dim4(m, n), 0) % 97 == 0) ||
+                     (af::range(af::dim4(m, n), 1) % (1 + af::range(af::dim4(m, n), 0) % 7) == 0);
+    keep = keep && (af::range(af::dim4(m, n), 0) % 5 != 1);
+    A = A * keep;
+
+    af::array B  = cpu_randu<T>(af::dim4(n, k));
+    af::array Bt = cpu_randu<T>(af::dim4(m, k));
+
+    af::array sA = af::sparse(A, AF_STORAGE_CSR);
+
+    // The dense rows sum thousands of products, so the error is measured
+    // relative to the largest value instead of per element
+    af::array dRes = matmul(A, B);
+    af::array sRes = matmul(sA, B);
+    ASSERT_NEAR(0, af::max<double>(af::abs(dRes - sRes)) / af::max<double>(af::abs(dRes)), eps);
+
+    dRes = matmul(A, Bt, AF_MAT_CTRANS, AF_MAT_NONE);
+    sRes = matmul(sA, Bt, AF_MAT_CTRANS, AF_MAT_NONE);
+    ASSERT_NEAR(0, af::max<double>(af::abs(dRes - sRes)) / af::max<double>(af::abs(dRes)), eps);
+}
+
+#define SPARSE_SKEWED_TESTS(T, eps)                         \
+    TEST(SPARSE, T##SkewedMatVec)                           \
+    {                                                       \
+        sparseSkewedTester<T>(3000, 2000, 1, eps);          \
+    }                                                       \
+    TEST(SPARSE, T##SkewedColumns)                          \
+    {                                                       \
+        sparseSkewedTester<T>(3000, 2000, 7, eps);          \
+    }                                                       \
+
+SPARSE_SKEWED_TESTS(float, 1E-3)
+SPARSE_SKEWED_TESTS(double, 1E-5)
+SPARSE_SKEWED_TESTS(cfloat, 1E-3)
+SPARSE_SKEWED_TESTS(cdouble, 1E-5)
+
+#undef SPARSE_SKEWED_TESTS
+
+// Products through a sparse operator match matmul with the sparse array,
+// including repeated products and products with a different number of
+// columns than the operator was prepared for
+template<typename T>
+void sparseOperatorTester(const int m, const int n, const int k, double eps)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+
+    af::array A = cpu_randu<T>(af::dim4(m, n));
+    A = A * (af::range(af::dim4(m, n), 1) % (1 + af::range(af::dim4(m, n), 0) % 7) == 0);
+    af::array sA = af::sparse(A, AF_STORAGE_CSR);
+
+    af::array B  = cpu_randu<T>(af::dim4(n, k));
+    af::array Bt = cpu_randu<T>(af::dim4(m, k));
+
+    af::sparseOperator op(sA, AF_MAT_NONE, k);
+    af::sparseOperator opT(sA, AF_MAT_TRANS, k);
+    af::sparseOperator opH(sA, AF_MAT_CTRANS, k);
+
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_NEAR(0, af::max<double>(af::abs(matmul(sA, B) - matmul(op, B))), eps);
+        ASSERT_NEAR(0, af::max<double>(af::abs(matmul(sA, Bt, AF_MAT_TRANS, AF_MAT_NONE) -
+                                               matmul(opT, Bt))), eps);
+        ASSERT_NEAR(0, af::max<double>(af::abs(matmul(sA, Bt, AF_MAT_CTRANS, AF_MAT_NONE) -
+                                               matmul(opH, Bt))), eps);
+    }
+
+    af::array b = B.col(0);
+    af::sparseOperator copy = op;
+    ASSERT_NEAR(0, af::max<double>(af::abs(matmul(sA, b) - matmul(copy, b))), eps);
+}
+
+#define SPARSE_OPERATOR_TESTS(T, eps)                       \
+    TEST(SPARSE, T##Operator)                               \
+    {                                                       \
+        sparseOperatorTester<T>(1000, 800, 3, eps);         \
+    }                                                       \
+
+SPARSE_OPERATOR_TESTS(float, 1E-3)
+SPARSE_OPERATOR_TESTS(double, 1E-5)
+SPARSE_OPERATOR_TESTS(cfloat, 1E-3)
+SPARSE_OPERATOR_TESTS(cdouble, 1E-5)
+
+#undef SPARSE_OPERATOR_TESTS
+
+TEST(SPARSE, OperatorDims)
+{
+    af::array A = af::sparse(af::randu(10, 8) * (af::randu(10, 8) > 0.5), AF_STORAGE_CSR);
+    af::sparseOperator op(A);
+    ASSERT_THROW(matmul(op, af::randu(10, 1)), af::exception);
+    ASSERT_THROW(af::sparseOperator(af::randu(10, 8)), af::exception);
+}
+
+template<typename T>
+af::array sparseRandom(const int m, const int n, const int stride)
+{
+    af::array A = cpu_randu<T>(af::dim4(m, n));
+    af::array r = af::randu(m, n);
+    return A * (r < 1.0 / stride);
+}
+
+template<typename T>
+void sparseArithTester(const int m, const int n, const int k, double eps)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+    if (noCPUOnlyTests()) return;
+
+    af::array A = sparseRandom<T>(m, n, 5);
+    af::array B = sparseRandom<T>(m, n, 3);
+    af::array C = sparseRandom<T>(n, k, 4);
+
+    af::array sA = af::sparse(A);
+    af::array sB = af::sparse(B);
+    af::array sC = af::sparse(C);
+
+    af::array add = af::sparseAdd(sA, sB);
+    af::array mul = af::sparseMul(sA, sB);
+    af::array mm  = af::sparseMatmul(sA, sC);
+
+    ASSERT_EQ(AF_STORAGE_CSR, af::sparseGetStorage(add));
+    ASSERT_EQ(af::sum<float>((A != 0) || (B != 0)), af::sparseGetNNZ(add));
+    ASSERT_EQ(af::sum<float>((A != 0) && (B != 0)), af::sparseGetNNZ(mul));
+
+    ASSERT_NEAR(0, af::max<double>(af::abs(af::dense(add) - (A + B))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(af::dense(mul) - (A * B))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(af::dense(mm) - af::matmul(A, C))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(af::dense(af::matmul(sA, sC)) - af::matmul(A, C))), eps);
+
+    // Columns are sorted within every row
+    af::array rows = af::sparseGetRowIdx(mm);
+    af::array cols = af::sparseGetColIdx(mm);
+    std::vector<int> hRows(rows.elements()), hCols(cols.elements());
+    rows.host(&hRows.front());
+    cols.host(&hCols.front());
+    for (int i = 0; i < m; ++i) {
+        for (int j = hRows[i] + 1; j < hRows[i + 1]; ++j) {
+            ASSERT_LT(hCols[j - 1], hCols[j]);
+        }
+    }
+}
+
+#define SPARSE_ARITH_TESTS(T, eps)                          \
+    TEST(SPARSE, T##Arith)                                  \
+    {                                                       \
+        sparseArithTester<T>(500, 300, 200, eps);           \
+    }                                                       \
+
+SPARSE_ARITH_TESTS(float, 1E-3)
+SPARSE_ARITH_TESTS(double, 1E-5)
+SPARSE_ARITH_TESTS(cfloat, 1E-3)
+SPARSE_ARITH_TESTS(cdouble, 1E-5)
+
+#undef SPARSE_ARITH_TESTS
+
+TEST(SPARSE, ArithDims)
+{
+    if (noCPUOnlyTests()) return;
+
+    af::array A = af::sparse(af::randu(10, 8) * (af::randu(10, 8) > 0.5));
+    af::array B = af::sparse(af::randu(8, 10) * (af::randu(8, 10) > 0.5));
+    ASSERT_THROW(af::sparseAdd(A, B), af::exception);
+    ASSERT_THROW(af::sparseMul(A, B), af::exception);
+    ASSERT_THROW(af::sparseMatmul(A, A), af::exception);
+}
+
+TEST(SPARSE, TriangleCount)
+{
+    if (noCPUOnlyTests()) return;
+
+    // Two triangles sharing the edge 1-2 and a separate edge 4-5
+    const float edges[] = {0, 1, 1, 2, 0, 2, 1, 3, 2, 3, 4, 5};
+    af::array adj = af::constant(0, 6, 6);
+    for (int e = 0; e < 6; ++e) {
+        adj(edges[2 * e], edges[2 * e + 1]) = 1;
+        adj(edges[2 * e + 1], edges[2 * e]) = 1;
+    }
+    af::array A = af::sparse(adj);
+    af::array paths = af::sparseMul(af::sparseMatmul(A, A), A);
+    ASSERT_EQ(2, af::sum<float>(af::sparseGetValues(paths)) / 6);
+}
+
+// Products with the blocked storages match the dense products and the
+// conversions back to CSR and dense give the original matrix
+template<typename T>
+void sparseBlockedTester(const af::storage stype, const af::array &A,
+                         const int k, double eps)
+{
+    af::array sA = af::sparse(A, AF_STORAGE_CSR);
+    af::array bA = af::sparseConvertTo(sA, stype);
+    ASSERT_EQ(stype, af::sparseGetStorage(bA));
+
+    af::array B = cpu_randu<T>(af::dim4(A.dims(1), k));
+    af::array b = B.col(0);
+    ASSERT_NEAR(0, af::max<double>(af::abs(matmul(bA, B) - matmul(A, B))), eps);
+    ASSERT_NEAR(0, af::max<double>(af::abs(matmul(bA, b) - matmul(A, b))), eps);
+
+    ASSERT_EQ(0, af::max<double>(af::abs(af::dense(bA) - A)));
+
+    af::array cA = af::sparseConvertTo(bA, AF_STORAGE_CSR);
+    ASSERT_EQ(AF_STORAGE_CSR, af::sparseGetStorage(cA));
+    ASSERT_EQ(af::sparseGetNNZ(sA), af::sparseGetNNZ(cA));
+    ASSERT_EQ(0, af::max<double>(af::abs(af::dense(cA) - A)));
+}
+
+template<typename T>
+void sparseBSRTester(const int m, const int n, const int k, double eps)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+    if (noCPUOnlyTests()) return;
+
+    // 3 x 3 blocks like the ones of a finite element matrix with 3 degrees
+    // of freedom per node
+    af::array pattern = af::randu(m / 3, n / 3) < 0.05;
+    af::array rows = af::range(af::dim4(m), 0, s32) / 3;
+    af::array cols = af::range(af::dim4(n), 0, s32) / 3;
+    af::array A = cpu_randu<T>(af::dim4(m, n)) * pattern(rows, cols);
+
+    sparseBlockedTester<T>(AF_STORAGE_BSR, A, k, eps);
+
+    af::array bA = af::sparseConvertTo(af::sparse(A), AF_STORAGE_BSR);
+    ASSERT_EQ(m / 3 + 1, af::sparseGetRowIdx(bA).elements());
+    ASSERT_EQ(af::sum<float>(pattern) * 9, af::sparseGetNNZ(bA));
+}
+
+template<typename T>
+void sparseSELLTester(const int m, const int n, const int k, double eps)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+    if (noCPUOnlyTests()) return;
+
+    // Rows of very different lengths
+    af::array A = cpu_randu<T>(af::dim4(m, n));
+    A = A * (af::randu(m, n) < 0.2 * af::tile(af::randu(m) * af::randu(m), 1, n));
+
+    sparseBlockedTester<T>(AF_STORAGE_SELL, A, k, eps);
+}
+
+#define SPARSE_BLOCKED_TESTS(T, eps)                        \
+    TEST(SPARSE, T##BSR)                                    \
+    {                                                       \
+        sparseBSRTester<T>(600, 450, 5, eps);               \
+    }                                                       \
+    TEST(SPARSE, T##SELL)                                   \
+    {                                                       \
+        sparseSELLTester<T>(1003, 700, 5, eps);             \
+    }                                                       \
+
+SPARSE_BLOCKED_TESTS(float, 1E-3)
+SPARSE_BLOCKED_TESTS(double, 1E-5)
+SPARSE_BLOCKED_TESTS(cfloat, 1E-3)
+SPARSE_BLOCKED_TESTS(cdouble, 1E-5)
+
+#undef SPARSE_BLOCKED_TESTS
+
+TEST(SPARSE, BlockedArgs)
+{
+    if (noCPUOnlyTests()) return;
+
+    af::array A = af::sparse(af::randu(12, 12) * (af::randu(12, 12) > 0.5));
+    af::array bsr = af::sparseConvertTo(A, AF_STORAGE_BSR);
+    ASSERT_THROW(matmul(bsr, af::randu(12, 1), AF_MAT_TRANS), af::exception);
+    ASSERT_THROW(af::sparseConvertTo(bsr, AF_STORAGE_SELL), af::exception);
+    af::array coo = af::sparse(af::randu(12, 12) * (af::randu(12, 12) > 0.5), AF_STORAGE_COO);
+    ASSERT_THROW(af::sparseConvertTo(coo, AF_STORAGE_BSR), af::exception);
+}
+
+template<typename T>
+void sparseAssembleTester(const int m, const int n, const int nnz,
+                          const af::sparseDuplicates dups)
+{
+    af::deviceGC();
+
+    if (noDoubleTests<T>()) return;
+    if (noCPUOnlyTests()) return;
+
+    // Few distinct positions so that most of them are repeated
+    vector<int> r(nnz), c(nnz);
+    vector<float> v(nnz);
+    vector<float> gold(m * n, 0);
+    for (int i = 0; i < nnz; ++i) {
+        r[i] = rand() % m;
+        c[i] = (rand() % (n / 4 + 1)) * 4 % n;
+        v[i] = (rand() % 1000) / 100.f + 1;
+        float &g = gold[r[i] + c[i] * m];
+        g = (dups == AF_SPARSE_DUPLICATES_SUM) ? g + v[i] : v[i];
+    }
+
+    const af::dtype type = (af::dtype)af::dtype_traits<T>::af_type;
+    af::array values = af::array(nnz, &v.front()).as(type);
+    af::array rowIdx = af::array(nnz, &r.front());
+    af::array colIdx = af::array(nnz, &c.front());
+
+    af::array A = af::sparseAssemble(m, n, values, rowIdx, colIdx, dups);
+    ASSERT_EQ(AF_STORAGE_CSR, af::sparseGetStorage(A));
+
+    af::array expected = af::array(m, n, &gold.front()).as(type);
+    ASSERT_EQ(af::count<int>(expected), af::sparseGetNNZ(A));
+    ASSERT_NEAR(0, af::max<double>(af::abs(af::dense(A) - expected)), 1E-3);
+
+    // The columns of every row are sorted
+    vector<int> rowPtr(m + 1), colVec(af::sparseGetNNZ(A));
+    af::sparseGetRowIdx(A).host(&rowPtr.front());
+    if (!colVec.empty()) af::sparseGetColIdx(A).host(&colVec.front());
+    for (int i = 0; i < m; ++i) {
+        for (int j = rowPtr[i] + 1; j < rowPtr[i + 1]; ++j) {
+            ASSERT_LT(colVec[j - 1], colVec[j]);
+        }
+    }
+
+    if (dups == AF_SPARSE_DUPLICATES_SUM) {
+        af::array coo = af::sparse(m, n, values, rowIdx, colIdx, AF_STORAGE_COO);
+        af::array csr = af::sparseConvertTo(coo, AF_STORAGE_CSR);
+        ASSERT_NEAR(0, af::max<double>(af::abs(af::dense(csr) - expected)), 1E-3);
+    }
+}
+
+#define SPARSE_ASSEMBLE_TESTS(T)                                              \
+    TEST(SPARSE, T##AssembleSum)                                              \
+    {                                                                         \
+        sparseAssembleTester<T>(1500, 900, 40000, AF_SPARSE_DUPLICATES_SUM);  \
+    }                                                                         \
+    TEST(SPARSE, T##AssembleLast)                                             \
+    {                                                                         \
+        sparseAssembleTester<T>(1500, 900, 40000, AF_SPARSE_DUPLICATES_LAST); \
+    }                                                                         \
+
+SPARSE_ASSEMBLE_TESTS(float)
+SPARSE_ASSEMBLE_TESTS(double)
+SPARSE_ASSEMBLE_TESTS(cfloat)
+SPARSE_ASSEMBLE_TESTS(cdouble)
+
+#undef SPARSE_ASSEMBLE_TESTS
+
+TEST(SPARSE, AssembleArgs)
+{
+    if (noCPUOnlyTests()) return;
+
+    int   r[] = {0, 3};
+    int   c[] = {1, 0};
+    float v[] = {1, 2};
+    af::array values(2, v), rowIdx(2, r), colIdx(2, c);
+
+    // Row 3 is outside of a 3 x 3 matrix
+    ASSERT_THROW(af::sparseAssemble(3, 3, values, rowIdx, colIdx), af::exception);
+    ASSERT_THROW(af::sparseAssemble(4, 3, values, rowIdx.as(f32), colIdx), af::exception);
+    ASSERT_THROW(af::sparseAssemble(4, 3, values, rowIdx(0), colIdx(0)), af::exception);
+
+    af::array A = af::sparseAssemble(4, 3, values, rowIdx, colIdx);
+    ASSERT_EQ(2, af::sparseGetNNZ(A));
+}
@@ -0,0 +1,185 @@
+/*******************************************************
+ * Copyright (c) 2016, ArrayFire
+ * All rights reserved.
+ *
+ * This file is distributed under 3-clause BSD license.
+ * The complete license agreement can be obtained at:
+ * http://arrayfire.com/licenses/BSD-3-Clause
+ ********************************************************/
+
+#include <gtest/gtest.h>
+#include <arrayfire.h>
+#include <af/dim4.hpp>
+#include <af/traits.hpp>
+#include <algorithm>
+#include <vector>
+#include <testHelpers.hpp>
+
+using std::vector;
+using af::array;
+using af::dim4;
+
+template<typename T>
+class StreamFilter : public ::testing::Test
+{
+    public:
+        virtual void SetUp() {}
+};
+
+typedef ::testing::Types<float, double, af::cfloat, af::cdouble> TestTypes;
+
+TYPED_TEST_CASE(StreamFilter, TestTypes);
+
+// Chunk lengths, some of them shorter than the filters
+static const int chunks[] = {100, 3, 1, 250, 17, 629};
+
+// Pushes x through filter in chunks and checks the result against gold,
+// the whole of x filtered at once
+static void checkStream(af::streamFilter &filter, const array &x, const array &gold,
+                        const double eps)
+{
+    vector<array> out;
+    int begin = 0;
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        out.push_back(filter.push(x(af::seq(begin, begin + chunks[i] - 1), af::span)));
+        begin += chunks[i];
+    }
+    ASSERT_EQ(x.dims(0), begin);
+
+    array y = out[0];
+    for (size_t i = 1; i < out.size(); i++) y = af::join(0, y, out[i]);
+
+    ASSERT_EQ(gold.dims(), y.dims());
+    ASSERT_NEAR(0, af::max<double>(af::abs(y - gold)) / af::max<double>(af::abs(gold)), eps);
+}
+
+template<typename T>
+void streamTest(const int ntaps, const int nfeedback, const af::convDomain domain)
+{
+    if (noDoubleTests<T>()) return;
+
+    af::dtype ty = (af::dtype)af::dtype_traits<T>::af_type;
+    const double eps = (ty == f32 || ty == c32) ? 1e-4 : 1e-10;
+    array x = af::randu(1000, 3, ty);
+    array b = af::randu(ntaps, ty);
+
+    if (nfeedback == 0) {
+        af::streamFilter filter(b, domain);
+        checkStream(filter, x, af::fir(b, x), eps);
+    } else {
+        // Poles well inside the unit circle, as the feedback coefficients
+        // add up to less than half of a0
+        const double scale = std::min(0.2, 1.0 / nfeedback);
+        array a = af::constant(2, 1, ty);
+        if (nfeedback > 1) a = af::join(0, a, scale * af::randu(nfeedback - 1, ty));
+        af::streamFilter filter(b, a);
+        checkStream(filter, x, af::iir(b, a, x), eps);
+    }
+}
+
+TYPED_TEST(StreamFilter, FirSpatial)
+{
+    streamTest<TypeParam>(32, 0, AF_CONV_SPATIAL);
+}
+
+TYPED_TEST(StreamFilter, FirFreq)
+{
+    streamTest<TypeParam>(300, 0, AF_CONV_FREQ);
+}
+
+TYPED_TEST(StreamFilter, Iir)
+{
+    streamTest<TypeParam>(5, 4, AF_CONV_AUTO);
+}
+
+TYPED_TEST(StreamFilter, IirLongFeedforward)
+{
+    streamTest<TypeParam>(300, 4, AF_CONV_AUTO);
+}
+
+// Longer than the GPU backends convolve in the spatial domain
+TYPED_TEST(StreamFilter, IirLongFeedback)
+{
+    streamTest<TypeParam>(5, 300, AF_CONV_AUTO);
+}
+
+TYPED_TEST(StreamFilter, IirA0)
+{
+    streamTest<TypeParam>(5, 1, AF_CONV_AUTO);
+}
+
+TEST(StreamFilter, ResetAndCopies)
+{
+    array x = af::randu(200, 2);
+    array b = af::randu(8);
+    array a = af::randu(3);
+    a(0) = 1;
+
+    af::streamFilter filter(b, a);
+    filter.push(x);
+
+    // The copy shares the state, so the second chunk carries on the stream
+    af::streamFilter copy(filter);
+    array second = copy.push(x);
+    array both = af::iir(b, a, af::join(0, x, x));
+    ASSERT_NEAR(0, af::max<float>(af::abs(second - both(af::seq(200, 399), af::span))), 1e-4);
+
+    // After a reset, a new stream with another number of channels can start
+    filter.reset();
+    array y = af::randu(50, 4);
+    ASSERT_NEAR(0, af::max<float>(af::abs(filter.push(y) - af::iir(b, a, y))), 1e-4);
+}
+
+TEST(StreamFilter, InvalidArgs)
+{
+    af_array b = 0, x = 0, y = 0;
+    af_stream_filter filter = 0;
+    vector<float> in(100, 1);
+    dim4 bdims(5, 2), xdims(10, 10), ydims(10, 3);
+
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&b, &in.front(), bdims.ndims(), bdims.get(), f32));
+    ASSERT_EQ(AF_ERR_ARG, af_create_fir_stream(&filter, b, AF_CONV_AUTO));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(b));
+
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&b, &in.front(), 1, bdims.get(), f32));
+    ASSERT_EQ(AF_SUCCESS, af_create_fir_stream(&filter, b, AF_CONV_AUTO));
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&x, &in.front(), xdims.ndims(), xdims.get(), f32));
+    ASSERT_EQ(AF_SUCCESS, af_stream_filter_push(&y, filter, x));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(x));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(y));
+
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&x, &in.front(), ydims.ndims(), ydims.get(), f32));
+    ASSERT_EQ(AF_ERR_SIZE, af_stream_filter_push(&y, filter, x));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(x));
+
+    // The failed push leaves the stream as it was
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&x, &in.front(), xdims.ndims(), xdims.get(), f32));
+    ASSERT_EQ(AF_SUCCESS, af_stream_filter_push(&y, filter, x));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(x));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(y));
+
+    ASSERT_EQ(AF_SUCCESS, af_create_array(&x, &in.front(), xdims.ndims(), xdims.get(), f64));
+    ASSERT_EQ(AF_ERR_DIFF_TYPE, af_stream_filter_push(&y, filter, x));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(x));
+
+    ASSERT_EQ(AF_SUCCESS, af_release_stream_filter(filter));
+    ASSERT_EQ(AF_SUCCESS, af_release_array(b));
+}
+
+TEST(StreamFilter, FailedPushKeepsState)
+{
+    array b = af::randu(8);
+    array a = af::join(0, af::constant(1, 1), 0.2 * af::randu(3));
+    array x = af::randu(300, 2);
+
+    af::streamFilter failed(b, a), uninterrupted(b, a);
+    failed.push(x(af::seq(100), af::span));
+    uninterrupted.push(x(af::seq(100), af::span));
+
+    // Three channels instead of two
+    ASSERT_THROW(failed.push(af::randu(50, 3)), af::exception);
+
+    array y = failed.push(x(af::seq(100, 299), af::span));
+    array gold = uninterrupted.push(x(af::seq(100, 299), af::span));
+    ASSERT_EQ(0, af::max<float>(af::abs(y - gold)));
+}
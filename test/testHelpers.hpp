@@ -404,6 +404,21 @@ inline bool noLAPACKTests()
     return ret;
 }
 
+inline bool noBatchedLAPACKTests()
+{
+    bool ret = af::getActiveBackend() != AF_BACKEND_CPU;
+    if(ret) printf("Batched LAPACK is only available on the CPU backend. Test will exit\n");
+    return ret;
+}
+
+// Functions that the other backends report as not supported
+inline bool noCPUOnlyTests()
+{
+    bool ret = af::getActiveBackend() != AF_BACKEND_CPU;
+    if(ret) printf("This function is only available on the CPU backend. Test will exit\n");
+    return ret;
+}
+
 // TODO: perform conversion on device for CUDA and OpenCL
 template<typename T>
 af_err conv_image(af_array *out, af_array in)
@@ -345,3 +345,23 @@ TEST(TransformBatching, CPP)
         delete[] outData;
     }
 }
+
+TEST(Transform, FixedPointU8MatchesFloat)
+{
+    using namespace af;
+    array img = (255 * randu(64, 48, 2)).as(u8);
+
+    float tf[] = {0.9f, 0.3f, 2.5f, -0.25f, 1.1f, -3.f};
+    array T(3, 2, tf);
+
+    af_interp_type methods[] = {AF_INTERP_BILINEAR, AF_INTERP_BICUBIC, AF_INTERP_BICUBIC_SPLINE};
+    for (int i = 0; i < 3; i++) {
+        array u = transform(img, T, 0, 0, methods[i], true);
+        array f = transform(img.as(f32), T, 0, 0, methods[i], true);
+        ASSERT_EQ(u8, u.type());
+        array gold = floor(clamp(f, 0.0, 255.0));
+        ASSERT_LE(max<float>(abs(u.as(f32) - gold)), 1.0f) << "for method " << methods[i];
+        ASSERT_LT(count<float>(u.as(f32) != gold), 0.05f * u.elements())
+            << "for method " << methods[i];
+    }
+}
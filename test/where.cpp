@@ -128,3 +128,59 @@ TEST(Where, ISSUE_1259)
     af::array indices = af::where(a > 2);
     ASSERT_EQ(indices.elements(), 0);
 }
+
+TEST(Where, LargeStrided)
+{
+    af::array a = af::randu(1000, 300);
+    af::array sub = a(af::seq(1, 998), af::seq(0, 299, 2));
+
+    af::array idx = af::where(sub > 0.5);
+
+    vector<float> h_sub(sub.elements());
+    sub.host(&h_sub.front());
+
+    vector<uint> gold;
+    for (size_t i = 0; i < h_sub.size(); i++) {
+        if (h_sub[i] > 0.5) gold.push_back(i);
+    }
+
+    ASSERT_EQ(gold.size(), (size_t)idx.elements());
+
+    vector<uint> h_idx(idx.elements());
+    idx.host(&h_idx.front());
+    for (size_t i = 0; i < gold.size(); i++) {
+        ASSERT_EQ(gold[i], h_idx[i]) << "at: " << i;
+    }
+}
+
+TEST(Compact, Elements)
+{
+    af::array a = af::randu(500, 40);
+    af::array mask = a > 0.3;
+
+    af::array gold = a(af::where(mask));
+    af::array out  = af::compact(a, mask);
+
+    ASSERT_EQ(gold.elements(), out.elements());
+    ASSERT_EQ(0, af::count<uint>(gold != out));
+}
+
+TEST(Compact, Rows)
+{
+    af::array a = af::randu(1000, 3);
+    af::array mask = a.col(0) > 0.5;
+
+    af::array gold = a(af::where(mask), af::span);
+    af::array out  = af::compact(a, mask);
+
+    ASSERT_EQ(gold.dims(0), out.dims(0));
+    ASSERT_EQ(3, out.dims(1));
+    ASSERT_EQ(0, af::count<uint>(gold != out));
+}
+
+TEST(Compact, Empty)
+{
+    af::array a = af::randu(10, 5);
+    af::array out = af::compact(a, a > 2);
+    ASSERT_EQ(0, out.elements());
+}